@@ -11,8 +11,10 @@ uniform bool isBackground;
 uniform bool isColorOverriden = false;
 uniform vec3 overrideColor;
 
+#include "../lib/sdf.glsl"
+
 void main() {
-  vec4 texColor = texture(inTexture, Texcoord);
+  float coverage  = sdfCoverage(texture(inTexture, Texcoord).r);
   vec4 usedColors = isColorOverriden ? vec4(overrideColor, 1.0) : Colors;
-  outColor = isBackground ? Colors : texColor.r * usedColors;
+  outColor = isBackground ? Colors : coverage * usedColors;
 }
@@ -5,6 +5,8 @@ in vec4 Colors;
 
 out vec4 outColor;
 
+#include "../lib/sdf.glsl"
+
 // bound to one due to shadowmap being bound to two.
 layout(binding=1) uniform sampler2D fontTexture;
 uniform bool isBackground;
@@ -23,6 +25,6 @@ void main() {
     outColor = Colors;
   else {
     outColor  = isColorOverriden ? vec4(overrideColor, 1.0) : Colors;
-    outColor *= texture(fontTexture, Texcoord).r;
+    outColor *= sdfCoverage(texture(fontTexture, Texcoord).r);
   }
 }
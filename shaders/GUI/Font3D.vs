@@ -3,15 +3,14 @@
 layout(location=0) in vec2 position;
 layout(location=1) in vec2 texcoord;
 layout(location=2) in vec4 colors;
+layout(location=3) in vec3 worldPosition;
 
 out vec2 Texcoord;
 out vec4 Colors;
 
-uniform mat4 MVP;
-uniform vec3 cameraRight;
-uniform vec3 cameraUp;
 uniform vec2 size;
-uniform vec3 worldPosition;
+
+#include "../lib/frame.glsl"
 
 const vec2 halfScreenRes = _CFG_.Graphics.resolution;
 
@@ -21,9 +20,15 @@ void main() {
 
   vec2 normalizedPosition = position / halfScreenRes;
 
+  // The first two rows of the view matrix are the camera's right and up
+  vec3 cameraRight =
+    vec3(frame.view[0][0], frame.view[1][0], frame.view[2][0]);
+  vec3 cameraUp =
+    vec3(frame.view[0][1], frame.view[1][1], frame.view[2][1]);
+
   vec3 vertexPosition = worldPosition +
     cameraRight * normalizedPosition.x +
     cameraUp * normalizedPosition.y * -1;
 
-  gl_Position = MVP * vec4(vertexPosition, 1.0);
+  gl_Position = frame.proj * frame.view * vec4(vertexPosition, 1.0);
 }
@@ -4,16 +4,18 @@ in vec3 position;
 in vec3 normal;
 in vec4 shadowCoord;
 in vec2 texCoord;
+in vec4 color;
 
-uniform vec3 dir;
 uniform vec4 overrideColor = vec4(-1);
 uniform bool useNormalsAsColors = false;
+uniform bool useInstanceColors = false;
 
 layout(binding=0) uniform sampler2D shadowMap;
 layout(binding=1) uniform sampler2D diffuseMap;
 
 out vec4 fragment;
 
+#include "lib/frame.glsl"
 #include "lib/shadow.glsl"
 
 // light properties
@@ -24,12 +26,15 @@ const vec3 diffuse_light  = vec3(0.7, 0.7, 0.7);
 const vec3 ambient_light  = vec3(0.2, 0.2, 0.2);
 
 void main () {
+  vec3 dir = frame.lightDirection.xyz;
 
   // phong lighting
   vec3 texel;
 
   if (useNormalsAsColors)
     texel = normal;
+  else if (useInstanceColors)
+    texel = color.xyz;
   else if (overrideColor.x < 0)
     texel = vec3(texture(diffuseMap, texCoord));
   else
@@ -4,38 +4,42 @@ layout(location=0) in vec3 vertexPosition;
 layout(location=1) in vec2 vertexTexCoord;
 layout(location=2) in vec3 vertexNormal;
 
+// Used instead of model when drawing instances
+layout(location=3) in mat4 instanceModel;
+
+// Used instead of the texture when drawing instances with colors
+layout(location=7) in vec4 instanceColor;
+
 uniform bool useNormalsAsColors = false;
+uniform bool instanced = false;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
-
-struct Light {
-  mat4 view;
-  mat4 proj;
-  mat4 model;
-};
 
-uniform Light light;
+#include "lib/frame.glsl"
 
 out vec3 position;
 out vec3 normal;
 out vec4 shadowCoord;
 out vec2 texCoord;
+out vec4 color;
 
 void main () {
+  mat4 modelMatrix = instanced ? instanceModel : model;
 
   if (useNormalsAsColors)
     normal = vertexNormal;
   else
-    normal = normalize (vec3(view * model * vec4(vertexNormal, 0.0)));
+    normal = normalize(
+      vec3(frame.view * modelMatrix * vec4(vertexNormal, 0.0)));
 
-  position = vec3(view * model * vec4(vertexPosition, 1.0));
+  position = vec3(frame.view * modelMatrix * vec4(vertexPosition, 1.0));
   texCoord = vertexTexCoord;
+  color    = instanceColor;
 
-  gl_Position = proj * vec4(position, 1.0);
+  gl_Position = frame.proj * vec4(position, 1.0);
 
-  shadowCoord = light.proj * light.view * model * vec4(vertexPosition, 1.0);
+  shadowCoord = frame.lightProj * frame.lightView * modelMatrix *
+                vec4(vertexPosition, 1.0);
   shadowCoord.xyz /= shadowCoord.w;
   shadowCoord.xyz += 1.0;
   shadowCoord.xyz *= 0.5;
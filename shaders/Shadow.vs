@@ -1,16 +1,18 @@
 #version 330
 
-in vec3 vpos;
+layout(location=0) in vec3 vpos;
 
-struct Light {
-  mat4 view;
-  mat4 proj;
-  mat4 model;
-};
+// Used instead of model when drawing instances
+layout(location=3) in mat4 instanceModel;
 
 uniform mat4 model;
-uniform Light light;
+uniform bool instanced = false;
+
+#include "lib/frame.glsl"
 
 void main () {
-  gl_Position = light.proj * light.view * model * vec4 (vpos, 1.0);
+  mat4 modelMatrix = instanced ? instanceModel : model;
+
+  gl_Position = frame.lightProj * frame.lightView * modelMatrix *
+                vec4 (vpos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,18 @@
+/**
+ * @brief
+ *
+ * This file describes the `Frame` block, which holds the uniforms that
+ * are the same for every program during a frame. It is uploaded once per
+ * frame by FrameUniforms.
+ *
+ * To use: #include "lib/frame.glsl"
+ */
+
+layout(std140, row_major) uniform Frame {
+  mat4 view;
+  mat4 proj;
+  mat4 lightView;
+  mat4 lightProj;
+  vec4 lightDirection;
+  vec4 cameraPosition;
+} frame;
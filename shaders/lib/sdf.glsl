@@ -0,0 +1,32 @@
+/**
+ * @brief
+ *
+ * This file describes functions for drawing glyphs from a signed
+ * distance field atlas, where 0.5 is on the outline of the glyph
+ * and larger values are inside it.
+ *
+ * To use: #include "lib/sdf.glsl"
+ */
+
+/**
+ * @brief
+ *   Returns how much of the pixel is covered by the glyph. The edge is
+ *   smoothed over about one pixel on the screen, whatever size the
+ *   glyph is drawn at.
+ *
+ * @param distance the distance sampled from the atlas
+ *
+ * @return
+ */
+float sdfCoverage(float distance);
+
+// Implementation details
+// ----------------------------------------------------------
+
+const float SDF_EDGE = 0.5;
+
+float sdfCoverage(float distance) {
+  float width = max(fwidth(distance) * 0.7, 0.001);
+
+  return smoothstep(SDF_EDGE - width, SDF_EDGE + width, distance);
+}
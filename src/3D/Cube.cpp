@@ -10,6 +10,8 @@
 #include "../Shape/GL/Cube.hpp"
 #include "../Utils/Asset.hpp"
 
+static const int MODEL_UNIFORM = Program::uniformId("model");
+
 Cube::Cube(const mmm::vec3& size, int weight, const mmm::vec3& position)
     : Logging::Log("Cube") {
   btVector3 btSize = btVector3(size.x / 2.0f, size.y / 2.0f, size.z / 2.0f);
@@ -77,7 +79,7 @@ void Cube::draw(std::shared_ptr<Program>& program,
                 mmm::vec3                 offset,
                 bool                      bindTexture) {
   program->bind();
-  program->setUniform("model",
+  program->setUniform(MODEL_UNIFORM,
                       mmm::translate(mPosition + offset) * mRotation * mScale);
 
   if (bindTexture)
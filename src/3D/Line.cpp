@@ -7,6 +7,9 @@
 #include "../Shape/GL/Line.hpp"
 #include "../Utils/Asset.hpp"
 
+static const int MODEL_UNIFORM = Program::uniformId("model");
+static const int COLOR_UNIFORM = Program::uniformId("overrideColor");
+
 Line::Line(const mmm::vec3& start, const mmm::vec3& end, const mmm::vec4& color)
     : Logging::Log("Line"), mLine(new GLLine()) {
   mTexture = nullptr;
@@ -67,18 +70,18 @@ void Line::draw(std::shared_ptr<Program>& program,
                 mmm::vec3                 offset,
                 bool                      bindTexture) {
   program->bind();
-  program->setUniform("model",
+  program->setUniform(MODEL_UNIFORM,
                       mmm::translate(mPosition + offset) * mRotation * mScale);
 
   if (mUsesColor && bindTexture)
-    program->setUniform("overrideColor", mColor);
+    program->setUniform(COLOR_UNIFORM, mColor);
 
   if (bindTexture && mTexture != nullptr)
     mTexture->bind(1);
   mLine->draw();
 
   if (mUsesColor && bindTexture)
-    program->setUniform("overrideColor", mmm::vec4(-1));
+    program->setUniform(COLOR_UNIFORM, mmm::vec4(-1));
 }
 
 void Line::input(const Input::Event&) {}
@@ -7,6 +7,8 @@
 
 #include <btBulletDynamicsCommon.h>
 
+static const int MODEL_UNIFORM = Program::uniformId("model");
+
 mmm::vec3 tovec(const btVector3& m) {
   return mmm::vec3(m.x(), m.y(), m.z());
 }
@@ -28,6 +30,7 @@ MeshPart::MeshPart(const SubMesh* subMesh,
   //   mShape->getName(),
   //   tovec(mBody->getLocalInertia()),
   //   mBody->getNumConstraintRefs());
+  mBounds = subMesh->bounds();
   updateFromPhysics();
 }
 
@@ -56,10 +59,17 @@ void MeshPart::draw(std::shared_ptr<Program>& program,
     return;
 
   program->bind();
-  program->setUniform("model",
-                      mmm::translate(mPosition + offset) * mRotation * mScale);
+  program->setUniform(MODEL_UNIFORM, model(offset));
 
   mMesh->draw(bindTexture ? 1 : -1);
 }
 
 void MeshPart::input(const Input::Event&) {}
+
+mmm::mat4 MeshPart::model(const mmm::vec3& offset) const {
+  return mmm::translate(mPosition + offset) * mRotation * mScale;
+}
+
+const SubMesh* MeshPart::subMesh() const {
+  return mMesh;
+}
@@ -26,6 +26,12 @@ public:
 
   void input(const Input::Event& event);
 
+  // Returns the model matrix of the part, moved by the offset
+  mmm::mat4 model(const mmm::vec3& offset) const;
+
+  // Returns the part of the mesh that is drawn
+  const SubMesh* subMesh() const;
+
 private:
   const SubMesh* mMesh;
 };
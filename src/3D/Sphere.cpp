@@ -12,6 +12,9 @@
 using mmm::vec2;
 using mmm::vec3;
 
+static const int MODEL_UNIFORM = Program::uniformId("model");
+static const int COLOR_UNIFORM = Program::uniformId("overrideColor");
+
 Sphere::Sphere(const mmm::vec3&         position,
                float                    radius,
                std::shared_ptr<Texture> texture,
@@ -74,18 +77,18 @@ void Sphere::draw(std::shared_ptr<Program>& program,
                   mmm::vec3                 offset,
                   bool                      bindTexture) {
   program->bind();
-  program->setUniform("model",
+  program->setUniform(MODEL_UNIFORM,
                       mmm::translate(mPosition + offset) * mRotation * mScale);
 
   if (mUsesColor && bindTexture)
-    program->setUniform("overrideColor", mColor);
+    program->setUniform(COLOR_UNIFORM, mColor);
 
   if (bindTexture && mTexture != nullptr)
     mTexture->bind(1);
   mSphere->draw();
 
   if (mUsesColor && bindTexture)
-    program->setUniform("overrideColor", mmm::vec4(-1));
+    program->setUniform(COLOR_UNIFORM, mmm::vec4(-1));
 }
 
 void Sphere::input(const Input::Event&) {}
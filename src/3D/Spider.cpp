@@ -35,79 +35,55 @@ Spider::Part::Part(unsigned short group,
     , hinge(nullptr)
     , dof(nullptr) {}
 
+/**
+ * @brief
+ *   Creates the spider from the shared SpiderTemplate. The children are
+ *   stored in the order of the template's parts, so that both the children
+ *   and the physics can be found by the index of the part.
+ */
 Spider::Spider() : Logging::Log("Spider") {
   ResourceManager* r = mAsset->rManager();
-  mMesh              = r->get<PhysicsMesh>("PhysicsMesh::Spider");
-  mElements          = mMesh->createCopyAll();
-  mParts             = SPIDER_PARTS;
-
-  for (auto& mesh : mElements->meshes) {
-    mElements->bodies[mesh.first]->setDeactivationTime(100000);
-    Drawable3D* child = new MeshPart(mesh.second,
-                                     mElements->bodies[mesh.first],
-                                     mElements->motions[mesh.first]);
-
-    child->setCollisionGroup(mParts[mesh.first].collisionGroup);
-    child->setCollisionMask(mParts[mesh.first].collisionMask);
-
-    for (auto& c : mElements->constraints[mesh.first]) {
-
-      // find hinge-constraint ref for each part
-      if (c->getConstraintType() ==
-          btTypedConstraintType::HINGE_CONSTRAINT_TYPE) {
-        auto* hinge = (btHingeConstraint*) c;
-
-        auto*       a = &(hinge->getRigidBodyA());
-        auto*       b = &(hinge->getRigidBodyB());
-        std::string nameA;
-        std::string nameB;
-
-        for (auto& m : mElements->bodies) {
-          if (m.second == a)
-            nameA = m.first;
-          if (m.second == b)
-            nameB = m.first;
-        }
-
-        if (nameA == mesh.first) {
-          mParts[mesh.first].hinge = hinge;
-        }
-      } else if (c->getConstraintType() ==
-                 btTypedConstraintType::D6_SPRING_CONSTRAINT_TYPE) {
-
-        auto* dof = (btGeneric6DofSpringConstraint*) c;
-
-        auto*       a = &(dof->getRigidBodyA());
-        auto*       b = &(dof->getRigidBodyB());
-        std::string nameA;
-        std::string nameB;
-
-        for (auto& m : mElements->bodies) {
-          if (m.second == a)
-            nameA = m.first;
-          if (m.second == b)
-            nameB = m.first;
-        }
-
-        if (nameA == mesh.first) {
-          mParts[mesh.first].dof = dof;
-        }
-      }
-
-      child->addConstraint(c);
-    }
-
-    mParts[mesh.first].part = child;
+  mMesh              = r->handle<PhysicsMesh>("PhysicsMesh::Spider");
+  mTemplate          = SpiderTemplate::get(mMesh.get());
+  mInstance          = mTemplate->instantiate();
+
+  const auto&        templateParts = mTemplate->parts();
+  std::vector<Part*> parts;
+  parts.reserve(templateParts.size());
+
+  // The parts of the template are sorted by name, so each one is inserted
+  // at the end of the map
+  for (size_t i = 0; i < templateParts.size(); ++i) {
+    const SpiderTemplate::Part& p = templateParts[i];
+    Drawable3D*                 child =
+      new MeshPart(p.subMesh, mInstance.bodies[i], mInstance.motions[i]);
+
+    child->setCollisionGroup(p.collisionGroup);
+    child->setCollisionMask(p.collisionMask);
+
+    auto part = mParts.emplace_hint(
+      mParts.end(),
+      p.name,
+      Part(p.collisionGroup, p.collisionMask, p.restAngle, p.active));
+
+    part->second.part = child;
+    parts.push_back(&part->second);
     mChildren.push_back(child);
-    child->updateFromPhysics();
   }
 
+  const auto& joints = mTemplate->joints();
+
+  for (size_t i = 0; i < joints.size(); ++i) {
+    const SpiderTemplate::Joint& joint = joints[i];
+    btTypedConstraint*           c     = mInstance.constraints[i];
 
-  if (!SPIDER_POSITIONS.size()) {
-    for (auto& mesh : mElements->meshes) {
-      SPIDER_POSITIONS[mesh.first] =
-        mParts[mesh.first].part->rigidBody()->getWorldTransform();
-    }
+    if (joint.type == btTypedConstraintType::HINGE_CONSTRAINT_TYPE)
+      parts[joint.a]->hinge = static_cast<btHingeConstraint*>(c);
+    else
+      parts[joint.a]->dof = static_cast<btGeneric6DofSpringConstraint*>(c);
+
+    mChildren[joint.a]->addConstraint(c);
+    mChildren[joint.b]->addConstraint(c);
   }
 
   mLog->debug("Spider loaded");
@@ -119,7 +95,7 @@ Spider::~Spider() {
   for (auto& c : mChildren)
     delete c;
 
-  mMesh->deleteCopy(mElements);
+  SpiderTemplate::destroy(mInstance);
 }
 
 /**
@@ -127,13 +103,15 @@ Spider::~Spider() {
  *   Resets the spiders position to the start state
  */
 void Spider::reset() {
-  btVector3 zero(0, 0, 0);
-  for (auto& part : mParts) {
-    btRigidBody* r = part.second.part->rigidBody();
+  btVector3   zero(0, 0, 0);
+  const auto& parts = mTemplate->parts();
+
+  for (size_t i = 0; i < parts.size(); ++i) {
+    btRigidBody* r = mInstance.bodies[i];
     r->clearForces();
     r->setAngularVelocity(zero);
     r->setLinearVelocity(zero);
-    r->setWorldTransform(SPIDER_POSITIONS[part.first]);
+    r->setWorldTransform(parts[i].transform);
     r->activate(true);
   }
 }
@@ -202,7 +180,6 @@ Spider* Spider::upcast(Drawable3D* drawable) {
   return dynamic_cast<Spider*>(drawable);
 }
 
-std::map<std::string, btTransform>  Spider::SPIDER_POSITIONS = {};
 std::map<std::string, Spider::Part> Spider::SPIDER_PARTS =
   { { "Abdomin",
       { 0b1000000000000000, 0b1011111111111111, radians(0), false } },
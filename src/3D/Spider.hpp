@@ -5,9 +5,10 @@
 
 #include "../Drawable/Drawable3D.hpp"
 #include "../Log.hpp"
+#include "../Resource/ResourceHandle.hpp"
+#include "SpiderTemplate.hpp"
 
 class PhysicsMesh;
-struct PhysicsElements;
 class Program;
 
 class btGeneric6DofSpringConstraint;
@@ -55,9 +56,8 @@ public:
   static std::map<std::string, Part> SPIDER_PARTS;
 
 private:
-  static std::map<std::string, btTransform> SPIDER_POSITIONS;
-
-  PhysicsElements*             mElements;
-  std::shared_ptr<PhysicsMesh> mMesh;
-  std::map<std::string, Part> mParts;
+  ResourceHandle<PhysicsMesh>           mMesh;
+  std::shared_ptr<const SpiderTemplate> mTemplate;
+  SpiderTemplate::Instance              mInstance;
+  std::map<std::string, Part>           mParts;
 };
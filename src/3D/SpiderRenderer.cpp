@@ -0,0 +1,253 @@
+#include "SpiderRenderer.hpp"
+
+#include "../GLSL/Program.hpp"
+#include "../Resource/Mesh.hpp"
+#include "MeshPart.hpp"
+#include "Spider.hpp"
+
+#include <cstring>
+
+// The first of the four locations used by the model matrix of an instance
+static const GLuint INSTANCE_LOCATION = 3;
+
+static const int INSTANCED_UNIFORM = Program::uniformId("instanced");
+
+static_assert(sizeof(mmm::mat4) == 16 * sizeof(float),
+              "Model matrices must be tightly packed");
+
+SpiderRenderer::SpiderRenderer()
+    : Logging::Log("SpiderRenderer")
+    , mBuffer(0)
+    , mCapacity(0)
+    , mDrawCalls(0)
+    , mCulled(0) {}
+
+SpiderRenderer::~SpiderRenderer() {
+  if (mBuffer != 0)
+    glDeleteBuffers(1, &mBuffer);
+}
+
+/**
+ * @brief
+ *   Removes every spider that has been added. The batches themselves are
+ *   kept, since the same spider mesh is used from frame to frame.
+ */
+void SpiderRenderer::clear() {
+  for (auto& batch : mBatches) {
+    batch.models.clear();
+    batch.bounds.clear();
+  }
+}
+
+/**
+ * @brief
+ *   Appends the model matrix of each part of the spider, taken straight
+ *   from its motion state. Parts without any vertices are skipped, just
+ *   like when they are drawn one by one.
+ *
+ * @param spider
+ * @param offset
+ * @param instances
+ */
+void SpiderRenderer::capture(Spider&                spider,
+                             const mmm::vec3&       offset,
+                             std::vector<Instance>& instances) {
+  spider.enableUpdatingFromPhysics();
+
+  for (auto child : spider.children()) {
+    MeshPart* part = dynamic_cast<MeshPart*>(child);
+
+    if (part == nullptr || part->subMesh()->size() == 0)
+      continue;
+
+    part->updateFromPhysics();
+    instances.push_back({ part->subMesh(), part->model(offset) });
+  }
+}
+
+/**
+ * @brief
+ *   Adds each instance to the batch of its submesh, together with the box
+ *   around it that is used to cull it.
+ *
+ * @param instances
+ */
+void SpiderRenderer::add(const std::vector<Instance>& instances) {
+  for (auto& instance : instances) {
+    auto it = mBatchIndex.find(instance.mesh);
+
+    if (it == mBatchIndex.end()) {
+      it = mBatchIndex.emplace(instance.mesh, mBatches.size()).first;
+      mBatches.push_back({ instance.mesh, {}, {} });
+    }
+
+    Batch& batch = mBatches[it->second];
+
+    // The matrices are stored by column, as OpenGL expects
+    batch.models.push_back(mmm::transpose(instance.model));
+    batch.bounds.push_back(instance.mesh->bounds().transformed(instance.model));
+  }
+}
+
+/**
+ * @brief
+ *   Draws all the parts that have been added and can be seen, with one
+ *   instanced draw call per material for each run of visible instances of
+ *   a submesh. Spiders are added one after another, so the parts of
+ *   spiders that are next to each other end up in the same run.
+ *
+ * @param program
+ * @param bindTexture
+ * @param frustum
+ */
+void SpiderRenderer::draw(std::shared_ptr<Program>& program,
+                          bool                      bindTexture,
+                          const Frustum&            frustum) {
+  mDrawCalls = 0;
+  mCulled    = 0;
+
+  if (numInstances() == 0)
+    return;
+
+  upload();
+
+  program->bind();
+  program->setUniform(INSTANCED_UNIFORM, true);
+
+  glBindBuffer(GL_ARRAY_BUFFER, mBuffer);
+
+  const Mesh* bound    = nullptr;
+  size_t      instance = 0;
+
+  for (auto& batch : mBatches) {
+    if (batch.models.empty())
+      continue;
+
+    const Mesh* mesh = batch.mesh->mesh();
+
+    if (mesh != bound) {
+      if (bound != nullptr)
+        bound->unbindVertexArray();
+
+      mesh->bindVertexArray();
+      bound = mesh;
+
+      for (GLuint i = 0; i < 4; ++i) {
+        glEnableVertexAttribArray(INSTANCE_LOCATION + i);
+        glVertexAttribDivisor(INSTANCE_LOCATION + i, 1);
+      }
+    }
+
+    size_t count = batch.models.size();
+    size_t start = 0;
+
+    while (start < count) {
+      if (!frustum.isVisible(batch.bounds[start])) {
+        mCulled += 1;
+        start += 1;
+        continue;
+      }
+
+      size_t end = start + 1;
+
+      while (end < count && frustum.isVisible(batch.bounds[end]))
+        end += 1;
+
+      setInstanceOffset(instance + start);
+      mDrawCalls +=
+        batch.mesh->drawInstanced(end - start, bindTexture ? 1 : -1);
+      start = end;
+    }
+
+    instance += count;
+  }
+
+  // The vertex array is shared with spiders that are drawn one by one,
+  // which read the model matrix from the uniform instead
+  for (GLuint i = 0; i < 4; ++i)
+    glDisableVertexAttribArray(INSTANCE_LOCATION + i);
+
+  bound->unbindVertexArray();
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  program->setUniform(INSTANCED_UNIFORM, false);
+}
+
+size_t SpiderRenderer::numInstances() const {
+  size_t size = 0;
+
+  for (auto& batch : mBatches)
+    size += batch.models.size();
+
+  return size;
+}
+
+size_t SpiderRenderer::numDrawCalls() const {
+  return mDrawCalls;
+}
+
+size_t SpiderRenderer::numCulled() const {
+  return mCulled;
+}
+
+/**
+ * @brief
+ *   Gathers the models of the batches into one list and uploads it. The
+ *   shadow pass and the main pass draw the same spiders, so the upload is
+ *   skipped when nothing has moved since the last draw. The buffer grows
+ *   when needed and is otherwise orphaned before being written to.
+ */
+void SpiderRenderer::upload() {
+  mInstances.clear();
+
+  for (auto& batch : mBatches)
+    mInstances.insert(mInstances.end(),
+                      batch.models.begin(),
+                      batch.models.end());
+
+  size_t bytes = mInstances.size() * sizeof(mmm::mat4);
+
+  if (mBuffer != 0 && mInstances.size() == mUploaded.size() &&
+      std::memcmp(mInstances.data(), mUploaded.data(), bytes) == 0)
+    return;
+
+  if (mBuffer == 0)
+    glGenBuffers(1, &mBuffer);
+
+  glBindBuffer(GL_ARRAY_BUFFER, mBuffer);
+
+  if (mInstances.size() > mCapacity)
+    mCapacity = mInstances.size();
+
+  glBufferData(GL_ARRAY_BUFFER,
+               mCapacity * sizeof(mmm::mat4),
+               nullptr,
+               GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, mInstances.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  mUploaded.swap(mInstances);
+}
+
+/**
+ * @brief
+ *   A model matrix is read as four columns from four locations. Since
+ *   OpenGL 3.3 cannot start an instanced draw at a given instance, the
+ *   attributes are pointed at the first instance of each batch instead.
+ *
+ * @param instance
+ */
+void SpiderRenderer::setInstanceOffset(size_t instance) {
+  size_t stride = sizeof(mmm::mat4);
+
+  for (GLuint i = 0; i < 4; ++i) {
+    size_t offset = instance * stride + i * 4 * sizeof(float);
+
+    glVertexAttribPointer(INSTANCE_LOCATION + i,
+                          4,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          stride,
+                          (void*) offset);
+  }
+}
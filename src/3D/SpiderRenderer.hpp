@@ -0,0 +1,107 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <mmm.hpp>
+
+#include "../Camera/Frustum.hpp"
+#include "../Log.hpp"
+#include "../OpenGLHeaders.hpp"
+#include "../Shape/BoundingBox.hpp"
+
+class Program;
+class Spider;
+class SubMesh;
+
+/**
+ * @brief
+ *   Draws many spiders at once by instancing their parts. Every spider
+ *   shares the same mesh, so instead of setting the model matrix and
+ *   drawing each part of each spider, the model matrices of all the parts
+ *   are gathered into one instance buffer, grouped by the submesh they
+ *   belong to. Each submesh is then drawn once per material for all the
+ *   spiders.
+ *
+ *   The spiders are added after `clear` and drawn with `draw`. Drawing the
+ *   same spiders with several programs, like in the shadow and the main
+ *   pass, only uploads the instance buffer once.
+ *
+ *   Spiders are added as instances captured by `capture`, which only reads
+ *   the physics of the spider. Capturing can therefore be done by the
+ *   thread that simulates the spiders, and the instances handed to the
+ *   thread that draws them.
+ *
+ *   Parts outside of the frustum given to `draw` are skipped. The visible
+ *   parts of a batch are drawn as runs of neighbouring instances, so the
+ *   instance buffer stays the same for every frustum and is still only
+ *   uploaded once.
+ *
+ *   The program must have the `instanced` uniform and read the model
+ *   matrix from location 3 when it is set, like the Model and Shadow
+ *   shaders.
+ */
+class SpiderRenderer : public Logging::Log {
+public:
+  //! A part of a spider, as it is drawn
+  struct Instance {
+    const SubMesh* mesh;
+    mmm::mat4      model;
+  };
+
+  SpiderRenderer();
+  ~SpiderRenderer();
+
+  // Removes every spider that has been added
+  void clear();
+
+  // Appends every part of the spider, moved by the offset, to instances
+  static void capture(Spider&                spider,
+                      const mmm::vec3&       offset,
+                      std::vector<Instance>& instances);
+
+  // Adds the captured instances
+  void add(const std::vector<Instance>& instances);
+
+  // Draws every part that has been added since the last clear and can be
+  // seen in the frustum
+  void draw(std::shared_ptr<Program>& program,
+            bool                      bindTexture,
+            const Frustum&            frustum = Frustum());
+
+  // Returns the number of parts that will be drawn
+  size_t numInstances() const;
+
+  // Returns the number of draw calls used by the last draw
+  size_t numDrawCalls() const;
+
+  // Returns the number of parts that were outside of the last frustum
+  size_t numCulled() const;
+
+private:
+  // Uploads the instances unless they are the same as last time
+  void upload();
+
+  // Points the instance attributes of the bound vertex array at the
+  // given instance
+  void setInstanceOffset(size_t instance);
+
+  struct Batch {
+    const SubMesh*           mesh;
+    std::vector<mmm::mat4>   models;
+    std::vector<BoundingBox> bounds;
+  };
+
+  std::vector<Batch>               mBatches;
+  std::map<const SubMesh*, size_t> mBatchIndex;
+
+  // All the models in the order of the batches, as uploaded
+  std::vector<mmm::mat4> mInstances;
+  std::vector<mmm::mat4> mUploaded;
+
+  GLuint mBuffer;
+  size_t mCapacity;
+  size_t mDrawCalls;
+  size_t mCulled;
+};
@@ -0,0 +1,273 @@
+#include "SpiderTemplate.hpp"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+#include "../Resource/Mesh.hpp"
+#include "../Resource/PhysicsMesh.hpp"
+#include "Spider.hpp"
+
+using RigidBodyInfo = btRigidBody::btRigidBodyConstructionInfo;
+
+namespace {
+  // The heavier parts of the body, every other part weighs 1
+  const std::map<std::string, btScalar> MASSES = { { "Abdomin", 10.0 },
+                                                   { "Sternum", 5.0 },
+                                                   { "Eye", 2.5 } };
+
+  const btScalar FRICTION = 0.84;
+}
+
+/**
+ * @brief
+ *   Builds the template from the rigid bodies, submeshes and constraints of
+ *   the physics mesh. Parts are sorted by name, so that they are in the same
+ *   order as the parts of Spider.
+ *
+ * @param mesh
+ */
+SpiderTemplate::SpiderTemplate(const std::shared_ptr<PhysicsMesh>& mesh)
+    : Logging::Log("SpiderTemplate")
+    , mMesh(mesh)
+    , mGeneration(mesh->generation()) {
+  for (auto& element : mMesh->getAll()) {
+    const std::string&    name = element.first;
+    const SubMeshPhysics& sub  = element.second;
+
+    if (sub.body == nullptr) {
+      mLog->warn("Part '{}' has no rigid body, skipping it", name);
+      continue;
+    }
+
+    Part part;
+    part.name    = name;
+    part.subMesh = sub.subMesh;
+    part.shape   = sub.body->getCollisionShape();
+    part.mass    = MASSES.count(name) ? MASSES.at(name) : 1.0;
+
+    part.shape->calculateLocalInertia(part.mass, part.inertia);
+
+    btMatrix3x3      mat;
+    const mmm::mat4& t      = sub.subMesh->transform();
+    const mmm::vec3& matPos = mmm::dropColumns<3>(t).xyz;
+
+    // TODO fix static +2 up translation
+    mat.setFromOpenGLSubMatrix(mmm::transpose(t).rawdata);
+    part.transform =
+      btTransform(mat, btVector3(matPos.x, matPos.y + 1, matPos.z));
+
+    Spider::Part descriptor;
+
+    if (Spider::SPIDER_PARTS.count(name))
+      descriptor = Spider::SPIDER_PARTS.at(name);
+
+    part.collisionGroup = descriptor.collisionGroup;
+    part.collisionMask  = descriptor.collisionMask;
+    part.restAngle      = descriptor.restAngle;
+    part.active         = descriptor.active;
+
+    mParts.push_back(part);
+  }
+
+  std::sort(mParts.begin(), mParts.end(), [](const Part& a, const Part& b) {
+    return a.name < b.name;
+  });
+
+  std::map<const btRigidBody*, size_t> indices;
+
+  for (auto& element : mMesh->getAll()) {
+    for (size_t i = 0; i < mParts.size(); ++i)
+      if (mParts[i].name == element.first)
+        indices[element.second.body] = i;
+  }
+
+  // Only the constraint types used by the spider are supported, since each
+  // type stores its frames and limits differently
+  for (auto& c : mMesh->constraints()) {
+    auto a = indices.find(&c->getRigidBodyA());
+    auto b = indices.find(&c->getRigidBodyB());
+
+    if (a == indices.end() || b == indices.end()) {
+      mLog->error("Constraint between bodies that are not parts, skipping");
+      continue;
+    }
+
+    Joint joint;
+    joint.type               = c->getConstraintType();
+    joint.a                  = a->second;
+    joint.b                  = b->second;
+    joint.useReferenceFrameA = true;
+    joint.angularOnly        = false;
+    joint.hasLimit           = false;
+    joint.lowerLimit         = btVector3(0, 0, 0);
+    joint.upperLimit         = btVector3(0, 0, 0);
+    joint.angularLowerLimit  = btVector3(0, 0, 0);
+    joint.angularUpperLimit  = btVector3(0, 0, 0);
+
+    switch (joint.type) {
+      case btTypedConstraintType::HINGE_CONSTRAINT_TYPE: {
+        auto* h = static_cast<btHingeConstraint*>(c);
+
+        // The angular only flag of the file is ignored, as spiders have
+        // always been created with hinges that are not angular only
+        joint.frameA             = h->getAFrame();
+        joint.frameB             = h->getBFrame();
+        joint.useReferenceFrameA = h->getUseReferenceFrameA();
+        joint.hasLimit           = h->hasLimit();
+        joint.angularLowerLimit.setX(h->getLowerLimit());
+        joint.angularUpperLimit.setX(h->getUpperLimit());
+        break;
+      }
+      case btTypedConstraintType::D6_SPRING_CONSTRAINT_TYPE: {
+        auto* d = static_cast<btGeneric6DofSpringConstraint*>(c);
+
+        joint.frameA = d->getFrameOffsetA();
+        joint.frameB = d->getFrameOffsetB();
+        d->getLinearLowerLimit(joint.lowerLimit);
+        d->getLinearUpperLimit(joint.upperLimit);
+        d->getAngularLowerLimit(joint.angularLowerLimit);
+        d->getAngularUpperLimit(joint.angularUpperLimit);
+        break;
+      }
+      default:
+        mLog->error("No duplication handler for constraint type {}",
+                    static_cast<int>(joint.type));
+        continue;
+    }
+
+    mJoints.push_back(joint);
+  }
+
+  mLog->debug("Built with {} parts and {} joints",
+              mParts.size(),
+              mJoints.size());
+}
+
+/**
+ * @brief
+ *   Returns the template of the physics mesh. The template is shared by
+ *   every spider. It is built again once the last spider using it is gone,
+ *   or once the mesh has been unloaded, since the shapes of the template
+ *   belonged to the bodies that were unloaded.
+ *
+ * @param mesh
+ *
+ * @return
+ */
+std::shared_ptr<const SpiderTemplate>
+SpiderTemplate::get(const std::shared_ptr<PhysicsMesh>& mesh) {
+  static std::mutex mutex;
+  static std::map<const PhysicsMesh*, std::weak_ptr<const SpiderTemplate>>
+    templates;
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  auto& cached   = templates[mesh.get()];
+  auto  existing = cached.lock();
+
+  if (existing != nullptr && existing->mGeneration == mesh->generation())
+    return existing;
+
+  auto created = std::make_shared<SpiderTemplate>(mesh);
+  cached       = created;
+  return created;
+}
+
+/**
+ * @brief
+ *   Creates the rigid bodies, motion states and constraints of a spider.
+ *   Bodies and motions are in the order of `parts` and constraints in the
+ *   order of `joints`.
+ *
+ *   Only the template is read, so this can be called from several threads
+ *   at the same time.
+ *
+ * @return
+ */
+SpiderTemplate::Instance SpiderTemplate::instantiate() const {
+  Instance instance;
+  instance.bodies.reserve(mParts.size());
+  instance.motions.reserve(mParts.size());
+  instance.constraints.reserve(mJoints.size());
+
+  for (auto& part : mParts) {
+    btMotionState* motion = new btDefaultMotionState(part.transform);
+
+    auto info =
+      RigidBodyInfo(part.mass, motion, part.shape, part.inertia);
+    info.m_friction = FRICTION;
+
+    btRigidBody* body = new btRigidBody(info);
+    body->setDeactivationTime(100000);
+
+    instance.bodies.push_back(body);
+    instance.motions.push_back(motion);
+  }
+
+  for (auto& joint : mJoints) {
+    btRigidBody&       a = *instance.bodies[joint.a];
+    btRigidBody&       b = *instance.bodies[joint.b];
+    btTypedConstraint* c = nullptr;
+
+    if (joint.type == btTypedConstraintType::HINGE_CONSTRAINT_TYPE) {
+      auto* h = new btHingeConstraint(a,
+                                      b,
+                                      joint.frameA,
+                                      joint.frameB,
+                                      joint.useReferenceFrameA);
+      h->setAngularOnly(joint.angularOnly);
+
+      if (joint.hasLimit)
+        h->setLimit(joint.angularLowerLimit.x(), joint.angularUpperLimit.x());
+
+      c = h;
+    } else {
+      auto* d = new btGeneric6DofSpringConstraint(a,
+                                                  b,
+                                                  joint.frameA,
+                                                  joint.frameB,
+                                                  joint.useReferenceFrameA);
+      d->setLinearLowerLimit(joint.lowerLimit);
+      d->setLinearUpperLimit(joint.upperLimit);
+      d->setAngularLowerLimit(joint.angularLowerLimit);
+      d->setAngularUpperLimit(joint.angularUpperLimit);
+
+      c = d;
+    }
+
+    instance.constraints.push_back(c);
+  }
+
+  return instance;
+}
+
+/**
+ * @brief
+ *   Deletes everything created by `instantiate`. The bodies and constraints
+ *   must have been removed from the world first.
+ *
+ * @param instance
+ */
+void SpiderTemplate::destroy(Instance& instance) {
+  for (auto& c : instance.constraints)
+    delete c;
+
+  for (auto& b : instance.bodies)
+    delete b;
+
+  for (auto& m : instance.motions)
+    delete m;
+
+  instance.constraints.clear();
+  instance.bodies.clear();
+  instance.motions.clear();
+}
+
+const std::vector<SpiderTemplate::Part>& SpiderTemplate::parts() const {
+  return mParts;
+}
+
+const std::vector<SpiderTemplate::Joint>& SpiderTemplate::joints() const {
+  return mJoints;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <btBulletDynamicsCommon.h>
+
+#include "../Log.hpp"
+
+class PhysicsMesh;
+class SubMesh;
+
+/**
+ * @brief
+ *   Everything needed to create the physics of a spider, derived once from
+ *   the PhysicsMesh and Spider::SPIDER_PARTS.
+ *
+ *   Names, masses, inertia, constraint frames and collision masks are all
+ *   resolved when the template is built, and joints refer to parts by their
+ *   index. Creating a spider is then a loop over the parts and joints that
+ *   only allocates the Bullet objects. The template is never changed after
+ *   it has been built, so any number of threads can call `instantiate` at
+ *   once. Nothing else about the template or the PhysicsMesh is thread
+ *   safe.
+ *
+ *   The collision shapes are shared between every spider. They are owned by
+ *   the PhysicsMesh, which the template keeps alive, and are gone once the
+ *   mesh is unloaded.
+ */
+class SpiderTemplate : public Logging::Log {
+public:
+  //! A rigid body of the spider together with the part it is drawn as.
+  //! The transform is both the start and the rest position of the part.
+  struct Part {
+    std::string       name;
+    const SubMesh*    subMesh;
+    btCollisionShape* shape;
+    btScalar          mass;
+    btVector3         inertia;
+    btTransform       transform;
+    unsigned short    collisionGroup;
+    unsigned short    collisionMask;
+    float             restAngle;
+    bool              active;
+  };
+
+  //! A constraint between two parts, where `a` is the part it belongs to.
+  //! Hinges only use the x component of the angular limits.
+  struct Joint {
+    btTypedConstraintType type;
+    size_t                a;
+    size_t                b;
+    btTransform           frameA;
+    btTransform           frameB;
+    bool                  useReferenceFrameA;
+    bool                  angularOnly;
+    bool                  hasLimit;
+    btVector3             lowerLimit;
+    btVector3             upperLimit;
+    btVector3             angularLowerLimit;
+    btVector3             angularUpperLimit;
+  };
+
+  //! The physics of one spider, indexed the same way as the template
+  struct Instance {
+    std::vector<btRigidBody*>       bodies;
+    std::vector<btMotionState*>     motions;
+    std::vector<btTypedConstraint*> constraints;
+  };
+
+  SpiderTemplate(const std::shared_ptr<PhysicsMesh>& mesh);
+
+  // Returns the template of the mesh, building it if no spider is using it
+  // or if the mesh has been unloaded since it was built
+  static std::shared_ptr<const SpiderTemplate>
+  get(const std::shared_ptr<PhysicsMesh>& mesh);
+
+  // Creates the bodies and constraints of a new spider
+  Instance instantiate() const;
+
+  // Deletes the bodies and constraints, which must not be in a world
+  static void destroy(Instance& instance);
+
+  const std::vector<Part>&  parts() const;
+  const std::vector<Joint>& joints() const;
+
+private:
+  std::shared_ptr<PhysicsMesh> mMesh;
+  unsigned int                 mGeneration;
+  std::vector<Part>            mParts;
+  std::vector<Joint>           mJoints;
+};
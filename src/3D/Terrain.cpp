@@ -16,6 +16,8 @@ using mmm::vec3;
 using mmm::mat4;
 using RigidBodyInfo = btRigidBody::btRigidBodyConstructionInfo;
 
+static const int MODEL_UNIFORM = Program::uniformId("model");
+
 Terrain::Terrain() : Logging::Log("Terrain") {
   mGrid   = new GLGrid3D(vec2(16, 16));
   mShape  = new btStaticPlaneShape(btVector3(0, 1, 0), 1);
@@ -32,6 +34,9 @@ Terrain::Terrain() : Logging::Log("Terrain") {
   mTexture->repeat();
   /* mScale = mmm::scale(38.0f, 0.0f, 38.0f); */
   mScale = mmm::scale(64.0f, 0.0f, 64.0f);
+
+  // The grid is flat and one unit wide before it is scaled
+  mBounds = BoundingBox(vec3(-0.5, 0, -0.5), vec3(0.5, 0, 0.5));
 }
 
 Terrain::~Terrain() {
@@ -50,11 +55,8 @@ void Terrain::draw(std::shared_ptr<Program>& program, bool bindTexture) {
 void Terrain::draw(std::shared_ptr<Program>& program,
                    mmm::vec3                 offset,
                    bool                      bindTexture) {
-  mat4 model =
-    mmm::translate(mPosition + vec3(0, 1, 0) + offset) * mRotation * mScale;
-
   program->bind();
-  program->setUniform("model", model);
+  program->setUniform(MODEL_UNIFORM, model(offset));
 
   if (bindTexture)
     mTexture->bind(1);
@@ -62,3 +64,12 @@ void Terrain::draw(std::shared_ptr<Program>& program,
 }
 
 void Terrain::input(const Input::Event&) {}
+
+BoundingBox Terrain::bounds() const {
+  return mBounds.transformed(model(vec3(0)));
+}
+
+mat4 Terrain::model(const vec3& offset) const {
+  return mmm::translate(mPosition + vec3(0, 1, 0) + offset) * mRotation *
+         mScale;
+}
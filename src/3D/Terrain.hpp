@@ -27,7 +27,12 @@ public:
   // Input handler
   void input(const Input::Event& event);
 
+  // Returns the box around the grid, as it is drawn
+  BoundingBox bounds() const;
+
 private:
+  mmm::mat4 model(const mmm::vec3& offset) const;
+
   GLGrid3D*                mGrid;
   std::shared_ptr<Texture> mTexture;
 };
@@ -1,10 +1,7 @@
 #include "Text3D.hpp"
 
 #include "../Camera/Camera.hpp"
-#include "../GLSL/Program.hpp"
-#include "../Resource/Font.hpp"
-#include "../Resource/ResourceManager.hpp"
-#include "../Resource/Texture.hpp"
+#include "../GUI/TextRenderer.hpp"
 #include "../Utils/Asset.hpp"
 #include "../Utils/CFG.hpp"
 #include "../Utils/Utils.hpp"
@@ -13,7 +10,6 @@ Text3D::Text3D(const std::string& font,
                const std::string& text,
                const mmm::vec3&   position)
     : Text(font, text, mmm::vec2(0), 300) {
-  mFont3DProgram = mAsset->rManager()->get<Program>("Program::Font3D");
   setPosition(position);
 }
 
@@ -45,40 +41,18 @@ void Text3D::setPosition(const mmm::vec3& position) {
 
 /**
  * @brief
- *   Draws the 3D text
+ *   Draws the 3D text through the TextRenderer. It is drawn right away
+ *   unless the caller has started a batch
  */
 void Text3D::draw(mmm::vec3 offset) {
-  Camera*          camera = mAsset->camera();
-  const mmm::mat4& proj   = camera->projection();
-  const mmm::mat4& view   = camera->view();
+  if (!isVisible())
+    return;
 
-  mmm::vec3 cameraRight = { view[0][0], view[0][1], view[0][2] };
-  mmm::vec3 cameraUp    = { view[1][0], view[1][1], view[1][2] };
+  Camera* camera = mAsset->camera();
 
-  mFont3DProgram->bind();
-  mFont3DProgram->setUniform("MVP", proj * view * mmm::mat4::identity);
-  mFont3DProgram->setUniform("cameraRight", cameraRight);
-  mFont3DProgram->setUniform("cameraUp", cameraUp);
+  // Background needs a slight offset depending on the inverse of camera
+  // viewpoint since it needs to be behind the text
+  mmm::vec3 backgroundOffset = (camera->target() - camera->position()) * 0.01;
 
-  if (mHasBackgroundColor) {
-    // Background needs a slight offset depending on the inverse of camera
-    // viewpoint
-    // since it needs to be behind the text
-    mmm::vec3 backgroundOffset = (camera->target() - camera->position()) * 0.01;
-    mFont3DProgram->setUniform("worldPosition",
-                               mPosition + offset + backgroundOffset);
-    mFont3DProgram->setUniform("isBackground", true);
-
-    glBindVertexArray(mVAOBackground);
-    glDrawArrays(GL_TRIANGLES, 0, mNumVerticesBackground);
-    glBindVertexArray(0);
-  }
-
-  mFont3DProgram->setUniform("worldPosition", mPosition + offset);
-  mTextFont->getTexture(mCharacterSize)->bind(1);
-  mFont3DProgram->setUniform("isBackground", false);
-
-  glBindVertexArray(mVAO);
-  glDrawArrays(GL_TRIANGLES, 0, mNumVertices);
-  glBindVertexArray(0);
+  mAsset->textRenderer()->draw(*this, mPosition + offset, backgroundOffset);
 }
@@ -22,6 +22,5 @@ public:
   void draw(mmm::vec3 offset = mmm::vec3(0, 0, 0));
 
 private:
-  std::shared_ptr<Program> mFont3DProgram;
-  mmm::vec3                mPosition;
+  mmm::vec3 mPosition;
 };
@@ -44,7 +44,7 @@ Camera::Camera(Asset* asset)
   mModelProgram  = mAsset->rManager()->get<Program>("Program::Model");
   update(0);
 
-  setMVPUniforms(mModelProgram);
+  mModelProgram->setUniform("model", mModel);
 }
 
 /**
@@ -71,52 +71,6 @@ mat4 Camera::updateProjectionMatrix() const {
                                    mAsset->cfg()->graphics.viewDistance);
 }
 
-/**
- * @brief
- *   Sets a uniform of `name` in `program` to the MVP value calculated
- *   by multiplying projection, view and model together
- *
- *   This uses the Light's MVP.
- *
- * @param program the program to set the variable in
- * @param name the name of the uniform variable.
- */
-void Camera::setLightMVPUniform(std::shared_ptr<Program> program,
-                                const std::string&       name) {
-  program->setUniform(name, mLight.projection * mLight.view * mLight.model);
-}
-
-/**
- * @brief
- *   Sets three uniforms that is expected to be within a struct. The struct
- *   is expected to have three members, `model`, `view` and `proj`, all
- *   of which are mat4 types.
- *
- *   The `name` indicates the name of an instance of the structure.
- *
- * @param program
- * @param name
- */
-void Camera::setLightMVPUniforms(std::shared_ptr<Program> program,
-                                 const std::string&       name) {
-  program->setUniform(name + ".model", mLight.model);
-  setLightVPUniforms(program, name);
-}
-
-/**
- * @brief
- *   Does the same as the function above, but does not set
- *   the `model` type.
- *
- * @param program
- * @param name
- */
-void Camera::setLightVPUniforms(std::shared_ptr<Program> program,
-                                const std::string&       name) {
-  program->setUniform(name + ".view", mLight.view);
-  program->setUniform(name + ".proj", mLight.projection);
-}
-
 /**
  * @brief
  *   Sets a uniform of `name` in `program` to the MVP value calculated
@@ -134,17 +88,13 @@ void Camera::setMVPUniform(std::shared_ptr<Program> program,
 
 /**
  * @brief
- *   This function expects to find three different uniform mat4
- *   variables in the given program with name `model`, `view`
- *   and `proj` and sets them to be the model matrix, view matrix
- *   and projection matrix, respectively.
- *
- * @param program
+ *   Uploads the view and projection of the camera and its light into the
+ *   uniform buffer that every program reads them from. Must be called
+ *   once per frame, after the camera has been updated and before anything
+ *   is drawn.
  */
-void Camera::setMVPUniforms(std::shared_ptr<Program> program) {
-  program->setUniform("model", mModel);
-  program->setUniform("view", mView);
-  program->setUniform("proj", mProjection);
+void Camera::uploadFrameUniforms() {
+  mFrameUniforms.update(*this);
 }
 
 /**
@@ -198,6 +148,28 @@ const vec3& Camera::target() const {
   return mTarget;
 }
 
+/**
+ * @brief
+ *   Returns the frustum of the view and projection of the camera, as of
+ *   the last update
+ *
+ * @return
+ */
+Frustum Camera::frustum() const {
+  return Frustum(mProjection * mView);
+}
+
+/**
+ * @brief
+ *   Returns the frustum of the light. Objects outside of it do not cast
+ *   shadows that end up in the shadow map.
+ *
+ * @return
+ */
+Frustum Camera::lightFrustum() const {
+  return Frustum(mLight.projection * mLight.view);
+}
+
 /**
  * @brief
  *   Returns a const reference to the position vector
@@ -4,7 +4,9 @@
 #include <mmm.hpp>
 #include <string>
 
+#include "../GLSL/FrameUniforms.hpp"
 #include "../Log.hpp"
+#include "Frustum.hpp"
 
 class Asset;
 class Program;
@@ -34,21 +36,11 @@ public:
   mmm::mat4 updateViewMatrix() const;
   mmm::mat4 updateProjectionMatrix() const;
 
-  void setLightVPUniforms(std::shared_ptr<Program> program,
-                          const std::string&       name = "light");
-
-  void setLightMVPUniform(std::shared_ptr<Program> program,
-                          const std::string&       name = "lightMVP");
-
-  void setLightMVPUniforms(std::shared_ptr<Program> program,
-                           const std::string&       name = "light");
-
   void setMVPUniform(std::shared_ptr<Program> program,
                      const std::string&       name = "MVP");
 
-  // sets the model, view, projection matrices as separate
-  // variables called model, view and proj
-  void setMVPUniforms(std::shared_ptr<Program> program);
+  // Uploads the camera and light matrices that every program shares
+  void uploadFrameUniforms();
 
   // returns the light instance
   const Light& light() const;
@@ -68,6 +60,12 @@ public:
   // returns the target vector
   const mmm::vec3& target() const;
 
+  // Returns what can be seen by the camera
+  Frustum frustum() const;
+
+  // Returns what is covered by the shadow map of the light
+  Frustum lightFrustum() const;
+
   void setPosition(const mmm::vec3& position);
   void setTarget(const mmm::vec3& target);
 
@@ -104,4 +102,6 @@ private:
   float mMinViewDistance;
   float mFieldOfView;
   Light mLight;
+
+  FrameUniforms mFrameUniforms;
 };
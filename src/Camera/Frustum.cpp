@@ -0,0 +1,50 @@
+#include "Frustum.hpp"
+
+#include "../Shape/BoundingBox.hpp"
+
+Frustum::Frustum()
+    : mViewProjection(mmm::mat4::identity), mContainsAll(true) {}
+
+Frustum::Frustum(const mmm::mat4& viewProjection)
+    : mViewProjection(viewProjection), mContainsAll(false) {}
+
+/**
+ * @brief
+ *   Checks the corners of the box against each side of the frustum. Empty
+ *   boxes are never visible.
+ *
+ * @param box
+ *
+ * @return
+ */
+bool Frustum::isVisible(const BoundingBox& box) const {
+  if (box.isEmpty())
+    return false;
+
+  if (mContainsAll)
+    return true;
+
+  // One bit per side of the frustum that every corner so far is outside of
+  int outside = 0x3f;
+
+  for (int i = 0; i < 8 && outside != 0; ++i) {
+    mmm::vec4 c = mViewProjection *
+                  mmm::vec4((i & 1) ? box.max.x : box.min.x,
+                            (i & 2) ? box.max.y : box.min.y,
+                            (i & 4) ? box.max.z : box.min.z,
+                            1);
+
+    int sides = 0;
+
+    sides |= (c.x < -c.w) ? 0x01 : 0;
+    sides |= (c.x > c.w) ? 0x02 : 0;
+    sides |= (c.y < -c.w) ? 0x04 : 0;
+    sides |= (c.y > c.w) ? 0x08 : 0;
+    sides |= (c.z < -c.w) ? 0x10 : 0;
+    sides |= (c.z > c.w) ? 0x20 : 0;
+
+    outside &= sides;
+  }
+
+  return outside == 0;
+}
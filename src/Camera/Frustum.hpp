@@ -0,0 +1,32 @@
+#pragma once
+
+#include <mmm.hpp>
+
+struct BoundingBox;
+
+/**
+ * @brief
+ *   The volume that can be seen through a view and projection, used to skip
+ *   drawing objects that are outside of it.
+ *
+ *   Boxes are tested by moving their corners into clip space, where the
+ *   frustum is the cube from -w to w. A box is only outside when all of its
+ *   corners are outside the same side, so a few boxes near the corners of
+ *   the frustum are drawn even though they cannot be seen, but a box that
+ *   can be seen is never skipped.
+ */
+class Frustum {
+public:
+  // Creates a frustum that contains everything
+  Frustum();
+
+  // Creates the frustum of projection * view
+  Frustum(const mmm::mat4& viewProjection);
+
+  // Returns whether any part of the box may be inside the frustum
+  bool isVisible(const BoundingBox& box) const;
+
+private:
+  mmm::mat4 mViewProjection;
+  bool      mContainsAll;
+};
@@ -5,6 +5,7 @@
 #include "../GLSL/Program.hpp"
 #include "../GUI/Menu.hpp"
 #include "../GUI/Text.hpp"
+#include "../GUI/TextRenderer.hpp"
 #include "../Input/Event.hpp"
 #include "../Input/Input.hpp"
 #include "../Lua/Lua.hpp"
@@ -521,14 +522,21 @@ void Console::draw() {
   mProgram->bind();
   mRect->draw();
 
-  if (mShowAutoComplete) {
+  if (mShowAutoComplete)
     mAutoCompleteBox->draw();
+
+  // All the text is drawn over the boxes, so every line of history can
+  // be drawn together
+  mAsset->textRenderer()->begin();
+
+  if (mShowAutoComplete)
     mAutoComplete->draw();
-  }
 
   mText->draw();
 
   for (auto a : mHistory) {
     a->draw();
   }
+
+  mAsset->textRenderer()->end();
 }
@@ -1,6 +1,7 @@
 #include "Drawable3D.hpp"
 
 #include "../Camera/Camera.hpp"
+#include "../Camera/Frustum.hpp"
 #include "Graphical/Framebuffer.hpp"
 
 #include <btBulletDynamicsCommon.h>
@@ -103,6 +104,36 @@ void Drawable3D::disableUpdatingFromPhysics() {
     child->disableUpdatingFromPhysics();
 }
 
+/**
+ * @brief
+ *   Returns the bounds of the object moved, rotated and scaled the way most
+ *   objects are drawn. Objects that are drawn differently should override
+ *   this.
+ *
+ * @return
+ */
+BoundingBox Drawable3D::bounds() const {
+  return mBounds.transformed(mmm::translate(mPosition) * mRotation * mScale);
+}
+
+bool Drawable3D::isVisible(const Frustum& frustum) const {
+  if (mBounds.isEmpty())
+    return true;
+
+  return frustum.isVisible(bounds());
+}
+
+/**
+ * @brief
+ *   Static objects are not moved by bullet, which is the case for objects
+ *   without mass, like the terrain.
+ *
+ * @return
+ */
+bool Drawable3D::isStatic() const {
+  return mBody != nullptr && mBody->isStaticObject();
+}
+
 /**
  * @brief
  *   Returns the stored position that is often updated by
@@ -6,6 +6,8 @@
 #include <mmm.hpp>
 #include <vector>
 
+#include "../Shape/BoundingBox.hpp"
+
 class btRigidBody;
 class btCollisionShape;
 class btMotionState;
@@ -14,6 +16,7 @@ class btTypedConstraint;
 class Asset;
 class Camera;
 class Framebuffer;
+class Frustum;
 class Program;
 
 namespace Input {
@@ -53,6 +56,17 @@ public:
   // to have physics
   bool hasPhysics() const;
 
+  // Returns the box around the object in world coordinates, which is
+  // empty if the size of the object is not known
+  virtual BoundingBox bounds() const;
+
+  // Returns whether the object can be seen in the frustum. Objects
+  // without bounds are always visible
+  bool isVisible(const Frustum& frustum) const;
+
+  // Returns whether the object never moves, such as objects without mass
+  bool isStatic() const;
+
   // Returns the position of the object
   const mmm::vec3& position() const;
 
@@ -126,6 +140,9 @@ protected:
   std::vector<btTypedConstraint*> mConstraints;
   std::vector<Drawable3D*>        mChildren;
 
+  // The box around the object before it is moved, rotated and scaled
+  BoundingBox mBounds;
+
   bool mUpdateFromPhysics;
   int  mCollisionGroup;
   int  mCollisionMask;
@@ -6,13 +6,17 @@
 #include "Drawable/Drawable.hpp"
 #include "GLSL/Shader.hpp"
 #include "GUI/GUI.hpp"
+#include "GUI/TextRenderer.hpp"
+#include "Graphical/FrameCapture.hpp"
 #include "Graphical/Framebuffer.hpp"
 #include "Input/Event.hpp"
 #include "Input/Input.hpp"
 #include "Lua/Lua.hpp"
 #include "Resource/ResourceManager.hpp"
+#include "State/Exporter.hpp"
 #include "State/MainMenu.hpp"
 #include "State/Master.hpp"
+#include "State/Worker.hpp"
 #include "Utils/Asset.hpp"
 #include "Utils/CFG.hpp"
 #include "Utils/Utils.hpp"
@@ -69,6 +73,8 @@ Engine::Engine(std::string cfgPath)
     , mAsset(nullptr)
     , mLua(nullptr)
     , mResourceManager(nullptr)
+    , mTextRenderer(nullptr)
+    , mFrameCapture(nullptr)
     , mWindowRefresh(false) {}
 
 Engine::~Engine() {
@@ -174,6 +180,13 @@ bool Engine::initialize(int argc, char* argv[], int isRefresh, int initState) {
 
   mResourceManager->loadDescription("./media/resources.lua");
 
+  mTextRenderer = new TextRenderer(mAsset);
+  mAsset->setTextRenderer(mTextRenderer);
+
+  mFrameCapture = new FrameCapture(mCFG);
+  mAsset->setFrameCapture(mFrameCapture);
+  mLua->add(mFrameCapture);
+
   Drawable::mAsset = mAsset;
   GUI::mAsset      = mAsset;
   Shader::mCFG     = mCFG;
@@ -257,8 +270,15 @@ bool Engine::initWindow() {
   // If window mode, do decorated
   glfwWindowHint(GLFW_DECORATED, isFullscreen ? GL_FALSE : GL_TRUE);
 
+  // Workers and exports never draw anything, but still need a
+  // context to load the meshes of the spiders
+  bool isHeadless = !mWorkerAddress.empty() || !mExportGenome.empty();
+
+  if (isHeadless)
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+
   // get monitor, may be null, but thats okay since glfw supports it
-  GLFWmonitor* monitor = getMonitor();
+  GLFWmonitor* monitor = isHeadless ? NULL : getMonitor();
   mWindow              = glfwCreateWindow((int) mCFG->graphics.res.x,
                              (int) mCFG->graphics.res.y,
                              "Wooooo",
@@ -368,6 +388,17 @@ void Engine::deinitialize(bool isFullDeinit) {
     mCurrent = nullptr;
   }
 
+  if (mTextRenderer != nullptr) {
+    delete mTextRenderer;
+    mTextRenderer = nullptr;
+  }
+
+  // Writes the frames that are still being captured
+  if (mFrameCapture != nullptr) {
+    delete mFrameCapture;
+    mFrameCapture = nullptr;
+  }
+
   mResourceManager->unloadAll();
 
   mCFG->writetoFile("config/config.ini");
@@ -427,14 +458,27 @@ void Engine::runLoop() {
   static int   numFrames = 30;
   static float loopTime  = 1.0 / float(numFrames);
 
+  // How much of each frame may be spent uploading resources that have
+  // been loaded in the background
+  static float loadTime = loopTime / 4;
+
   while (!glfwWindowShouldClose(mWindow)) {
     float currentTime = glfwGetTime();
     float deltaTime   = currentTime - startTime;
     startTime         = currentTime;
 
+    // Captured frames are a fixed time apart, however long they take to
+    // draw, so that the video plays at the speed it was simulated at
+    if (mFrameCapture->isCapturing())
+      deltaTime = mFrameCapture->frameTime();
+
+    mResourceManager->update(loadTime);
+
     // Update the stack if available
     mCurrent->update(deltaTime);
 
+    mFrameCapture->beginFrame();
+
     // Clear everything
     // glClearColor(0, 0.4, 0.7, 1);
     // glClearColor(0.15, 0.15, 0.18, 1);
@@ -445,13 +489,16 @@ void Engine::runLoop() {
 
     mCurrent->draw(deltaTime);
 
+    mFrameCapture->endFrame();
+
     glfwSwapBuffers(mWindow);
     glfwPollEvents();
 
     float remainingLoopTime = loopTime - (glfwGetTime() - currentTime);
 
-    // Lock FPS to specific duration. See comment before loop started
-    if (remainingLoopTime > 0) {
+    // Lock FPS to specific duration. See comment before loop started.
+    // Frames that are captured are drawn as fast as possible instead
+    if (remainingLoopTime > 0 && !mFrameCapture->isCapturing()) {
       std::chrono::milliseconds ms(int(remainingLoopTime * 1000));
       std::this_thread::sleep_for(ms);
     }
@@ -536,6 +583,13 @@ void Engine::changeState(int newState) {
     case States::MasterThesis:
       mCurrent = new Master(mAsset);
       break;
+    case States::Worker:
+      mCurrent = new Worker(mAsset, mWorkerAddress);
+      break;
+    case States::Exporter:
+      mCurrent = new Exporter(
+        mAsset, mExportExperiment, mExportGenome, mExportFilename);
+      break;
     default:
       throw std::runtime_error("No state! THROW FIT. (╯°□°）╯︵ ┻━┻)");
   }
@@ -551,3 +605,33 @@ void Engine::closeWindow() {
   mLog->info("Now closing GLFW window..");
   glfwSetWindowShouldClose(mWindow, GL_TRUE);
 }
+
+/**
+ * @brief
+ *   Sets the address of the master to connect to. When set, the window
+ *   is created hidden and the engine should be initialized with
+ *   States::Worker as the initial state.
+ *
+ * @param address
+ */
+void Engine::setWorkerAddress(const std::string& address) {
+  mWorkerAddress = address;
+}
+
+/**
+ * @brief
+ *   Sets the genome to export and the file to export it to. When set,
+ *   the window is created hidden and the engine should be initialized
+ *   with States::Exporter as the initial state.
+ *
+ * @param experiment
+ * @param genome
+ * @param filename
+ */
+void Engine::setExport(const std::string& experiment,
+                       const std::string& genome,
+                       const std::string& filename) {
+  mExportExperiment = experiment;
+  mExportGenome     = genome;
+  mExportFilename   = filename;
+}
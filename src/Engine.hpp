@@ -10,6 +10,8 @@ class Asset;
 class CFG;
 class ResourceManager;
 class State;
+class TextRenderer;
+class FrameCapture;
 
 struct GLFWmonitor;
 struct GLFWwindow;
@@ -61,6 +63,16 @@ public:
 
   void closeWindow();
 
+  //! Makes the engine run as a headless evaluation worker that connects
+  //! to the master at the given address. Must be called before initialize
+  void setWorkerAddress(const std::string& address);
+
+  //! Makes the engine export the genome to a controller file without
+  //! showing a window. Must be called before initialize
+  void setExport(const std::string& experiment,
+                 const std::string& genome,
+                 const std::string& filename);
+
 protected:
   //! Initializesers of the different libraries that are being used
   bool initGLFW();
@@ -79,6 +91,10 @@ protected:
   std::stack<int> mActiveStates;
 
   std::string mCFGPath;
+  std::string mWorkerAddress;
+  std::string mExportExperiment;
+  std::string mExportGenome;
+  std::string mExportFilename;
 
   CFG*             mCFG;
   State*           mCurrent;
@@ -87,5 +103,7 @@ protected:
   Asset*           mAsset;
   Lua::Lua*        mLua;
   ResourceManager* mResourceManager;
+  TextRenderer*    mTextRenderer;
+  FrameCapture*    mFrameCapture;
   bool             mWindowRefresh;
 };
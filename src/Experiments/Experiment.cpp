@@ -1,12 +1,60 @@
 #include "Experiment.hpp"
 
+#include "../3D/Spider.hpp"
+#include "../Learning/Phenotype.hpp"
 #include "../Learning/Substrate.hpp"
+#include "../Runtime/ControllerFile.hpp"
 #include <Population.h>
+#include <btBulletDynamicsCommon.h>
+
+#include "Standing0102.hpp"
+#include "Standing0304.hpp"
+#include "Walking0102.hpp"
+#include "Walking03.hpp"
+#include "Walking04.hpp"
+#include "Walking05.hpp"
+#include "Walking07.hpp"
+#include "Walking08.hpp"
 
 Experiment::Experiment(const std::string& name)
     : Logging::Log(name), mName(name) {}
 Experiment::~Experiment() {}
 
+/**
+ * @brief
+ *   Creates a new instance of the experiment with the given name.
+ *
+ *   This is used both when setting up the SpiderSwarm and by the
+ *   evaluation workers, which only receive the name of the experiment
+ *   they should evaluate with.
+ *
+ *   Throws if no experiment exists with the given name
+ *
+ * @param name
+ *
+ * @return
+ */
+Experiment* Experiment::create(const std::string& name) {
+  if (name == "Walking0102")
+    return new Walking0102();
+  else if (name == "Walking04")
+    return new Walking04();
+  else if (name == "Standing0102")
+    return new Standing0102();
+  else if (name == "Standing0304")
+    return new Standing0304();
+  else if (name == "Walking05")
+    return new Walking05();
+  else if (name == "Walking03")
+    return new Walking03();
+  else if (name == "Walking08")
+    return new Walking08();
+  else if (name == "Walking07")
+    return new Walking07();
+
+  throw std::runtime_error("Unable to find experiment: " + name);
+}
+
 /**
  * @brief
  *   Returns the substrate of the experiment.
@@ -85,6 +133,18 @@ const ExperimentParameters& Experiment::parameters() const {
   return mParameters;
 }
 
+void Experiment::setSparsifyOptions(const SparsifyOptions& options) {
+  mParameters.sparsify = options;
+}
+
+void Experiment::setSinglePrecision(bool enable) {
+  mParameters.singlePrecision = enable;
+}
+
+void Experiment::setPersistentLeakyState(bool enable) {
+  mParameters.persistentLeakyState = enable;
+}
+
 /**
  * @brief
  *   Returns a reference to the name of the experiment
@@ -564,6 +624,68 @@ void Experiment::initPhenotype(Phenotype&) const {}
  */
 void Experiment::postUpdate(const Phenotype&) const {}
 
+/**
+ * @brief
+ *   Describes the inputs and outputs that are shared by most experiments,
+ *   so that the network can be run by ControllerRuntime:
+ *
+ *   - 0-2: The rotation of the sternum, given as the sensors
+ *     `SternumRotationX`, `SternumRotationY` and `SternumRotationZ`
+ *   - 8-15: Whether each tarsus touches the ground, given as the sensors
+ *     `TarsusL1Contact` to `TarsusR4Contact`
+ *   - 16 and onwards: The angle of each active joint, given as a sensor
+ *     with the name of the part, normalized between the limits of the
+ *     hinge. The output with the same index is the target of the joint
+ *
+ *   Every other input is the output with the same index from the previous
+ *   step. Experiments that use the inputs differently should call this
+ *   and change the inputs that differ.
+ *
+ * @param p
+ * @param file
+ */
+void Experiment::describeController(const Phenotype& p,
+                                    ControllerFile&  file) const {
+  typedef ControllerFile::Input Input;
+
+  const char* tarsi[] = { "TarsusL1", "TarsusL2", "TarsusL3", "TarsusL4",
+                          "TarsusR1", "TarsusR2", "TarsusR3", "TarsusR4" };
+
+  uint32_t numOutputs = mSubstrate->m_output_coords.size();
+
+  file.sensors.clear();
+  file.inputs.clear();
+  file.motors.clear();
+
+  for (uint32_t i = 0; i < numInputs(); ++i)
+    file.inputs.push_back(i < numOutputs ? Input::feedback(i) :
+                                           Input::constant(0));
+
+  file.inputs[0] = Input::sensor(file.addSensor("SternumRotationX"));
+  file.inputs[1] = Input::sensor(file.addSensor("SternumRotationY"));
+  file.inputs[2] = Input::sensor(file.addSensor("SternumRotationZ"));
+
+  for (uint32_t i = 0; i < 8; ++i) {
+    std::string name = std::string(tarsi[i]) + "Contact";
+    file.inputs[8 + i] = Input::sensor(file.addSensor(name));
+  }
+
+  uint32_t index = 16;
+
+  for (auto& a : p.spider->parts()) {
+    if (!a.second.active || a.second.hinge == nullptr)
+      continue;
+
+    float low  = a.second.hinge->getLowerLimit();
+    float up   = a.second.hinge->getUpperLimit();
+    float zero = (up + low) * 0.5;
+
+    file.inputs[index] = Input::angle(file.addSensor(a.first), low, up, zero);
+    file.motors.push_back({ a.first, index, low, up, zero });
+    index++;
+  }
+}
+
 /**
  * @brief
  *   Allows you to customize the way that the fitness values are merged
@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "../Learning/Fitness.hpp"
+#include "../Learning/Sparsifier.hpp"
 #include "../Log.hpp"
 
 #include <Genome.h>
@@ -10,12 +11,31 @@
 
 class Substrate;
 struct Phenotype;
+struct ControllerFile;
 
 struct ExperimentParameters {
   // Describes the amount of activations that the network
   // should perform.
+  //
+  // Networks are compiled into layers which are activated once
+  // each, so this is only used as the maximum number of passes
+  // for recurrent networks. Leaky networks are integrated this
+  // many times every time step.
   int numActivates = 4;
 
+  // Recurrent networks stop activating once no activation has
+  // changed more than this. Negative values disables the check.
+  double activationTolerance = 1e-6;
+
+  // Whether to activate the networks in float instead of double
+  // precision. The inputs and outputs are floats either way.
+  bool singlePrecision = false;
+
+  // Whether leaky networks keep their membrane potentials between time
+  // steps. Otherwise they start from rest every time step, as they did
+  // with NEAT's ActivateLeaky.
+  bool persistentLeakyState = false;
+
   // Performs the static deltaTime that should be used.
   float deltaTime = 1.0f / 60.f;
 
@@ -30,6 +50,10 @@ struct ExperimentParameters {
 
   // Start in flat mode
   bool flatMode = false;
+
+  // Optional pruning and quantization of the networks after they
+  // have been built
+  SparsifyOptions sparsify;
 };
 
 /**
@@ -45,6 +69,10 @@ class Experiment : public Logging::Log {
 public:
   virtual ~Experiment();
 
+  // Creates the experiment with the given name, throwing if there is
+  // no experiment by that name. The caller owns the returned experiment
+  static Experiment* create(const std::string& name);
+
   // Returns the set substrate for the Experiment
   Substrate* substrate() const;
 
@@ -60,6 +88,15 @@ public:
   // Returns the parameters that are not specific to MultiNEAT
   const ExperimentParameters& parameters() const;
 
+  // Sets the sparsification stage used on networks after they are built
+  void setSparsifyOptions(const SparsifyOptions& options);
+
+  // Sets whether networks are activated in float or double precision
+  void setSinglePrecision(bool enable);
+
+  // Sets whether leaky networks keep their state between time steps
+  void setPersistentLeakyState(bool enable);
+
   // Returns the name of the experiment
   const std::string& name() const;
 
@@ -93,11 +130,17 @@ public:
   virtual void postUpdate(const Phenotype& p) const;
 
   // Tells the experiment to use the outputs from the network
-  virtual void outputs(Phenotype&                 p,
-                       const std::vector<double>& outputs) const = 0;
+  virtual void outputs(Phenotype&                p,
+                       const std::vector<float>& outputs) const = 0;
 
   // Tells the experiment to retrieve inputs
-  virtual std::vector<double> inputs(const Phenotype& p) const = 0;
+  virtual std::vector<float> inputs(const Phenotype& p) const = 0;
+
+  // Optional: Describes how inputs and outputs maps to the sensors and
+  // motors of the spider, which is needed to export controllers.
+  // Default behaviour matches the inputs and outputs most experiments use
+  virtual void describeController(const Phenotype& p,
+                                  ControllerFile&  file) const;
 
 protected:
   Experiment(const std::string& name);
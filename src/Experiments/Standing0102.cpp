@@ -4,6 +4,7 @@
 
 #include "../Learning/Phenotype.hpp"
 #include "../Learning/Substrate.hpp"
+#include "../Runtime/ControllerFile.hpp"
 
 #include <btBulletDynamicsCommon.h>
 
@@ -157,8 +158,8 @@ float Standing0102::mergeFitnessValues(const mmm::vec<9>& fitness) const {
   return mmm::product(fitness.xyzw);
 }
 
-void Standing0102::outputs(Phenotype&                 p,
-                           const std::vector<double>& outputs) const {
+void Standing0102::outputs(Phenotype&                p,
+                           const std::vector<float>& outputs) const {
   size_t index = 16;
   for (auto& part : p.spider->parts()) {
     if (part.second.hinge == nullptr)
@@ -192,10 +193,10 @@ void Standing0102::outputs(Phenotype&                 p,
   }
 }
 
-std::vector<double> Standing0102::inputs(const Phenotype& p) const {
+std::vector<float> Standing0102::inputs(const Phenotype& p) const {
   btRigidBody* sternum = p.spider->parts().at("Sternum").part->rigidBody();
   mmm::vec3    rots    = ExpUtil::getEulerAngles(sternum->getOrientation());
-  std::vector<double> inputs = p.previousOutput;
+  std::vector<float> inputs = p.previousOutput;
 
   if (inputs.size() == 0) {
     inputs.insert(inputs.end(), mSubstrate->m_output_coords.size(), 0);
@@ -235,3 +236,13 @@ std::vector<double> Standing0102::inputs(const Phenotype& p) const {
 
   return inputs;
 }
+
+void Standing0102::describeController(const Phenotype& p,
+                                      ControllerFile&  file) const {
+  typedef ControllerFile::Input Input;
+
+  Experiment::describeController(p, file);
+
+  for (int i = 3; i < 8; ++i)
+    file.inputs[i] = Input::constant(1);
+}
@@ -8,6 +8,7 @@ public:
   ~Standing0102();
 
   float mergeFitnessValues(const mmm::vec<9>& fitness) const;
-  void outputs(Phenotype& p, const std::vector<double>& outputs) const;
-  std::vector<double> inputs(const Phenotype& p) const;
+  void outputs(Phenotype& p, const std::vector<float>& outputs) const;
+  std::vector<float> inputs(const Phenotype& p) const;
+  void describeController(const Phenotype& p, ControllerFile& file) const;
 };
@@ -4,6 +4,7 @@
 
 #include "../Learning/Phenotype.hpp"
 #include "../Learning/Substrate.hpp"
+#include "../Runtime/ControllerFile.hpp"
 
 #include <btBulletDynamicsCommon.h>
 
@@ -102,8 +103,8 @@ Walking0102::~Walking0102() {
   delete mSubstrate;
 }
 
-void Walking0102::outputs(Phenotype&                 p,
-                          const std::vector<double>& outputs) const {
+void Walking0102::outputs(Phenotype&                p,
+                          const std::vector<float>& outputs) const {
   size_t index = 16;
   for (auto& part : p.spider->parts()) {
     if (part.second.hinge == nullptr)
@@ -127,10 +128,10 @@ void Walking0102::outputs(Phenotype&                 p,
   }
 }
 
-std::vector<double> Walking0102::inputs(const Phenotype& p) const {
+std::vector<float> Walking0102::inputs(const Phenotype& p) const {
   btRigidBody* sternum = p.spider->parts().at("Sternum").part->rigidBody();
   mmm::vec3    rots    = ExpUtil::getEulerAngles(sternum->getOrientation());
-  std::vector<double> inputs = p.previousOutput;
+  std::vector<float> inputs = p.previousOutput;
 
   if (inputs.size() == 0) {
     inputs.insert(inputs.end(), mSubstrate->m_output_coords.size(), 0);
@@ -165,3 +166,24 @@ std::vector<double> Walking0102::inputs(const Phenotype& p) const {
 
   return inputs;
 }
+
+void Walking0102::describeController(const Phenotype& p,
+                                     ControllerFile&  file) const {
+  typedef ControllerFile::Input Input;
+
+  Experiment::describeController(p, file);
+
+  file.inputs[3] = Input::clock(3, 0);
+
+  for (int i = 4; i < 8; ++i)
+    file.inputs[i] = Input::constant(1);
+
+  // The joints are normalized between -PI and PI instead of their limits
+  for (auto& motor : file.motors) {
+    ControllerFile::Input& input = file.inputs[motor.output];
+
+    input.low  = motor.low  = -PI;
+    input.up   = motor.up   = PI;
+    input.rest = motor.rest = 0;
+  }
+}
@@ -7,6 +7,7 @@ public:
   Walking0102();
   ~Walking0102();
 
-  void outputs(Phenotype& p, const std::vector<double>& outputs) const;
-  std::vector<double> inputs(const Phenotype& p) const;
+  void outputs(Phenotype& p, const std::vector<float>& outputs) const;
+  std::vector<float> inputs(const Phenotype& p) const;
+  void describeController(const Phenotype& p, ControllerFile& file) const;
 };
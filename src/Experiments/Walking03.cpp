@@ -4,6 +4,7 @@
 
 #include "../Learning/Phenotype.hpp"
 #include "../Learning/Substrate.hpp"
+#include "../Runtime/ControllerFile.hpp"
 
 #include <btBulletDynamicsCommon.h>
 
@@ -153,8 +154,8 @@ float Walking03::mergeFitnessValues(const mmm::vec<9>& fitness) const {
   return mmm::sum(fitness);
 }
 
-void Walking03::outputs(Phenotype&                 p,
-                        const std::vector<double>& outputs) const {
+void Walking03::outputs(Phenotype&                p,
+                        const std::vector<float>& outputs) const {
   size_t index = 16;
   for (auto& part : p.spider->parts()) {
     if (part.second.hinge == nullptr)
@@ -188,10 +189,10 @@ void Walking03::outputs(Phenotype&                 p,
   }
 }
 
-std::vector<double> Walking03::inputs(const Phenotype& p) const {
+std::vector<float> Walking03::inputs(const Phenotype& p) const {
   btRigidBody* sternum = p.spider->parts().at("Sternum").part->rigidBody();
   mmm::vec3    rots    = ExpUtil::getEulerAngles(sternum->getOrientation());
-  std::vector<double> inputs = p.previousOutput;
+  std::vector<float> inputs = p.previousOutput;
 
   if (inputs.size() == 0) {
     inputs.insert(inputs.end(), mSubstrate->m_output_coords.size(), 0);
@@ -231,3 +232,16 @@ std::vector<double> Walking03::inputs(const Phenotype& p) const {
 
   return inputs;
 }
+
+void Walking03::describeController(const Phenotype& p,
+                                   ControllerFile&  file) const {
+  typedef ControllerFile::Input Input;
+
+  Experiment::describeController(p, file);
+
+  for (int i = 0; i < 3; ++i)
+    file.inputs[i] = Input::feedback(i);
+
+  file.inputs[3] = Input::clock(2, 0);
+  file.inputs[7] = Input::clock(2, PI / 2);
+}
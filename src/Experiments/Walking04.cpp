@@ -4,9 +4,12 @@
 
 #include "../Learning/Phenotype.hpp"
 #include "../Learning/Substrate.hpp"
+#include "../Runtime/ControllerFile.hpp"
 
 #include <btBulletDynamicsCommon.h>
 
+const float PI = mmm::constants<float>::pi;
+
 Walking04::Walking04() : Experiment("Walking04") {
 
   mParameters.numActivates       = 8;
@@ -120,8 +123,8 @@ float Walking04::mergeFitnessValues(const mmm::vec<9>& fitness) const {
   return fitness.x * fitness.y;
 }
 
-void Walking04::outputs(Phenotype&                 p,
-                        const std::vector<double>& outputs) const {
+void Walking04::outputs(Phenotype&                p,
+                        const std::vector<float>& outputs) const {
   size_t index = 16;
   for (auto& part : p.spider->parts()) {
     if (part.second.hinge == nullptr)
@@ -155,10 +158,10 @@ void Walking04::outputs(Phenotype&                 p,
   }
 }
 
-std::vector<double> Walking04::inputs(const Phenotype& p) const {
+std::vector<float> Walking04::inputs(const Phenotype& p) const {
   btRigidBody* sternum = p.spider->parts().at("Sternum").part->rigidBody();
   mmm::vec3    rots    = ExpUtil::getEulerAngles(sternum->getOrientation());
-  std::vector<double> inputs = p.previousOutput;
+  std::vector<float> inputs = p.previousOutput;
 
   if (inputs.size() == 0) {
     inputs.insert(inputs.end(), mSubstrate->m_output_coords.size(), 0);
@@ -198,3 +201,16 @@ std::vector<double> Walking04::inputs(const Phenotype& p) const {
 
   return inputs;
 }
+
+void Walking04::describeController(const Phenotype& p,
+                                   ControllerFile&  file) const {
+  typedef ControllerFile::Input Input;
+
+  Experiment::describeController(p, file);
+
+  file.inputs[3] = Input::clock(2, 0);
+  file.inputs[7] = Input::clock(2, PI / 2);
+
+  for (int i = 4; i < 7; ++i)
+    file.inputs[i] = Input::constant(1);
+}
@@ -4,6 +4,7 @@
 
 #include "../Learning/Phenotype.hpp"
 #include "../Learning/Substrate.hpp"
+#include "../Runtime/ControllerFile.hpp"
 
 #include <btBulletDynamicsCommon.h>
 
@@ -154,8 +155,8 @@ float Walking05::mergeFitnessValues(const mmm::vec<9>& fitness) const {
   return fitness[0] * fitness[1] * fitness[2] * fitness[3];
 }
 
-void Walking05::outputs(Phenotype&                 p,
-                        const std::vector<double>& outputs) const {
+void Walking05::outputs(Phenotype&                p,
+                        const std::vector<float>& outputs) const {
   size_t index = 16;
   for (auto& part : p.spider->parts()) {
     if (part.second.hinge == nullptr)
@@ -189,10 +190,10 @@ void Walking05::outputs(Phenotype&                 p,
   }
 }
 
-std::vector<double> Walking05::inputs(const Phenotype& p) const {
+std::vector<float> Walking05::inputs(const Phenotype& p) const {
   btRigidBody* sternum = p.spider->parts().at("Sternum").part->rigidBody();
   mmm::vec3    rots    = ExpUtil::getEulerAngles(sternum->getOrientation());
-  std::vector<double> inputs = p.previousOutput;
+  std::vector<float> inputs = p.previousOutput;
 
   if (inputs.size() == 0) {
     inputs.insert(inputs.end(), mSubstrate->m_output_coords.size(), 0);
@@ -232,3 +233,20 @@ std::vector<double> Walking05::inputs(const Phenotype& p) const {
 
   return inputs;
 }
+
+void Walking05::describeController(const Phenotype& p,
+                                   ControllerFile&  file) const {
+  typedef ControllerFile::Input Input;
+
+  Experiment::describeController(p, file);
+
+  file.inputs[0] = Input::angle(file.inputs[0].index, -PI, PI, 0);
+  file.inputs[1] =
+    Input::angle(file.inputs[1].index, -PI, PI, 0, mmm::degrees(90));
+  file.inputs[2] = Input::angle(file.inputs[2].index, -PI, PI, 0);
+  file.inputs[3] = Input::clock(2, 0);
+  file.inputs[7] = Input::clock(2, PI / 2);
+
+  for (int i = 4; i < 7; ++i)
+    file.inputs[i] = Input::constant(1);
+}
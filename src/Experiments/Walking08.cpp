@@ -4,6 +4,7 @@
 
 #include "../Learning/Phenotype.hpp"
 #include "../Learning/Substrate.hpp"
+#include "../Runtime/ControllerFile.hpp"
 
 #include <btBulletDynamicsCommon.h>
 
@@ -101,8 +102,8 @@ float Walking08::mergeFitnessValues(const mmm::vec<9>& f) const {
   return mmm::max(f.x - f.y, 0.f) * f.z;
 }
 
-void Walking08::outputs(Phenotype&                 p,
-                        const std::vector<double>& outputs) const {
+void Walking08::outputs(Phenotype&                p,
+                        const std::vector<float>& outputs) const {
   size_t index = 16;
   for (auto& part : p.spider->parts()) {
     if (part.second.hinge == nullptr)
@@ -136,10 +137,10 @@ void Walking08::outputs(Phenotype&                 p,
   }
 }
 
-std::vector<double> Walking08::inputs(const Phenotype& p) const {
+std::vector<float> Walking08::inputs(const Phenotype& p) const {
   btRigidBody* sternum = p.spider->parts().at("Sternum").part->rigidBody();
   mmm::vec3    rots    = ExpUtil::getEulerAngles(sternum->getOrientation());
-  std::vector<double> inputs = p.previousOutput;
+  std::vector<float> inputs = p.previousOutput;
 
   if (inputs.size() == 0) {
     inputs.insert(inputs.end(), mSubstrate->m_output_coords.size(), 0);
@@ -179,3 +180,13 @@ std::vector<double> Walking08::inputs(const Phenotype& p) const {
 
   return inputs;
 }
+
+void Walking08::describeController(const Phenotype& p,
+                                   ControllerFile&  file) const {
+  typedef ControllerFile::Input Input;
+
+  Experiment::describeController(p, file);
+
+  file.inputs[3] = Input::clock(2, 0);
+  file.inputs[7] = Input::clock(2, PI / 2);
+}
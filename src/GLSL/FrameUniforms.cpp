@@ -0,0 +1,45 @@
+#include "FrameUniforms.hpp"
+
+#include "../Camera/Camera.hpp"
+
+static_assert(sizeof(mmm::mat4) == 16 * sizeof(float),
+              "Matrices must be tightly packed to match std140");
+static_assert(sizeof(mmm::vec4) == 4 * sizeof(float),
+              "Vectors must be tightly packed to match std140");
+
+const char* const FrameUniforms::BLOCK = "Frame";
+
+FrameUniforms::FrameUniforms() : Logging::Log("FrameUniforms"), mBuffer(0) {
+  glGenBuffers(1, &mBuffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+FrameUniforms::~FrameUniforms() {
+  glDeleteBuffers(1, &mBuffer);
+}
+
+/**
+ * @brief
+ *   Uploads the camera and light of this frame, and binds the buffer to
+ *   BINDING so that every program reads them from there.
+ *
+ * @param camera
+ */
+void FrameUniforms::update(const Camera& camera) {
+  const Camera::Light& light = camera.light();
+
+  Block block = { camera.view(),
+                  camera.projection(),
+                  light.view,
+                  light.projection,
+                  mmm::vec4(light.direction, 0),
+                  mmm::vec4(camera.position(), 1) };
+
+  glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &block);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+  glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, mBuffer);
+}
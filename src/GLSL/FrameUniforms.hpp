@@ -0,0 +1,47 @@
+#pragma once
+
+#include <mmm.hpp>
+
+#include "../Log.hpp"
+#include "../OpenGLHeaders.hpp"
+
+class Camera;
+
+/**
+ * @brief
+ *   The uniforms that are the same for every program during a frame, like
+ *   the matrices of the camera and the light. They are uploaded once per
+ *   frame into a uniform buffer, which every program that declares the
+ *   `Frame` block from `shaders/lib/frame.glsl` reads from.
+ *
+ *   Programs bind their `Frame` block to BINDING when they are linked, so
+ *   the buffer only has to be bound to that binding point.
+ */
+class FrameUniforms : public Logging::Log {
+public:
+  // The binding point of the Frame block
+  static const GLuint BINDING = 0;
+
+  // The name of the block in the shaders
+  static const char* const BLOCK;
+
+  FrameUniforms();
+  ~FrameUniforms();
+
+  // Uploads the matrices of the camera and its light
+  void update(const Camera& camera);
+
+private:
+  // The Frame block, laid out by std140 with row major matrices, which is
+  // the layout of mmm
+  struct Block {
+    mmm::mat4 view;
+    mmm::mat4 proj;
+    mmm::mat4 lightView;
+    mmm::mat4 lightProj;
+    mmm::vec4 lightDirection;
+    mmm::vec4 cameraPosition;
+  };
+
+  GLuint mBuffer;
+};
@@ -6,15 +6,28 @@
 #include "../GlobalLog.hpp"
 #include "../Utils/Utils.hpp"
 #include "../Utils/str.hpp"
+#include "FrameUniforms.hpp"
+#include "ProgramCache.hpp"
 #include "Shader.hpp"
 
 GLuint Program::activeProgram = 0;
 
+// Marks a uniform id whose location has not been looked up yet
+static const GLint UNRESOLVED = -2;
+
 Program::Program()
-    : Logging::Log("Program"), program(0), isLinked(false), isUsable(false) {}
+    : Logging::Log("Program")
+    , mCacheKey(0)
+    , program(0)
+    , isLinked(false)
+    , isUsable(false) {}
 
 Program::Program(const std::string& fsvs, bool link)
-    : Logging::Log("Program"), program(0), isLinked(false), isUsable(false) {
+    : Logging::Log("Program")
+    , mCacheKey(0)
+    , program(0)
+    , isLinked(false)
+    , isUsable(false) {
   createProgram(fsvs, link);
 }
 
@@ -28,6 +41,20 @@ Program::~Program() {
 }
 
 
+/**
+ * @brief
+ *   Reads the shaders and creates the program from them. When the program
+ *   is linked straight away, a cached binary of it is used if one exists
+ *   for the same source and driver, skipping both compiling and linking.
+ *
+ *   Programs that are linked later are never cached, since attributes may
+ *   be bound before they are linked.
+ *
+ * @param shaders
+ * @param link
+ *
+ * @return
+ */
 bool Program::createProgram(const std::string& shaders, bool link) {
   if (shaders.find(",") == std::string::npos) {
     throw std::runtime_error(
@@ -45,11 +72,8 @@ bool Program::createProgram(const std::string& shaders, bool link) {
   }
 
   for (auto& s : srcs) {
-    mShaders[s.first] = new Shader(s.second);
-
-    if (mShaders[s.first]->id() == 0) {
-      throw std::runtime_error("Failed to create program due to shader error");
-    }
+    mShaders[s.first] = new Shader();
+    mShaders[s.first]->read(s.second, s.first);
   }
 
   if (program != 0)
@@ -60,7 +84,27 @@ bool Program::createProgram(const std::string& shaders, bool link) {
   if (program == 0)
     throw std::runtime_error("Failed to create program");
 
+  mCacheFile = "";
+
+  if (link && ProgramCache::isSupported()) {
+    mCacheFile = mShaders[Shader::Type::Fragment]->filename() + ".program";
+    mCacheKey  = ProgramCache::key(mShaders);
+
+    if (ProgramCache::load(mCacheFile, mCacheKey, program)) {
+      mLog->debug("Loaded {} from {}", shaders, mCacheFile);
+
+      isLinked = true;
+      isUsable = true;
+      setupLinked();
+      return true;
+    }
+  }
+
   for (auto& s : mShaders) {
+    if (s.second->compile() == 0) {
+      throw std::runtime_error("Failed to create program due to shader error");
+    }
+
     if (!addShader(*s.second)) {
       throw std::runtime_error("Failed to create program due to " +
                                Shader::typeToStr(s.first));
@@ -91,6 +135,9 @@ void Program::unload() {
 
   isUsable = false;
   isLinked = false;
+
+  uniLocations.clear();
+  idLocations.clear();
 }
 
 bool Program::addShader(const Shader& sh) {
@@ -107,12 +154,34 @@ bool Program::link() {
   if (isLinked)
     return true;
 
+  if (!mCacheFile.empty())
+    ProgramCache::setRetrievable(program);
+
   glLinkProgram(program);
 
   isLinked = true;
   isUsable = checkProgram(program);
   checkErrors("link()");
 
+  if (!isUsable)
+    return false;
+
+  if (!mCacheFile.empty() &&
+      ProgramCache::save(mCacheFile, mCacheKey, program))
+    mLog->debug("Saved program binary to {}", mCacheFile);
+
+  setupLinked();
+  return true;
+}
+
+/**
+ * @brief
+ *   Looks up the uniforms of the linked program and sets the layout
+ *   bindings that the shaders were stripped of.
+ */
+void Program::setupLinked() {
+  resolveUniforms();
+
   // Set the binding layouts if the shader has that.
   for (auto& s : mShaders) {
     const Shader::Details& details = s.second->details();
@@ -125,8 +194,6 @@ bool Program::link() {
       setUniform(binding.name, binding.location);
     }
   }
-
-  return isUsable;
 }
 
 void Program::bind() {
@@ -140,6 +207,53 @@ void Program::bind() {
   glUseProgram(program);
 }
 
+/**
+ * @brief
+ *   Looks up the location of every active uniform right after linking, so
+ *   that setting a uniform never has to ask the driver. Uniforms within
+ *   blocks have no location and are skipped.
+ *
+ *   The `Frame` block, if the program uses it, is bound to the binding
+ *   point that FrameUniforms uploads to.
+ */
+void Program::resolveUniforms() {
+  GLint numUniforms = 0;
+  GLint maxLength   = 0;
+
+  glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &numUniforms);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+  std::vector<GLchar> name(maxLength + 1);
+
+  for (GLint i = 0; i < numUniforms; ++i) {
+    GLsizei length = 0;
+    GLint   size   = 0;
+    GLenum  type   = 0;
+
+    glGetActiveUniform(
+      program, i, name.size(), &length, &size, &type, name.data());
+
+    std::string uni(name.data(), length);
+    GLint       loc = glGetUniformLocation(program, uni.c_str());
+
+    if (loc == -1)
+      continue;
+
+    // Arrays are reported as `name[0]`, but are set by their name
+    if (uni.size() > 3 && uni.compare(uni.size() - 3, 3, "[0]") == 0)
+      uniLocations[uni.substr(0, uni.size() - 3)] = loc;
+
+    uniLocations[uni] = loc;
+  }
+
+  GLuint frame = glGetUniformBlockIndex(program, FrameUniforms::BLOCK);
+
+  if (frame != GL_INVALID_INDEX)
+    glUniformBlockBinding(program, frame, FrameUniforms::BINDING);
+
+  checkErrors("resolveUniforms()");
+}
+
 GLint Program::getUniformLocation(const std::string& uni) {
   if (program == 0 || !isUsable)
     return -1;
@@ -159,6 +273,58 @@ GLint Program::getUniformLocation(const std::string& uni) {
   return loc;
 }
 
+/**
+ * @brief
+ *   Returns the location of the uniform with the given id. The first call
+ *   for an id looks the name up, later calls only index a vector, even if
+ *   the uniform does not exist in this program.
+ *
+ * @param id an id returned by uniformId
+ *
+ * @return
+ */
+GLint Program::getUniformLocation(int id) {
+  if (program == 0 || !isUsable)
+    return -1;
+
+  if (id >= static_cast<int>(idLocations.size()))
+    idLocations.resize(uniformNames().size(), UNRESOLVED);
+
+  if (idLocations[id] == UNRESOLVED)
+    idLocations[id] = getUniformLocation(uniformNames()[id]);
+
+  return idLocations[id];
+}
+
+/**
+ * @brief
+ *   Returns the id of the uniform name, creating one if the name has not
+ *   been seen before. The ids are shared by every program, so that one id
+ *   can be used with any program that has the uniform.
+ *
+ * @param uni
+ *
+ * @return
+ */
+int Program::uniformId(const std::string& uni) {
+  static std::map<std::string, int> ids;
+
+  auto it = ids.find(uni);
+
+  if (it != ids.end())
+    return it->second;
+
+  std::vector<std::string>& names = uniformNames();
+  names.push_back(uni);
+
+  return ids[uni] = names.size() - 1;
+}
+
+std::vector<std::string>& Program::uniformNames() {
+  static std::vector<std::string> names;
+  return names;
+}
+
 GLint Program::getAttribLocation(const std::string& attrib) {
   if (program == 0 || !isUsable)
     return -1;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
@@ -20,6 +21,8 @@ class ResourceManager;
 //! if it fails to create/link GLSL program.
 class Program : public Resource, public Logging::Log {
 public:
+  static constexpr ResourceType TYPE = ResourceType::Program;
+
   //! Default Constructor
   Program();
 
@@ -56,6 +59,10 @@ public:
   //! Note: Only works if createProgram() has been called
   GLint getUniformLocation(const std::string& uni);
 
+  //! Returns the location of a uniform by the id returned from uniformId.
+  //! The location is looked up the first time and then cached.
+  GLint getUniformLocation(int id);
+
   //! Returns the location of an attrib variable within the program.
   //! Note: Only works if createProgram() has been called
   GLint getAttribLocation(const std::string& atrib);
@@ -65,6 +72,16 @@ public:
   template <typename T>
   bool setUniform(const std::string& uni, const T& t);
 
+  //! Does the same as above, but uses an id returned from uniformId
+  //! instead of the name, which avoids any string work when drawing.
+  template <typename T>
+  bool setUniform(int id, const T& t);
+
+  //! Returns an id for the uniform name that is the same for all programs.
+  //! Meant to be stored once, for instance in a static variable, and then
+  //! used with setUniform.
+  static int uniformId(const std::string& uni);
+
   //! Lets you bind an attribute (by name) to a index.
   //!  Only allowed if the program is not linked.
   bool bindAttrib(const std::string& attrib, const int index);
@@ -89,14 +106,29 @@ private:
 
   bool checkProgram(const GLuint pro);
 
+  // Caches the uniforms and sets the layout bindings of a linked program
+  void setupLinked();
+
+  // Stores the location of every active uniform and binds the uniform
+  // blocks the program shares with the rest of the engine
+  void resolveUniforms();
+
+  // The names of the uniform ids, where the id is the index
+  static std::vector<std::string>& uniformNames();
+
   static std::map<Shader::Type, std::string>
   loadMultipleShaderFilename(const std::string& vsfs);
 
   static GLuint activeProgram;
 
   std::map<std::string, int>      uniLocations;
+  std::vector<GLint>              idLocations;
   std::map<Shader::Type, Shader*> mShaders;
 
+  // Where the binary of the program is cached, empty if it is not cached
+  std::string mCacheFile;
+  uint64_t    mCacheKey;
+
   GLuint program;
   bool   isLinked;
   bool   isUsable;
@@ -115,3 +147,12 @@ bool Program::setUniform(const std::string& uni, const T& t) {
     return setGLUniform(loc, t);
   return false;
 }
+
+template <typename T>
+bool Program::setUniform(int id, const T& t) {
+  bind();
+  GLint loc = getUniformLocation(id);
+  if (loc != -1)
+    return setGLUniform(loc, t);
+  return false;
+}
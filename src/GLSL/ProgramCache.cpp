@@ -0,0 +1,258 @@
+#include "ProgramCache.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#include "../GlobalLog.hpp"
+
+// The OpenGL 3.3 headers do not declare what is needed for program
+// binaries, so the constants and functions are declared here instead
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+#ifndef APIENTRY
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32) || defined(__CYGWIN__)
+#define APIENTRY __stdcall
+#else
+#define APIENTRY
+#endif
+#endif
+
+namespace {
+  const char     MAGIC[4] = { 'P', 'R', 'O', 'G' };
+  const uint32_t VERSION  = 1;
+
+  typedef void(APIENTRY* GetProgramBinary)(GLuint,
+                                           GLsizei,
+                                           GLsizei*,
+                                           GLenum*,
+                                           void*);
+  typedef void(APIENTRY* ProgramBinary)(GLuint, GLenum, const void*, GLsizei);
+  typedef void(APIENTRY* ProgramParameteri)(GLuint, GLenum, GLint);
+
+  struct Functions {
+    GetProgramBinary  getProgramBinary;
+    ProgramBinary     programBinary;
+    ProgramParameteri programParameteri;
+    bool              isSupported;
+  };
+
+  /**
+   * @brief
+   *   Looks up the functions the first time it is called, which has to be
+   *   after the context has been made current.
+   *
+   * @return
+   */
+  const Functions& functions() {
+    static Functions functions = []() {
+      Functions f;
+      f.getProgramBinary =
+        (GetProgramBinary) glfwGetProcAddress("glGetProgramBinary");
+      f.programBinary = (ProgramBinary) glfwGetProcAddress("glProgramBinary");
+      f.programParameteri =
+        (ProgramParameteri) glfwGetProcAddress("glProgramParameteri");
+
+      GLint numFormats = 0;
+
+      if (f.getProgramBinary != nullptr)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+
+      f.isSupported = f.getProgramBinary != nullptr &&
+                      f.programBinary != nullptr &&
+                      f.programParameteri != nullptr && numFormats > 0;
+
+      // Clear the error from drivers that do not know the enum
+      glGetError();
+
+      info("Program binaries are {}",
+           f.isSupported ? "supported" : "not supported");
+      return f;
+    }();
+
+    return functions;
+  }
+
+  // 64 bit FNV-1a, which is fast and more than good enough to tell
+  // sources apart
+  void hash(uint64_t& h, const std::string& value) {
+    for (unsigned char c : value) {
+      h ^= c;
+      h *= 1099511628211ULL;
+    }
+
+    // Separate the values, so that moving text between them changes the key
+    h ^= 0xff;
+    h *= 1099511628211ULL;
+  }
+
+  std::string glString(GLenum name) {
+    const GLubyte* value = glGetString(name);
+    return value == nullptr ? "" : reinterpret_cast<const char*>(value);
+  }
+
+  template <typename T>
+  void write(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  void read(std::ifstream& file, T& value) {
+    file.read(reinterpret_cast<char*>(&value), sizeof(T));
+  }
+}
+
+bool ProgramCache::isSupported() {
+  return functions().isSupported;
+}
+
+/**
+ * @brief
+ *   Creates the key of the shaders from the version of the cache, the
+ *   driver and the source the shaders are compiled from.
+ *
+ * @param shaders
+ *
+ * @return
+ */
+uint64_t ProgramCache::key(const std::map<Shader::Type, Shader*>& shaders) {
+  uint64_t h = 14695981039346656037ULL;
+
+  hash(h, std::to_string(VERSION));
+  hash(h, glString(GL_VENDOR));
+  hash(h, glString(GL_RENDERER));
+  hash(h, glString(GL_VERSION));
+
+  for (auto& s : shaders) {
+    hash(h, Shader::typeToStr(s.first));
+    hash(h, s.second->details().source);
+  }
+
+  return h;
+}
+
+void ProgramCache::setRetrievable(GLuint program) {
+  if (isSupported())
+    functions().programParameteri(
+      program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+/**
+ * @brief
+ *   Loads the binary into the program. A binary can still be rejected by
+ *   the driver, for instance after a driver update that did not change its
+ *   version string, in which case the program has to be linked from source.
+ *
+ * @param filename
+ * @param key
+ * @param program
+ *
+ * @return
+ */
+bool ProgramCache::load(const std::string& filename,
+                        uint64_t           key,
+                        GLuint             program) {
+  if (!isSupported())
+    return false;
+
+  std::ifstream file(filename, std::ios::in | std::ios::binary);
+
+  if (!file.is_open())
+    return false;
+
+  char     magic[4];
+  uint32_t version, format, length;
+  uint64_t cached;
+
+  file.read(magic, 4);
+  read(file, version);
+  read(file, cached);
+  read(file, format);
+  read(file, length);
+
+  if (!file || !std::equal(magic, magic + 4, MAGIC) || version != VERSION ||
+      cached != key)
+    return false;
+
+  std::vector<char> binary(length);
+  file.read(binary.data(), length);
+
+  if (!file)
+    return false;
+
+  functions().programBinary(program, format, binary.data(), length);
+
+  GLint isLinked = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+
+  // A rejected binary leaves an error behind, which is expected
+  glGetError();
+
+  if (isLinked != GL_TRUE) {
+    debug("Program binary {} was rejected by the driver", filename);
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief
+ *   Saves the binary of the program with the key. Failing to save only
+ *   means that the program is compiled again on the next start.
+ *
+ * @param filename
+ * @param key
+ * @param program
+ *
+ * @return
+ */
+bool ProgramCache::save(const std::string& filename,
+                        uint64_t           key,
+                        GLuint             program) {
+  if (!isSupported())
+    return false;
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+  if (length <= 0)
+    return false;
+
+  std::vector<char> binary(length);
+  GLenum            format = 0;
+
+  functions().getProgramBinary(
+    program, length, &length, &format, binary.data());
+
+  std::ofstream file(filename, std::ios::out | std::ios::binary);
+
+  if (!file.is_open()) {
+    warn("Unable to write program binary: {}", filename);
+    return false;
+  }
+
+  file.write(MAGIC, 4);
+  write(file, VERSION);
+  write(file, key);
+  write(file, static_cast<uint32_t>(format));
+  write(file, static_cast<uint32_t>(length));
+  file.write(binary.data(), length);
+
+  if (!file) {
+    warn("Unable to write program binary: {}", filename);
+    return false;
+  }
+
+  return true;
+}
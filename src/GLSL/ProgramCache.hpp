@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "../OpenGLHeaders.hpp"
+#include "Shader.hpp"
+
+/**
+ * @brief
+ *   Stores linked programs on disk, so that the shaders do not have to be
+ *   compiled and linked again on the next start.
+ *
+ *   Binaries are only valid for the driver that created them, so each one
+ *   is stored with a key made from the driver strings and the preprocessed
+ *   source of every shader. The preprocessed source already contains the
+ *   included files and the values substituted from the CFG, so changing
+ *   any of them gives a new key and the binary is replaced.
+ *
+ *   Program binaries are part of OpenGL 4.1 and ARB_get_program_binary,
+ *   so the functions are looked up at runtime. If they are missing, the
+ *   cache does nothing and every program is compiled as before.
+ */
+class ProgramCache {
+public:
+  // Returns whether the driver supports program binaries
+  static bool isSupported();
+
+  // Returns the key of the shaders for the current driver
+  static uint64_t key(const std::map<Shader::Type, Shader*>& shaders);
+
+  // Asks the driver to keep the binary of the program when it is linked
+  static void setRetrievable(GLuint program);
+
+  // Loads the binary into the program, returning false if the file is
+  // missing, made with another key or rejected by the driver
+  static bool load(const std::string& filename, uint64_t key, GLuint program);
+
+  // Saves the binary of a linked program, returning false on failure
+  static bool save(const std::string& filename, uint64_t key, GLuint program);
+};
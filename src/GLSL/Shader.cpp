@@ -395,7 +395,8 @@ GLuint Shader::typeToGLType(Type t) {
  * @brief
  *   Creates an empty shader
  */
-Shader::Shader() : Logging::Log("Shader"), mId(0), mFilename("Unknown") {}
+Shader::Shader()
+    : Logging::Log("Shader"), mId(0), mFilename("Unknown"), mType(Type::None) {}
 
 /**
  * @brief
@@ -438,6 +439,20 @@ GLuint Shader::id() const {
 }
 
 GLuint Shader::loadShader(const std::string& filename, Shader::Type type) {
+  read(filename, type);
+  return compile();
+}
+
+/**
+ * @brief
+ *   Reads the shader from file, resolving includes, CFG expressions and
+ *   layout bindings. Nothing is sent to OpenGL, which lets a program look
+ *   for a cached binary of the source before compiling it.
+ *
+ * @param filename
+ * @param type
+ */
+void Shader::read(const std::string& filename, Shader::Type type) {
   if (type == Shader::Type::None) {
     type = Shader::typeFromFilename(filename);
   }
@@ -446,10 +461,19 @@ GLuint Shader::loadShader(const std::string& filename, Shader::Type type) {
     throw std::runtime_error("No type given to shader: " + filename);
   }
 
-  GLuint shaderType = Shader::typeToGLType(type);
-  mType             = type;
-  mId               = glCreateShader(shaderType);
-  mDetail           = loadTextfile(filename);
+  mFilename = filename;
+  mType     = type;
+  mDetail   = loadTextfile(filename);
+}
+
+/**
+ * @brief
+ *   Compiles the source read by `read`, throwing if it does not compile
+ *
+ * @return
+ */
+GLuint Shader::compile() {
+  mId = glCreateShader(Shader::typeToGLType(mType));
 
   const char* source = mDetail.source.c_str();
 
@@ -62,6 +62,14 @@ public:
   //! - ".cs" for Compute Shader
   GLuint loadShader(const std::string& filename, Type type = Type::None);
 
+  //! Reads and preprocesses the shader without compiling it, so that its
+  //! source is available through details(). Takes the same type as
+  //! loadShader.
+  void read(const std::string& filename, Type type = Type::None);
+
+  //! Compiles the source that has been read
+  GLuint compile();
+
   const Details& details() const;
   std::string    filename() const;
   Type           type() const;
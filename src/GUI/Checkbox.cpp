@@ -120,8 +120,7 @@ void Checkbox::defaultInputHandler(const Input::Event& event) {
  *   Draws the checkbox and all its elements
  */
 void Checkbox::draw() {
-  mGUIProgram->bind();
-  mGUIProgram->setUniform("guiOffset", mOffset);
+  bindGUIProgram();
   mSquare->draw();
   mTick->draw();
 }
@@ -11,6 +11,7 @@
 #include "../Utils/Asset.hpp"
 #include "../Utils/str.hpp"
 #include "Text.hpp"
+#include "TextRenderer.hpp"
 
 /**
  * @brief
@@ -419,16 +420,20 @@ void Dropdown::draw() {
   if (!isVisible())
     return;
 
-  mGUIProgram->bind();
-  mGUIProgram->setUniform("guiOffset", mOffset);
+  bindGUIProgram();
   mBox->draw();
 
   // if optionList is visible, draw em all
   if (mIsOptionsListVisible) {
     mOptionsList->draw();
+
+    mAsset->textRenderer()->begin();
+
     for (auto& text : mOptions)
       text->draw();
 
+    mAsset->textRenderer()->end();
+
     return;
   }
 
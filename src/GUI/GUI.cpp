@@ -5,6 +5,7 @@
 #include "../Resource/ResourceManager.hpp"
 #include "../Utils/Asset.hpp"
 #include "../Utils/CFG.hpp"
+#include "TextRenderer.hpp"
 
 using mmm::vec2;
 
@@ -31,6 +32,18 @@ bool GUI::isInside(const vec2& pos) const {
 void GUI::draw() {}
 void GUI::update(float) {}
 
+/**
+ * @brief
+ *   Draws the text collected by the TextRenderer so far and binds the GUI
+ *   program at the offset of the element. Without the flush, text drawn
+ *   before the element in the same batch would end up on top of it.
+ */
+void GUI::bindGUIProgram() {
+  mAsset->textRenderer()->flush();
+  mGUIProgram->bind();
+  mGUIProgram->setUniform("guiOffset", mOffset);
+}
+
 bool GUI::isVisible() const {
   return mIsVisible;
 }
@@ -75,6 +75,10 @@ public:
 protected:
   GUI();
 
+  // Flushes the batched text and binds the GUI program at the offset of
+  // the element, before drawing anything that is not text
+  void bindGUIProgram();
+
   Rectangle mBoundingBox;
   Rectangle mMouseoverBox;
 
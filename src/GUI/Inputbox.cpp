@@ -200,15 +200,13 @@ void Inputbox::setOffset(const mmm::vec2& offset) {
  *   Draws the input box and the other sub elements
  */
 void Inputbox::draw() {
-  mGUIProgram->bind();
-  mGUIProgram->setUniform("guiOffset", mOffset);
+  bindGUIProgram();
 
   mTextBox->draw();
   mText->draw();
 
   if (mInputIsVisible) {
-    mGUIProgram->bind();
-    mGUIProgram->setUniform("guiOffset", mOffset);
+    bindGUIProgram();
     mInputBox->draw();
     mInputBoxText->draw();
   }
@@ -7,6 +7,7 @@
 #include "../Utils/Asset.hpp"
 #include "../Utils/Utils.hpp"
 #include "Text.hpp"
+#include "TextRenderer.hpp"
 
 #include <limits>
 
@@ -434,6 +435,10 @@ void Menu::draw() {
   if (!isVisible())
     return;
 
+  mAsset->textRenderer()->begin();
+
   for (unsigned int i = 0; i < mMenuItems.size(); i++)
     mMenuItems[i]->draw();
+
+  mAsset->textRenderer()->end();
 }
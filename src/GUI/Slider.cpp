@@ -181,8 +181,7 @@ void Slider::draw() {
   if (!mIsVisible)
     return;
 
-  mGUIProgram->bind();
-  mGUIProgram->setUniform("guiOffset", mOffset);
+  bindGUIProgram();
   mBackground->draw();
   mGUIProgram->setUniform("guiOffset", mOffset + mButtonOffset);
   mButton->draw();
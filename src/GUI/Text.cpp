@@ -4,7 +4,6 @@
 #include <stack>
 #include <vector>
 
-#include "../GLSL/Program.hpp"
 #include "../Resource/Font.hpp"
 #include "../Resource/ResourceManager.hpp"
 #include "../Resource/Texture.hpp"
@@ -12,6 +11,7 @@
 #include "../Utils/Asset.hpp"
 #include "../Utils/CFG.hpp"
 #include "../Utils/Utils.hpp"
+#include "TextRenderer.hpp"
 
 enum ColorState {
   START,
@@ -117,21 +117,14 @@ Text::Text(const std::string& font,
            int                color,
            const mmm::vec2&   limit)
     : Logging::Log("Text")
-    , mNumVertices(0)
     , mCharacterSize(size)
-    , mNumVerticesBackground(0)
     , mStyle(0)
-    , mVBO(0)
-    , mVAO(0)
-    , mVBOBackground(0)
-    , mVAOBackground(0)
     , mText(text)
     , mLimit(limit) {
 
-  mTextFont    = mAsset->rManager()->get<Font>(font);
-  mFontProgram = mAsset->rManager()->get<Program>("Program::Font");
-  mIsLimitOn   = limit.x != 0 || limit.y != 0;
-  mColor       = { mmm::vec3(), mmm::vec3(), 0, 0 };
+  mTextFont  = mAsset->rManager()->get<Font>(font);
+  mIsLimitOn = limit.x != 0 || limit.y != 0;
+  mColor     = { mmm::vec3(), mmm::vec3(), 0, 0 };
 
   // try to load text colors from the text, if it fails, ignore
   // it and use default colors
@@ -155,18 +148,24 @@ Text::Text(const std::string& font,
   recalculateGeometry();
 }
 
-Text::~Text() {
-  if (mVBO != 0)
-    glDeleteBuffers(1, &mVBO);
-
-  if (mVAO != 0)
-    glDeleteVertexArrays(1, &mVAO);
-}
+Text::~Text() {}
 
 bool Text::hasBackgroundColor() const {
   return mHasBackgroundColor;
 }
 
+const std::vector<mmm::vec<8>>& Text::vertices() const {
+  return mVertices;
+}
+
+const std::vector<mmm::vec<8>>& Text::backgroundVertices() const {
+  return mBackgroundVertices;
+}
+
+Texture* Text::texture() const {
+  return mTextFont->getTexture(mCharacterSize);
+}
+
 /**
  * @brief
  *   Sets the style of the text to either
@@ -511,7 +510,6 @@ void Text::recalculateGeometry() {
   std::vector<mmm::vec<8>> bkCords;
 
   float           scale   = 1;
-  const mmm::vec2 texSize = mTextFont->getTexture(mCharacterSize)->getSize();
   const mmm::vec2 metrics = mTextFont->getMetrics(mCharacterSize);
   mmm::vec2       tempPos = mBoundingBox.topleft + mmm::vec2(0, mCharacterSize);
   mmm::vec2       size    = mmm::vec2();
@@ -577,8 +575,8 @@ void Text::recalculateGeometry() {
       }
 
 
-      const float tx = g.tc.x + g.bitmapSize.x / texSize.x;
-      const float ty = g.tc.y + g.bitmapSize.y / texSize.y;
+      const float tx = g.tc.x + g.tcSize.x;
+      const float ty = g.tc.y + g.tcSize.y;
 
       coordinates.push_back({ x2 + w, -y2, tx, g.tc.y, fColor });
       coordinates.push_back({ x2, -y2 + h, g.tc.x, ty, fColor });
@@ -610,82 +608,14 @@ void Text::recalculateGeometry() {
   size.y            = mmm::max(size.y - mBoundingBox.topleft.y, metrics.y);
   mBoundingBox.size = size;
 
-  mNumVertices = coordinates.size();
-
-  // Create the VAO and VBO for the actual text together
-  // with their colors
-  if (mVAO != 0)
-    glDeleteVertexArrays(1, &mVAO);
-  if (mVBO != 0)
-    glDeleteBuffers(1, &mVBO);
-
-  glGenVertexArrays(1, &mVAO);
-  glGenBuffers(1, &mVBO);
-
-  glBindVertexArray(mVAO);
-  glBindBuffer(GL_ARRAY_BUFFER, mVBO);
-  glBufferData(GL_ARRAY_BUFFER,
-               sizeof(mmm::vec<8>) * coordinates.size(),
-               &coordinates[0],
-               GL_STATIC_DRAW);
-
-  glEnableVertexAttribArray(0);
-  glEnableVertexAttribArray(1);
-  glEnableVertexAttribArray(2);
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GL_FLOAT), 0);
-  glVertexAttribPointer(1,
-                        2,
-                        GL_FLOAT,
-                        GL_FALSE,
-                        8 * sizeof(GL_FLOAT),
-                        (void*) (2 * sizeof(GL_FLOAT)));
-  glVertexAttribPointer(2,
-                        4,
-                        GL_FLOAT,
-                        GL_FALSE,
-                        8 * sizeof(GL_FLOAT),
-                        (void*) (4 * sizeof(GL_FLOAT)));
-  glBindVertexArray(0);
-
-  // No need to create lots of background color stuff if its never
-  // used.
-  if (!mHasBackgroundColor)
-    return;
+  // The vertices are only kept here, the TextRenderer uploads them
+  // together with the rest of the text when they are drawn
+  mVertices.swap(coordinates);
 
-  // Create the quads for the background colors
-  mNumVerticesBackground = bkCords.size();
-
-  if (mVAOBackground != 0)
-    glDeleteVertexArrays(1, &mVAOBackground);
-  if (mVBOBackground != 0)
-    glDeleteBuffers(1, &mVBOBackground);
-
-  glGenVertexArrays(1, &mVAOBackground);
-  glGenBuffers(1, &mVBOBackground);
-
-  glBindVertexArray(mVAOBackground);
-  glBindBuffer(GL_ARRAY_BUFFER, mVBOBackground);
-  glBufferData(GL_ARRAY_BUFFER,
-               sizeof(mmm::vec<8>) * bkCords.size(),
-               &bkCords[0],
-               GL_STATIC_DRAW);
-
-  glEnableVertexAttribArray(0);
-  glEnableVertexAttribArray(2);
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GL_FLOAT), 0);
-  glVertexAttribPointer(1,
-                        2,
-                        GL_FLOAT,
-                        GL_FALSE,
-                        8 * sizeof(GL_FLOAT),
-                        (void*) (2 * sizeof(GL_FLOAT)));
-  glVertexAttribPointer(2,
-                        4,
-                        GL_FLOAT,
-                        GL_FALSE,
-                        8 * sizeof(GL_FLOAT),
-                        (void*) (4 * sizeof(GL_FLOAT)));
-  glBindVertexArray(0);
+  if (mHasBackgroundColor)
+    mBackgroundVertices.swap(bkCords);
+  else
+    mBackgroundVertices.clear();
 }
 
 /**
@@ -697,21 +627,5 @@ void Text::draw() {
   if (!isVisible())
     return;
 
-  mFontProgram->bind();
-  mFontProgram->setUniform("guiOffset", mOffset);
-
-  if (mHasBackgroundColor) {
-    mFontProgram->setUniform("isBackground", true);
-
-    glBindVertexArray(mVAOBackground);
-    glDrawArrays(GL_TRIANGLES, 0, mNumVerticesBackground);
-    glBindVertexArray(0);
-  }
-
-  mTextFont->getTexture(mCharacterSize)->bind(0);
-  mFontProgram->setUniform("isBackground", false);
-
-  glBindVertexArray(mVAO);
-  glDrawArrays(GL_TRIANGLES, 0, mNumVertices);
-  glBindVertexArray(0);
+  mAsset->textRenderer()->draw(*this);
 }
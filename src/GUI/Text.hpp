@@ -10,7 +10,7 @@
 
 class Font;
 class CFG;
-class Program;
+class Texture;
 
 /**
  * @brief
@@ -18,6 +18,9 @@ class Program;
  *   kind of text is using this class.
  *
  *   This class is exported fully in Lua and can be used as it can in C++
+ *
+ *   The text does not own any OpenGL buffers. Its vertices are kept on the
+ *   CPU and drawn through the TextRenderer of the Asset.
  */
 class Text : public GUI, public Logging::Log {
 public:
@@ -60,7 +63,7 @@ public:
   //! Changes the text. Has to recalculate vertices.
   void setText(const std::string& s);
 
-  //! Changes size. Note: If font does not have the size, creates it. Taxing
+  //! Changes size. Every size is drawn from the same font atlas
   void setTextSize(int charSize);
 
   //! Changes the color on next rendering (and from there on.)
@@ -97,6 +100,16 @@ public:
 
   static std::string stripColorsFromStr(const std::string& s);
 
+  // Returns the vertices of the glyphs, as position, texture coordinate
+  // and color
+  const std::vector<mmm::vec<8>>& vertices() const;
+
+  // Returns the vertices of the background colors, if there are any
+  const std::vector<mmm::vec<8>>& backgroundVertices() const;
+
+  // Returns the font atlas page the glyphs are read from
+  Texture* texture() const;
+
 protected:
   void recalculateGeometry();
 
@@ -107,19 +120,13 @@ protected:
     int       prevEnumColor;
   } mColor;
 
-  int mNumVertices;
   int mCharacterSize;
-  int mNumVerticesBackground;
   int mStyle;
 
-  GLuint mVBO;
-  GLuint mVAO;
-
-  GLuint mVBOBackground;
-  GLuint mVAOBackground;
+  std::vector<mmm::vec<8>> mVertices;
+  std::vector<mmm::vec<8>> mBackgroundVertices;
 
-  std::shared_ptr<Font>    mTextFont;
-  std::shared_ptr<Program> mFontProgram;
+  std::shared_ptr<Font> mTextFont;
 
   std::vector<TextBlock> mFormattedText;
   std::string            mText;
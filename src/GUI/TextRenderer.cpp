@@ -0,0 +1,287 @@
+#include "TextRenderer.hpp"
+
+#include <cstddef>
+#include <stdexcept>
+
+#include "../GLSL/Program.hpp"
+#include "../Resource/ResourceManager.hpp"
+#include "../Resource/Texture.hpp"
+#include "../Utils/Asset.hpp"
+#include "Text.hpp"
+
+static const int OFFSET_UNIFORM     = Program::uniformId("guiOffset");
+static const int BACKGROUND_UNIFORM = Program::uniformId("isBackground");
+
+TextRenderer::TextRenderer(Asset* asset)
+    : Logging::Log("TextRenderer")
+    , mAsset(asset)
+    , mVBO(0)
+    , mVAO(0)
+    , mCapacity(0)
+    , mDepth(0)
+    , mDrawCalls(0) {
+  mFontProgram   = asset->rManager()->get<Program>("Program::Font");
+  mFont3DProgram = asset->rManager()->get<Program>("Program::Font3D");
+}
+
+TextRenderer::~TextRenderer() {
+  if (mVBO != 0)
+    glDeleteBuffers(1, &mVBO);
+
+  if (mVAO != 0)
+    glDeleteVertexArrays(1, &mVAO);
+}
+
+/**
+ * @brief
+ *   Starts a batch. Until the matching `end`, text is only collected.
+ */
+void TextRenderer::begin() {
+  if (mDepth == 0)
+    mDrawCalls = 0;
+
+  mDepth++;
+}
+
+/**
+ * @brief
+ *   Ends a batch, drawing everything that has been collected if it was the
+ *   outermost batch.
+ */
+void TextRenderer::end() {
+  if (mDepth == 0)
+    throw std::runtime_error("TextRenderer::end called without begin");
+
+  mDepth--;
+
+  if (mDepth == 0)
+    flush();
+}
+
+/**
+ * @brief
+ *   Draws the text on the screen. Its GUI offset is added to the vertices
+ *   so that texts with different offsets can share a draw call.
+ *
+ * @param text
+ */
+void TextRenderer::draw(Text& text) {
+  if (text.texture() == nullptr)
+    return;
+
+  add(text.backgroundVertices(), nullptr, false, text.offset(), mmm::vec3(0));
+  add(text.vertices(), text.texture(), false, text.offset(), mmm::vec3(0));
+
+  if (mDepth == 0) {
+    mDrawCalls = 0;
+    flush();
+  }
+}
+
+/**
+ * @brief
+ *   Draws the text as a billboard at the given position in the world.
+ *
+ * @param text
+ * @param worldPosition
+ * @param backgroundOffset
+ */
+void TextRenderer::draw(Text&            text,
+                        const mmm::vec3& worldPosition,
+                        const mmm::vec3& backgroundOffset) {
+  if (text.texture() == nullptr)
+    return;
+
+  add(text.backgroundVertices(),
+      nullptr,
+      true,
+      mmm::vec2(0),
+      worldPosition + backgroundOffset);
+  add(text.vertices(), text.texture(), true, mmm::vec2(0), worldPosition);
+
+  if (mDepth == 0) {
+    mDrawCalls = 0;
+    flush();
+  }
+}
+
+size_t TextRenderer::numDrawCalls() const {
+  return mDrawCalls;
+}
+
+/**
+ * @brief
+ *   Appends the vertices to the batch of the texture, creating the batch
+ *   the first time the texture is seen. Batches are kept between frames
+ *   so that their vectors keep their capacity.
+ *
+ * @param vertices
+ * @param texture
+ * @param is3D
+ * @param offset
+ * @param worldPosition
+ */
+void TextRenderer::add(const std::vector<mmm::vec<8>>& vertices,
+                       Texture*                        texture,
+                       bool                            is3D,
+                       const mmm::vec2&                offset,
+                       const mmm::vec3&                worldPosition) {
+  if (vertices.empty())
+    return;
+
+  Batch* batch = nullptr;
+
+  for (auto& b : mBatches) {
+    if (b.texture == texture && b.is3D == is3D) {
+      batch = &b;
+      break;
+    }
+  }
+
+  if (batch == nullptr) {
+    mBatches.push_back({ texture, is3D, {} });
+    batch = &mBatches.back();
+  }
+
+  for (auto& v : vertices)
+    batch->vertices.push_back({ mmm::vec2(v[0], v[1]) + offset,
+                                mmm::vec2(v[2], v[3]),
+                                mmm::vec4(v[4], v[5], v[6], v[7]),
+                                worldPosition });
+}
+
+/**
+ * @brief
+ *   Uploads the vertices of every batch into the buffer at once and draws
+ *   each batch with a single call. Backgrounds are drawn before any of the
+ *   glyphs, so that they never cover text.
+ */
+void TextRenderer::flush() {
+  mVertices.clear();
+
+  std::vector<std::pair<const Batch*, size_t>> order;
+
+  for (bool is3D : { true, false }) {
+    for (bool isBackground : { true, false }) {
+      for (auto& batch : mBatches) {
+        if (batch.vertices.empty() || batch.is3D != is3D ||
+            (batch.texture == nullptr) != isBackground)
+          continue;
+
+        order.push_back({ &batch, mVertices.size() });
+        mVertices.insert(mVertices.end(),
+                         batch.vertices.begin(),
+                         batch.vertices.end());
+      }
+    }
+  }
+
+  if (mVertices.empty())
+    return;
+
+  if (mVAO == 0)
+    setup();
+
+  glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+
+  // The buffer is orphaned before it is written to, so that it does not
+  // have to wait for the previous draw calls to finish
+  if (mVertices.size() > mCapacity)
+    mCapacity = mVertices.size();
+
+  glBufferData(GL_ARRAY_BUFFER,
+               mCapacity * sizeof(Vertex),
+               nullptr,
+               GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER,
+                  0,
+                  mVertices.size() * sizeof(Vertex),
+                  mVertices.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  glBindVertexArray(mVAO);
+
+  for (auto& o : order)
+    drawBatch(*o.first, o.second);
+
+  glBindVertexArray(0);
+
+  for (auto& batch : mBatches)
+    batch.vertices.clear();
+}
+
+/**
+ * @brief
+ *   Draws one batch from the uploaded vertices. The vertices already
+ *   contain their offsets, so the offsets of the programs are cleared.
+ *
+ * @param batch
+ * @param first
+ */
+void TextRenderer::drawBatch(const Batch& batch, size_t first) {
+  bool isBackground = batch.texture == nullptr;
+
+  // The camera of 3D text comes from the Frame block of the shader
+  if (batch.is3D) {
+    mFont3DProgram->bind();
+    mFont3DProgram->setUniform(BACKGROUND_UNIFORM, isBackground);
+
+    if (!isBackground)
+      batch.texture->bind(1);
+  } else {
+    mFontProgram->bind();
+    mFontProgram->setUniform(OFFSET_UNIFORM, mmm::vec2(0));
+    mFontProgram->setUniform(BACKGROUND_UNIFORM, isBackground);
+
+    if (!isBackground)
+      batch.texture->bind(0);
+  }
+
+  glDrawArrays(GL_TRIANGLES, first, batch.vertices.size());
+  mDrawCalls++;
+}
+
+/**
+ * @brief
+ *   Creates the streaming buffer and points the attributes of the vertex
+ *   array at it. The attributes never change, only the buffer's content.
+ */
+void TextRenderer::setup() {
+  glGenVertexArrays(1, &mVAO);
+  glGenBuffers(1, &mVBO);
+
+  glBindVertexArray(mVAO);
+  glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+
+  glEnableVertexAttribArray(0);
+  glEnableVertexAttribArray(1);
+  glEnableVertexAttribArray(2);
+  glEnableVertexAttribArray(3);
+  glVertexAttribPointer(0,
+                        2,
+                        GL_FLOAT,
+                        GL_FALSE,
+                        sizeof(Vertex),
+                        (void*) offsetof(Vertex, position));
+  glVertexAttribPointer(1,
+                        2,
+                        GL_FLOAT,
+                        GL_FALSE,
+                        sizeof(Vertex),
+                        (void*) offsetof(Vertex, texCoord));
+  glVertexAttribPointer(2,
+                        4,
+                        GL_FLOAT,
+                        GL_FALSE,
+                        sizeof(Vertex),
+                        (void*) offsetof(Vertex, color));
+  glVertexAttribPointer(3,
+                        3,
+                        GL_FLOAT,
+                        GL_FALSE,
+                        sizeof(Vertex),
+                        (void*) offsetof(Vertex, worldPosition));
+
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
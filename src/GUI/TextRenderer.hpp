@@ -0,0 +1,106 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <mmm.hpp>
+
+#include "../Log.hpp"
+#include "../OpenGLHeaders.hpp"
+
+class Asset;
+class Program;
+class Text;
+class Texture;
+
+/**
+ * @brief
+ *   Draws all text through one streaming vertex buffer. Text elements only
+ *   keep their vertices on the CPU and hand them to the renderer when they
+ *   are drawn, instead of owning buffers of their own.
+ *
+ *   Text drawn between `begin` and `end` is batched: every background is
+ *   drawn with one call and the glyphs with one call for each font atlas
+ *   page, no matter how many text elements there are. Text drawn outside
+ *   of a batch is drawn right away, still without any buffers of its own.
+ *
+ *   GUI elements that draw anything else than text flush the batch first,
+ *   so that a batch never changes which element is drawn on top.
+ *
+ *   Batches can be nested, in which case the text is drawn when the
+ *   outermost batch ends.
+ */
+class TextRenderer : public Logging::Log {
+public:
+  TextRenderer(Asset* asset);
+  ~TextRenderer();
+
+  // Starts collecting text instead of drawing it right away
+  void begin();
+
+  // Draws all the text collected since the outermost begin
+  void end();
+
+  // Draws the text collected so far without ending the batch. Anything
+  // that is not text must call this before it is drawn inside a batch,
+  // or the text collected before it would be drawn on top of it.
+  void flush();
+
+  // Draws text on the screen, moved by its GUI offset
+  void draw(Text& text);
+
+  // Draws text facing the camera at a position in the world. The
+  // background is moved by its own offset so that it is behind the text.
+  void draw(Text&            text,
+            const mmm::vec3& worldPosition,
+            const mmm::vec3& backgroundOffset);
+
+  // Returns the number of draw calls used since the outermost begin, or
+  // by the last text drawn outside of a batch
+  size_t numDrawCalls() const;
+
+private:
+  // The vertex of a glyph or background, as read by the Font and Font3D
+  // shaders. The world position is only used by Font3D.
+  struct Vertex {
+    mmm::vec2 position;
+    mmm::vec2 texCoord;
+    mmm::vec4 color;
+    mmm::vec3 worldPosition;
+  };
+
+  // Glyphs of the same page and backgrounds are drawn together. Pages are
+  // a null texture for backgrounds.
+  struct Batch {
+    Texture*            texture;
+    bool                is3D;
+    std::vector<Vertex> vertices;
+  };
+
+  // Adds the vertices to the batch with the given texture
+  void add(const std::vector<mmm::vec<8>>& vertices,
+           Texture*                        texture,
+           bool                            is3D,
+           const mmm::vec2&                offset,
+           const mmm::vec3&                worldPosition);
+
+  // Draws a range of the uploaded vertices with the batch's program
+  void drawBatch(const Batch& batch, size_t first);
+
+  // Creates the buffer and the vertex array
+  void setup();
+
+  Asset* mAsset;
+
+  std::shared_ptr<Program> mFontProgram;
+  std::shared_ptr<Program> mFont3DProgram;
+
+  std::vector<Batch>  mBatches;
+  std::vector<Vertex> mVertices;
+
+  GLuint mVBO;
+  GLuint mVAO;
+  size_t mCapacity;
+  int    mDepth;
+  size_t mDrawCalls;
+};
@@ -75,8 +75,7 @@ void Tooltip::setOffset(const mmm::vec2& offset) {
  *   Draws the elements
  */
 void Tooltip::draw() {
-  mGUIProgram->bind();
-  mGUIProgram->setUniform("guiOffset", mOffset);
+  bindGUIProgram();
   mBackground->draw();
   mActiveText->draw();
 }
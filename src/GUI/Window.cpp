@@ -510,8 +510,7 @@ void Window::draw() {
     return;
 
   if (mBackground != nullptr) {
-    mGUIProgram->bind();
-    mGUIProgram->setUniform("guiOffset", mOffset);
+    bindGUIProgram();
     mBackground->draw();
   }
 
@@ -0,0 +1,478 @@
+#include "FrameCapture.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../Utils/CFG.hpp"
+#include "Framebuffer.hpp"
+
+namespace {
+  unsigned char toByte(float value) {
+    return static_cast<unsigned char>(
+      std::max(0.f, std::min(255.f, value + 0.5f)));
+  }
+
+  bool endsWith(const std::string& str, const std::string& end) {
+    return str.size() >= end.size() &&
+           str.compare(str.size() - end.size(), end.size(), end) == 0;
+  }
+}
+
+FrameCapture::FrameCapture(CFG* cfg)
+    : Logging::Log("FrameCapture")
+    , mCFG(cfg)
+    , mFormat(Format::TGA)
+    , mFramesPerSecond(30)
+    , mWidth(0)
+    , mHeight(0)
+    , mNumFrames(0)
+    , mIsCapturing(false)
+    , mIsDrawing(false)
+    , mStopWanted(false)
+    , mFrameBuffer(0)
+    , mColorBuffer(0)
+    , mDepthBuffer(0)
+    , mNextPixelBuffer(0)
+    , mIsDone(false)
+    , mFailed(false) {
+  for (unsigned int i = 0; i < NUM_PIXEL_BUFFERS; ++i) {
+    mPixelBuffers[i] = 0;
+    mFences[i]       = nullptr;
+    mPending[i]      = 0;
+    mIsPending[i]    = false;
+  }
+}
+
+FrameCapture::~FrameCapture() {
+  if (mIsCapturing) {
+    mIsDrawing = false;
+    finish();
+  }
+}
+
+/**
+ * @brief
+ *   Starts capturing the frames drawn from now on. The size of the frames is
+ *   the resolution of the window when the capture is started.
+ *
+ * @param filename
+ *   A `.y4m` file, or the start of the names of the images
+ * @param framesPerSecond
+ */
+void FrameCapture::start(const std::string& filename, int framesPerSecond) {
+  if (mIsCapturing)
+    throw std::runtime_error("Already capturing to " + mFilename);
+
+  if (framesPerSecond <= 0)
+    throw std::runtime_error("Frames per second has to be above zero");
+
+  mFilename        = filename;
+  mFramesPerSecond = framesPerSecond;
+  mWidth           = mCFG->graphics.res.x;
+  mHeight          = mCFG->graphics.res.y;
+  mFormat          = endsWith(filename, ".y4m") ? Format::Y4M : Format::TGA;
+  mNumFrames       = 0;
+  mNextPixelBuffer = 0;
+  mIsDone          = false;
+  mFailed          = false;
+
+  if (mFormat == Format::Y4M) {
+    mFile.open(filename, std::ios::out | std::ios::binary);
+
+    if (!mFile.is_open())
+      throw std::runtime_error("Unable to write capture: " + filename);
+
+    // C420jpeg is full range 4:2:0, which is what the colors are converted to
+    mFile << "YUV4MPEG2 W" << mWidth << " H" << mHeight << " F"
+          << mFramesPerSecond << ":1 Ip A1:1 C420jpeg\n";
+  }
+
+  createBuffers();
+
+  mIsCapturing = true;
+  mWriter      = std::thread(&FrameCapture::writeLoop, this);
+
+  mLog->info("Capturing {}x{} at {} frames per second to {}",
+             mWidth,
+             mHeight,
+             mFramesPerSecond,
+             filename);
+}
+
+/**
+ * @brief
+ *   Stops capturing, waiting for the remaining frames to be read back and
+ *   written. If a frame is being drawn, it is captured before stopping.
+ */
+void FrameCapture::stop() {
+  if (!mIsCapturing)
+    return;
+
+  if (mIsDrawing) {
+    mStopWanted = true;
+    return;
+  }
+
+  finish();
+}
+
+bool FrameCapture::isCapturing() const {
+  return mIsCapturing;
+}
+
+float FrameCapture::frameTime() const {
+  return 1.f / float(mFramesPerSecond);
+}
+
+size_t FrameCapture::numFrames() const {
+  return mNumFrames;
+}
+
+/**
+ * @brief
+ *   Binds the offscreen framebuffer and makes it the screen that other
+ *   framebuffers return to when they are finalized. Does nothing when not
+ *   capturing.
+ */
+void FrameCapture::beginFrame() {
+  if (!mIsCapturing || mIsDrawing)
+    return;
+
+  glBindFramebuffer(GL_FRAMEBUFFER, mFrameBuffer);
+  glViewport(0, 0, mWidth, mHeight);
+  Framebuffer::setScreen(mFrameBuffer);
+
+  mIsDrawing = true;
+}
+
+/**
+ * @brief
+ *   Reads the frame into the next pixel buffer of the ring and copies it to
+ *   the window. The pixel buffer that is reused was filled a few frames ago,
+ *   so it is normally ready and its pixels are handed to the writer without
+ *   waiting.
+ */
+void FrameCapture::endFrame() {
+  if (!mIsDrawing)
+    return;
+
+  mIsDrawing        = false;
+  unsigned int slot = mNextPixelBuffer;
+
+  if (mIsPending[slot])
+    readBack(slot);
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, mFrameBuffer);
+  glReadBuffer(GL_COLOR_ATTACHMENT0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, mPixelBuffers[slot]);
+  glReadPixels(0, 0, mWidth, mHeight, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  mFences[slot]    = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  mPending[slot]   = mNumFrames;
+  mIsPending[slot] = true;
+  mNextPixelBuffer = (slot + 1) % NUM_PIXEL_BUFFERS;
+  mNumFrames += 1;
+
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBlitFramebuffer(0,
+                    0,
+                    mWidth,
+                    mHeight,
+                    0,
+                    0,
+                    mWidth,
+                    mHeight,
+                    GL_COLOR_BUFFER_BIT,
+                    GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  Framebuffer::setScreen(0);
+
+  if (mStopWanted)
+    finish();
+}
+
+void FrameCapture::createBuffers() {
+  glGenFramebuffers(1, &mFrameBuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, mFrameBuffer);
+
+  glGenRenderbuffers(1, &mColorBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, mColorBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, mWidth, mHeight);
+  glFramebufferRenderbuffer(
+    GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mColorBuffer);
+
+  glGenRenderbuffers(1, &mDepthBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, mDepthBuffer);
+  glRenderbufferStorage(
+    GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, mWidth, mHeight);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER,
+                            GL_DEPTH_STENCIL_ATTACHMENT,
+                            GL_RENDERBUFFER,
+                            mDepthBuffer);
+
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  glGenBuffers(NUM_PIXEL_BUFFERS, mPixelBuffers);
+
+  for (unsigned int i = 0; i < NUM_PIXEL_BUFFERS; ++i) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, mPixelBuffers[i]);
+    glBufferData(
+      GL_PIXEL_PACK_BUFFER, mWidth * mHeight * 4, nullptr, GL_STREAM_READ);
+    mIsPending[i] = false;
+  }
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    deleteBuffers();
+    mFile.close();
+    throw std::runtime_error("Capture framebuffer is not complete.");
+  }
+}
+
+void FrameCapture::deleteBuffers() {
+  glDeleteBuffers(NUM_PIXEL_BUFFERS, mPixelBuffers);
+  glDeleteRenderbuffers(1, &mDepthBuffer);
+  glDeleteRenderbuffers(1, &mColorBuffer);
+  glDeleteFramebuffers(1, &mFrameBuffer);
+
+  for (unsigned int i = 0; i < NUM_PIXEL_BUFFERS; ++i)
+    mPixelBuffers[i] = 0;
+
+  mDepthBuffer = 0;
+  mColorBuffer = 0;
+  mFrameBuffer = 0;
+}
+
+/**
+ * @brief
+ *   Copies the pixels of the pixel buffer into a frame and queues it for
+ *   the writer. If the writer has fallen too far behind, this waits for it
+ *   instead of dropping frames, so every frame ends up in the video.
+ *
+ * @param slot
+ */
+void FrameCapture::readBack(unsigned int slot) {
+  glClientWaitSync(
+    mFences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+  glDeleteSync(mFences[slot]);
+
+  mFences[slot]    = nullptr;
+  mIsPending[slot] = false;
+
+  Frame  frame;
+  size_t size = mWidth * mHeight * 4;
+
+  frame.index = mPending[slot];
+
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mWritten.wait(lock, [this]() { return mQueue.size() < MAX_QUEUED_FRAMES; });
+
+    if (!mFree.empty()) {
+      frame.pixels = std::move(mFree.back());
+      mFree.pop_back();
+    }
+  }
+
+  frame.pixels.resize(size);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, mPixelBuffers[slot]);
+  void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+
+  if (data != nullptr) {
+    std::memcpy(frame.pixels.data(), data, size);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  } else {
+    mLog->warn("Unable to map pixels of frame {}", frame.index);
+  }
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mQueue.push_back(std::move(frame));
+  }
+
+  mQueued.notify_one();
+}
+
+/**
+ * @brief
+ *   Reads back the frames that are still in the pixel buffers, oldest
+ *   first, and waits for the writer to write all of them.
+ */
+void FrameCapture::finish() {
+  for (unsigned int i = 0; i < NUM_PIXEL_BUFFERS; ++i) {
+    unsigned int slot = (mNextPixelBuffer + i) % NUM_PIXEL_BUFFERS;
+
+    if (mIsPending[slot])
+      readBack(slot);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIsDone = true;
+  }
+
+  mQueued.notify_one();
+  mWriter.join();
+
+  mFile.close();
+  mFree.clear();
+  mPlanes.clear();
+  deleteBuffers();
+  Framebuffer::setScreen(0);
+
+  mIsCapturing = false;
+  mStopWanted  = false;
+
+  mLog->info("Captured {} frames to {}", mNumFrames, mFilename);
+}
+
+/**
+ * @brief
+ *   Runs on the writer thread, writing frames in the order they were queued
+ *   until the capture is finished and the queue is empty.
+ */
+void FrameCapture::writeLoop() {
+  while (true) {
+    Frame frame;
+
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mQueued.wait(lock, [this]() { return !mQueue.empty() || mIsDone; });
+
+      if (mQueue.empty())
+        return;
+
+      frame = std::move(mQueue.front());
+      mQueue.pop_front();
+    }
+
+    mWritten.notify_one();
+
+    if (!mFailed) {
+      if (mFormat == Format::Y4M)
+        writeY4M(frame);
+      else
+        writeTGA(frame);
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mFree.push_back(std::move(frame.pixels));
+  }
+}
+
+/**
+ * @brief
+ *   Converts the frame to full range YUV 4:2:0 and appends it to the video.
+ *   The rows are read from OpenGL bottom up, while Y4M stores them top down.
+ *
+ * @param frame
+ */
+void FrameCapture::writeY4M(const Frame& frame) {
+  const int w  = mWidth;
+  const int h  = mHeight;
+  const int cw = (w + 1) / 2;
+  const int ch = (h + 1) / 2;
+
+  mPlanes.resize(w * h + 2 * cw * ch);
+
+  unsigned char*       yPlane = mPlanes.data();
+  unsigned char*       uPlane = yPlane + w * h;
+  unsigned char*       vPlane = uPlane + cw * ch;
+  const unsigned char* pixels = frame.pixels.data();
+
+  for (int y = 0; y < h; ++y) {
+    const unsigned char* row = pixels + (h - 1 - y) * w * 4;
+
+    for (int x = 0; x < w; ++x) {
+      const unsigned char* p = row + x * 4;
+      yPlane[y * w + x] = toByte(0.114f * p[0] + 0.587f * p[1] + 0.299f * p[2]);
+    }
+  }
+
+  for (int y = 0; y < ch; ++y) {
+    for (int x = 0; x < cw; ++x) {
+      float b = 0, g = 0, r = 0;
+      int   n = 0;
+
+      for (int dy = 2 * y; dy < std::min(2 * y + 2, h); ++dy) {
+        for (int dx = 2 * x; dx < std::min(2 * x + 2, w); ++dx) {
+          const unsigned char* p = pixels + ((h - 1 - dy) * w + dx) * 4;
+
+          b += p[0];
+          g += p[1];
+          r += p[2];
+          n += 1;
+        }
+      }
+
+      b /= n;
+      g /= n;
+      r /= n;
+
+      uPlane[y * cw + x] =
+        toByte(128.f - 0.168736f * r - 0.331264f * g + 0.5f * b);
+      vPlane[y * cw + x] =
+        toByte(128.f + 0.5f * r - 0.418688f * g - 0.081312f * b);
+    }
+  }
+
+  mFile.write("FRAME\n", 6);
+  mFile.write(reinterpret_cast<const char*>(mPlanes.data()), mPlanes.size());
+
+  if (!mFile) {
+    mLog->warn("Unable to write frame {} to {}", frame.index, mFilename);
+    mFailed = true;
+  }
+}
+
+/**
+ * @brief
+ *   Writes the frame as an uncompressed TGA image, using the same header as
+ *   Framebuffer::takeScreenshot. TGA images are stored bottom up, just like
+ *   OpenGL reads them, so only the alpha has to be removed.
+ *
+ * @param frame
+ */
+void FrameCapture::writeTGA(const Frame& frame) {
+  std::string number = std::to_string(frame.index);
+
+  // Pad the number, so that the images are sorted in order
+  if (number.size() < 6)
+    number.insert(0, 6 - number.size(), '0');
+
+  std::string filename = mFilename + "-" + number + ".tga";
+
+  // clang-format off
+  unsigned char header[18] = { 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                               (unsigned char) (mWidth % 256),
+                               (unsigned char) (mWidth / 256),
+                               (unsigned char) (mHeight % 256),
+                               (unsigned char) (mHeight / 256),
+                               24, 0 };
+  // clang-format on
+
+  mPlanes.resize(mWidth * mHeight * 3);
+
+  for (int i = 0; i < mWidth * mHeight; ++i) {
+    mPlanes[i * 3 + 0] = frame.pixels[i * 4 + 0];
+    mPlanes[i * 3 + 1] = frame.pixels[i * 4 + 1];
+    mPlanes[i * 3 + 2] = frame.pixels[i * 4 + 2];
+  }
+
+  std::ofstream file(filename, std::ios::out | std::ios::binary);
+  file.write(reinterpret_cast<char*>(header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(mPlanes.data()), mPlanes.size());
+
+  if (!file) {
+    mLog->warn("Unable to write frame {} to {}", frame.index, filename);
+    mFailed = true;
+  }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Log.hpp"
+#include "../OpenGLHeaders.hpp"
+
+class CFG;
+
+/**
+ * @brief
+ *   Records every frame the engine draws, so that videos can be made
+ *   without a screen recorder.
+ *
+ *   While capturing, frames are drawn to an offscreen framebuffer which is
+ *   then copied to the window. The pixels are read into one of a ring of
+ *   pixel buffers, and are only mapped a few frames later, when the GPU has
+ *   finished with them, so reading them back does not stall drawing. The
+ *   frames are then written by a thread of their own.
+ *
+ *   A filename ending in `.y4m` is written as a single raw video, which
+ *   ffmpeg and most players read directly. Anything else is used as the
+ *   start of a numbered sequence of TGA images, `name-000000.tga` and so
+ *   on.
+ *
+ *   The engine steps by exactly one frame time while capturing and does
+ *   not wait between frames, so the video plays at the right speed no
+ *   matter how long each frame took to draw.
+ */
+class FrameCapture : public Logging::Log {
+public:
+  FrameCapture(CFG* cfg);
+  ~FrameCapture();
+
+  // Starts capturing to the file at the given rate
+  void start(const std::string& filename, int framesPerSecond);
+
+  // Stops capturing once every frame has been written
+  void stop();
+
+  bool isCapturing() const;
+
+  // Returns the time between two frames of the video
+  float frameTime() const;
+
+  // Returns the number of frames that have been captured
+  size_t numFrames() const;
+
+  // Redirects drawing to the offscreen framebuffer
+  void beginFrame();
+
+  // Starts reading the frame back and shows it in the window
+  void endFrame();
+
+private:
+  enum class Format { Y4M, TGA };
+
+  struct Frame {
+    size_t                     index;
+    std::vector<unsigned char> pixels;
+  };
+
+  void createBuffers();
+  void deleteBuffers();
+
+  // Waits for the pixel buffer and hands its pixels to the writer
+  void readBack(unsigned int slot);
+  void finish();
+
+  void writeLoop();
+  void writeY4M(const Frame& frame);
+  void writeTGA(const Frame& frame);
+
+  static const unsigned int NUM_PIXEL_BUFFERS = 3;
+  static const unsigned int MAX_QUEUED_FRAMES = 8;
+
+  CFG*        mCFG;
+  Format      mFormat;
+  std::string mFilename;
+  int         mFramesPerSecond;
+  int         mWidth;
+  int         mHeight;
+  size_t      mNumFrames;
+  bool        mIsCapturing;
+  bool        mIsDrawing;
+  bool        mStopWanted;
+
+  GLuint       mFrameBuffer;
+  GLuint       mColorBuffer;
+  GLuint       mDepthBuffer;
+  GLuint       mPixelBuffers[NUM_PIXEL_BUFFERS];
+  GLsync       mFences[NUM_PIXEL_BUFFERS];
+  size_t       mPending[NUM_PIXEL_BUFFERS];
+  bool         mIsPending[NUM_PIXEL_BUFFERS];
+  unsigned int mNextPixelBuffer;
+
+  // Shared with the writer
+  std::thread                             mWriter;
+  std::mutex                              mMutex;
+  std::condition_variable                 mQueued;
+  std::condition_variable                 mWritten;
+  std::deque<Frame>                       mQueue;
+  std::vector<std::vector<unsigned char>> mFree;
+  bool                                    mIsDone;
+
+  // Only used by the writer
+  std::ofstream              mFile;
+  std::vector<unsigned char> mPlanes;
+  bool                       mFailed;
+};
@@ -10,9 +10,10 @@
 #include "../Utils/CFG.hpp"
 #include "../Utils/Utils.hpp"
 
-CFG*        Framebuffer::cfg   = NULL;
-std::string Framebuffer::ssLoc = "";
-int         Framebuffer::numSS = 0;
+CFG*        Framebuffer::cfg    = NULL;
+std::string Framebuffer::ssLoc  = "";
+int         Framebuffer::numSS  = 0;
+GLuint      Framebuffer::screen = 0;
 
 Framebuffer::Framebuffer()
     : Logging::Log("Framebuffer")
@@ -234,7 +235,7 @@ void Framebuffer::nonClearBind(std::shared_ptr<Program> program) {
  *   unbinding it and setting the viewport back to normal.
  */
 void Framebuffer::finalize() {
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, screen);
 
   // I removed this as it gave a significant performance increase,
   // however, there may have been a reason to why this was done
@@ -371,7 +372,7 @@ std::vector<float> Framebuffer::getPixels(const Rectangle& r, GLenum type) {
                &data[0]);
 
   // unbind it and viewport back to normal
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, screen);
   glViewport(0, 0, cfg->graphics.res.x, cfg->graphics.res.y);
 
   return data;
@@ -400,6 +401,37 @@ void Framebuffer::save(std::string filename) {
   mTexture->saveTexture(filename, mFrameSize);
 }
 
+/**
+ * @brief
+ *   Copies the depth or the color of the framebuffer into the target
+ *   without drawing a quad, which is how a depth framebuffer is filled
+ *   with depths that were drawn earlier.
+ *
+ * @param target
+ */
+void Framebuffer::copyTo(Framebuffer* target) {
+  failCheck();
+  target->failCheck();
+
+  if (mIsDepth != target->mIsDepth || mFrameSize.x != target->mFrameSize.x ||
+      mFrameSize.y != target->mFrameSize.y)
+    throw std::runtime_error("Can only copy to a framebuffer of the same kind");
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, mFrameBuffer);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target->mFrameBuffer);
+  glBlitFramebuffer(0,
+                    0,
+                    mFrameSize.x,
+                    mFrameSize.y,
+                    0,
+                    0,
+                    mFrameSize.x,
+                    mFrameSize.y,
+                    mIsDepth ? GL_DEPTH_BUFFER_BIT : GL_COLOR_BUFFER_BIT,
+                    GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, screen);
+}
+
 /* void Framebuffer::clear() { */
 /*   clearProgram->setUniform("screenRes", mFrameSize); */
 /*   doQuad(clearProgram, {}); */
@@ -457,7 +489,7 @@ void Framebuffer::takeScreenshot() {
 
   // make sure the framebuffer is the actual screen
   // and not some other framebuffer then read pixels
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, screen);
   glReadPixels(0, 0, res.x, res.y, GL_BGR, GL_UNSIGNED_BYTE, data);
 
   // store them as values between 0 and 255
@@ -485,6 +517,10 @@ void Framebuffer::takeScreenshot() {
   debug("Saved screenshot to: '", filename, "'");
 }
 
+void Framebuffer::setScreen(GLuint framebuffer) {
+  screen = framebuffer;
+}
+
 void Framebuffer::printFramebufferLimits() {
   int res;
   glGetIntegerv(GL_MAX_COLOR_ATTACHMENTS, &res);
@@ -101,6 +101,10 @@ public:
                    GLenum           type = GL_RED,
                    std::string      name = "Framebuffer");
   void save(std::string filename);
+
+  //! Copies the texture of the framebuffer into another framebuffer of the
+  //! same size and kind
+  void copyTo(Framebuffer* target);
   /* void copy(Texture* toCopy); */
   /* void clear(); */
 
@@ -115,6 +119,10 @@ public:
   static void takeScreenshot();
   static void printFramebufferLimits();
 
+  //! Sets the framebuffer that finalize() returns to, which is the
+  //! window unless the frames are being captured
+  static void setScreen(GLuint framebuffer);
+
 private:
   void setup();
 
@@ -136,4 +144,5 @@ private:
   static int         numSS;
   static std::string ssLoc;
   static CFG*        cfg;
+  static GLuint      screen;
 };
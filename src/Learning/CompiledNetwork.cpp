@@ -0,0 +1,629 @@
+#include "CompiledNetwork.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../Runtime/ControllerFile.hpp"
+
+#include <NeuralNetwork.h>
+
+/**
+ * @brief
+ *   Applies the activation function in the same way as
+ *   NEAT::NeuralNetwork::Activate, in either float or double precision
+ *
+ * @param function
+ * @param x
+ * @param a
+ * @param b
+ *
+ * @return
+ */
+template <typename T>
+static inline T activation(int function, T x, T a, T b) {
+  const T one  = 1;
+  const T half = 0.5;
+  const T two  = 2;
+  const T zero = 0;
+
+  switch (function) {
+    case NEAT::SIGNED_SIGMOID:
+      return (one / (one + std::exp(-a * x - b)) - half) * two;
+    case NEAT::UNSIGNED_SIGMOID:
+      return one / (one + std::exp(-a * x - b));
+    case NEAT::TANH:
+      return std::tanh(x * a);
+    case NEAT::TANH_CUBIC:
+      return std::tanh(x * x * x * a);
+    case NEAT::SIGNED_STEP:
+      return x > b ? one : -one;
+    case NEAT::UNSIGNED_STEP:
+      return x > half + b ? one : zero;
+    case NEAT::SIGNED_GAUSS:
+      return (std::exp(-a * x * x + b) - half) * two;
+    case NEAT::UNSIGNED_GAUSS:
+      return std::exp(-a * x * x + b);
+    case NEAT::ABS:
+      return std::abs(x + b);
+    case NEAT::SIGNED_SINE:
+      return std::sin(x * a + b);
+    case NEAT::UNSIGNED_SINE:
+      return (std::sin(x * a + b) + one) / two;
+    case NEAT::LINEAR:
+      return x + b;
+    case NEAT::RELU:
+      return x > zero ? x : zero;
+    case NEAT::SOFTPLUS:
+      return std::log(one + std::exp(x));
+    default:
+      return x;
+  }
+}
+
+/**
+ * @brief
+ *   Applies a single activation function to a run of neurons. Since the
+ *   function is known at compile time, the switch in activation is
+ *   removed and the loop only contains the function itself.
+ *
+ * @param x
+ * @param a
+ * @param b
+ * @param y
+ * @param size
+ */
+template <int Function, typename T>
+static void
+activateRun(const T* x, const T* a, const T* b, T* y, size_t size) {
+  for (size_t i = 0; i < size; ++i)
+    y[i] = activation(Function, x[i], a[i], b[i]);
+}
+
+template <typename T>
+static void activateRun(int      function,
+                        const T* x,
+                        const T* a,
+                        const T* b,
+                        T*       y,
+                        size_t   size) {
+  switch (function) {
+    case NEAT::SIGNED_SIGMOID:
+      return activateRun<NEAT::SIGNED_SIGMOID, T>(x, a, b, y, size);
+    case NEAT::UNSIGNED_SIGMOID:
+      return activateRun<NEAT::UNSIGNED_SIGMOID, T>(x, a, b, y, size);
+    case NEAT::TANH:
+      return activateRun<NEAT::TANH, T>(x, a, b, y, size);
+    case NEAT::TANH_CUBIC:
+      return activateRun<NEAT::TANH_CUBIC, T>(x, a, b, y, size);
+    case NEAT::SIGNED_STEP:
+      return activateRun<NEAT::SIGNED_STEP, T>(x, a, b, y, size);
+    case NEAT::UNSIGNED_STEP:
+      return activateRun<NEAT::UNSIGNED_STEP, T>(x, a, b, y, size);
+    case NEAT::SIGNED_GAUSS:
+      return activateRun<NEAT::SIGNED_GAUSS, T>(x, a, b, y, size);
+    case NEAT::UNSIGNED_GAUSS:
+      return activateRun<NEAT::UNSIGNED_GAUSS, T>(x, a, b, y, size);
+    case NEAT::ABS:
+      return activateRun<NEAT::ABS, T>(x, a, b, y, size);
+    case NEAT::SIGNED_SINE:
+      return activateRun<NEAT::SIGNED_SINE, T>(x, a, b, y, size);
+    case NEAT::UNSIGNED_SINE:
+      return activateRun<NEAT::UNSIGNED_SINE, T>(x, a, b, y, size);
+    case NEAT::LINEAR:
+      return activateRun<NEAT::LINEAR, T>(x, a, b, y, size);
+    case NEAT::RELU:
+      return activateRun<NEAT::RELU, T>(x, a, b, y, size);
+    case NEAT::SOFTPLUS:
+      return activateRun<NEAT::SOFTPLUS, T>(x, a, b, y, size);
+    default:
+      return activateRun<-1, T>(x, a, b, y, size);
+  }
+}
+
+/**
+ * @brief
+ *   Moves each membrane potential towards the sum of its inputs by its
+ *   rate, and stores the potential plus the bias in x. This is the same
+ *   calculation as NEAT::NeuralNetwork::ActivateLeaky, done two neurons
+ *   at a time with SSE2 when it is available. The float version below
+ *   does four at a time.
+ *
+ * @param rate
+ * @param sum
+ * @param bias
+ * @param membrane
+ * @param x
+ * @param size
+ */
+static void integrate(const double* rate,
+                      const double* sum,
+                      const double* bias,
+                      double*       membrane,
+                      double*       x,
+                      size_t        size) {
+  size_t i = 0;
+
+#ifdef __SSE2__
+  const __m128d one = _mm_set1_pd(1.0);
+
+  for (; i + 2 <= size; i += 2) {
+    __m128d r = _mm_loadu_pd(rate + i);
+    __m128d m = _mm_loadu_pd(membrane + i);
+    __m128d s = _mm_loadu_pd(sum + i);
+
+    m = _mm_add_pd(_mm_mul_pd(_mm_sub_pd(one, r), m), _mm_mul_pd(r, s));
+
+    _mm_storeu_pd(membrane + i, m);
+    _mm_storeu_pd(x + i, _mm_add_pd(m, _mm_loadu_pd(bias + i)));
+  }
+#endif
+
+  for (; i < size; ++i) {
+    membrane[i] = (1.0 - rate[i]) * membrane[i] + rate[i] * sum[i];
+    x[i]        = membrane[i] + bias[i];
+  }
+}
+
+static void integrate(const float* rate,
+                      const float* sum,
+                      const float* bias,
+                      float*       membrane,
+                      float*       x,
+                      size_t       size) {
+  size_t i = 0;
+
+#ifdef __SSE2__
+  const __m128 one = _mm_set1_ps(1.0f);
+
+  for (; i + 4 <= size; i += 4) {
+    __m128 r = _mm_loadu_ps(rate + i);
+    __m128 m = _mm_loadu_ps(membrane + i);
+    __m128 s = _mm_loadu_ps(sum + i);
+
+    m = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(one, r), m), _mm_mul_ps(r, s));
+
+    _mm_storeu_ps(membrane + i, m);
+    _mm_storeu_ps(x + i, _mm_add_ps(m, _mm_loadu_ps(bias + i)));
+  }
+#endif
+
+  for (; i < size; ++i) {
+    membrane[i] = (1.0f - rate[i]) * membrane[i] + rate[i] * sum[i];
+    x[i]        = membrane[i] + bias[i];
+  }
+}
+
+template <typename T>
+BasicCompiledNetwork<T>::BasicCompiledNetwork()
+    : mNumInputs(0), mNumOutputs(0), mNumLayers(0), mStep(-1) {}
+
+/**
+ * @brief
+ *   Sorts the neurons into layers and stores the connections going into
+ *   each neuron next to each other.
+ *
+ *   First a depth first search marks every connection that leads back to
+ *   a neuron that is still being searched as recurrent. The remaining
+ *   connections have no cycles, so each neuron is put in the layer after
+ *   the last of its sources. Inputs are never activated, so connections
+ *   into them are ignored just like Activate does.
+ *
+ * @param network
+ */
+template <typename T>
+void BasicCompiledNetwork<T>::compile(const NEAT::NeuralNetwork& network) {
+  const auto& neurons     = network.m_neurons;
+  const auto& connections = network.m_connections;
+  size_t      size        = neurons.size();
+
+  mNumInputs  = std::min<size_t>(network.m_num_inputs, size);
+  mNumOutputs = network.m_num_outputs;
+
+  std::vector<std::vector<uint32_t>> outgoing(size);
+
+  for (uint32_t i = 0; i < connections.size(); ++i)
+    if (connections[i].m_target_neuron_idx >= mNumInputs)
+      outgoing[connections[i].m_source_neuron_idx].push_back(i);
+
+  // 0 = not visited, 1 = on the stack, 2 = done
+  std::vector<char>                          state(size, 0);
+  std::vector<bool>                          recurrent(connections.size());
+  std::vector<std::pair<uint32_t, uint32_t>> stack;
+
+  for (uint32_t root = 0; root < size; ++root) {
+    if (state[root] != 0)
+      continue;
+
+    state[root] = 1;
+    stack.push_back({ root, 0 });
+
+    while (!stack.empty()) {
+      uint32_t  node = stack.back().first;
+      uint32_t& next = stack.back().second;
+
+      if (next == outgoing[node].size()) {
+        state[node] = 2;
+        stack.pop_back();
+        continue;
+      }
+
+      uint32_t c      = outgoing[node][next++];
+      uint32_t target = connections[c].m_target_neuron_idx;
+
+      if (state[target] == 1) {
+        recurrent[c] = true;
+      } else if (state[target] == 0) {
+        state[target] = 1;
+        stack.push_back({ target, 0 });
+      }
+    }
+  }
+
+  // Find the layer of each neuron using the connections that are left,
+  // going through the neurons in topological order
+  std::vector<uint32_t> layer(size, 0);
+  std::vector<uint32_t> numIncoming(size, 0);
+  std::vector<uint32_t> ready;
+
+  for (uint32_t i = 0; i < connections.size(); ++i)
+    if (!recurrent[i] && connections[i].m_target_neuron_idx >= mNumInputs)
+      numIncoming[connections[i].m_target_neuron_idx] += 1;
+
+  for (uint32_t i = 0; i < size; ++i) {
+    if (i >= mNumInputs)
+      layer[i] = 1;
+
+    if (numIncoming[i] == 0)
+      ready.push_back(i);
+  }
+
+  while (!ready.empty()) {
+    uint32_t node = ready.back();
+    ready.pop_back();
+
+    for (auto c : outgoing[node]) {
+      if (recurrent[c])
+        continue;
+
+      uint32_t target = connections[c].m_target_neuron_idx;
+      layer[target]   = std::max(layer[target], layer[node] + 1);
+
+      if (--numIncoming[target] == 0)
+        ready.push_back(target);
+    }
+  }
+
+  mOrder.clear();
+
+  for (uint32_t i = mNumInputs; i < size; ++i)
+    mOrder.push_back(i);
+
+  // Neurons of the same layer do not depend on each other, so they are
+  // grouped by activation function as well
+  std::stable_sort(mOrder.begin(),
+                   mOrder.end(),
+                   [&](uint32_t a, uint32_t b) {
+                     if (layer[a] != layer[b])
+                       return layer[a] < layer[b];
+
+                     return neurons[a].m_activation_function_type <
+                            neurons[b].m_activation_function_type;
+                   });
+
+  mNumLayers = mOrder.empty() ? 0 : layer[mOrder.back()];
+
+  // Store the connections by the position of their target in mOrder
+  std::vector<uint32_t> position(size, 0);
+
+  for (uint32_t i = 0; i < mOrder.size(); ++i)
+    position[mOrder[i]] = i;
+
+  std::vector<std::vector<uint32_t>> forward(mOrder.size());
+  std::vector<std::vector<uint32_t>> backward(mOrder.size());
+
+  for (uint32_t i = 0; i < connections.size(); ++i) {
+    uint32_t target = connections[i].m_target_neuron_idx;
+
+    if (target < mNumInputs)
+      continue;
+
+    if (recurrent[i])
+      backward[position[target]].push_back(i);
+    else
+      forward[position[target]].push_back(i);
+  }
+
+  mFunction.clear();
+  mA.clear();
+  mB.clear();
+  mRuns.clear();
+  mTimeConst.clear();
+  mBias.clear();
+  mForwardStart   = { 0 };
+  mRecurrentStart = { 0 };
+  mForwardSource.clear();
+  mForwardWeight.clear();
+  mRecurrentSource.clear();
+  mRecurrentWeight.clear();
+
+  for (uint32_t i = 0; i < mOrder.size(); ++i) {
+    const NEAT::Neuron& n = neurons[mOrder[i]];
+
+    mFunction.push_back(n.m_activation_function_type);
+    mA.push_back(n.m_a);
+    mB.push_back(n.m_b);
+    mTimeConst.push_back(n.m_timeconst);
+    mBias.push_back(n.m_bias);
+
+    if (mRuns.empty() || mRuns.back().function != mFunction.back())
+      mRuns.push_back({ i, i, mFunction.back() });
+
+    mRuns.back().end = i + 1;
+
+    for (auto c : forward[i]) {
+      mForwardSource.push_back(connections[c].m_source_neuron_idx);
+      mForwardWeight.push_back(connections[c].m_weight);
+    }
+
+    for (auto c : backward[i]) {
+      mRecurrentSource.push_back(connections[c].m_source_neuron_idx);
+      mRecurrentWeight.push_back(connections[c].m_weight);
+    }
+
+    mForwardStart.push_back(mForwardSource.size());
+    mRecurrentStart.push_back(mRecurrentSource.size());
+  }
+
+  mActivation.assign(size, T(0));
+  mPrevious.assign(isRecurrent() ? size : 0, T(0));
+  mMembrane.assign(mOrder.size(), T(0));
+  mRate.assign(mOrder.size(), T(0));
+  mSum.assign(mOrder.size(), T(0));
+  mValue.assign(mOrder.size(), T(0));
+  mStep = -1;
+}
+
+template <typename T>
+void BasicCompiledNetwork<T>::flush() {
+  std::fill(mActivation.begin(), mActivation.end(), T(0));
+  std::fill(mPrevious.begin(), mPrevious.end(), T(0));
+  std::fill(mMembrane.begin(), mMembrane.end(), T(0));
+}
+
+/**
+ * @brief
+ *   Activates the network. A feed forward network is always done after a
+ *   single pass. A recurrent network runs up to maxPasses passes, stopping
+ *   when the largest change of any activation is at most the tolerance.
+ *
+ * @param maxPasses
+ * @param tolerance
+ *
+ * @return
+ */
+template <typename T>
+unsigned int BasicCompiledNetwork<T>::activate(unsigned int maxPasses,
+                                              double       tolerance) {
+  pass();
+
+  if (!isRecurrent())
+    return 1;
+
+  unsigned int passes = 1;
+
+  while (passes < maxPasses) {
+    pass();
+    passes += 1;
+
+    double change = 0;
+
+    for (auto i : mOrder) {
+      double diff = std::abs(mActivation[i] - mPrevious[i]);
+      change      = std::max(change, diff);
+    }
+
+    if (change <= tolerance)
+      break;
+  }
+
+  return passes;
+}
+
+/**
+ * @brief
+ *   Activates the network as a continuous time recurrent network. Every
+ *   neuron is updated at the same time, using the activations from the
+ *   previous step, so the layers and recurrent connections are treated
+ *   the same. Neurons without a positive time constant follow their
+ *   input immediately.
+ *
+ * @param step
+ * @param steps
+ */
+template <typename T>
+void BasicCompiledNetwork<T>::activateLeaky(double step, unsigned int steps) {
+  if (step != mStep) {
+    for (size_t i = 0; i < mRate.size(); ++i)
+      mRate[i] = mTimeConst[i] > 0 ? T(step / mTimeConst[i]) : T(1);
+
+    mStep = step;
+  }
+
+  for (unsigned int i = 0; i < steps; ++i)
+    leakyStep();
+}
+
+template <typename T>
+size_t BasicCompiledNetwork<T>::numLayers() const {
+  return mNumLayers;
+}
+
+template <typename T>
+bool BasicCompiledNetwork<T>::isRecurrent() const {
+  return !mRecurrentSource.empty();
+}
+
+template <typename T>
+size_t BasicCompiledNetwork<T>::numNeurons() const {
+  return mActivation.size();
+}
+
+template <typename T>
+size_t BasicCompiledNetwork<T>::numConnections() const {
+  return mForwardSource.size() + mRecurrentSource.size();
+}
+
+/**
+ * @brief
+ *   Converts the activation function to the one used by ControllerFile
+ *
+ * @param function
+ *
+ * @return
+ */
+static ControllerFile::Function exportFunction(int function) {
+  typedef ControllerFile::Function F;
+
+  switch (function) {
+    case NEAT::SIGNED_SIGMOID:
+      return F::SignedSigmoid;
+    case NEAT::UNSIGNED_SIGMOID:
+      return F::UnsignedSigmoid;
+    case NEAT::TANH:
+      return F::Tanh;
+    case NEAT::TANH_CUBIC:
+      return F::TanhCubic;
+    case NEAT::SIGNED_STEP:
+      return F::SignedStep;
+    case NEAT::UNSIGNED_STEP:
+      return F::UnsignedStep;
+    case NEAT::SIGNED_GAUSS:
+      return F::SignedGauss;
+    case NEAT::UNSIGNED_GAUSS:
+      return F::UnsignedGauss;
+    case NEAT::ABS:
+      return F::Abs;
+    case NEAT::SIGNED_SINE:
+      return F::SignedSine;
+    case NEAT::UNSIGNED_SINE:
+      return F::UnsignedSine;
+    case NEAT::LINEAR:
+      return F::Linear;
+    case NEAT::RELU:
+      return F::Relu;
+    case NEAT::SOFTPLUS:
+      return F::Softplus;
+    default:
+      throw std::runtime_error("Unable to export activation function " +
+                               std::to_string(function));
+  }
+}
+
+/**
+ * @brief
+ *   Stores the neurons in the order of activation and the connections by
+ *   the position of their target in that order, which is what
+ *   ControllerRuntime expects.
+ *
+ * @param file
+ */
+template <typename T>
+void BasicCompiledNetwork<T>::exportTo(ControllerFile& file) const {
+  file.numNeurons = mActivation.size();
+  file.numInputs  = mNumInputs;
+  file.numOutputs = mNumOutputs;
+  file.neurons.clear();
+  file.connections.clear();
+
+  for (uint32_t i = 0; i < mOrder.size(); ++i) {
+    file.neurons.push_back({ mOrder[i],
+                             exportFunction(mFunction[i]),
+                             static_cast<float>(mA[i]),
+                             static_cast<float>(mB[i]),
+                             static_cast<float>(mTimeConst[i]),
+                             static_cast<float>(mBias[i]) });
+
+    for (uint32_t c = mForwardStart[i]; c < mForwardStart[i + 1]; ++c)
+      file.connections.push_back(
+        { i, mForwardSource[c], static_cast<float>(mForwardWeight[c]), false });
+
+    for (uint32_t c = mRecurrentStart[i]; c < mRecurrentStart[i + 1]; ++c)
+      file.connections.push_back({ i,
+                                   mRecurrentSource[c],
+                                   static_cast<float>(mRecurrentWeight[c]),
+                                   true });
+  }
+}
+
+/**
+ * @brief
+ *   Activates each neuron once, in the order of the layers. Recurrent
+ *   connections read the activations from before the pass.
+ */
+template <typename T>
+void BasicCompiledNetwork<T>::pass() {
+  if (isRecurrent())
+    mPrevious = mActivation;
+
+  for (size_t i = 0; i < mOrder.size(); ++i) {
+    T sum = 0;
+
+    for (uint32_t c = mForwardStart[i]; c < mForwardStart[i + 1]; ++c)
+      sum += mActivation[mForwardSource[c]] * mForwardWeight[c];
+
+    for (uint32_t c = mRecurrentStart[i]; c < mRecurrentStart[i + 1]; ++c)
+      sum += mPrevious[mRecurrentSource[c]] * mRecurrentWeight[c];
+
+    mActivation[mOrder[i]] = activation(mFunction[i], sum, mA[i], mB[i]);
+  }
+}
+
+/**
+ * @brief
+ *   Sums the input of every neuron before any activation is changed, then
+ *   integrates and activates all of them in the order of activation.
+ */
+template <typename T>
+void BasicCompiledNetwork<T>::leakyStep() {
+  size_t size = mOrder.size();
+
+  for (size_t i = 0; i < size; ++i) {
+    T sum = 0;
+
+    for (uint32_t c = mForwardStart[i]; c < mForwardStart[i + 1]; ++c)
+      sum += mActivation[mForwardSource[c]] * mForwardWeight[c];
+
+    for (uint32_t c = mRecurrentStart[i]; c < mRecurrentStart[i + 1]; ++c)
+      sum += mActivation[mRecurrentSource[c]] * mRecurrentWeight[c];
+
+    mSum[i] = sum;
+  }
+
+  integrate(mRate.data(),
+            mSum.data(),
+            mBias.data(),
+            mMembrane.data(),
+            mValue.data(),
+            size);
+
+  for (auto& run : mRuns) {
+    activateRun(run.function,
+                mValue.data() + run.begin,
+                mA.data() + run.begin,
+                mB.data() + run.begin,
+                mValue.data() + run.begin,
+                run.end - run.begin);
+  }
+
+  for (size_t i = 0; i < size; ++i)
+    mActivation[mOrder[i]] = mValue[i];
+}
+
+template class BasicCompiledNetwork<float>;
+template class BasicCompiledNetwork<double>;
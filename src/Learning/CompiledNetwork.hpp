@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct ControllerFile;
+
+namespace NEAT {
+  class NeuralNetwork;
+}
+
+/**
+ * @brief
+ *   A flattened copy of a NEAT::NeuralNetwork that is laid out for
+ *   activating it as fast as possible.
+ *
+ *   NEAT::NeuralNetwork::Activate moves the signal a single connection
+ *   forward each time it is called, so it has to be called as many times
+ *   as the network is deep. Since the depth is not known, the Phenotype
+ *   used to activate a fixed number of times, which is either too few for
+ *   deep networks or wasted work for shallow ones.
+ *
+ *   When compiled, the neurons are sorted into layers where every neuron
+ *   only depends on neurons of earlier layers, so a single pass through
+ *   the layers gives the same result as activating a feed forward network
+ *   until it is stable.
+ *
+ *   Connections that would create a cycle are marked as recurrent, found
+ *   by a depth first search in the order of the neurons. They read the
+ *   activation of their source from the previous pass instead, which is 0
+ *   after a flush. Networks with recurrent connections can be activated
+ *   several times, stopping early once no activation changes more than
+ *   a given tolerance.
+ *
+ *   The connections going into each neuron are stored contiguously, in the
+ *   order the neurons are activated.
+ *
+ *   Leaky (CTRNN) networks are activated with activateLeaky instead, which
+ *   updates every neuron at the same time like
+ *   NEAT::NeuralNetwork::ActivateLeaky. The membrane potential, time
+ *   constant and bias of each neuron are kept in arrays in the order of
+ *   activation so that the integration step runs over contiguous memory
+ *   with SIMD. Within a layer the neurons are sorted by activation
+ *   function, letting the activation functions be applied to whole runs
+ *   of neurons at a time.
+ *
+ *   The network can be compiled with either double or float precision.
+ *   Floats halve the memory the network reads each activation and let the
+ *   SIMD code handle twice as many neurons at a time, at the cost of
+ *   rounding the weights and activations.
+ */
+template <typename T>
+class BasicCompiledNetwork {
+public:
+  BasicCompiledNetwork();
+
+  // Compiles the network, replacing whatever was compiled before
+  void compile(const NEAT::NeuralNetwork& network);
+
+  // Sets every activation to 0
+  void flush();
+
+  // Sets the activation of the input neurons
+  template <typename U>
+  void input(const std::vector<U>& inputs);
+
+  // Activates every layer once per pass, returning the number of passes.
+  // Only recurrent networks run more than a single pass
+  unsigned int activate(unsigned int maxPasses = 1, double tolerance = 0.0);
+
+  // Integrates the membrane potentials `steps` times, each covering `step`
+  // seconds. The potentials are kept until the next flush or compile
+  void activateLeaky(double step, unsigned int steps = 1);
+
+  // Copies the activations of the output neurons into outputs, resizing
+  // it to the number of outputs
+  template <typename U>
+  void output(std::vector<U>& outputs) const;
+
+  // Returns the number of layers, not counting the inputs
+  size_t numLayers() const;
+
+  // Whether or not the network has any recurrent connections
+  bool isRecurrent() const;
+
+  size_t numNeurons() const;
+  size_t numConnections() const;
+
+  // Stores the compiled network in the file, leaving the mapping and the
+  // activation settings as they are
+  void exportTo(ControllerFile& file) const;
+
+private:
+  // Runs a single pass through all layers
+  void pass();
+
+  // Runs a single step of the leaky integration
+  void leakyStep();
+
+  //! Neurons mOrder[begin] to mOrder[end] share the activation function
+  struct Run {
+    uint32_t begin;
+    uint32_t end;
+    int      function;
+  };
+
+  unsigned int mNumInputs;
+  unsigned int mNumOutputs;
+  size_t       mNumLayers;
+
+  // The neurons that are activated, in the order of activation
+  std::vector<uint32_t> mOrder;
+  std::vector<int>      mFunction;
+  std::vector<T>        mA;
+  std::vector<T>        mB;
+  std::vector<Run>      mRuns;
+
+  // mForwardStart[i] to mForwardStart[i + 1] are the connections going into
+  // mOrder[i]. The same goes for mRecurrentStart
+  std::vector<uint32_t> mForwardStart;
+  std::vector<uint32_t> mForwardSource;
+  std::vector<T>        mForwardWeight;
+  std::vector<uint32_t> mRecurrentStart;
+  std::vector<uint32_t> mRecurrentSource;
+  std::vector<T>        mRecurrentWeight;
+
+  // Leaky integration, in the order of activation. mRate is the step
+  // divided by the time constant, recomputed whenever the step changes
+  std::vector<T> mTimeConst;
+  std::vector<T> mBias;
+  std::vector<T> mMembrane;
+  std::vector<T> mRate;
+  std::vector<T> mSum;
+  std::vector<T> mValue;
+  double         mStep;
+
+  // Indexed by the index of the neuron in the original network
+  std::vector<T> mActivation;
+  std::vector<T> mPrevious;
+};
+
+template <typename T>
+template <typename U>
+void BasicCompiledNetwork<T>::input(const std::vector<U>& inputs) {
+  size_t size = inputs.size() < mNumInputs ? inputs.size() : mNumInputs;
+
+  for (size_t i = 0; i < size; ++i)
+    mActivation[i] = static_cast<T>(inputs[i]);
+}
+
+template <typename T>
+template <typename U>
+void BasicCompiledNetwork<T>::output(std::vector<U>& outputs) const {
+  size_t begin = mNumInputs < mActivation.size() ? mNumInputs : 0;
+  size_t end   = begin + mNumOutputs;
+
+  if (end > mActivation.size())
+    end = mActivation.size();
+
+  outputs.resize(end - begin);
+
+  for (size_t i = begin; i < end; ++i)
+    outputs[i - begin] = static_cast<U>(mActivation[i]);
+}
+
+typedef BasicCompiledNetwork<double> CompiledNetwork;
+typedef BasicCompiledNetwork<float>  CompiledNetworkF;
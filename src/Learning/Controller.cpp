@@ -4,6 +4,8 @@
 #include "../GlobalLog.hpp"
 #include "../Input/Event.hpp"
 #include "../OpenGLHeaders.hpp"
+#include "../Utils/ThreadPool.hpp"
+#include "ESHyperNEAT.hpp"
 #include "Phenotype.hpp"
 #include "Substrate.hpp"
 
@@ -22,9 +24,11 @@ void buildNetwork(Experiment*          experiment,
                   NEAT::NeuralNetwork* network,
                   NEAT::Genome&        g) {
   if (experiment->parameters().useESHyperNEAT) {
-    g.BuildESHyperNEATPhenotype(*network,
-                                *experiment->substrate(),
-                                experiment->population()->m_Parameters);
+    ESHyperNEAT::build(g,
+                       *network,
+                       *experiment->substrate(),
+                       experiment->population()->m_Parameters,
+                       &ThreadPool::global());
   } else {
     g.BuildHyperNEATPhenotype(*network, *experiment->substrate());
   }
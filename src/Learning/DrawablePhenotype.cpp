@@ -9,8 +9,8 @@
 #include "../Utils/Utils.hpp"
 
 #include "../3D/Line.hpp"
-#include "../3D/Sphere.hpp"
 #include "../Shape/GL/Shape.hpp"
+#include "../Shape/GL/Sphere.hpp"
 
 #include "../GlobalLog.hpp"
 
@@ -18,6 +18,17 @@ using mmm::vec2;
 using mmm::vec3;
 using mmm::vec4;
 
+// The first of the locations used by the instances of the Model shader
+static const GLuint INSTANCE_MODEL_LOCATION = 3;
+static const GLuint INSTANCE_COLOR_LOCATION = 7;
+
+static const int MODEL_UNIFORM = Program::uniformId("model");
+static const int INSTANCED_UNIFORM = Program::uniformId("instanced");
+static const int INSTANCE_COLORS_UNIFORM =
+  Program::uniformId("useInstanceColors");
+static const int NORMALS_AS_COLORS_UNIFORM =
+  Program::uniformId("useNormalsAsColors");
+
 float scale(double coord,
             double minCoord,
             double maxCoord,
@@ -42,7 +53,14 @@ DrawablePhenotype::DrawablePhenotype()
     , mVBO(0)
     , mVAO(0)
     , mVBO3D(0)
-    , mVAO3D(0) {
+    , mVAO3D(0)
+    , mNumNeurons(0)
+    , mSphereOffset(0)
+    , mSpheresUploaded(false)
+    , mSphereBuffer(0)
+    , mSphereCapacity(0)
+    , mFilledSphere(new GLSphere())
+    , mOutlineSphere(new GLSphere(true)) {
   ResourceManager* r = mAsset->rManager();
 
   mModelColorProgram = r->get<Program>("Program::Model");
@@ -56,6 +74,10 @@ DrawablePhenotype::~DrawablePhenotype() {
   glDeleteVertexArrays(1, &mVAO);
   glDeleteBuffers(1, &mVBO3D);
   glDeleteVertexArrays(1, &mVAO3D);
+  glDeleteBuffers(1, &mSphereBuffer);
+
+  delete mFilledSphere;
+  delete mOutlineSphere;
 }
 
 void DrawablePhenotype::input(const Input::Event&) {}
@@ -150,11 +172,8 @@ void DrawablePhenotype::recreate(const NEAT::NeuralNetwork& network,
 
   float maxWeight = findMaxConnectionWeight(network);
 
-  if (mDrawables.size()) {
-    for (auto& a : mDrawables)
-      delete a;
-    mDrawables.clear();
-  }
+  mSpheres.clear();
+  mSpheresUploaded = false;
 
   std::vector<GLShape::Vertex> lines;
   // Create a line for each connection, making the color depend on the
@@ -304,14 +323,12 @@ void DrawablePhenotype::recreate(const NEAT::NeuralNetwork& network,
 
   Utils::assertGL();
 
-  if (mVBO3D != 0)
-    glDeleteBuffers(1, &mVBO3D);
-
-  if (mVAO3D != 0)
-    glDeleteVertexArrays(1, &mVAO3D);
-
-  glGenBuffers(1, &mVBO3D);
-  glGenVertexArrays(1, &mVAO3D);
+  // The buffers are kept between networks, as the same phenotype is
+  // recreated every generation
+  if (mVAO3D == 0) {
+    glGenBuffers(1, &mVBO3D);
+    glGenVertexArrays(1, &mVAO3D);
+  }
 
   glBindVertexArray(mVAO3D);
 
@@ -319,7 +336,7 @@ void DrawablePhenotype::recreate(const NEAT::NeuralNetwork& network,
   glBindBuffer(GL_ARRAY_BUFFER, mVBO3D);
   glBufferData(GL_ARRAY_BUFFER,
                sizeof(GLShape::Vertex) * lines.size(),
-               &lines[0],
+               lines.data(),
                GL_STATIC_DRAW);
   Utils::assertGL();
 
@@ -344,8 +361,8 @@ void DrawablePhenotype::recreate(const NEAT::NeuralNetwork& network,
   glBindVertexArray(0);
   Utils::assertGL();
 
-  std::vector<Drawable3D*> filled;
-  /* filled.resize(network.m_neurons.size()); */
+  std::vector<SphereInstance> filled;
+  mNumNeurons = network.m_neurons.size();
   // For each neuron where an outline of the circle indicates the type
   // of neuron.
   //
@@ -392,11 +409,18 @@ void DrawablePhenotype::recreate(const NEAT::NeuralNetwork& network,
     radiusFilled = neuronRadius; // * mmm::clamp(neuron.m_activation, 0.3, 2.0);
     colorFilled  = mmm::clamp(colorFilled, 0.0, 1.0);
 
-    filled.push_back(new Sphere(pos, radiusFilled, colorFilled));
-    mDrawables.push_back(new Sphere(pos, radiusOutline, colorOutline, true));
+    // Same orientation as the Sphere drawable
+    mmm::mat4 rotation = mmm::rotate_x(-90.f);
+
+    filled.push_back({ mmm::translate(pos) * rotation *
+                         mmm::scale(vec3(radiusFilled)),
+                       colorFilled });
+    mSpheres.push_back({ mmm::translate(pos) * rotation *
+                           mmm::scale(vec3(radiusOutline)),
+                         colorOutline });
   }
 
-  mDrawables.insert(mDrawables.end(), filled.begin(), filled.end());
+  mSpheres.insert(mSpheres.end(), filled.begin(), filled.end());
 }
 
 void DrawablePhenotype::recreate(const NEAT::NeuralNetwork& network,
@@ -599,20 +623,33 @@ void DrawablePhenotype::draw() {
   glBindVertexArray(0);
 }
 
+/**
+ * @brief
+ *   Draws the network in 3D. The outlines and the filled spheres of the
+ *   neurons are drawn with one instanced draw call each, followed by the
+ *   connections.
+ *
+ * @param offset
+ */
 void DrawablePhenotype::draw3D(mmm::vec3 offset) {
   if (mVAO3D == 0)
     return;
 
-  for (auto& d : mDrawables) {
-    if (d == nullptr)
-      std::cout << "nullptr" << std::endl;
-    else
-      d->draw(mModelColorProgram, offset, true);
-  }
+  if (!mSpheresUploaded || offset.x != mSphereOffset.x ||
+      offset.y != mSphereOffset.y || offset.z != mSphereOffset.z)
+    uploadSpheres(offset);
 
   mModelColorProgram->bind();
-  mModelColorProgram->setUniform("model", mmm::translate(offset));
-  mModelColorProgram->setUniform("useNormalsAsColors", true);
+  mModelColorProgram->setUniform(INSTANCED_UNIFORM, true);
+  mModelColorProgram->setUniform(INSTANCE_COLORS_UNIFORM, true);
+
+  drawSpheres(mOutlineSphere, 0, mNumNeurons);
+  drawSpheres(mFilledSphere, mNumNeurons, mNumNeurons);
+
+  mModelColorProgram->setUniform(INSTANCED_UNIFORM, false);
+  mModelColorProgram->setUniform(INSTANCE_COLORS_UNIFORM, false);
+  mModelColorProgram->setUniform(MODEL_UNIFORM, mmm::translate(offset));
+  mModelColorProgram->setUniform(NORMALS_AS_COLORS_UNIFORM, true);
 
   glBindVertexArray(mVAO3D);
 
@@ -620,7 +657,100 @@ void DrawablePhenotype::draw3D(mmm::vec3 offset) {
 
   glBindVertexArray(0);
 
-  mModelColorProgram->setUniform("useNormalsAsColors", false);
+  mModelColorProgram->setUniform(NORMALS_AS_COLORS_UNIFORM, false);
+}
+
+/**
+ * @brief
+ *   Uploads the spheres to the instance buffer, moved by the offset. The
+ *   buffer only grows, and is otherwise orphaned before being written to.
+ *
+ * @param offset
+ */
+void DrawablePhenotype::uploadSpheres(const mmm::vec3& offset) {
+  std::vector<SphereInstance> instances;
+  instances.reserve(mSpheres.size());
+
+  // The matrices are stored by column, as OpenGL expects
+  for (auto& sphere : mSpheres)
+    instances.push_back(
+      { mmm::transpose(mmm::translate(offset) * sphere.model), sphere.color });
+
+  if (mSphereBuffer == 0)
+    glGenBuffers(1, &mSphereBuffer);
+
+  glBindBuffer(GL_ARRAY_BUFFER, mSphereBuffer);
+
+  if (instances.size() > mSphereCapacity)
+    mSphereCapacity = instances.size();
+
+  glBufferData(GL_ARRAY_BUFFER,
+               mSphereCapacity * sizeof(SphereInstance),
+               nullptr,
+               GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER,
+                  0,
+                  instances.size() * sizeof(SphereInstance),
+                  instances.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  mSphereOffset    = offset;
+  mSpheresUploaded = true;
+}
+
+/**
+ * @brief
+ *   Draws a range of the uploaded spheres. The vertex array of the sphere
+ *   is shared by every sphere, so the instance attributes are pointed at
+ *   the first sphere of the range and disabled again afterwards.
+ *
+ * @param sphere
+ * @param first
+ * @param count
+ */
+void DrawablePhenotype::drawSpheres(GLSphere* sphere,
+                                    size_t    first,
+                                    size_t    count) {
+  if (count == 0)
+    return;
+
+  size_t stride = sizeof(SphereInstance);
+  size_t start  = first * stride;
+
+  sphere->bindVertexArray();
+  glBindBuffer(GL_ARRAY_BUFFER, mSphereBuffer);
+
+  for (GLuint i = 0; i < 4; ++i) {
+    GLuint location = INSTANCE_MODEL_LOCATION + i;
+
+    glEnableVertexAttribArray(location);
+    glVertexAttribDivisor(location, 1);
+    glVertexAttribPointer(location,
+                          4,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          stride,
+                          (void*) (start + i * sizeof(mmm::vec4)));
+  }
+
+  glEnableVertexAttribArray(INSTANCE_COLOR_LOCATION);
+  glVertexAttribDivisor(INSTANCE_COLOR_LOCATION, 1);
+  glVertexAttribPointer(INSTANCE_COLOR_LOCATION,
+                        4,
+                        GL_FLOAT,
+                        GL_FALSE,
+                        stride,
+                        (void*) (start + sizeof(mmm::mat4)));
+
+  sphere->drawInstanced(static_cast<int>(count));
+
+  for (GLuint i = 0; i < 4; ++i)
+    glDisableVertexAttribArray(INSTANCE_MODEL_LOCATION + i);
+
+  glDisableVertexAttribArray(INSTANCE_COLOR_LOCATION);
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  sphere->unbindVertexArray();
 }
 
 void DrawablePhenotype::save(const std::string&) {}
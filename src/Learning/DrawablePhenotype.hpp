@@ -9,7 +9,7 @@
 
 class Texture;
 class Program;
-class Drawable3D;
+class GLSphere;
 struct Phenotype;
 
 namespace NEAT {
@@ -28,6 +28,10 @@ namespace NEAT {
  *   as it was when this structure was created.
  *
  *   It can either be drawn to the screen or saved to file.
+ *
+ *   In 3D, the neurons of the network are drawn as instances of one
+ *   sphere, so that a network only needs two draw calls for its neurons
+ *   and one for its connections, no matter how large it is.
  */
 class DrawablePhenotype : Drawable {
 
@@ -74,6 +78,18 @@ private:
 
   float findMaxConnectionWeight(const NEAT::NeuralNetwork& network);
 
+  // Uploads the spheres moved by the offset to the instance buffer
+  void uploadSpheres(const mmm::vec3& offset);
+
+  // Draws a range of the spheres in the instance buffer
+  void drawSpheres(GLSphere* sphere, size_t first, size_t count);
+
+  // A neuron drawn as a sphere, as stored in the instance buffer
+  struct SphereInstance {
+    mmm::mat4 model;
+    mmm::vec4 color;
+  };
+
   mmm::vec2 mSize;
 
   int mNum3DLines;
@@ -87,7 +103,19 @@ private:
   GLuint mVBO3D;
   GLuint mVAO3D;
 
-  std::vector<Drawable3D*> mDrawables;
+  // The outline of every neuron, followed by the filled spheres
+  std::vector<SphereInstance> mSpheres;
+  size_t                      mNumNeurons;
+
+  // The offset the spheres were uploaded with, since they are
+  // usually drawn at the same place every frame
+  mmm::vec3 mSphereOffset;
+  bool      mSpheresUploaded;
+  GLuint    mSphereBuffer;
+  size_t    mSphereCapacity;
+
+  GLSphere* mFilledSphere;
+  GLSphere* mOutlineSphere;
 
   std::shared_ptr<Program> mLinesProgram;
   std::shared_ptr<Program> mOutlineCircleProgram;
@@ -0,0 +1,856 @@
+#include "ESHyperNEAT.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "../Utils/ThreadPool.hpp"
+#include "Substrate.hpp"
+
+#include <Genome.h>
+#include <NeuralNetwork.h>
+#include <Parameters.h>
+
+namespace {
+  typedef std::vector<double> Point;
+
+  //! Whether `build` uses buildParallel instead of MultiNEAT
+  std::atomic<bool> useParallel(false);
+
+  //! A square of the quadtree, with the CPPN output at its center
+  struct QuadPoint {
+    double x;
+    double y;
+    double width;
+    double height;
+    double weight;
+    double leo;
+    int    level;
+    int    children; // Index of the first of four children, or -1
+  };
+
+  //! Direction of each of the four children from the center of the parent
+  const double OFFSETS[4][2] = { { -1, -1 }, { -1, 1 }, { 1, -1 }, { 1, 1 } };
+
+  //! A connection found by the search from a single node
+  struct Link {
+    Point  source;
+    Point  target;
+    double weight;
+  };
+
+  /**
+   * @brief
+   *   Returns the index of the CPPN output with the bias of leaky neurons.
+   *   The CPPN outputs the weight first, then the LEO if it is enabled,
+   *   then the bias and the time constant.
+   *
+   * @param params
+   *
+   * @return
+   */
+  size_t biasOutput(const NEAT::Parameters& params) {
+    return params.Leo ? 2 : 1;
+  }
+
+  /**
+   * @brief
+   *   Returns the number of outputs the CPPN needs for the substrate.
+   *
+   * @param sub
+   * @param params
+   *
+   * @return
+   */
+  size_t requiredOutputs(const Substrate&        sub,
+                         const NEAT::Parameters& params) {
+    return sub.m_leaky ? biasOutput(params) + 2 : biasOutput(params);
+  }
+
+  /**
+   * @brief
+   *   Queries the CPPN and everything that does not change between
+   *   queries for a single genome.
+   */
+  struct Query {
+    NEAT::NeuralNetwork&    cppn;
+    const Substrate&        sub;
+    const NEAT::Parameters& params;
+    unsigned int            depth;
+
+    /**
+     * @brief
+     *   Returns the outputs of the CPPN for the connection between the
+     *   source and the target.
+     *
+     * @param source
+     * @param target
+     *
+     * @return
+     */
+    std::vector<double> outputs(const Point& source,
+                                const Point& target) const {
+      std::vector<double> inputs(source);
+      inputs.insert(inputs.end(), target.begin(), target.end());
+
+      if (sub.m_with_distance) {
+        double d = 0;
+
+        for (size_t i = 0; i < source.size(); ++i)
+          d += (target[i] - source[i]) * (target[i] - source[i]);
+
+        inputs.push_back(std::sqrt(d));
+      }
+
+      inputs.push_back(params.CPPN_Bias);
+
+      cppn.Flush();
+      cppn.Input(inputs);
+
+      for (unsigned int i = 0; i < depth; ++i)
+        cppn.Activate();
+
+      return cppn.Output();
+    }
+
+    /**
+     * @brief
+     *   Returns the weight and LEO output of the connection between the
+     *   node and the point (x, y) on the hidden plane. If outgoing is
+     *   true, the node is the source of the connection.
+     *
+     * @param node
+     * @param x
+     * @param y
+     * @param outgoing
+     * @param leo
+     *
+     * @return
+     */
+    double operator()(const Point& node,
+                      double       x,
+                      double       y,
+                      bool         outgoing,
+                      double&      leo) const {
+      Point other(node.size(), 0.0);
+      other[0] = x;
+      other[1] = y;
+
+      std::vector<double> output =
+        outgoing ? outputs(node, other) : outputs(other, node);
+
+      leo = params.Leo && output.size() > 1 ? output[1] : 1.0;
+      return output[0];
+    }
+  };
+
+  /**
+   * @brief
+   *   Returns the variance of the weights of the leaves below the point,
+   *   or 0 if the point has no children.
+   *
+   * @param tree
+   * @param index
+   *
+   * @return
+   */
+  double variance(const std::vector<QuadPoint>& tree, int index) {
+    if (tree[index].children < 0)
+      return 0;
+
+    std::vector<double> values;
+    std::vector<int>    stack = { index };
+
+    while (!stack.empty()) {
+      const QuadPoint& p = tree[stack.back()];
+      stack.pop_back();
+
+      if (p.children < 0) {
+        values.push_back(p.weight);
+        continue;
+      }
+
+      for (int i = 0; i < 4; ++i)
+        stack.push_back(p.children + i);
+    }
+
+    double mean = 0;
+    double sum  = 0;
+
+    for (auto v : values)
+      mean += v;
+
+    mean /= values.size();
+
+    for (auto v : values)
+      sum += (v - mean) * (v - mean);
+
+    return sum / values.size();
+  }
+
+  /**
+   * @brief
+   *   Divides the hidden plane around the node until it reaches the
+   *   initial depth, continuing further in the areas where the CPPN
+   *   output varies more than the division threshold.
+   *
+   * @param query
+   * @param node
+   * @param outgoing
+   *
+   * @return
+   */
+  std::vector<QuadPoint>
+  divide(const Query& query, const Point& node, bool outgoing) {
+    const NEAT::Parameters& params = query.params;
+    std::vector<QuadPoint>  tree;
+    std::deque<int>         queue = { 0 };
+
+    tree.push_back({ params.Qtree_X,
+                     params.Qtree_Y,
+                     params.Width,
+                     params.Height,
+                     0,
+                     0,
+                     1,
+                     -1 });
+
+    while (!queue.empty()) {
+      int index = queue.front();
+      queue.pop_front();
+
+      QuadPoint p = tree[index];
+      double    w = p.width / 2;
+      double    h = p.height / 2;
+
+      tree[index].children = tree.size();
+
+      for (auto& offset : OFFSETS) {
+        QuadPoint c = { p.x + offset[0] * w, p.y + offset[1] * h, w, h, 0, 0,
+                        p.level + 1, -1 };
+
+        c.weight = query(node, c.x, c.y, outgoing, c.leo);
+        tree.push_back(c);
+      }
+
+      bool divide = p.level < params.InitialDepth ||
+                    (p.level < params.MaxDepth &&
+                     variance(tree, index) > params.DivisionThreshold);
+
+      if (!divide)
+        continue;
+
+      for (int i = 0; i < 4; ++i)
+        queue.push_back(tree[index].children + i);
+    }
+
+    return tree;
+  }
+
+  /**
+   * @brief
+   *   Walks the quadtree, expressing a connection for every point with low
+   *   enough variance that differs enough from its neighbours, which is
+   *   where the pattern the CPPN draws has a band.
+   *
+   * @param query
+   * @param tree
+   * @param index
+   * @param node
+   * @param outgoing
+   * @param links
+   */
+  void prune(const Query&                  query,
+             const std::vector<QuadPoint>& tree,
+             int                           index,
+             const Point&                  node,
+             bool                          outgoing,
+             std::vector<Link>&            links) {
+    const NEAT::Parameters& params = query.params;
+
+    if (tree[index].children < 0)
+      return;
+
+    for (int i = 0; i < 4; ++i) {
+      int              child = tree[index].children + i;
+      const QuadPoint& c     = tree[child];
+
+      if (variance(tree, child) >= params.VarianceThreshold) {
+        prune(query, tree, child, node, outgoing, links);
+        continue;
+      }
+
+      double leo;
+      double left   = query(node, c.x - c.width, c.y, outgoing, leo);
+      double right  = query(node, c.x + c.width, c.y, outgoing, leo);
+      double top    = query(node, c.x, c.y - c.height, outgoing, leo);
+      double bottom = query(node, c.x, c.y + c.height, outgoing, leo);
+
+      double vertical =
+        std::min(std::abs(c.weight - top), std::abs(c.weight - bottom));
+      double horizontal =
+        std::min(std::abs(c.weight - left), std::abs(c.weight - right));
+
+      if (std::max(vertical, horizontal) <= params.BandThreshold)
+        continue;
+
+      if (params.Leo && c.leo <= params.LeoThreshold)
+        continue;
+
+      Point point(node.size(), 0.0);
+      point[0] = c.x;
+      point[1] = c.y;
+
+      links.push_back({ outgoing ? node : point, outgoing ? point : node,
+                        c.weight });
+    }
+  }
+
+  /**
+   * @brief
+   *   Searches for the connections of each of the nodes, spreading the
+   *   nodes over the pool if there is one. The result of each node is
+   *   stored at the same index as the node.
+   *
+   * @param cppn
+   * @param sub
+   * @param params
+   * @param depth
+   * @param nodes
+   * @param outgoing
+   * @param pool
+   *
+   * @return
+   */
+  std::vector<std::vector<Link>> search(const NEAT::NeuralNetwork& cppn,
+                                        const Substrate&           sub,
+                                        const NEAT::Parameters&    params,
+                                        unsigned int               depth,
+                                        const std::vector<Point>&  nodes,
+                                        bool                       outgoing,
+                                        ThreadPool*                pool) {
+    std::vector<std::vector<Link>> links(nodes.size());
+
+    auto worker = [&](size_t begin, size_t end) {
+      // Activating the CPPN changes it, so each thread needs its own
+      NEAT::NeuralNetwork local = cppn;
+      Query               query = { local, sub, params, depth };
+
+      for (size_t i = begin; i < end; ++i) {
+        auto tree = divide(query, nodes[i], outgoing);
+        prune(query, tree, 0, nodes[i], outgoing, links[i]);
+      }
+    };
+
+    if (pool != nullptr)
+      pool->parallelFor(nodes.size(), worker);
+    else
+      worker(0, nodes.size());
+
+    return links;
+  }
+
+  /**
+   * @brief
+   *   Returns the number of activations needed for the inputs of the CPPN
+   *   to reach every neuron, which is the longest path through the genome.
+   *   Loops are only followed until every neuron has been reached.
+   *
+   * @param genome
+   *
+   * @return
+   */
+  unsigned int depthOf(NEAT::Genome& genome) {
+    std::map<int, unsigned int> depth;
+    unsigned int                maxDepth = 1;
+    unsigned int                limit    = genome.NumNeurons();
+    bool                        changed  = true;
+
+    for (unsigned int i = 0; i < genome.NumNeurons(); ++i)
+      depth[genome.GetNeuronByIndex(i).ID()] = 0;
+
+    for (unsigned int n = 0; n < limit && changed; ++n) {
+      changed = false;
+
+      for (unsigned int i = 0; i < genome.NumLinks(); ++i) {
+        NEAT::LinkGene l    = genome.GetLinkByIndex(i);
+        unsigned int   next = std::min(depth[l.FromNeuronID()] + 1, limit);
+
+        if (next > depth[l.ToNeuronID()]) {
+          depth[l.ToNeuronID()] = next;
+          maxDepth              = std::max(maxDepth, next);
+          changed               = true;
+        }
+      }
+    }
+
+    return maxDepth;
+  }
+
+  /**
+   * @brief
+   *   Scales the CPPN output to a weight in the same way as HyperNEAT,
+   *   returning 0 if it is below the link threshold of the substrate.
+   *
+   * @param sub
+   * @param w
+   *
+   * @return
+   */
+  double scaleWeight(const Substrate& sub, double w) {
+    if (std::abs(w) < sub.m_link_threshold)
+      return 0;
+
+    double scaled = (std::abs(w) - sub.m_link_threshold) /
+                    (1.0 - sub.m_link_threshold) * sub.m_max_weight_and_bias;
+
+    return w < 0 ? -scaled : scaled;
+  }
+
+  /**
+   * @brief
+   *   Removes the hidden nodes that cannot be reached from an input or
+   *   cannot reach an output, along with their connections. The remaining
+   *   hidden nodes keep their order.
+   *
+   * @param connections
+   * @param hidden
+   * @param numInputs
+   * @param numFixed
+   */
+  void clean(std::vector<NEAT::Connection>& connections,
+             std::vector<Point>&            hidden,
+             unsigned int                   numInputs,
+             unsigned int                   numFixed) {
+    size_t            size = numFixed + hidden.size();
+    std::vector<bool> fromInput(size, false);
+    std::vector<bool> toOutput(size, false);
+
+    for (unsigned int i = 0; i < numFixed; ++i) {
+      fromInput[i] = i < numInputs;
+      toOutput[i]  = i >= numInputs;
+    }
+
+    for (bool changed = true; changed;) {
+      changed = false;
+
+      for (auto& c : connections) {
+        if (fromInput[c.m_source_neuron_idx] &&
+            !fromInput[c.m_target_neuron_idx]) {
+          fromInput[c.m_target_neuron_idx] = true;
+          changed                          = true;
+        }
+
+        if (toOutput[c.m_target_neuron_idx] &&
+            !toOutput[c.m_source_neuron_idx]) {
+          toOutput[c.m_source_neuron_idx] = true;
+          changed                         = true;
+        }
+      }
+    }
+
+    std::vector<int>   index(size, -1);
+    std::vector<Point> kept;
+
+    for (unsigned int i = 0; i < numFixed; ++i)
+      index[i] = i;
+
+    for (size_t i = 0; i < hidden.size(); ++i) {
+      if (!fromInput[i + numFixed] || !toOutput[i + numFixed])
+        continue;
+
+      index[i + numFixed] = numFixed + kept.size();
+      kept.push_back(hidden[i]);
+    }
+
+    std::vector<NEAT::Connection> result;
+
+    for (auto c : connections) {
+      if (index[c.m_source_neuron_idx] < 0 || index[c.m_target_neuron_idx] < 0)
+        continue;
+
+      c.m_source_neuron_idx = index[c.m_source_neuron_idx];
+      c.m_target_neuron_idx = index[c.m_target_neuron_idx];
+      result.push_back(c);
+    }
+
+    connections.swap(result);
+    hidden.swap(kept);
+  }
+
+  /**
+   * @brief
+   *   Sets the bias and time constant of a leaky neuron by querying the
+   *   CPPN with the neuron as both source and target. They are read from
+   *   the outputs after the weight and LEO outputs, with the time constant
+   *   scaled into the range of the substrate. The caller has checked that
+   *   the CPPN has those outputs.
+   *
+   * @param query
+   * @param neuron
+   */
+  void setLeaky(const Query& query, NEAT::Neuron& neuron) {
+    const Substrate&    sub    = query.sub;
+    const Point&        coords = neuron.m_substrate_coords;
+    std::vector<double> output = query.outputs(coords, coords);
+    size_t              bias   = biasOutput(query.params);
+    double t = std::min(std::max((output[bias + 1] + 1.0) / 2.0, 0.0), 1.0);
+
+    neuron.m_bias = scaleWeight(sub, output[bias]);
+    neuron.m_timeconst =
+      sub.m_min_time_const + t * (sub.m_max_time_const - sub.m_min_time_const);
+  }
+
+  /**
+   * @brief
+   *   Sets the bias and time constant of every hidden and output neuron of
+   *   a network that has already been built on a leaky substrate.
+   *   MultiNEAT leaves them at zero for ES-HyperNEAT, so this is what
+   *   makes its networks leaky, just like those of buildParallel.
+   *
+   * @param genome
+   * @param network
+   * @param sub
+   * @param params
+   */
+  void setLeakyNeurons(NEAT::Genome&           genome,
+                       NEAT::NeuralNetwork&    network,
+                       const Substrate&        sub,
+                       const NEAT::Parameters& params) {
+    NEAT::NeuralNetwork cppn(true);
+    genome.BuildPhenotype(cppn);
+    cppn.Flush();
+
+    if (cppn.m_num_outputs < requiredOutputs(sub, params))
+      throw std::runtime_error(
+        "CPPN has " + std::to_string(cppn.m_num_outputs) +
+        " outputs, the leaky substrate needs " +
+        std::to_string(requiredOutputs(sub, params)));
+
+    Query query = { cppn, sub, params, depthOf(genome) };
+
+    for (size_t i = network.m_num_inputs; i < network.m_neurons.size(); ++i)
+      setLeaky(query, network.m_neurons[i]);
+  }
+
+  NEAT::Neuron createNeuron(NEAT::NeuronType         type,
+                            NEAT::ActivationFunction function,
+                            const Point&             coords) {
+    NEAT::Neuron n;
+    n.m_type                     = type;
+    n.m_activation_function_type = function;
+    n.m_substrate_coords         = coords;
+    n.m_a                        = 1;
+    n.m_b                        = 0;
+    n.m_timeconst                = 0;
+    n.m_bias                     = 0;
+    n.m_activation               = 0;
+    n.m_activesum                = 0;
+    n.m_membrane_potential       = 0;
+    return n;
+  }
+
+  NEAT::Connection
+  createConnection(unsigned int source, unsigned int target, double weight) {
+    NEAT::Connection c;
+    c.m_source_neuron_idx = source;
+    c.m_target_neuron_idx = target;
+    c.m_weight            = weight;
+    c.m_recur_flag        = false;
+    c.m_hebb_rate         = 0;
+    c.m_hebb_pre_rate     = 0;
+    return c;
+  }
+
+  bool isClose(double a, double b) {
+    return std::abs(a - b) <= 1e-9 * std::max(1.0, std::abs(a));
+  }
+
+  std::string toString(const Point& p) {
+    std::ostringstream ss;
+    ss << "(";
+
+    for (size_t i = 0; i < p.size(); ++i)
+      ss << (i > 0 ? ", " : "") << p[i];
+
+    ss << ")";
+    return ss.str();
+  }
+
+  /**
+   * @brief
+   *   Describes the first difference between the neurons and connections
+   *   of the two networks. Since the hidden nodes may be numbered in a
+   *   different order, neurons are matched by their substrate coordinates.
+   *
+   * @param a
+   * @param b
+   *
+   * @return
+   *   An empty string if the networks are the same
+   */
+  std::string difference(const NEAT::NeuralNetwork& a,
+                         const NEAT::NeuralNetwork& b) {
+    if (a.m_neurons.size() != b.m_neurons.size())
+      return "Neurons: " + std::to_string(a.m_neurons.size()) + " vs " +
+             std::to_string(b.m_neurons.size());
+
+    if (a.m_connections.size() != b.m_connections.size())
+      return "Connections: " + std::to_string(a.m_connections.size()) +
+             " vs " + std::to_string(b.m_connections.size());
+
+    std::map<Point, size_t> neurons;
+
+    for (size_t i = 0; i < b.m_neurons.size(); ++i)
+      neurons[b.m_neurons[i].m_substrate_coords] = i;
+
+    for (auto& n : a.m_neurons) {
+      auto it = neurons.find(n.m_substrate_coords);
+
+      if (it == neurons.end())
+        return "Neuron at " + toString(n.m_substrate_coords) + " is missing";
+
+      const NEAT::Neuron& m = b.m_neurons[it->second];
+
+      if (n.m_type != m.m_type ||
+          n.m_activation_function_type != m.m_activation_function_type ||
+          !isClose(n.m_bias, m.m_bias) ||
+          !isClose(n.m_timeconst, m.m_timeconst))
+        return "Neuron at " + toString(n.m_substrate_coords) + " differs";
+    }
+
+    std::map<std::pair<Point, Point>, double> connections;
+
+    for (auto& c : b.m_connections) {
+      const NEAT::Neuron& from = b.m_neurons[c.m_source_neuron_idx];
+      const NEAT::Neuron& to   = b.m_neurons[c.m_target_neuron_idx];
+
+      connections[{ from.m_substrate_coords, to.m_substrate_coords }] =
+        c.m_weight;
+    }
+
+    for (auto& c : a.m_connections) {
+      const NEAT::Neuron& from   = a.m_neurons[c.m_source_neuron_idx];
+      const NEAT::Neuron& to     = a.m_neurons[c.m_target_neuron_idx];
+      const Point&        source = from.m_substrate_coords;
+      const Point&        target = to.m_substrate_coords;
+      auto                it     = connections.find({ source, target });
+
+      if (it == connections.end() || !isClose(c.m_weight, it->second))
+        return "Connection from " + toString(source) + " to " +
+               toString(target) + " differs";
+    }
+
+    return "";
+  }
+}
+
+/**
+ * @brief
+ *   Builds the ES-HyperNEAT network of the genome with buildParallel if it
+ *   has been enabled, or with MultiNEAT otherwise. Networks on a leaky
+ *   substrate get the bias and time constant of their neurons from the
+ *   CPPN with either builder.
+ *
+ * @param genome
+ * @param network
+ * @param sub
+ * @param params
+ * @param pool
+ */
+void ESHyperNEAT::build(NEAT::Genome&        genome,
+                        NEAT::NeuralNetwork& network,
+                        Substrate&           sub,
+                        NEAT::Parameters&    params,
+                        ThreadPool*          pool) {
+  if (useParallel) {
+    buildParallel(genome, network, sub, params, pool);
+    return;
+  }
+
+  genome.BuildESHyperNEATPhenotype(network, sub, params);
+
+  if (sub.m_leaky)
+    setLeakyNeurons(genome, network, sub, params);
+}
+
+/**
+ * @brief
+ *   Builds the network of the genome both with MultiNEAT and with
+ *   buildParallel, comparing the neurons and connections of the two. The
+ *   leaky neurons are set on both, as `build` does.
+ *
+ * @param genome
+ * @param sub
+ * @param params
+ *
+ * @return
+ *   A description of the first difference, or an empty string if
+ *   the networks are the same
+ */
+std::string ESHyperNEAT::compare(NEAT::Genome&     genome,
+                                 Substrate&        sub,
+                                 NEAT::Parameters& params) {
+  NEAT::NeuralNetwork reference;
+  NEAT::NeuralNetwork parallel;
+
+  genome.BuildESHyperNEATPhenotype(reference, sub, params);
+  buildParallel(genome, parallel, sub, params, nullptr);
+
+  if (sub.m_leaky)
+    setLeakyNeurons(genome, reference, sub, params);
+
+  return difference(reference, parallel);
+}
+
+void ESHyperNEAT::setParallel(bool enable) {
+  useParallel = enable;
+}
+
+bool ESHyperNEAT::isParallel() {
+  return useParallel;
+}
+
+/**
+ * @brief
+ *   Builds the ES-HyperNEAT network of the genome. See the description
+ *   in the header for how the work is split up.
+ *
+ * @param genome
+ * @param network
+ * @param sub
+ * @param params
+ * @param pool
+ */
+void ESHyperNEAT::buildParallel(NEAT::Genome&        genome,
+                                NEAT::NeuralNetwork& network,
+                                Substrate&           sub,
+                                NEAT::Parameters&    params,
+                                ThreadPool*          pool) {
+  const auto& inputs  = sub.m_input_coords;
+  const auto& outputs = sub.m_output_coords;
+
+  if (inputs.empty() || outputs.empty())
+    throw std::runtime_error("ES-HyperNEAT requires inputs and outputs");
+
+  unsigned int numInputs  = inputs.size();
+  unsigned int numOutputs = outputs.size();
+  unsigned int numFixed   = numInputs + numOutputs;
+
+  NEAT::NeuralNetwork cppn(true);
+  genome.BuildPhenotype(cppn);
+  cppn.Flush();
+
+  unsigned int expected = inputs[0].size() * 2 + (sub.m_with_distance ? 2 : 1);
+
+  if (cppn.m_num_inputs != expected)
+    throw std::runtime_error("CPPN has " + std::to_string(cppn.m_num_inputs) +
+                             " inputs, the substrate needs " +
+                             std::to_string(expected));
+
+  if (cppn.m_num_outputs < requiredOutputs(sub, params))
+    throw std::runtime_error("CPPN has " + std::to_string(cppn.m_num_outputs) +
+                             " outputs, the substrate needs " +
+                             std::to_string(requiredOutputs(sub, params)));
+
+  unsigned int depth = depthOf(genome);
+
+  std::vector<NEAT::Connection> connections;
+  std::vector<Point>            hidden;
+  std::map<Point, unsigned int> hiddenIndex;
+  std::vector<Point>            unexplored;
+
+  // Gives the index of the hidden node, adding it if it is new
+  auto findOrAdd = [&](const Point& p) {
+    auto it = hiddenIndex.find(p);
+
+    if (it != hiddenIndex.end())
+      return it->second;
+
+    unsigned int index = numFixed + hidden.size();
+    hiddenIndex[p]     = index;
+    hidden.push_back(p);
+    unexplored.push_back(p);
+
+    return index;
+  };
+
+  // Inputs to hidden
+  auto links = search(cppn, sub, params, depth, inputs, true, pool);
+
+  for (unsigned int i = 0; i < numInputs; ++i) {
+    for (auto& l : links[i]) {
+      double weight = scaleWeight(sub, l.weight);
+
+      if (weight != 0)
+        connections.push_back(createConnection(i, findOrAdd(l.target), weight));
+    }
+  }
+
+  // Hidden to hidden, starting with the nodes found in the previous step
+  for (int level = 0; level < params.IterationLevel; ++level) {
+    std::vector<Point> nodes;
+    nodes.swap(unexplored);
+
+    links = search(cppn, sub, params, depth, nodes, true, pool);
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      unsigned int source = hiddenIndex[nodes[i]];
+
+      for (auto& l : links[i]) {
+        double weight = scaleWeight(sub, l.weight);
+
+        if (weight != 0)
+          connections.push_back(
+            createConnection(source, findOrAdd(l.target), weight));
+      }
+    }
+  }
+
+  // Hidden to outputs, only from hidden nodes that already exist
+  links = search(cppn, sub, params, depth, outputs, false, pool);
+
+  for (unsigned int i = 0; i < numOutputs; ++i) {
+    for (auto& l : links[i]) {
+      auto   it     = hiddenIndex.find(l.source);
+      double weight = scaleWeight(sub, l.weight);
+
+      if (it != hiddenIndex.end() && weight != 0)
+        connections.push_back(
+          createConnection(it->second, numInputs + i, weight));
+    }
+  }
+
+  clean(connections, hidden, numInputs, numFixed);
+
+  network.m_neurons.clear();
+  network.m_neurons.reserve(numFixed + hidden.size());
+
+  for (auto& p : inputs)
+    network.m_neurons.push_back(
+      createNeuron(NEAT::INPUT, NEAT::LINEAR, p));
+
+  for (auto& p : outputs)
+    network.m_neurons.push_back(
+      createNeuron(NEAT::OUTPUT, sub.m_output_nodes_activation, p));
+
+  for (auto& p : hidden)
+    network.m_neurons.push_back(
+      createNeuron(NEAT::HIDDEN, sub.m_hidden_nodes_activation, p));
+
+  if (sub.m_leaky) {
+    Query query = { cppn, sub, params, depth };
+
+    for (size_t i = numInputs; i < network.m_neurons.size(); ++i)
+      setLeaky(query, network.m_neurons[i]);
+  }
+
+  network.m_connections = connections;
+  network.m_num_inputs  = numInputs;
+  network.m_num_outputs = numOutputs;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+
+class Substrate;
+class ThreadPool;
+
+namespace NEAT {
+  class Genome;
+  class NeuralNetwork;
+  class Parameters;
+}
+
+/**
+ * @brief
+ *   Builds ES-HyperNEAT networks from a genome, following the same steps
+ *   as NEAT::Genome::BuildESHyperNEATPhenotype:
+ *
+ *   1. For every input, divide the hidden plane into a quadtree by querying
+ *      the CPPN, then prune and express the connections to the hidden
+ *      points that stand out
+ *   2. Repeat the search from the newly found hidden nodes,
+ *      `IterationLevel` times
+ *   3. Search backwards from every output, only keeping connections from
+ *      hidden nodes that were found
+ *   4. Remove hidden nodes that are not on a path from an input to an output
+ *   5. For leaky substrates, query the bias and time constant of every
+ *      hidden and output neuron. This is also done for networks built by
+ *      MultiNEAT, which does not do it on its own
+ *
+ *   The search from each node only depends on the CPPN and the node, so
+ *   within each of the steps above every node can be searched at the same
+ *   time. When a ThreadPool is given, the searches are spread over it, each
+ *   thread using its own copy of the CPPN. The results are merged in the
+ *   order of the nodes afterwards, so hidden nodes are numbered and
+ *   connections are ordered exactly like they are when built on a single
+ *   thread.
+ *
+ *   No pool should be given when many genomes are already being built in
+ *   parallel, such as when recreating the phenotypes of a population.
+ *
+ *   Until it has been shown to build the same networks as MultiNEAT, using
+ *   `compare`, `build` uses MultiNEAT unless `setParallel` enables it.
+ */
+namespace ESHyperNEAT {
+  // Builds the network of the genome on the given substrate
+  void build(NEAT::Genome&        genome,
+             NEAT::NeuralNetwork& network,
+             Substrate&           substrate,
+             NEAT::Parameters&    params,
+             ThreadPool*          pool = nullptr);
+
+  // Builds the network as described above, regardless of `setParallel`
+  void buildParallel(NEAT::Genome&        genome,
+                     NEAT::NeuralNetwork& network,
+                     Substrate&           substrate,
+                     NEAT::Parameters&    params,
+                     ThreadPool*          pool = nullptr);
+
+  // Builds the network with both MultiNEAT and `buildParallel`, returning
+  // the first difference between them or an empty string if there is none
+  std::string compare(NEAT::Genome&     genome,
+                      Substrate&        substrate,
+                      NEAT::Parameters& params);
+
+  // Whether `build` uses `buildParallel` instead of MultiNEAT
+  void setParallel(bool enable);
+  bool isParallel();
+}
@@ -0,0 +1,377 @@
+#include "EvaluationMaster.hpp"
+
+#include <algorithm>
+
+#include <Genome.h>
+
+EvaluationMaster::EvaluationMaster()
+    : Logging::Log("EvaluationMaster")
+    , mNextId(0)
+    , mNextWorkerId(1)
+    , mNumFinished(0)
+    , mBatchSize(0)
+    , mTimeout(120.f) {}
+
+EvaluationMaster::~EvaluationMaster() {
+  close();
+}
+
+/**
+ * @brief
+ *   Starts listening for workers on the address, which is either
+ *   `host:port` or `unix:/path`.
+ *
+ * @param address
+ *
+ * @return
+ */
+bool EvaluationMaster::listen(const std::string& address) {
+  return mListener.listen(address);
+}
+
+/**
+ * @brief
+ *   Sends Shutdown to every worker before disconnecting them and closing
+ *   the listening socket. Jobs that have not finished are kept, but
+ *   will not be processed until the master listens again.
+ */
+void EvaluationMaster::close() {
+  for (auto& worker : mWorkers)
+    worker.socket->send(Evaluation::Shutdown, "");
+
+  while (!mWorkers.empty())
+    removeWorker(mWorkers.size() - 1);
+
+  mListener.close();
+}
+
+bool EvaluationMaster::isListening() const {
+  return mListener.isOpen();
+}
+
+size_t EvaluationMaster::numWorkers() const {
+  return mWorkers.size();
+}
+
+void EvaluationMaster::setBatchSize(unsigned int batchSize) {
+  mBatchSize = batchSize;
+}
+
+void EvaluationMaster::setTimeout(float seconds) {
+  mTimeout = seconds;
+}
+
+/**
+ * @brief
+ *   Remembers the settings of the experiment so that they can be sent
+ *   to workers as they connect. If they differ from the previous
+ *   settings they are sent to all the workers right away, which is
+ *   before any job that is submitted after this call.
+ *
+ * @param settings
+ */
+void EvaluationMaster::setup(const Evaluation::Settings& settings) {
+  std::string  payload = Evaluation::encodeSetup(settings);
+  std::string& current = mSetups[settings.experiment];
+
+  if (payload == current)
+    return;
+
+  current = payload;
+
+  for (auto& worker : mWorkers)
+    if (worker.numThreads > 0)
+      worker.socket->send(Evaluation::Setup, payload);
+}
+
+/**
+ * @brief
+ *   Queues a genome for evaluation. The genome is serialized right away,
+ *   so it is safe to change the genome after submitting it.
+ *
+ * @param key
+ * @param experiment
+ * @param genome
+ */
+void EvaluationMaster::submit(unsigned int       key,
+                              const std::string& experiment,
+                              NEAT::Genome&      genome) {
+  Job job;
+  job.job.id         = mNextId++;
+  job.job.experiment = experiment;
+  job.job.genome     = Evaluation::serializeGenome(genome);
+  job.key            = key;
+  job.finished       = false;
+  job.queued         = true;
+  job.worker         = 0;
+
+  mQueue.push_back(job.job.id);
+  mJobs[job.job.id] = job;
+}
+
+/**
+ * @brief
+ *   Performs all the networking without blocking:
+ *
+ *   1. Accepts new workers
+ *   2. Reads results from every worker, removing those that are gone
+ *   3. Removes workers that have hung, putting their jobs back into
+ *      the queue
+ *   4. Sends a new batch to every idle worker
+ */
+void EvaluationMaster::poll() {
+  if (!isListening())
+    return;
+
+  acceptWorkers();
+
+  for (size_t i = 0; i < mWorkers.size();) {
+    bool isOpen = mWorkers[i].socket->pump();
+
+    readResults(mWorkers[i]);
+
+    if (!isOpen) {
+      removeWorker(i);
+      continue;
+    }
+
+    ++i;
+  }
+
+  removeHungWorkers();
+  dispatch();
+}
+
+bool EvaluationMaster::done() const {
+  return mNumFinished == mJobs.size();
+}
+
+size_t EvaluationMaster::numPending() const {
+  return mJobs.size() - mNumFinished;
+}
+
+/**
+ * @brief
+ *   Returns the results that has arrived since the last call,
+ *   clearing the list.
+ *
+ * @return
+ */
+std::vector<std::pair<unsigned int, Evaluation::Result>>
+EvaluationMaster::results() {
+  std::vector<std::pair<unsigned int, Evaluation::Result>> results;
+  results.swap(mResults);
+  return results;
+}
+
+/**
+ * @brief
+ *   Forgets all the jobs. Since job ids are never reused, results that
+ *   arrive later for the forgotten jobs are simply ignored.
+ */
+void EvaluationMaster::clear() {
+  mJobs.clear();
+  mQueue.clear();
+  mResults.clear();
+  mNumFinished = 0;
+
+  for (auto& worker : mWorkers)
+    worker.inFlight.clear();
+}
+
+/**
+ * @brief
+ *   Accepts all pending connections. The workers will not receive any
+ *   jobs until they have said Hello.
+ */
+void EvaluationMaster::acceptWorkers() {
+  Socket* socket = nullptr;
+
+  while ((socket = mListener.accept()) != nullptr) {
+    Worker worker;
+    worker.socket.reset(socket);
+    worker.id         = mNextWorkerId++;
+    worker.numThreads = 0;
+    mWorkers.push_back(std::move(worker));
+
+    mLog->info("Worker connected, {} worker(s) in total", mWorkers.size());
+  }
+}
+
+/**
+ * @brief
+ *   Handles every complete frame that the worker has sent
+ *
+ * @param worker
+ */
+void EvaluationMaster::readResults(Worker& worker) {
+  uint32_t    type;
+  std::string payload;
+
+  while (worker.socket->pop(type, payload)) {
+    switch (type) {
+      case Evaluation::Hello:
+        if (!Evaluation::decodeHello(payload, worker.numThreads))
+          mLog->error("Received invalid hello from worker");
+
+        worker.numThreads = std::max(worker.numThreads, 1u);
+        mLog->info("Worker has {} thread(s)", worker.numThreads);
+
+        for (auto& setup : mSetups)
+          worker.socket->send(Evaluation::Setup, setup.second);
+        break;
+
+      case Evaluation::Results: {
+        std::vector<Evaluation::Result> results;
+
+        if (!Evaluation::decodeResults(payload, results)) {
+          mLog->error("Received invalid results from worker");
+          worker.socket->close();
+          break;
+        }
+
+        for (auto& result : results) {
+          worker.inFlight.erase(result.id);
+
+          auto job = mJobs.find(result.id);
+
+          // Either from a previous generation, already evaluated or
+          // sent to another worker since
+          if (job == mJobs.end() || job->second.finished ||
+              job->second.worker != worker.id)
+            continue;
+
+          job->second.finished = true;
+          mNumFinished += 1;
+          mResults.push_back({ job->second.key, result });
+        }
+        break;
+      }
+
+      default:
+        mLog->warn("Received unknown message of type {} from worker", type);
+        break;
+    }
+  }
+}
+
+/**
+ * @brief
+ *   Disconnects every worker that has had a job in flight for longer
+ *   than the timeout. Such a worker is assumed to hang, and keeping it
+ *   would mean that it is never sent anything again while its jobs are
+ *   evaluated elsewhere.
+ */
+void EvaluationMaster::removeHungWorkers() {
+  auto now = Clock::now();
+
+  for (size_t i = 0; i < mWorkers.size();) {
+    bool isHung = false;
+
+    for (auto id : mWorkers[i].inFlight) {
+      auto job = mJobs.find(id);
+
+      if (job == mJobs.end() || job->second.finished)
+        continue;
+
+      std::chrono::duration<float> elapsed = now - job->second.dispatched;
+
+      if (elapsed.count() >= mTimeout) {
+        mLog->warn("Job {} timed out, dropping the worker", id);
+        isHung = true;
+        break;
+      }
+    }
+
+    if (isHung) {
+      removeWorker(i);
+      continue;
+    }
+
+    ++i;
+  }
+}
+
+/**
+ * @brief
+ *   Sends one batch to each worker that has said hello and has nothing
+ *   in flight. A worker is never sent a job that it is already working on.
+ */
+void EvaluationMaster::dispatch() {
+  auto now = Clock::now();
+
+  for (auto& worker : mWorkers) {
+    if (mQueue.empty())
+      return;
+
+    if (worker.numThreads == 0 || !worker.inFlight.empty())
+      continue;
+
+    unsigned int batchSize = mBatchSize > 0 ? mBatchSize : worker.numThreads;
+    std::vector<Evaluation::Job> batch;
+
+    auto it = mQueue.begin();
+
+    while (it != mQueue.end() && batch.size() < batchSize) {
+      auto job = mJobs.find(*it);
+
+      if (job == mJobs.end() || job->second.finished) {
+        it = mQueue.erase(it);
+        continue;
+      }
+
+      job->second.queued     = false;
+      job->second.worker     = worker.id;
+      job->second.dispatched = now;
+      batch.push_back(job->second.job);
+      worker.inFlight.insert(*it);
+      it = mQueue.erase(it);
+    }
+
+    if (batch.empty())
+      continue;
+
+    // If sending fails, the worker is removed on the next poll and the
+    // jobs are put back into the queue
+    worker.socket->send(Evaluation::Jobs, Evaluation::encodeJobs(batch));
+  }
+}
+
+/**
+ * @brief
+ *   Puts the job back into the front of the queue, unless it has
+ *   finished or is already waiting there.
+ *
+ * @param id
+ */
+void EvaluationMaster::requeue(uint32_t id) {
+  auto job = mJobs.find(id);
+
+  if (job == mJobs.end() || job->second.finished || job->second.queued)
+    return;
+
+  job->second.queued = true;
+  job->second.worker = 0;
+  mQueue.push_front(id);
+}
+
+/**
+ * @brief
+ *   Removes the worker, putting the jobs it was working on back into the
+ *   queue if they have not finished.
+ *
+ * @param index
+ */
+void EvaluationMaster::removeWorker(size_t index) {
+  Worker& worker = mWorkers[index];
+
+  for (auto id : worker.inFlight) {
+    auto job = mJobs.find(id);
+
+    if (job != mJobs.end() && job->second.worker == worker.id)
+      requeue(id);
+  }
+
+  mWorkers.erase(mWorkers.begin() + index);
+  mLog->info("Worker disconnected, {} worker(s) left", mWorkers.size());
+}
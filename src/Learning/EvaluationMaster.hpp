@@ -0,0 +1,131 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "../Log.hpp"
+#include "../Network/Socket.hpp"
+#include "EvaluationProtocol.hpp"
+
+namespace NEAT {
+  class Genome;
+}
+
+/**
+ * @brief
+ *   The EvaluationMaster hands out genomes to be evaluated by workers
+ *   that have connected to it, collecting the results as they come in.
+ *
+ *   It is meant to be polled from the main loop and never blocks. Each
+ *   poll accepts new workers, reads results and sends a new batch of jobs
+ *   to each worker that is idle.
+ *
+ *   A worker that has not returned a job within the timeout is assumed
+ *   to hang and is disconnected. Jobs that were sent to a worker that
+ *   disconnected are put back into the queue, once, and are only
+ *   accepted from the worker they were last sent to, so a late result
+ *   from a worker that has been dropped is never counted.
+ *
+ *   Each job is submitted together with a key that is used to identify
+ *   the result, such as the index of the Phenotype.
+ *
+ *   The settings of each experiment are given through `setup` and are
+ *   sent to every worker before any of the jobs, so the workers evaluate
+ *   the genomes with the same substrate and parameters as the master.
+ */
+class EvaluationMaster : public Logging::Log {
+public:
+  EvaluationMaster();
+  ~EvaluationMaster();
+
+  // Starts listening for workers on the given address
+  bool listen(const std::string& address);
+
+  // Tells all the workers to shut down and stops listening
+  void close();
+
+  // Whether or not the master is listening for workers
+  bool isListening() const;
+
+  // Returns the number of workers that are connected
+  size_t numWorkers() const;
+
+  // Sets the number of jobs sent to a worker at a time. If zero, the
+  // number of threads reported by the worker is used
+  void setBatchSize(unsigned int batchSize);
+
+  // Sets the number of seconds a worker has to return a job before it
+  // is disconnected and the job is sent to another worker
+  void setTimeout(float seconds);
+
+  // Sets the settings that workers should use for the experiment,
+  // sending them to the workers if they have changed
+  void setup(const Evaluation::Settings& settings);
+
+  // Queues a genome to be evaluated under the given experiment
+  void submit(unsigned int        key,
+              const std::string&  experiment,
+              NEAT::Genome&       genome);
+
+  // Accepts workers, reads results and dispatches jobs. Never blocks
+  void poll();
+
+  // Returns true when all the submitted jobs have a result
+  bool done() const;
+
+  // Returns the number of jobs that does not have a result yet
+  size_t numPending() const;
+
+  // Returns the results that have arrived since the last call together
+  // with the key they were submitted with
+  std::vector<std::pair<unsigned int, Evaluation::Result>> results();
+
+  // Forgets all the submitted jobs. Results for them are ignored
+  void clear();
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Job {
+    Evaluation::Job   job;
+    unsigned int      key;
+    bool              finished;
+    bool              queued;
+    uint32_t          worker;
+    Clock::time_point dispatched;
+  };
+
+  struct Worker {
+    std::unique_ptr<Socket> socket;
+    uint32_t                id;
+    unsigned int            numThreads;
+    std::set<uint32_t>      inFlight;
+  };
+
+  void acceptWorkers();
+  void readResults(Worker& worker);
+  void removeHungWorkers();
+  void dispatch();
+  void requeue(uint32_t id);
+  void removeWorker(size_t index);
+
+  Socket mListener;
+
+  std::vector<Worker>     mWorkers;
+  std::map<uint32_t, Job> mJobs;
+  std::deque<uint32_t>    mQueue;
+
+  std::map<std::string, std::string> mSetups;
+
+  std::vector<std::pair<unsigned int, Evaluation::Result>> mResults;
+
+  uint32_t     mNextId;
+  uint32_t     mNextWorkerId;
+  size_t       mNumFinished;
+  unsigned int mBatchSize;
+  float        mTimeout;
+};
@@ -0,0 +1,323 @@
+#include "EvaluationProtocol.hpp"
+
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <Genome.h>
+#include <Parameters.h>
+
+namespace {
+
+/**
+ * @brief
+ *   Small helper for appending values to a payload in network
+ *   byte order
+ */
+struct Writer {
+  std::string data;
+
+  void u32(uint32_t value) {
+    value = htonl(value);
+    data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  void f32(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    u32(bits);
+  }
+
+  void f64(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    u32(bits >> 32);
+    u32(bits & 0xffffffff);
+  }
+
+  void str(const std::string& value) {
+    u32(value.size());
+    data.append(value);
+  }
+};
+
+/**
+ * @brief
+ *   Small helper for reading values written by Writer. Every read
+ *   returns false if the payload is too short.
+ */
+struct Reader {
+  const std::string& data;
+  size_t             offset;
+
+  Reader(const std::string& d) : data(d), offset(0) {}
+
+  bool u32(uint32_t& value) {
+    if (offset + sizeof(value) > data.size())
+      return false;
+
+    std::memcpy(&value, data.data() + offset, sizeof(value));
+    value = ntohl(value);
+    offset += sizeof(value);
+    return true;
+  }
+
+  bool f32(float& value) {
+    uint32_t bits;
+
+    if (!u32(bits))
+      return false;
+
+    std::memcpy(&value, &bits, sizeof(value));
+    return true;
+  }
+
+  bool f64(double& value) {
+    uint32_t high;
+    uint32_t low;
+
+    if (!u32(high) || !u32(low))
+      return false;
+
+    uint64_t bits = (uint64_t(high) << 32) | low;
+    std::memcpy(&value, &bits, sizeof(value));
+    return true;
+  }
+
+  bool str(std::string& value) {
+    uint32_t length;
+
+    if (!u32(length) || offset + length > data.size())
+      return false;
+
+    value = data.substr(offset, length);
+    offset += length;
+    return true;
+  }
+};
+}
+
+std::string Evaluation::encodeHello(uint32_t numThreads) {
+  Writer w;
+  w.u32(numThreads);
+  return w.data;
+}
+
+bool Evaluation::decodeHello(const std::string& payload, uint32_t& numThreads) {
+  Reader r(payload);
+  return r.u32(numThreads);
+}
+
+std::string Evaluation::encodeSetup(const Settings& settings) {
+  Writer w;
+  w.str(settings.experiment);
+  w.str(settings.substrate);
+  w.str(settings.parameters);
+  w.u32(settings.singlePrecision ? 1 : 0);
+  w.u32(settings.persistentLeakyState ? 1 : 0);
+  w.f64(settings.sparsify.minContribution);
+  w.u32(settings.sparsify.mergeDuplicates ? 1 : 0);
+  w.u32(static_cast<uint32_t>(settings.sparsify.quantization));
+  return w.data;
+}
+
+bool Evaluation::decodeSetup(const std::string& payload, Settings& settings) {
+  Reader   r(payload);
+  uint32_t singlePrecision;
+  uint32_t persistentLeakyState;
+  uint32_t mergeDuplicates;
+  uint32_t quantization;
+
+  if (!r.str(settings.experiment) || !r.str(settings.substrate) ||
+      !r.str(settings.parameters) || !r.u32(singlePrecision) ||
+      !r.u32(persistentLeakyState) ||
+      !r.f64(settings.sparsify.minContribution) || !r.u32(mergeDuplicates) ||
+      !r.u32(quantization))
+    return false;
+
+  if (quantization > static_cast<uint32_t>(Quantization::Int8))
+    return false;
+
+  settings.singlePrecision          = singlePrecision != 0;
+  settings.persistentLeakyState     = persistentLeakyState != 0;
+  settings.sparsify.mergeDuplicates = mergeDuplicates != 0;
+  settings.sparsify.quantization    = static_cast<Quantization>(quantization);
+  return true;
+}
+
+std::string Evaluation::encodeJobs(const std::vector<Job>& jobs) {
+  Writer w;
+  w.u32(jobs.size());
+
+  for (auto& job : jobs) {
+    w.u32(job.id);
+    w.str(job.experiment);
+    w.str(job.genome);
+  }
+
+  return w.data;
+}
+
+bool Evaluation::decodeJobs(const std::string& payload,
+                            std::vector<Job>&  jobs) {
+  Reader   r(payload);
+  uint32_t size;
+
+  if (!r.u32(size))
+    return false;
+
+  jobs.clear();
+  jobs.reserve(size);
+
+  for (uint32_t i = 0; i < size; ++i) {
+    Job job;
+
+    if (!r.u32(job.id) || !r.str(job.experiment) || !r.str(job.genome))
+      return false;
+
+    jobs.push_back(job);
+  }
+
+  return true;
+}
+
+std::string Evaluation::encodeResults(const std::vector<Result>& results) {
+  Writer w;
+  w.u32(results.size());
+
+  for (auto& result : results) {
+    w.u32(result.id);
+    w.u32(result.killed ? 1 : 0);
+    w.f32(result.finalizedFitness);
+    w.f32(result.duration);
+    w.u32(result.fitness.size());
+
+    for (auto f : result.fitness)
+      w.f32(f);
+  }
+
+  return w.data;
+}
+
+bool Evaluation::decodeResults(const std::string&   payload,
+                               std::vector<Result>& results) {
+  Reader   r(payload);
+  uint32_t size;
+
+  if (!r.u32(size))
+    return false;
+
+  results.clear();
+  results.reserve(size);
+
+  for (uint32_t i = 0; i < size; ++i) {
+    Result   result;
+    uint32_t killed;
+    uint32_t numFitness;
+
+    if (!r.u32(result.id) || !r.u32(killed) ||
+        !r.f32(result.finalizedFitness) || !r.f32(result.duration) ||
+        !r.u32(numFitness))
+      return false;
+
+    result.killed = killed != 0;
+    result.fitness.resize(numFitness);
+
+    for (auto& f : result.fitness)
+      if (!r.f32(f))
+        return false;
+
+    results.push_back(result);
+  }
+
+  return true;
+}
+
+/**
+ * @brief
+ *   Serializes the genome by letting MultiNEAT write it to an in-memory
+ *   stream. This keeps the format identical to the `.genome` files.
+ *
+ * @param genome
+ *
+ * @return
+ */
+std::string Evaluation::serializeGenome(NEAT::Genome& genome) {
+  char*  buffer = nullptr;
+  size_t size   = 0;
+  FILE*  stream = open_memstream(&buffer, &size);
+
+  if (stream == nullptr)
+    throw std::runtime_error("Unable to open memory stream for genome");
+
+  genome.Save(stream);
+  fclose(stream);
+
+  std::string data(buffer, size);
+  free(buffer);
+
+  return data;
+}
+
+/**
+ * @brief
+ *   MultiNEAT only reads genomes from an std::ifstream, so the stream is
+ *   pointed at an in-memory buffer holding the data instead of a file.
+ *
+ * @param data
+ *
+ * @return
+ */
+NEAT::Genome Evaluation::deserializeGenome(const std::string& data) {
+  std::stringbuf buffer(data, std::ios::in);
+  std::ifstream  stream;
+  stream.std::basic_ios<char>::rdbuf(&buffer);
+
+  return NEAT::Genome(stream);
+}
+
+/**
+ * @brief
+ *   Serializes the parameters the same way as `serializeGenome`, so that
+ *   the text is identical to the `.parameters` files.
+ *
+ * @param parameters
+ *
+ * @return
+ */
+std::string Evaluation::serializeParameters(NEAT::Parameters& parameters) {
+  char*  buffer = nullptr;
+  size_t size   = 0;
+  FILE*  stream = open_memstream(&buffer, &size);
+
+  if (stream == nullptr)
+    throw std::runtime_error("Unable to open memory stream for parameters");
+
+  parameters.Save(stream);
+  fclose(stream);
+
+  std::string data(buffer, size);
+  free(buffer);
+
+  return data;
+}
+
+/**
+ * @brief
+ *   Reads the parameters from memory the same way as `deserializeGenome`.
+ *
+ * @param data
+ * @param parameters
+ */
+void Evaluation::deserializeParameters(const std::string& data,
+                                       NEAT::Parameters&  parameters) {
+  std::stringbuf buffer(data, std::ios::in);
+  std::ifstream  stream;
+  stream.std::basic_ios<char>::rdbuf(&buffer);
+
+  parameters.Load(stream);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Sparsifier.hpp"
+
+namespace NEAT {
+  class Genome;
+  class Parameters;
+}
+
+/**
+ * @brief
+ *   Contains the messages that are sent between the EvaluationMaster and
+ *   the EvaluationWorkers, together with the functions that turns them
+ *   into bytes and back.
+ *
+ *   The conversation is simple. The worker connects and sends a Hello
+ *   containing the number of threads it has. The master answers with a
+ *   Setup for each experiment, followed by batches of Jobs, and the worker
+ *   answers each batch with Results. A new Setup is sent whenever the
+ *   settings change on the master. When the master has no more use for
+ *   the worker it sends Shutdown.
+ *
+ *   All integers and floats are sent in network byte order.
+ */
+namespace Evaluation {
+
+  //! The different types of frames that can be sent
+  enum Message : uint32_t {
+    Hello    = 1,
+    Jobs     = 2,
+    Results  = 3,
+    Shutdown = 4,
+    Setup    = 5,
+  };
+
+  //! The settings of an experiment on the master that a worker cannot
+  //! know by itself, such as a substrate and parameters loaded from file
+  struct Settings {
+    std::string     experiment;
+    std::string     substrate;
+    std::string     parameters;
+    bool            singlePrecision;
+    bool            persistentLeakyState;
+    SparsifyOptions sparsify;
+  };
+
+  //! A single genome to evaluate under an experiment
+  struct Job {
+    uint32_t    id;
+    std::string experiment;
+    std::string genome;
+  };
+
+  //! The outcome of evaluating a single Job
+  struct Result {
+    uint32_t           id;
+    bool               killed;
+    float              finalizedFitness;
+    float              duration;
+    std::vector<float> fitness;
+  };
+
+  // Encodes / decodes the Hello message
+  std::string encodeHello(uint32_t numThreads);
+  bool decodeHello(const std::string& payload, uint32_t& numThreads);
+
+  // Encodes / decodes the settings of an experiment
+  std::string encodeSetup(const Settings& settings);
+  bool decodeSetup(const std::string& payload, Settings& settings);
+
+  // Encodes / decodes a batch of jobs
+  std::string encodeJobs(const std::vector<Job>& jobs);
+  bool decodeJobs(const std::string& payload, std::vector<Job>& jobs);
+
+  // Encodes / decodes a batch of results
+  std::string encodeResults(const std::vector<Result>& results);
+  bool decodeResults(const std::string& payload, std::vector<Result>& results);
+
+  // Turns a genome into the same text as Genome::Save produces
+  std::string serializeGenome(NEAT::Genome& genome);
+
+  // Recreates a genome from the text produced by `serializeGenome`
+  NEAT::Genome deserializeGenome(const std::string& data);
+
+  // Turns parameters into the same text as Parameters::Save produces
+  std::string serializeParameters(NEAT::Parameters& parameters);
+
+  // Reads parameters from the text produced by `serializeParameters`
+  void deserializeParameters(const std::string& data,
+                             NEAT::Parameters&  parameters);
+}
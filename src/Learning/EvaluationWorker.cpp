@@ -0,0 +1,226 @@
+#include "EvaluationWorker.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+#include "../3D/Spider.hpp"
+#include "../Experiments/Experiment.hpp"
+#include "../Utils/ThreadPool.hpp"
+#include "ESHyperNEAT.hpp"
+#include "Substrate.hpp"
+
+#include <Genome.h>
+#include <NeuralNetwork.h>
+#include <Parameters.h>
+#include <Population.h>
+
+EvaluationWorker::EvaluationWorker() : Logging::Log("EvaluationWorker") {}
+
+EvaluationWorker::~EvaluationWorker() {
+  for (auto& p : mPhenotypes)
+    p.remove();
+
+  for (auto& e : mExperiments)
+    delete e.second;
+}
+
+/**
+ * @brief
+ *   Connects to the master and introduces itself by sending the number
+ *   of threads it evaluates with, which are those of the global
+ *   ThreadPool and the calling thread.
+ *
+ * @param address
+ *
+ * @return
+ */
+bool EvaluationWorker::connect(const std::string& address) {
+  if (!mSocket.connect(address))
+    return false;
+
+  unsigned int numThreads = ThreadPool::global().numThreads() + 1;
+
+  mLog->info("Connected to {} with {} thread(s)", address, numThreads);
+  return mSocket.send(Evaluation::Hello, Evaluation::encodeHello(numThreads));
+}
+
+bool EvaluationWorker::isConnected() const {
+  return mSocket.isOpen();
+}
+
+/**
+ * @brief
+ *   Blocks until the master sends something. Jobs are evaluated, grouped
+ *   by their experiment, and the results are sent back as a single batch.
+ *
+ * @return
+ */
+bool EvaluationWorker::step() {
+  uint32_t    type;
+  std::string payload;
+
+  if (!mSocket.receive(type, payload)) {
+    mLog->info("Master closed the connection");
+    return false;
+  }
+
+  switch (type) {
+    case Evaluation::Jobs: {
+      std::vector<Evaluation::Job> jobs;
+
+      if (!Evaluation::decodeJobs(payload, jobs)) {
+        mLog->error("Received invalid jobs from master");
+        mSocket.close();
+        return false;
+      }
+
+      std::map<std::string, std::vector<Evaluation::Job>> byExperiment;
+      std::vector<Evaluation::Result> results;
+
+      for (auto& job : jobs)
+        byExperiment[job.experiment].push_back(job);
+
+      for (auto& group : byExperiment)
+        evaluate(experiment(group.first), group.second, results);
+
+      return mSocket.send(Evaluation::Results,
+                          Evaluation::encodeResults(results));
+    }
+
+    case Evaluation::Setup: {
+      Evaluation::Settings settings;
+
+      if (!Evaluation::decodeSetup(payload, settings)) {
+        mLog->error("Received invalid setup from master");
+        mSocket.close();
+        return false;
+      }
+
+      apply(settings);
+      return true;
+    }
+
+    case Evaluation::Shutdown:
+      mLog->info("Master asked the worker to shut down");
+      mSocket.close();
+      return false;
+
+    default:
+      mLog->warn("Received unknown message of type {} from master", type);
+      return true;
+  }
+}
+
+/**
+ * @brief
+ *   Builds the networks for the jobs before simulating each of them
+ *   for the total duration of the experiment, stopping early if the
+ *   spider has been killed. The jobs are spread over the global
+ *   ThreadPool, so no threads are created for each batch.
+ *
+ * @param exp
+ * @param jobs
+ * @param results
+ */
+void EvaluationWorker::evaluate(Experiment&                         exp,
+                                const std::vector<Evaluation::Job>& jobs,
+                                std::vector<Evaluation::Result>&    results) {
+  while (mPhenotypes.size() < jobs.size())
+    mPhenotypes.push_back(Phenotype());
+
+  std::vector<NEAT::Genome> genomes;
+  genomes.reserve(jobs.size());
+
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    genomes.push_back(Evaluation::deserializeGenome(jobs[i].genome));
+
+    Phenotype& p = mPhenotypes[i];
+    p.reset(0, 0, i, genomes.back().GetID());
+    p.spider->disableUpdatingFromPhysics();
+    exp.initPhenotype(p);
+  }
+
+  auto worker = [&exp, &genomes, this](size_t begin, size_t end) {
+    NEAT::Population& pop = *exp.population();
+    float             dt  = exp.parameters().deltaTime;
+
+    for (size_t i = begin; i < end; ++i) {
+      Phenotype& p = mPhenotypes[i];
+
+      if (exp.parameters().useESHyperNEAT)
+        ESHyperNEAT::build(genomes[i],
+                           *p.network,
+                           *exp.substrate(),
+                           pop.m_Parameters);
+      else
+        genomes[i].BuildHyperNEATPhenotype(*p.network, *exp.substrate());
+
+      for (float t = 0; t < exp.totalDuration() && !p.hasBeenKilled(); t += dt)
+        p.update(exp);
+    }
+  };
+
+  ThreadPool::global().parallelFor(jobs.size(), worker);
+
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    Phenotype&         p = mPhenotypes[i];
+    Evaluation::Result result;
+
+    result.id               = jobs[i].id;
+    result.finalizedFitness = p.finalizeFitness(exp);
+    result.killed           = p.hasBeenKilled();
+    result.duration         = p.duration;
+
+    for (size_t j = 0; j < exp.fitnessFunctions().size(); ++j)
+      result.fitness.push_back(p.fitness[j]);
+
+    results.push_back(result);
+  }
+}
+
+/**
+ * @brief
+ *   Replaces the substrate and parameters of the experiment with the
+ *   ones the master is using, which may have been loaded from file.
+ *
+ * @param settings
+ */
+void EvaluationWorker::apply(const Evaluation::Settings& settings) {
+  Experiment&       exp = experiment(settings.experiment);
+  std::stringstream ss(settings.substrate);
+  Substrate*        substrate = new Substrate();
+
+  substrate->load(ss);
+  exp.setSubstrate(substrate);
+
+  Evaluation::deserializeParameters(settings.parameters,
+                                    exp.population()->m_Parameters);
+
+  exp.setSinglePrecision(settings.singlePrecision);
+  exp.setPersistentLeakyState(settings.persistentLeakyState);
+  exp.setSparsifyOptions(settings.sparsify);
+
+  mLog->info("Using the settings of the master for: {}", settings.experiment);
+}
+
+/**
+ * @brief
+ *   Returns the experiment with the given name, creating it the first
+ *   time it is asked for.
+ *
+ * @param name
+ *
+ * @return
+ */
+Experiment& EvaluationWorker::experiment(const std::string& name) {
+  auto it = mExperiments.find(name);
+
+  if (it != mExperiments.end())
+    return *it->second;
+
+  mLog->info("Loading experiment: {}", name);
+
+  Experiment* exp    = Experiment::create(name);
+  mExperiments[name] = exp;
+  return *exp;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../Log.hpp"
+#include "../Network/Socket.hpp"
+#include "EvaluationProtocol.hpp"
+#include "Phenotype.hpp"
+
+class Experiment;
+
+/**
+ * @brief
+ *   The EvaluationWorker connects to an EvaluationMaster and evaluates the
+ *   genomes it is sent, returning the fitness of each of them.
+ *
+ *   A batch of jobs is simulated in parallel using as many threads as the
+ *   machine has. Unlike the SpiderSwarm, every thread runs its Phenotypes
+ *   for the entire duration of the experiment before joining, since there
+ *   is no need to keep the Phenotypes in lockstep when nothing is drawn.
+ *
+ *   Experiments are created the first time a job or setup refers to them
+ *   and are kept for the lifetime of the worker. The master sends the
+ *   substrate and parameters it uses before any job, and these replace
+ *   the defaults of the experiment.
+ */
+class EvaluationWorker : public Logging::Log {
+public:
+  EvaluationWorker();
+  ~EvaluationWorker();
+
+  // Connects to the master, telling it how many threads are available
+  bool connect(const std::string& address);
+
+  // Whether or not the worker is connected to a master
+  bool isConnected() const;
+
+  // Waits for the next batch of jobs, evaluates it and sends back the
+  // results. Returns false when the master has gone away
+  bool step();
+
+private:
+  // Evaluates all of the jobs that use the same experiment
+  void evaluate(Experiment&                         experiment,
+                const std::vector<Evaluation::Job>& jobs,
+                std::vector<Evaluation::Result>&    results);
+
+  // Uses the substrate and parameters of the master for an experiment
+  void apply(const Evaluation::Settings& settings);
+
+  // Returns the experiment by the given name, creating it if needed
+  Experiment& experiment(const std::string& name);
+
+  Socket                             mSocket;
+  std::map<std::string, Experiment*> mExperiments;
+  std::vector<Phenotype>             mPhenotypes;
+};
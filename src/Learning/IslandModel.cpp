@@ -0,0 +1,563 @@
+#include "IslandModel.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "../3D/Spider.hpp"
+#include "../Experiments/Experiment.hpp"
+#include "../Utils/ThreadPool.hpp"
+#include "DrawablePhenotype.hpp"
+#include "ESHyperNEAT.hpp"
+#include "EvaluationProtocol.hpp"
+#include "Substrate.hpp"
+
+#include <NeuralNetwork.h>
+#include <Parameters.h>
+#include <Population.h>
+
+/**
+ * @brief
+ *   Creates the islands, each with their own instance of the experiment.
+ *
+ *   Since the experiments seed their populations with the current time,
+ *   the population of every island is rebuilt from the seed plus the index
+ *   of the island. The islands therefore start out different from each
+ *   other, while a run can be repeated by using the same seed.
+ *
+ * @param experiment
+ * @param numIslands
+ * @param migrationInterval
+ * @param numMigrants
+ * @param seed
+ */
+IslandModel::IslandModel(const std::string& experiment,
+                         unsigned int       numIslands,
+                         unsigned int       migrationInterval,
+                         unsigned int       numMigrants,
+                         int                seed)
+    : Logging::Log("IslandModel")
+    , mExperimentName(experiment)
+    , mMigrationInterval(std::max(migrationInterval, 1u))
+    , mNumMigrants(numMigrants)
+    , mRecordingMethod(RecordingMethod::None) {
+
+  for (unsigned int i = 0; i < std::max(numIslands, 1u); ++i) {
+    Island* island      = new Island();
+    island->experiment  = Experiment::create(experiment);
+    island->index       = i;
+    island->generation  = 0;
+    island->duration    = 0;
+    island->bestFitness = -99999.f;
+
+    if (island->experiment->population() == nullptr ||
+        island->experiment->substrate() == nullptr)
+      throw std::runtime_error("Experiment is missing population/substrate");
+
+    NEAT::Population* pop    = island->experiment->population();
+    NEAT::Parameters& params = pop->m_Parameters;
+
+    // Every individual has the topology of the genome the population was
+    // created from, only the weights are randomized
+    NEAT::Genome start = pop->m_Species[0].m_Individuals[0];
+
+    island->experiment->setPopulation(
+      new NEAT::Population(start, params, true, params.MaxWeight, seed + i));
+
+    recreatePhenotypes(*island);
+    mIslands.push_back(island);
+  }
+
+  // The islands start from the same genome and therefore agree on the
+  // innovations so far. From here on, they all use this one
+  mInnovations = mIslands[0]->experiment->population()->m_InnovationDatabase;
+
+  mLog->info("Created {} islands of {} with seed {}, migrating {} "
+             "genome(s) every {} generation(s)",
+             mIslands.size(),
+             experiment,
+             seed,
+             mNumMigrants,
+             mMigrationInterval);
+}
+
+IslandModel::~IslandModel() {
+  for (auto island : mIslands) {
+    for (auto& p : island->phenotypes)
+      p.remove();
+
+    delete island->experiment;
+    delete island;
+  }
+
+  mIslands.clear();
+}
+
+/**
+ * @brief
+ *   Runs a single step of every Phenotype on every island. The Phenotypes
+ *   are split evenly over the threads regardless of which island they
+ *   belong to.
+ *
+ *   Islands that have finished their generation, either because the
+ *   duration has passed or every Phenotype has been killed, go through
+ *   their epoch before the next update.
+ *
+ * @param deltaTime
+ */
+void IslandModel::update(float deltaTime) {
+  std::vector<std::pair<Phenotype*, const Experiment*>> work;
+
+  for (auto island : mIslands)
+    for (auto& p : island->phenotypes)
+      work.push_back({ &p, island->experiment });
+
+  auto worker = [&work](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i)
+      work[i].first->update(*work[i].second);
+  };
+
+#ifdef BT_NO_PROFILE
+  ThreadPool::global().parallelFor(work.size(), worker);
+#else
+  worker(0, work.size());
+#endif
+
+  for (size_t i = 0; i < mIslands.size(); ++i) {
+    Island& island = *mIslands[i];
+    island.duration += deltaTime;
+
+    bool isWipeout = std::all_of(island.phenotypes.begin(),
+                                 island.phenotypes.end(),
+                                 [](const Phenotype& p) {
+                                   return p.hasBeenKilled();
+                                 });
+
+    if (isWipeout || island.duration >= island.experiment->totalDuration())
+      updateEpoch(i);
+  }
+}
+
+/**
+ * @brief
+ *   Starts the current generation of every island over, just like
+ *   SpiderSwarm::restart does for a single population.
+ */
+void IslandModel::restart() {
+  for (auto island : mIslands)
+    recreatePhenotypes(*island);
+
+  mLog->info("Restarted the current generation of every island");
+}
+
+/**
+ * @brief
+ *   Captures the first Phenotype of each island, as long as there are
+ *   enough offsets.
+ *
+ * @param instances
+ * @param offsets
+ */
+void IslandModel::capture(std::vector<SpiderRenderer::Instance>& instances,
+                          const std::vector<mmm::vec3>&          offsets) {
+  for (size_t i = 0; i < mIslands.size() && i < offsets.size(); ++i) {
+    if (mIslands[i]->phenotypes.empty())
+      continue;
+
+    mIslands[i]->phenotypes[0].capture(instances, offsets[i]);
+  }
+}
+
+/**
+ * @brief
+ *   Saves each island to its own set of files, using the same file
+ *   endings as SpiderSwarm::save:
+ *
+ *   - `filename-islandX.population`
+ *   - `filename-islandX.genome`
+ *   - `filename-islandX.csv`
+ *
+ * @param filename
+ */
+void IslandModel::save(const std::string& filename) {
+  for (size_t i = 0; i < mIslands.size(); ++i) {
+    Island&     island = *mIslands[i];
+    std::string prefix = filename + "-island" + std::to_string(i);
+
+    island.experiment->population()->Save((prefix + ".population").c_str());
+    island.bestGenome.Save((prefix + ".genome").c_str());
+    island.stats.save(prefix + ".csv");
+  }
+}
+
+size_t IslandModel::numIslands() const {
+  return mIslands.size();
+}
+
+float IslandModel::bestFitness() const {
+  float best = -99999.f;
+
+  for (auto island : mIslands)
+    best = std::max(best, island->bestFitness);
+
+  return best;
+}
+
+/**
+ * @brief
+ *   Sets which individuals of the islands are recorded, just like
+ *   SpiderSwarm::setRecording. Recording everything starts with the next
+ *   generation of each island.
+ *
+ * @param method
+ * @param directory
+ */
+void IslandModel::setRecording(RecordingMethod    method,
+                               const std::string& directory) {
+  mRecordingMethod    = method;
+  mRecordingDirectory = directory;
+}
+
+/**
+ * @brief
+ *   Resets the Phenotypes of the island so that there is one for each
+ *   individual in the population before building the networks in
+ *   parallel, just like SpiderSwarm::recreatePhenotypes. Networks of
+ *   genomes that survived the epoch unchanged are taken from the cache.
+ *
+ * @param island
+ */
+void IslandModel::recreatePhenotypes(Island& island) {
+  NEAT::Population& pop   = *island.experiment->population();
+  Substrate&        sub   = *island.experiment->substrate();
+  bool              useES = island.experiment->parameters().useESHyperNEAT;
+  size_t            index = 0;
+
+  std::vector<NEAT::Genome*> genomes;
+  std::vector<size_t>        toBuild;
+  std::vector<uint64_t>      hashes;
+
+  for (size_t i = 0; i < pop.m_Species.size(); ++i) {
+    auto& species = pop.m_Species[i];
+
+    for (size_t j = 0; j < species.m_Individuals.size(); ++j) {
+      NEAT::Genome& g = species.m_Individuals[j];
+
+      if (index >= island.phenotypes.size())
+        island.phenotypes.push_back(Phenotype());
+
+      Phenotype& p = island.phenotypes[index];
+      p.reset(species.ID(), i, j, g.GetID());
+      p.spider->disableUpdatingFromPhysics();
+      island.experiment->initPhenotype(p);
+      genomes.push_back(&g);
+
+      if (mRecordingMethod == RecordingMethod::All)
+        p.startRecording(
+          replayPath(island, island.generation, species.ID(), g.GetID()),
+          *island.experiment);
+
+      uint64_t hash = NetworkCache::hash(g);
+
+      if (!island.cache.get(g.GetID(), hash, *p.network)) {
+        toBuild.push_back(index);
+        hashes.push_back(hash);
+      }
+
+      ++index;
+    }
+  }
+
+  while (index < island.phenotypes.size()) {
+    island.phenotypes.back().remove();
+    island.phenotypes.pop_back();
+  }
+
+  auto builder = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      size_t               k       = toBuild[i];
+      NEAT::NeuralNetwork& network = *island.phenotypes[k].network;
+
+      if (useES)
+        ESHyperNEAT::build(*genomes[k], network, sub, pop.m_Parameters);
+      else
+        genomes[k]->BuildHyperNEATPhenotype(network, sub);
+    }
+  };
+
+#ifdef BT_NO_PROFILE
+  ThreadPool::global().parallelFor(toBuild.size(), builder);
+#else
+  builder(0, toBuild.size());
+#endif
+
+  for (size_t i = 0; i < toBuild.size(); ++i)
+    island.cache.put(genomes[toBuild[i]]->GetID(),
+                     hashes[i],
+                     *island.phenotypes[toBuild[i]].network);
+
+  island.cache.nextGeneration();
+  island.duration = 0;
+}
+
+/**
+ * @brief
+ *   Gives the fitness of each Phenotype to its genome and stores the
+ *   statistics of the island. If the island has reached a migration
+ *   generation, it sends its best genomes onwards. Any genomes that have
+ *   arrived at the island replace its worst before the epoch.
+ *
+ * @param index
+ */
+void IslandModel::updateEpoch(size_t index) {
+  Island&           island      = *mIslands[index];
+  NEAT::Population& pop         = *island.experiment->population();
+  float             best        = -99999.f;
+  bool              newBest     = false;
+  unsigned int      bestSpecies = 0;
+  size_t            p           = 0;
+
+  island.generation += 1;
+
+  for (auto& species : pop.m_Species) {
+    NEAT::Genome* leader = nullptr;
+
+    for (auto& individual : species.m_Individuals) {
+      float fitness =
+        island.phenotypes[p].finalizeFitness(*island.experiment);
+
+      individual.SetFitness(fitness);
+      individual.SetEvaluated();
+
+      best = std::max(best, fitness);
+
+      if (fitness > island.bestFitness) {
+        island.bestFitness = fitness;
+        island.bestGenome  = individual;
+        newBest            = true;
+        bestSpecies        = species.ID();
+      }
+
+      if (leader == nullptr || fitness > leader->GetFitness())
+        leader = &individual;
+
+      ++p;
+    }
+
+    // The Phenotypes were reset before the generation was increased
+    if (mRecordingMethod == RecordingMethod::SpeciesLeaders && leader)
+      record(island, *leader, species.ID(), island.generation - 1);
+  }
+
+  if (mRecordingMethod == RecordingMethod::BestFitness && newBest)
+    record(island, island.bestGenome, bestSpecies, island.generation - 1);
+
+  island.stats.addEntry(island.phenotypes, island.generation);
+
+  mLog->info("Island {}, generation {}: Best of generation {}, Best of all {}",
+             index,
+             island.generation,
+             best,
+             island.bestFitness);
+
+  if (newBest) {
+    std::string prefix = "current-island" + std::to_string(index);
+    island.bestGenome.Save((prefix + ".genome").c_str());
+    island.stats.save(prefix + ".csv");
+  }
+
+  if (island.generation % mMigrationInterval == 0 && mIslands.size() > 1)
+    sendMigrants(index);
+
+  receiveMigrants(island);
+
+  // Mutations are looked up in and added to the innovations shared by
+  // all the islands, so a migrant means the same thing everywhere
+  pop.m_InnovationDatabase = mInnovations;
+  pop.Epoch();
+  mInnovations = pop.m_InnovationDatabase;
+
+  recreatePhenotypes(island);
+}
+
+std::string IslandModel::replayPath(const Island& island,
+                                    unsigned int  generation,
+                                    unsigned int  speciesId,
+                                    unsigned int  genomeId) const {
+  return mRecordingDirectory + "/i" + std::to_string(island.index) + "-" +
+         ReplayRecorder::name(generation, speciesId, genomeId);
+}
+
+/**
+ * @brief
+ *   Builds the network of the genome and simulates it again in the
+ *   experiment of the island, recording it to a replay file. Must be
+ *   called before the epoch, while the genome is still the one that was
+ *   evaluated.
+ *
+ * @param island
+ * @param genome
+ * @param speciesId
+ * @param generation
+ */
+void IslandModel::record(Island&       island,
+                         NEAT::Genome& genome,
+                         unsigned int  speciesId,
+                         unsigned int  generation) {
+  NEAT::Population&   pop = *island.experiment->population();
+  Substrate&          sub = *island.experiment->substrate();
+  NEAT::NeuralNetwork network;
+
+  if (island.experiment->parameters().useESHyperNEAT)
+    ESHyperNEAT::build(genome, network, sub, pop.m_Parameters);
+  else
+    genome.BuildHyperNEATPhenotype(network, sub);
+
+  Phenotype::evaluate(
+    *island.experiment,
+    network,
+    genome.GetID(),
+    speciesId,
+    replayPath(island, generation, speciesId, genome.GetID()));
+}
+
+/**
+ * @brief
+ *   Puts copies of the best genomes of the island in the inbox of the
+ *   next island in the ring. Must be called after the fitness has been
+ *   set on the genomes.
+ *
+ * @param index
+ */
+void IslandModel::sendMigrants(size_t index) {
+  NEAT::Population& pop = *mIslands[index]->experiment->population();
+  Island&           to  = *mIslands[(index + 1) % mIslands.size()];
+
+  std::vector<NEAT::Genome*> genomes;
+
+  for (auto& species : pop.m_Species)
+    for (auto& individual : species.m_Individuals)
+      genomes.push_back(&individual);
+
+  size_t numMigrants = std::min<size_t>(mNumMigrants, genomes.size());
+
+  std::partial_sort(genomes.begin(),
+                    genomes.begin() + numMigrants,
+                    genomes.end(),
+                    [](NEAT::Genome* a, NEAT::Genome* b) {
+                      return a->GetFitness() > b->GetFitness();
+                    });
+
+  for (size_t i = 0; i < numMigrants; ++i)
+    to.inbox.push_back({ Evaluation::serializeGenome(*genomes[i]),
+                         static_cast<float>(genomes[i]->GetFitness()) });
+
+  mLog->debug("Island {} sent {} migrant(s)", index, numMigrants);
+}
+
+/**
+ * @brief
+ *   Replaces the worst genomes of the island with the genomes in its inbox.
+ *   Each migrant is given a new ID from the receiving population so that
+ *   IDs stay unique within it.
+ *
+ *   A migrant takes the place of a genome in a species it may have nothing
+ *   in common with, so the migrants are speciated again afterwards. The
+ *   fitness sharing of the species is then adjusted by the epoch.
+ *
+ * @param island
+ */
+void IslandModel::receiveMigrants(Island& island) {
+  if (island.inbox.empty())
+    return;
+
+  NEAT::Population& pop = *island.experiment->population();
+
+  std::vector<NEAT::Genome*> genomes;
+  std::vector<unsigned int>  migrants;
+
+  for (auto& species : pop.m_Species)
+    for (auto& individual : species.m_Individuals)
+      genomes.push_back(&individual);
+
+  std::sort(genomes.begin(),
+            genomes.end(),
+            [](NEAT::Genome* a, NEAT::Genome* b) {
+              return a->GetFitness() < b->GetFitness();
+            });
+
+  size_t numMigrants = std::min(island.inbox.size(), genomes.size());
+
+  for (size_t i = 0; i < numMigrants; ++i) {
+    NEAT::Genome& target = *genomes[i];
+
+    target = Evaluation::deserializeGenome(island.inbox[i].genome);
+    target.SetID(pop.GetNextGenomeID());
+    target.SetFitness(island.inbox[i].fitness);
+    target.SetEvaluated();
+    pop.IncrementNextGenomeID();
+    migrants.push_back(target.GetID());
+  }
+
+  island.inbox.clear();
+
+  for (auto id : migrants)
+    speciate(pop, id);
+}
+
+/**
+ * @brief
+ *   Moves the genome to the first species it is compatible with, or the
+ *   species it is closest to if there is none. A genome that is the only
+ *   member of its species stays there, since species are not allowed to
+ *   be empty.
+ *
+ * @param pop
+ * @param id
+ */
+void IslandModel::speciate(NEAT::Population& pop, unsigned int id) {
+  size_t from  = 0;
+  size_t index = 0;
+  bool   found = false;
+
+  for (size_t i = 0; i < pop.m_Species.size() && !found; ++i) {
+    auto& individuals = pop.m_Species[i].m_Individuals;
+
+    for (size_t j = 0; j < individuals.size(); ++j) {
+      if (individuals[j].GetID() == id) {
+        from  = i;
+        index = j;
+        found = true;
+        break;
+      }
+    }
+  }
+
+  if (!found || pop.m_Species[from].m_Individuals.size() < 2)
+    return;
+
+  NEAT::Genome genome  = pop.m_Species[from].m_Individuals[index];
+  size_t       to      = from;
+  double       closest = std::numeric_limits<double>::max();
+
+  for (size_t i = 0; i < pop.m_Species.size(); ++i) {
+    NEAT::Genome representative = pop.m_Species[i].GetRepresentative();
+    double distance =
+      genome.CompatibilityDistance(representative, pop.m_Parameters);
+
+    if (distance < closest) {
+      closest = distance;
+      to      = i;
+    }
+
+    if (distance < pop.m_Parameters.CompatTreshold)
+      break;
+  }
+
+  if (to == from)
+    return;
+
+  auto& individuals = pop.m_Species[from].m_Individuals;
+  individuals.erase(individuals.begin() + index);
+  pop.m_Species[to].AddIndividual(genome);
+}
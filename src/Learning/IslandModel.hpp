@@ -0,0 +1,142 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <mmm.hpp>
+
+#include "../Log.hpp"
+#include "NetworkCache.hpp"
+#include "Phenotype.hpp"
+#include "Replay.hpp"
+#include "Statistics.hpp"
+
+#include <Genome.h>
+#include <Innovation.h>
+
+class Experiment;
+
+namespace NEAT {
+  class Population;
+}
+
+/**
+ * @brief
+ *   The IslandModel evolves several independent populations, called islands,
+ *   of the same experiment at once. Every island has its own Experiment,
+ *   and therefore its own Population and Substrate, and goes through its
+ *   generations without waiting for the other islands.
+ *
+ *   Every `migrationInterval` generations, an island sends copies of its
+ *   best genomes to the next island in a ring. They are serialized the same
+ *   way as `.genome` files and replace the worst individuals of the
+ *   receiving island before its next epoch. Their fitness from the island
+ *   they came from is kept, so they take part in reproduction right away.
+ *
+ *   All the Phenotypes of all the islands are simulated in parallel on the
+ *   global ThreadPool, while epochs and migration happens on the main
+ *   thread.
+ *
+ *   Islands only scale across cores. They are not evaluated by worker
+ *   processes, since each island reaches its epoch on its own while the
+ *   EvaluationMaster hands out one generation of one population at a
+ *   time. SpiderSwarm therefore refuses to listen for workers when
+ *   islands are used.
+ *
+ *   All the islands share one database of innovations, so that a link or
+ *   neuron of a migrant has the same innovation number on every island.
+ *
+ *   Each island keeps its own Statistics, which are saved to separate files.
+ *
+ *   Replays are recorded like those of SpiderSwarm, prefixed with the
+ *   island, like `i2-g12-s3-4051.replay`.
+ */
+class IslandModel : public Logging::Log {
+public:
+  IslandModel(const std::string& experiment,
+              unsigned int       numIslands,
+              unsigned int       migrationInterval,
+              unsigned int       numMigrants,
+              int                seed);
+  ~IslandModel();
+
+  // Runs a single step on every Phenotype of every island
+  void update(float deltaTime);
+
+  // Starts the current generation of every island over
+  void restart();
+
+  // Captures the first Phenotype of each island at the given offsets
+  void capture(std::vector<SpiderRenderer::Instance>& instances,
+               const std::vector<mmm::vec3>&          offsets);
+
+  // Saves the population, statistics and best genome of each island to
+  // files postfixed with `-islandX`
+  void save(const std::string& filename);
+
+  // Returns the number of islands
+  size_t numIslands() const;
+
+  // Returns the best fitness found on any island
+  float bestFitness() const;
+
+  // Sets which individuals are recorded, writing one replay file for each
+  // of them into the directory
+  void setRecording(RecordingMethod method, const std::string& directory);
+
+private:
+  //! A genome that is on its way to another island
+  struct Migrant {
+    std::string genome;
+    float       fitness;
+  };
+
+  struct Island {
+    Experiment*            experiment;
+    std::vector<Phenotype> phenotypes;
+    std::vector<Migrant>   inbox;
+    Statistics             stats;
+    NetworkCache           cache;
+    NEAT::Genome           bestGenome;
+    size_t                 index;
+    unsigned int           generation;
+    float                  duration;
+    float                  bestFitness;
+  };
+
+  // Resets the Phenotypes and builds the networks of the island
+  void recreatePhenotypes(Island& island);
+
+  // Finalizes the generation of the island, migrating if it is time
+  void updateEpoch(size_t index);
+
+  // Sends the best genomes of the island to the next island
+  void sendMigrants(size_t index);
+
+  // Replaces the worst genomes of the island with those in its inbox
+  void receiveMigrants(Island& island);
+
+  // Moves the genome with the given ID to the species it belongs to
+  void speciate(NEAT::Population& pop, unsigned int id);
+
+  // Returns the path of the replay of a genome of the island
+  std::string replayPath(const Island& island,
+                         unsigned int  generation,
+                         unsigned int  speciesId,
+                         unsigned int  genomeId) const;
+
+  // Simulates the genome again, recording it to a replay file
+  void record(Island&       island,
+              NEAT::Genome& genome,
+              unsigned int  speciesId,
+              unsigned int  generation);
+
+  std::vector<Island*>     mIslands;
+  NEAT::InnovationDatabase mInnovations;
+  std::string              mExperimentName;
+  unsigned int             mMigrationInterval;
+  unsigned int             mNumMigrants;
+  RecordingMethod          mRecordingMethod;
+  std::string              mRecordingDirectory;
+};
@@ -0,0 +1,135 @@
+#include "NetworkCache.hpp"
+
+#include <cstring>
+
+#include <Genome.h>
+
+// Constants used by the 64-bit FNV-1a hash
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME  = 1099511628211ULL;
+
+/**
+ * @brief
+ *   Mixes the bytes of the value into the hash
+ *
+ * @param hash
+ * @param value
+ */
+template <typename T>
+static void combine(uint64_t& hash, const T& value) {
+  unsigned char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+
+  for (auto b : bytes) {
+    hash ^= b;
+    hash *= FNV_PRIME;
+  }
+}
+
+NetworkCache::NetworkCache() : mGeneration(0), mHits(0) {}
+
+/**
+ * @brief
+ *   Hashes the neurons and links of the genome, including all the values
+ *   that are used when querying the CPPN. The order of the genes is part
+ *   of the hash, which is fine since copies of a genome keep the order.
+ *
+ * @param genome
+ *
+ * @return
+ */
+uint64_t NetworkCache::hash(NEAT::Genome& genome) {
+  uint64_t hash = FNV_OFFSET;
+
+  combine(hash, genome.NumNeurons());
+  combine(hash, genome.NumLinks());
+
+  for (unsigned int i = 0; i < genome.NumNeurons(); ++i) {
+    NEAT::NeuronGene n = genome.GetNeuronByIndex(i);
+
+    combine(hash, n.ID());
+    combine(hash, static_cast<int>(n.Type()));
+    combine(hash, static_cast<int>(n.m_ActFunction));
+    combine(hash, n.m_A);
+    combine(hash, n.m_B);
+    combine(hash, n.m_TimeConstant);
+    combine(hash, n.m_Bias);
+  }
+
+  for (unsigned int i = 0; i < genome.NumLinks(); ++i) {
+    NEAT::LinkGene l = genome.GetLinkByIndex(i);
+
+    combine(hash, l.FromNeuronID());
+    combine(hash, l.ToNeuronID());
+    combine(hash, l.InnovationID());
+    combine(hash, l.GetWeight());
+  }
+
+  return hash;
+}
+
+/**
+ * @brief
+ *   Copies the cached network for the genome into `network`, marking it
+ *   as used in this generation.
+ *
+ * @param genomeId
+ * @param hash
+ * @param network
+ *
+ * @return
+ */
+bool NetworkCache::get(unsigned int         genomeId,
+                       uint64_t             hash,
+                       NEAT::NeuralNetwork& network) {
+  auto it = mEntries.find(genomeId);
+
+  if (it == mEntries.end() || it->second.hash != hash)
+    return false;
+
+  it->second.lastUsed = mGeneration;
+  network             = it->second.network;
+  mHits += 1;
+
+  return true;
+}
+
+void NetworkCache::put(unsigned int               genomeId,
+                       uint64_t                   hash,
+                       const NEAT::NeuralNetwork& network) {
+  Entry& e   = mEntries[genomeId];
+  e.hash     = hash;
+  e.lastUsed = mGeneration;
+  e.network  = network;
+}
+
+/**
+ * @brief
+ *   Removes every network that has not been used or stored since the last
+ *   call. Genomes that are gone from the population are therefore only
+ *   kept for a single generation.
+ */
+void NetworkCache::nextGeneration() {
+  for (auto it = mEntries.begin(); it != mEntries.end();) {
+    if (it->second.lastUsed != mGeneration)
+      it = mEntries.erase(it);
+    else
+      ++it;
+  }
+
+  mGeneration += 1;
+  mHits = 0;
+}
+
+void NetworkCache::clear() {
+  mEntries.clear();
+  mHits = 0;
+}
+
+size_t NetworkCache::size() const {
+  return mEntries.size();
+}
+
+size_t NetworkCache::hits() const {
+  return mHits;
+}
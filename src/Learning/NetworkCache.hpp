@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+#include <NeuralNetwork.h>
+
+namespace NEAT {
+  class Genome;
+}
+
+/**
+ * @brief
+ *   Keeps the networks that were built for the genomes of the previous
+ *   generation so that genomes that survive unchanged, such as elites,
+ *   does not have to be built again.
+ *
+ *   Networks are stored by the ID of the genome together with a hash of
+ *   the structure of the genome, meaning its neurons, links and their
+ *   parameters. A network is only reused if both match, so a genome that
+ *   has been changed in place or a different genome with a reused ID is
+ *   always rebuilt.
+ *
+ *   The networks depend on the substrate and parameters as well, so the
+ *   cache has to be cleared whenever those change.
+ */
+class NetworkCache {
+public:
+  NetworkCache();
+
+  // Computes a hash of everything in the genome that affects the network
+  static uint64_t hash(NEAT::Genome& genome);
+
+  // Copies the cached network into `network` if there is one for the
+  // genome. Returns false if the network has to be built
+  bool get(unsigned int genomeId, uint64_t hash, NEAT::NeuralNetwork& network);
+
+  // Stores a copy of the network built for the genome
+  void put(unsigned int               genomeId,
+           uint64_t                   hash,
+           const NEAT::NeuralNetwork& network);
+
+  // Removes the networks that were not used since the last call
+  void nextGeneration();
+
+  // Removes every network
+  void clear();
+
+  // Returns the number of networks in the cache
+  size_t size() const;
+
+  // Returns the number of times a network was reused since the last
+  // call to nextGeneration
+  size_t hits() const;
+
+private:
+  struct Entry {
+    uint64_t            hash;
+    unsigned int        lastUsed;
+    NEAT::NeuralNetwork network;
+  };
+
+  std::unordered_map<unsigned int, Entry> mEntries;
+
+  unsigned int mGeneration;
+  size_t       mHits;
+};
@@ -13,6 +13,8 @@
 #include "../Experiments/ExperimentUtil.hpp"
 #include "DrawablePhenotype.hpp"
 #include "Fitness.hpp"
+#include "Replay.hpp"
+#include "Sparsifier.hpp"
 #include "Substrate.hpp"
 
 using mmm::vec2;
@@ -53,10 +55,13 @@ Phenotype::Phenotype()
     , world(nullptr)
     , spider(nullptr)
     , network(nullptr)
+    , compiledFrom(nullptr)
+    , compiledSingle(false)
     , planeMotion(nullptr)
     , planeBody(nullptr)
     , drawablePhenotype(nullptr)
     , hoverText(nullptr)
+    , recorder(nullptr)
     , fitness(0)
     , failed(false)
     , finalizedFitness(0)
@@ -79,6 +84,7 @@ void Phenotype::remove() {
   delete planeMotion;
   delete planeBody;
   delete hoverText;
+  stopRecording();
 }
 btRigidBody* Phenotype::rigidBody(const std::string& name) const {
   auto& parts = spider->parts();
@@ -196,6 +202,52 @@ void Phenotype::updatePrepareStanding(const Experiment& experiment) {
   duration += deltaTime;
 }
 
+/**
+ * @brief
+ *   Activates the compiled network, in whichever precision it was compiled
+ *   in, and stores the outputs
+ *
+ * @param compiled
+ * @param experiment
+ * @param duration
+ * @param inputs
+ * @param outputs
+ */
+template <typename Network>
+static void activateNetwork(Network&                  compiled,
+                            const Experiment&         experiment,
+                            float                     duration,
+                            const std::vector<float>& inputs,
+                            std::vector<float>&       outputs) {
+  const ExperimentParameters& expParams = experiment.parameters();
+  bool                        leaky     = experiment.substrate()->m_leaky;
+
+  if (leaky && expParams.persistentLeakyState) {
+    // The membrane potentials are kept between updates, and only reset
+    // when the network is compiled. Each update integrates over the time
+    // step, split into numActivates smaller steps
+    compiled.input(inputs);
+    compiled.activateLeaky(expParams.deltaTime / expParams.numActivates,
+                           expParams.numActivates);
+  } else if (leaky) {
+    // Starts from rest and integrates numActivates times over the elapsed
+    // duration, like NEAT's ActivateLeaky did. ES-HyperNEAT networks are
+    // leaky with either builder, see ESHyperNEAT::build
+    compiled.flush();
+    compiled.input(inputs);
+    compiled.activateLeaky(duration, expParams.numActivates);
+  } else {
+    // Each layer of the network is activated exactly once, so the signal
+    // reaches the outputs no matter how deep the network is. Recurrent
+    // networks are activated up to numActivates times, or until stable
+    compiled.flush();
+    compiled.input(inputs);
+    compiled.activate(expParams.numActivates, expParams.activationTolerance);
+  }
+
+  compiled.output(outputs);
+}
+
 /**
  * @brief
  *   Activates the network associated with the spider by using
@@ -221,7 +273,7 @@ void Phenotype::update(const Experiment& experiment) {
 
   duration += deltaTime;
 
-  std::vector<double> inputs = experiment.inputs(*this);
+  std::vector<float> inputs = experiment.inputs(*this);
 
   // Throw error if the input is not equal to the expected number of inputs.
   // This is mostly for debugging as we may sometimes forget to add/remove
@@ -233,47 +285,27 @@ void Phenotype::update(const Experiment& experiment) {
     throw std::runtime_error("Phenotype missing inputs. See message above.");
   }
 
-  // Flush the network, resetting its activesum and activations
-  // before giving it new input
-  network->Flush();
-  network->Input(inputs);
+  if (compiledFrom != network || compiledSingle != expParams.singlePrecision)
+    prepareNetwork(experiment);
 
-  // If using HyperNEAT, use the numActivates variable.
-  // If using ESHyperNEAT activate in the following way:
-  //
-  // IterationLevel describes how many hidden layers, where 0 = 1 hidden layer
-  // In order to activate properly, it has to be activated as many times
-  // as the number of hidden layers + 1, therefore:
-  //  0 IterationLevel = 1 Hidden Layer  = 2 Activations
-  //  1 IterationLevel = 2 Hidden Layers = 3 Activations
-  //  ...
-  //  and so on
-  int numActivates = expParams.useESHyperNEAT ?
-                       experiment.neatParameters().IterationLevel + 2 :
-                       expParams.numActivates;
-
-  // Activate the network, going through all connections and neurons
-  // to set the activesum and activation values. The number of
-  // times needed to activate depends on the depth of the network
-  //
-  for (int a = 0; a < numActivates; a++) {
-
-    // ESHyperNEAT does not support leaky as the bias and timeconst variables
-    // never change.
-    if (experiment.substrate()->m_leaky && !expParams.useESHyperNEAT)
-      network->ActivateLeaky(duration);
-    else
-      network->Activate();
-  }
+  // The outputs are written straight into previousOutput, which is read by
+  // the experiment the next time the inputs are created
+  if (expParams.singlePrecision)
+    activateNetwork(
+      compiledNetworkF, experiment, duration, inputs, previousOutput);
+  else
+    activateNetwork(
+      compiledNetwork, experiment, duration, inputs, previousOutput);
 
-  std::vector<double> output = network->Output();
-  experiment.outputs(*this, output);
-  previousOutput = output;
+  experiment.outputs(*this, previousOutput);
 
   // Finally, now that all things are set, lets keep updating the
   // physics
   world->doPhysics(deltaTime);
 
+  if (recorder != nullptr)
+    recorder->record(*spider, duration, previousOutput);
+
   // After the physics have been executed, evaluate the fitness
   // of the robot.
   updateFitness(experiment);
@@ -283,28 +315,76 @@ void Phenotype::update(const Experiment& experiment) {
 
 /**
  * @brief
- *   Draw the Phenotype by drawing the spider with an offset as
- *   well as text above it to make it easier to distinguish the
- *   different robots
+ *   Runs the sparsification stage of the experiment on the network, if it
+ *   is enabled, before compiling it. Sparsifying a network twice gives the
+ *   same result, so networks that are swapped back in can go through it
+ *   again.
  *
- * @param prog
- * @param offset
- * @param bindTexture
+ * @param experiment
  */
-void Phenotype::draw(std::shared_ptr<Program>& prog,
-                     mmm::vec3                 offset,
-                     bool                      bindTexture) {
+void Phenotype::prepareNetwork(const Experiment& experiment) {
+  const SparsifyOptions& options = experiment.parameters().sparsify;
+
+  if (options.enabled())
+    Sparsifier::sparsify(*network, options);
 
+  compiledSingle = experiment.parameters().singlePrecision;
+
+  if (compiledSingle)
+    compiledNetworkF.compile(*network);
+  else
+    compiledNetwork.compile(*network);
+
+  compiledFrom = network;
+}
+
+/**
+ * @brief
+ *   Captures the parts of the spider with an offset. This only reads the
+ *   physics, so it is done by the thread that simulates the Phenotype,
+ *   right after it has been updated.
+ *
+ * @param instances
+ * @param offset
+ */
+void Phenotype::capture(std::vector<SpiderRenderer::Instance>& instances,
+                        const mmm::vec3&                       offset) {
   if (spider == nullptr)
     return;
 
-  spider->enableUpdatingFromPhysics();
-  spider->draw(prog, offset, bindTexture);
+  SpiderRenderer::capture(*spider, offset, instances);
+}
+
+/**
+ * @brief
+ *   Rebuilds the drawable of the network. The drawable is only created
+ *   the first time the network is drawn, since it owns OpenGL buffers that
+ *   Phenotypes which are never drawn do not need.
+ */
+void Phenotype::recreateDrawable() {
+  if (drawablePhenotype == nullptr)
+    drawablePhenotype = new DrawablePhenotype();
 
-  if (bindTexture && hoverText != nullptr) {
-    /* auto& pos = spider->parts().at("Sternum").part->position(); */
-    /* hoverText->draw(pos + mmm::vec3(0, 3, 0) + offset); */
-  }
+  drawablePhenotype->recreate(*network, mmm::vec3(1.0, 1.0, 1.0));
+}
+
+/**
+ * @brief
+ *   Draws the label with the species and individual above the sternum of
+ *   the spider. The position is read from the physics, since the parts of
+ *   the spider are not updated from it.
+ *
+ * @param offset
+ */
+void Phenotype::drawLabel(const mmm::vec3& offset) {
+  if (spider == nullptr || hoverText == nullptr)
+    return;
+
+  const btRigidBody* sternum  = spider->parts().at("Sternum").part->rigidBody();
+  const btVector3&   position = sternum->getCenterOfMassPosition();
+
+  hoverText->draw(mmm::vec3(position.x(), position.y() + 3, position.z()) +
+                  offset);
 }
 
 /**
@@ -356,6 +436,7 @@ bool Phenotype::hasBeenKilled() const {
  */
 float Phenotype::finalizeFitness(const Experiment& experiment) {
   hasFinalized = true;
+  stopRecording();
 
   int index = 0;
   for (const auto& s : experiment.fitnessFunctions()) {
@@ -391,11 +472,6 @@ void Phenotype::reset(int          speciesId,
   else
     world->reset();
 
-  // Initiate the DrawablePhenotype class that lets
-  // you draw the network that the Phenotype represents
-  if (drawablePhenotype == nullptr)
-    drawablePhenotype = new DrawablePhenotype();
-
   // Create the plane that the spider will walk upon
   if (planeBody == nullptr) {
     planeMotion = new btDefaultMotionState(
@@ -457,6 +533,81 @@ void Phenotype::reset(int          speciesId,
   this->genomeId        = genomeId;
 
   previousOutput.clear();
+  compiledFrom = nullptr;
+
+  stopRecording();
+}
+
+/**
+ * @brief
+ *   Starts recording the phenotype to a replay file, which is closed when
+ *   its fitness is finalized or it is reset. Only the ticks after the
+ *   spider has been put into its resting position are recorded.
+ *
+ * @param filename
+ * @param experiment
+ */
+void Phenotype::startRecording(const std::string& filename,
+                               const Experiment&  experiment) {
+  stopRecording();
+  recorder = new ReplayRecorder(
+    filename, genomeId, speciesId, experiment.parameters().deltaTime);
+}
+
+void Phenotype::stopRecording() {
+  if (recorder == nullptr)
+    return;
+
+  mLog->debug("Recorded {} ticks to {}",
+              recorder->numTicks(),
+              recorder->filename());
+
+  delete recorder;
+  recorder = nullptr;
+}
+
+/**
+ * @brief
+ *   Runs a Phenotype with the given network from start to end, without
+ *   drawing it, and returns the finalized fitness. This is used to look
+ *   at genomes again after they have been evaluated, wherever that was.
+ *
+ * @param experiment
+ * @param network
+ * @param genomeId
+ * @param speciesId
+ * @param replay
+ *   The file to record the evaluation to, or empty to not record it
+ *
+ * @return
+ */
+float Phenotype::evaluate(const Experiment&          experiment,
+                          const NEAT::NeuralNetwork& network,
+                          unsigned int               genomeId,
+                          unsigned int               speciesId,
+                          const std::string&         replay) {
+  Phenotype p;
+  float     deltaTime = experiment.parameters().deltaTime;
+
+  p.reset(speciesId, 0, 0, genomeId);
+  p.spider->disableUpdatingFromPhysics();
+  experiment.initPhenotype(p);
+  *p.network = network;
+
+  if (!replay.empty())
+    p.startRecording(replay, experiment);
+
+  for (float t = 0; t < experiment.totalDuration(); t += deltaTime) {
+    if (p.hasBeenKilled())
+      break;
+
+    p.update(experiment);
+  }
+
+  float fitness = p.finalizeFitness(experiment);
+  p.remove();
+
+  return fitness;
 }
 
 // In order to save memory, this shape is stored statically on
@@ -3,7 +3,9 @@
 #include <mmm.hpp>
 #include <vector>
 
+#include "../3D/SpiderRenderer.hpp"
 #include "../Log.hpp"
+#include "CompiledNetwork.hpp"
 
 struct btDefaultMotionState;
 class btRigidBody;
@@ -16,6 +18,7 @@ class Text3D;
 class Experiment;
 class Drawable3D;
 class Program;
+class ReplayRecorder;
 
 namespace NEAT {
   class NeuralNetwork;
@@ -37,16 +40,27 @@ struct Phenotype : Logging::Log {
   Spider*              spider;
   NEAT::NeuralNetwork* network;
 
+  // The network is compiled the first time it is activated after a reset,
+  // or when the network pointer has been changed. Only one of the two is
+  // compiled, depending on ExperimentParameters::singlePrecision
+  CompiledNetwork            compiledNetwork;
+  CompiledNetworkF           compiledNetworkF;
+  const NEAT::NeuralNetwork* compiledFrom;
+  bool                       compiledSingle;
+
   btDefaultMotionState* planeMotion;
   btRigidBody*          planeBody;
 
   DrawablePhenotype* drawablePhenotype;
   Text3D*            hoverText;
 
+  // Writes the transforms of every tick to a replay file while set
+  ReplayRecorder* recorder;
+
   mmm::vec<9> fitness;
   mmm::vec3   initialPosition;
 
-  std::vector<double> previousOutput;
+  std::vector<float> previousOutput;
 
   mutable std::vector<std::vector<float>> tmp;
 
@@ -85,11 +99,34 @@ struct Phenotype : Logging::Log {
              int          individualIndex,
              unsigned int genomeId);
 
+  // Records every following tick of the evaluation to the file
+  void startRecording(const std::string& filename,
+                      const Experiment&  experiment);
+
+  // Closes the replay file, if the phenotype is being recorded
+  void stopRecording();
+
+  // Simulates the network for the entire experiment without drawing it,
+  // recording it to the replay file if one is given, and returns its
+  // fitness
+  static float evaluate(const Experiment&          experiment,
+                        const NEAT::NeuralNetwork& network,
+                        unsigned int               genomeId,
+                        unsigned int               speciesId,
+                        const std::string&         replay = "");
+
   // Performs the update of the phenotype
   void update(const Experiment& experiment);
 
-  // Draws the spider representing the phenotype together with its text
-  void draw(std::shared_ptr<Program>& prog, mmm::vec3 offset, bool bindTexture);
+  // Appends the parts of the spider, moved by the offset, to instances
+  void capture(std::vector<SpiderRenderer::Instance>& instances,
+               const mmm::vec3&                       offset);
+
+  // Rebuilds the drawable of the network, creating it the first time
+  void recreateDrawable();
+
+  // Draws the species and individual of the spider above it
+  void drawLabel(const mmm::vec3& offset);
 
   static btStaticPlaneShape* plane;
 
@@ -97,6 +134,9 @@ struct Phenotype : Logging::Log {
   void kill() const;
 
 private:
+  // Sparsifies and compiles the network
+  void prepareNetwork(const Experiment& experiment);
+
   // Prepares the phenotype for simulation
   void updatePrepareStanding(const Experiment& experiment);
 
@@ -0,0 +1,354 @@
+#include "Replay.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../3D/Spider.hpp"
+
+namespace {
+  const char     MAGIC[4] = { 'R', 'P', 'L', 'Y' };
+  const uint32_t VERSION  = 1;
+
+  // Offsets from the first part are stored in steps of 1/1024, which
+  // covers 32 units in each direction
+  const float POSITION_STEP = 1.f / 1024.f;
+  const float ROTATION_STEP = 1.f / 32767.f;
+
+  template <typename T>
+  void write(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  void read(std::ifstream& file, T& value) {
+    file.read(reinterpret_cast<char*>(&value), sizeof(T));
+  }
+
+  int16_t quantize(float value, float step) {
+    float q = std::round(value / step);
+    return static_cast<int16_t>(std::max(-32767.f, std::min(32767.f, q)));
+  }
+}
+
+/**
+ * @brief
+ *   Opens the file for writing. The header is written together with the
+ *   first tick, once the number of outputs is known.
+ *
+ *   Recording is only done to be looked at later, so failing to write the
+ *   file is logged instead of stopping the evaluation.
+ *
+ * @param filename
+ * @param genomeId
+ * @param speciesId
+ * @param deltaTime
+ */
+ReplayRecorder::ReplayRecorder(const std::string& filename,
+                               unsigned int       genomeId,
+                               unsigned int       speciesId,
+                               float              deltaTime)
+    : Logging::Log("ReplayRecorder")
+    , mFile(filename, std::ios::out | std::ios::binary)
+    , mFilename(filename)
+    , mGenomeId(genomeId)
+    , mSpeciesId(speciesId)
+    , mDeltaTime(deltaTime)
+    , mNumParts(0)
+    , mNumOutputs(0)
+    , mNumTicks(0)
+    , mFailed(false) {
+  if (!mFile.is_open()) {
+    mLog->warn("Unable to write replay: {}", filename);
+    mFailed = true;
+  }
+}
+
+void ReplayRecorder::writeHeader(Spider& spider, size_t numOutputs) {
+  mNumParts   = spider.parts().size();
+  mNumOutputs = numOutputs;
+
+  mFile.write(MAGIC, 4);
+  write(mFile, VERSION);
+  write(mFile, static_cast<uint32_t>(mGenomeId));
+  write(mFile, static_cast<uint32_t>(mSpeciesId));
+  write(mFile, mDeltaTime);
+  write(mFile, static_cast<uint32_t>(mNumParts));
+
+  for (auto& part : spider.parts()) {
+    write(mFile, static_cast<uint32_t>(part.first.size()));
+    mFile.write(part.first.data(), part.first.size());
+  }
+
+  write(mFile, static_cast<uint32_t>(mNumOutputs));
+}
+
+/**
+ * @brief
+ *   Appends the transforms of every part of the spider, in the order of
+ *   `Spider::parts`, and the outputs of the network. The number of outputs
+ *   must be the same for every tick.
+ *
+ * @param spider
+ * @param time
+ * @param outputs
+ */
+void ReplayRecorder::record(Spider&                   spider,
+                            float                     time,
+                            const std::vector<float>& outputs) {
+  if (mFailed)
+    return;
+
+  if (mNumTicks == 0)
+    writeHeader(spider, outputs.size());
+
+  if (outputs.size() != mNumOutputs) {
+    mLog->warn("Expected {} outputs but got {}, stopping replay: {}",
+               mNumOutputs,
+               outputs.size(),
+               mFilename);
+    mFailed = true;
+    return;
+  }
+
+  btTransform origin;
+  bool        hasOrigin = false;
+
+  write(mFile, time);
+
+  for (auto& part : spider.parts()) {
+    btTransform t;
+    part.second.part->rigidBody()->getMotionState()->getWorldTransform(t);
+
+    if (!hasOrigin) {
+      origin    = t;
+      hasOrigin = true;
+
+      write(mFile, static_cast<float>(origin.getOrigin().x()));
+      write(mFile, static_cast<float>(origin.getOrigin().y()));
+      write(mFile, static_cast<float>(origin.getOrigin().z()));
+    }
+
+    btVector3    offset   = t.getOrigin() - origin.getOrigin();
+    btQuaternion rotation = t.getRotation().normalized();
+
+    write(mFile, quantize(offset.x(), POSITION_STEP));
+    write(mFile, quantize(offset.y(), POSITION_STEP));
+    write(mFile, quantize(offset.z(), POSITION_STEP));
+    write(mFile, quantize(rotation.x(), ROTATION_STEP));
+    write(mFile, quantize(rotation.y(), ROTATION_STEP));
+    write(mFile, quantize(rotation.z(), ROTATION_STEP));
+    write(mFile, quantize(rotation.w(), ROTATION_STEP));
+  }
+
+  for (auto& o : outputs)
+    write(mFile, o);
+
+  if (!mFile) {
+    mLog->warn("Unable to write replay: {}", mFilename);
+    mFailed = true;
+    return;
+  }
+
+  mNumTicks += 1;
+}
+
+size_t ReplayRecorder::numTicks() const {
+  return mNumTicks;
+}
+
+const std::string& ReplayRecorder::filename() const {
+  return mFilename;
+}
+
+std::string ReplayRecorder::name(unsigned int generation,
+                                 unsigned int speciesId,
+                                 unsigned int genomeId) {
+  return "g" + std::to_string(generation) + "-s" + std::to_string(speciesId) +
+         "-" + std::to_string(genomeId) + ".replay";
+}
+
+/**
+ * @brief
+ *   Reads every tick of the replay. The last tick is dropped if the file
+ *   ends in the middle of it, which happens if the recording was stopped
+ *   while it was being written.
+ *
+ * @param filename
+ */
+Replay::Replay(const std::string& filename)
+    : Logging::Log("Replay"), mDeltaTime(0), mGenomeId(0), mSpeciesId(0) {
+  std::ifstream file(filename, std::ios::in | std::ios::binary);
+
+  if (!file.is_open())
+    throw std::runtime_error("Unable to open replay: " + filename);
+
+  char     magic[4];
+  uint32_t version, genomeId, speciesId, numParts, numOutputs;
+
+  file.read(magic, 4);
+  read(file, version);
+  read(file, genomeId);
+  read(file, speciesId);
+  read(file, mDeltaTime);
+  read(file, numParts);
+
+  if (!file || !std::equal(magic, magic + 4, MAGIC) || version != VERSION)
+    throw std::runtime_error("Not a replay file: " + filename);
+
+  mGenomeId  = genomeId;
+  mSpeciesId = speciesId;
+
+  for (uint32_t i = 0; i < numParts && file; ++i) {
+    uint32_t length;
+    read(file, length);
+
+    std::string name(length, '\0');
+    file.read(&name[0], length);
+    mPartNames.push_back(name);
+  }
+
+  read(file, numOutputs);
+
+  if (!file)
+    throw std::runtime_error("Replay has no header: " + filename);
+
+  std::vector<int16_t> raw(numParts * 7);
+
+  while (true) {
+    Tick  tick;
+    float x, y, z;
+
+    tick.outputs.resize(numOutputs);
+
+    read(file, tick.time);
+    read(file, x);
+    read(file, y);
+    read(file, z);
+    file.read(reinterpret_cast<char*>(raw.data()),
+              raw.size() * sizeof(int16_t));
+
+    for (auto& o : tick.outputs)
+      read(file, o);
+
+    if (!file)
+      break;
+
+    btVector3 origin(x, y, z);
+
+    tick.positions.reserve(numParts);
+    tick.rotations.reserve(numParts);
+
+    for (uint32_t i = 0; i < numParts; ++i) {
+      const int16_t* v = &raw[i * 7];
+
+      tick.positions.push_back(
+        origin + btVector3(v[0], v[1], v[2]) * POSITION_STEP);
+      tick.rotations.push_back(
+        btQuaternion(v[3] * ROTATION_STEP,
+                     v[4] * ROTATION_STEP,
+                     v[5] * ROTATION_STEP,
+                     v[6] * ROTATION_STEP)
+          .normalized());
+    }
+
+    mTicks.push_back(std::move(tick));
+  }
+
+  mLog->debug("Loaded {} ticks of {} parts from {}",
+              mTicks.size(),
+              mPartNames.size(),
+              filename);
+}
+
+/**
+ * @brief
+ *   Sets the transform of each part of the spider, interpolating between
+ *   the two ticks around the time. Times outside of the replay use the
+ *   first or last tick.
+ *
+ *   The parts are moved through their motion states, just like Bullet does
+ *   when it simulates them, so the spider is drawn the same way.
+ *
+ * @param spider
+ * @param time
+ */
+void Replay::apply(Spider& spider, float time) const {
+  if (mTicks.empty())
+    return;
+
+  auto& parts = spider.parts();
+
+  if (parts.size() != mPartNames.size())
+    throw std::runtime_error("Replay does not match the parts of the spider");
+
+  size_t      index  = tickAt(time);
+  const Tick& a      = mTicks[index];
+  const Tick& b      = mTicks[std::min(index + 1, mTicks.size() - 1)];
+  float       length = b.time - a.time;
+  float       t      = length > 0 ? (time - a.time) / length : 0;
+
+  t = std::max(0.f, std::min(1.f, t));
+
+  spider.enableUpdatingFromPhysics();
+
+  size_t i = 0;
+  for (auto& part : parts) {
+    if (part.first != mPartNames[i])
+      throw std::runtime_error("Replay does not have the part " + part.first);
+
+    btTransform transform(a.rotations[i].slerp(b.rotations[i], t),
+                          a.positions[i].lerp(b.positions[i], t));
+
+    btRigidBody* body = part.second.part->rigidBody();
+    body->setWorldTransform(transform);
+    body->getMotionState()->setWorldTransform(transform);
+    part.second.part->updateFromPhysics();
+
+    i += 1;
+  }
+}
+
+const std::vector<float>& Replay::outputs(float time) const {
+  static const std::vector<float> empty;
+
+  if (mTicks.empty())
+    return empty;
+
+  return mTicks[tickAt(time)].outputs;
+}
+
+float Replay::duration() const {
+  return mTicks.empty() ? 0 : mTicks.back().time;
+}
+
+size_t Replay::tickAt(float time) const {
+  auto it = std::upper_bound(
+    mTicks.begin(), mTicks.end(), time, [](float t, const Tick& tick) {
+      return t < tick.time;
+    });
+
+  if (it == mTicks.begin())
+    return 0;
+
+  return (it - mTicks.begin()) - 1;
+}
+
+size_t Replay::numTicks() const {
+  return mTicks.size();
+}
+
+float Replay::deltaTime() const {
+  return mDeltaTime;
+}
+
+unsigned int Replay::genomeId() const {
+  return mGenomeId;
+}
+
+unsigned int Replay::speciesId() const {
+  return mSpeciesId;
+}
+
+const std::vector<std::string>& Replay::partNames() const {
+  return mPartNames;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <btBulletDynamicsCommon.h>
+
+#include "../Log.hpp"
+
+class Spider;
+
+//! This describes which individuals are recorded to replay files
+//!
+//! - None          : Record nothing
+//! - SpeciesLeaders: Record the best genome of each species whenever it
+//!                   has been selected
+//! - BestFitness   : Record the best genome ever whenever it changes
+//! - All           : Record every individual
+//!
+enum class RecordingMethod { None, SpeciesLeaders, BestFitness, All };
+
+/**
+ * @brief
+ *   Writes the movement of a spider to a file while it is being evaluated,
+ *   so that it can be looked at afterwards with Replay, without running
+ *   Bullet or the network again.
+ *
+ *   Each tick stores the transform of every part together with the outputs
+ *   of the network. Positions are stored as 16 bit offsets from the first
+ *   part, with a precision of 1/1024 of a unit, and rotations as 16 bit
+ *   quaternions, which is about a fifth of the size of the full transforms.
+ *
+ *   Ticks are appended as they are recorded, so a file that is cut short
+ *   is still readable up to the last complete tick.
+ */
+class ReplayRecorder : public Logging::Log {
+public:
+  ReplayRecorder(const std::string& filename,
+                 unsigned int       genomeId,
+                 unsigned int       speciesId,
+                 float              deltaTime);
+
+  // Appends the transforms of the parts and the outputs of a tick
+  void record(Spider& spider, float time, const std::vector<float>& outputs);
+
+  // Returns the number of ticks that have been recorded
+  size_t numTicks() const;
+
+  // Returns the name of the file
+  const std::string& filename() const;
+
+  // Returns the name of the replay of a genome, like `g12-s3-4051.replay`
+  static std::string name(unsigned int generation,
+                          unsigned int speciesId,
+                          unsigned int genomeId);
+
+private:
+  void writeHeader(Spider& spider, size_t numOutputs);
+
+  std::ofstream mFile;
+  std::string   mFilename;
+  unsigned int  mGenomeId;
+  unsigned int  mSpeciesId;
+  float         mDeltaTime;
+  size_t        mNumParts;
+  size_t        mNumOutputs;
+  size_t        mNumTicks;
+  bool          mFailed;
+};
+
+/**
+ * @brief
+ *   A recording made by ReplayRecorder. The whole file is read when it is
+ *   loaded, and any point in time can then be applied to a spider, which
+ *   moves its parts without simulating it.
+ *
+ *   Time between two ticks is interpolated, so the replay looks smooth even
+ *   when it is played slower than it was recorded.
+ */
+class Replay : public Logging::Log {
+public:
+  Replay(const std::string& filename);
+
+  // Moves the parts of the spider to where they were at the time
+  void apply(Spider& spider, float time) const;
+
+  // Returns the outputs of the network at the tick closest to the time
+  const std::vector<float>& outputs(float time) const;
+
+  // Returns the time of the last tick
+  float duration() const;
+
+  size_t       numTicks() const;
+  float        deltaTime() const;
+  unsigned int genomeId() const;
+  unsigned int speciesId() const;
+
+  const std::vector<std::string>& partNames() const;
+
+private:
+  struct Tick {
+    float                     time;
+    std::vector<btVector3>    positions;
+    std::vector<btQuaternion> rotations;
+    std::vector<float>        outputs;
+  };
+
+  // Returns the index of the tick at or right before the time
+  size_t tickAt(float time) const;
+
+  std::vector<std::string> mPartNames;
+  std::vector<Tick>        mTicks;
+  float                    mDeltaTime;
+  unsigned int             mGenomeId;
+  unsigned int             mSpeciesId;
+};
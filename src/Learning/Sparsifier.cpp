@@ -0,0 +1,318 @@
+#include "Sparsifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+#include <NeuralNetwork.h>
+
+bool SparsifyOptions::enabled() const {
+  return minContribution > 0 || mergeDuplicates ||
+         quantization != Quantization::None;
+}
+
+/**
+ * @brief
+ *   Stores the weights in the given format. For int8, the scale is chosen
+ *   so that the weight with the largest magnitude becomes +-127.
+ *
+ * @param weights
+ * @param type
+ *
+ * @return
+ */
+QuantizedWeights QuantizedWeights::encode(const std::vector<double>& weights,
+                                          Quantization               type) {
+  QuantizedWeights q;
+  q.type = type;
+
+  switch (type) {
+    case Quantization::None:
+      q.full = weights;
+      break;
+
+    case Quantization::Float16:
+      for (auto w : weights)
+        q.half.push_back(Sparsifier::toHalf(w));
+      break;
+
+    case Quantization::Int8: {
+      double max = 0;
+
+      for (auto w : weights)
+        max = std::max(max, std::abs(w));
+
+      q.scale = max > 0 ? max / 127.0 : 1.0;
+
+      for (auto w : weights)
+        q.int8.push_back(static_cast<int8_t>(std::round(w / q.scale)));
+      break;
+    }
+  }
+
+  return q;
+}
+
+std::vector<double> QuantizedWeights::decode() const {
+  std::vector<double> weights;
+
+  switch (type) {
+    case Quantization::None:
+      weights = full;
+      break;
+
+    case Quantization::Float16:
+      for (auto w : half)
+        weights.push_back(Sparsifier::fromHalf(w));
+      break;
+
+    case Quantization::Int8:
+      for (auto w : int8)
+        weights.push_back(w * scale);
+      break;
+  }
+
+  return weights;
+}
+
+size_t QuantizedWeights::bytes() const {
+  switch (type) {
+    case Quantization::Float16:
+      return half.size() * sizeof(uint16_t);
+    case Quantization::Int8:
+      return int8.size() * sizeof(int8_t) + sizeof(scale);
+    default:
+      return full.size() * sizeof(double);
+  }
+}
+
+/**
+ * @brief
+ *   Returns the largest magnitude that the activation of the neuron can
+ *   have. Inputs are assumed to be within [-1, 1], while activation
+ *   functions without a bound return infinity so that connections from
+ *   them are never pruned.
+ *
+ * @param network
+ * @param index
+ *
+ * @return
+ */
+static double activationBound(const NEAT::NeuralNetwork& network,
+                              size_t                     index) {
+  if (index < network.m_num_inputs)
+    return 1.0;
+
+  switch (network.m_neurons[index].m_activation_function_type) {
+    case NEAT::SIGNED_SIGMOID:
+    case NEAT::UNSIGNED_SIGMOID:
+    case NEAT::TANH:
+    case NEAT::TANH_CUBIC:
+    case NEAT::SIGNED_STEP:
+    case NEAT::UNSIGNED_STEP:
+    case NEAT::SIGNED_SINE:
+    case NEAT::UNSIGNED_SINE:
+      return 1.0;
+    default:
+      return std::numeric_limits<double>::infinity();
+  }
+}
+
+/**
+ * @brief
+ *   Runs the enabled steps in order:
+ *
+ *   1. Connections with the same source and target are merged into one,
+ *      summing their weights
+ *   2. Connections whose weight times the largest possible activation of
+ *      their source is below `minContribution` are removed
+ *   3. The weights are rounded to the chosen format. Connections that end
+ *      up with a weight of exactly 0 are removed as well
+ *
+ *   The neurons are left untouched so that their indices stay the same.
+ *
+ * @param network
+ * @param options
+ *
+ * @return
+ */
+SparsifyReport Sparsifier::sparsify(NEAT::NeuralNetwork&   network,
+                                    const SparsifyOptions& options) {
+  auto&          connections = network.m_connections;
+  SparsifyReport report;
+
+  report.connectionsBefore = connections.size();
+  report.bytesBefore       = connections.size() * sizeof(double);
+
+  if (options.mergeDuplicates) {
+    std::map<std::pair<unsigned int, unsigned int>, size_t> seen;
+    std::vector<NEAT::Connection>                           merged;
+
+    for (auto& c : connections) {
+      auto key = std::make_pair(c.m_source_neuron_idx, c.m_target_neuron_idx);
+      auto it  = seen.find(key);
+
+      if (it != seen.end()) {
+        merged[it->second].m_weight += c.m_weight;
+        report.merged += 1;
+        continue;
+      }
+
+      seen[key] = merged.size();
+      merged.push_back(c);
+    }
+
+    connections.swap(merged);
+  }
+
+  if (options.minContribution > 0) {
+    size_t size = connections.size();
+
+    connections.erase(
+      std::remove_if(connections.begin(),
+                     connections.end(),
+                     [&](const NEAT::Connection& c) {
+                       double bound =
+                         activationBound(network, c.m_source_neuron_idx);
+                       return std::abs(c.m_weight) * bound <
+                              options.minContribution;
+                     }),
+      connections.end());
+
+    report.pruned += size - connections.size();
+  }
+
+  std::vector<double> weights;
+
+  for (auto& c : connections)
+    weights.push_back(c.m_weight);
+
+  auto quantized = QuantizedWeights::encode(weights, options.quantization);
+  auto decoded   = quantized.decode();
+
+  for (size_t i = 0; i < connections.size(); ++i) {
+    report.maxWeightError = std::max(report.maxWeightError,
+                                     std::abs(decoded[i] - weights[i]));
+    connections[i].m_weight = decoded[i];
+  }
+
+  if (options.quantization != Quantization::None) {
+    size_t size = connections.size();
+
+    connections.erase(std::remove_if(connections.begin(),
+                                     connections.end(),
+                                     [](const NEAT::Connection& c) {
+                                       return c.m_weight == 0.0;
+                                     }),
+                      connections.end());
+
+    report.pruned += size - connections.size();
+    weights.clear();
+
+    for (auto& c : connections)
+      weights.push_back(c.m_weight);
+
+    quantized = QuantizedWeights::encode(weights, options.quantization);
+  }
+
+  report.connectionsAfter = connections.size();
+  report.bytesAfter       = quantized.bytes();
+
+  return report;
+}
+
+/**
+ * @brief
+ *   Converts the float to half precision, rounding to the nearest value
+ *   and towards even on ties. Values that are too large become infinity.
+ *
+ * @param value
+ *
+ * @return
+ */
+uint16_t Sparsifier::toHalf(float value) {
+  uint32_t f;
+  std::memcpy(&f, &value, sizeof(f));
+
+  uint32_t sign     = (f >> 16) & 0x8000;
+  uint32_t bits     = (f >> 23) & 0xff;
+  int32_t  exponent = static_cast<int32_t>(bits) - 127 + 15;
+  uint32_t mantissa = f & 0x7fffff;
+
+  // Infinity and NaN
+  if (bits == 0xff)
+    return sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0);
+
+  if (exponent >= 31)
+    return sign | 0x7c00;
+
+  // Too small to be a normal half, so it becomes subnormal or zero
+  if (exponent <= 0) {
+    if (exponent < -10)
+      return sign;
+
+    mantissa |= 0x800000;
+
+    uint32_t shift  = 14 - exponent;
+    uint32_t half   = mantissa >> shift;
+    uint32_t rest   = mantissa & ((1u << shift) - 1);
+    uint32_t middle = 1u << (shift - 1);
+
+    if (rest > middle || (rest == middle && (half & 1)))
+      half += 1;
+
+    return sign | half;
+  }
+
+  uint32_t half = (exponent << 10) | (mantissa >> 13);
+  uint32_t rest = mantissa & 0x1fff;
+
+  // Rounding may carry into the exponent, which is still correct
+  if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+    half += 1;
+
+  return sign | half;
+}
+
+float Sparsifier::fromHalf(uint16_t value) {
+  uint32_t sign     = (value & 0x8000) << 16;
+  uint32_t exponent = (value >> 10) & 0x1f;
+  uint32_t mantissa = value & 0x3ff;
+  uint32_t f;
+
+  if (exponent == 0 && mantissa == 0) {
+    f = sign;
+  } else if (exponent == 0) {
+    // Subnormal, normalize it for the float
+    exponent = 127 - 15 + 1;
+
+    while ((mantissa & 0x400) == 0) {
+      mantissa <<= 1;
+      exponent -= 1;
+    }
+
+    f = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+  } else if (exponent == 31) {
+    f = sign | 0x7f800000 | (mantissa << 13);
+  } else {
+    f = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+  }
+
+  float result;
+  std::memcpy(&result, &f, sizeof(result));
+  return result;
+}
+
+Quantization Sparsifier::quantizationFromString(const std::string& name) {
+  if (name == "none")
+    return Quantization::None;
+  if (name == "float16")
+    return Quantization::Float16;
+  if (name == "int8")
+    return Quantization::Int8;
+
+  throw std::runtime_error("Unknown quantization: " + name);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace NEAT {
+  class NeuralNetwork;
+}
+
+//! How the weights of a sparsified network are stored
+enum class Quantization { None, Float16, Int8 };
+
+/**
+ * @brief
+ *   The settings of the sparsification stage that can be run on a network
+ *   after it has been built. Everything is disabled by default.
+ */
+struct SparsifyOptions {
+  // Connections that cannot contribute more than this to the sum of their
+  // target are removed. See Sparsifier::sparsify for how it is measured
+  double minContribution = 0.0;
+
+  // Whether or not to merge connections with the same source and target
+  bool mergeDuplicates = false;
+
+  // Whether or not to round the weights to float16 or int8 with a scale
+  Quantization quantization = Quantization::None;
+
+  // Returns true if any part of the stage is enabled
+  bool enabled() const;
+};
+
+/**
+ * @brief
+ *   What the sparsification did to a network
+ */
+struct SparsifyReport {
+  size_t connectionsBefore = 0;
+  size_t connectionsAfter  = 0;
+  size_t pruned            = 0;
+  size_t merged            = 0;
+  size_t bytesBefore       = 0;
+  size_t bytesAfter        = 0;
+  double maxWeightError    = 0.0;
+};
+
+/**
+ * @brief
+ *   A list of weights stored as either float16 or int8. Int8 weights are
+ *   multiplied by a single scale that is shared by the whole list, chosen
+ *   so that the largest weight becomes 127.
+ */
+struct QuantizedWeights {
+  Quantization          type  = Quantization::None;
+  double                scale = 1.0;
+  std::vector<double>   full;
+  std::vector<uint16_t> half;
+  std::vector<int8_t>   int8;
+
+  // Stores the weights in the given format
+  static QuantizedWeights encode(const std::vector<double>& weights,
+                                 Quantization               type);
+
+  // Returns the weights converted back to doubles
+  std::vector<double> decode() const;
+
+  // Returns the number of bytes used by the weights
+  size_t bytes() const;
+};
+
+namespace Sparsifier {
+  // Prunes, merges and quantizes the connections of the network in place
+  SparsifyReport sparsify(NEAT::NeuralNetwork&   network,
+                          const SparsifyOptions& options);
+
+  // Converts between float and IEEE 754 half precision
+  uint16_t toHalf(float value);
+  float fromHalf(uint16_t value);
+
+  // Converts "none", "float16" or "int8" to a Quantization, throwing if
+  // it is none of them
+  Quantization quantizationFromString(const std::string& name);
+}
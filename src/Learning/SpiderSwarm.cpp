@@ -1,20 +1,33 @@
 #include "SpiderSwarm.hpp"
 
 #include "../3D/Spider.hpp"
+#include "../3D/SpiderRenderer.hpp"
 #include "../3D/World.hpp"
+#include "../Utils/ThreadPool.hpp"
 #include "DrawablePhenotype.hpp"
+#include "ESHyperNEAT.hpp"
+#include "EvaluationMaster.hpp"
+#include "IslandModel.hpp"
+#include "Replay.hpp"
+#include "Sparsifier.hpp"
 #include "Substrate.hpp"
 
-#include "../Experiments/Standing0102.hpp"
-#include "../Experiments/Standing0304.hpp"
-#include "../Experiments/Walking0102.hpp"
-#include "../Experiments/Walking03.hpp"
-#include "../Experiments/Walking04.hpp"
-#include "../Experiments/Walking05.hpp"
-#include "../Experiments/Walking07.hpp"
-#include "../Experiments/Walking08.hpp"
+#include "../Experiments/Experiment.hpp"
+#include "../Experiments/ExperimentUtil.hpp"
+#include "../GUI/TextRenderer.hpp"
+#include "../Runtime/ControllerFile.hpp"
+#include "../Utils/Asset.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <ctime>
 #include <btBulletDynamicsCommon.h>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
 #include <thread>
 
 #include <Genome.h>
@@ -49,13 +62,36 @@ SpiderSwarm::SpiderSwarm()
     , mBestPossibleFitness(-99999)
     , mBestPossibleFitnessGeneration(-99999)
     , mDrawDebugNetworks(false)
+    , mDrawLabels(false)
     , mRestartOnNextUpdate(false)
+    , mHasSubmitted(false)
+    , mSteadyState(false)
     , mSimulatingStage(SimulationStage::None)
     , mDrawingMethod(SpiderSwarm::DrawingMethod::Species1)
+    , mDisableDrawing(false)
     , mBestIndex(0)
+    , mRecordingMethod(RecordingMethod::None)
+    , mReplay(nullptr)
+    , mReplaySpider(nullptr)
+    , mReplayTime(0)
+    , mReplaySpeed(1)
+    , mStageBeforeReplay(SimulationStage::None)
+    , mNumEvaluations(0)
+    , mTimerEvaluations(0)
+    , mEvaluationsPerSecond(0)
+    , mChangedBest(false)
+    , mEvaluationTimer(std::chrono::steady_clock::now())
+    , mLocksWanted(0)
+    , mStopThread(false)
+    , mThreadStopped(false)
+    , mSnapshotWanted(true)
     , mSubstrate(nullptr)
     , mPopulation(nullptr)
-    , mCurrentExperiment(nullptr) {
+    , mCurrentExperiment(nullptr)
+    , mMaster(nullptr)
+    , mIslands(nullptr)
+    , mSeed(static_cast<int>(time(0)))
+    , mRenderer(new SpiderRenderer()) {
 
 // Save some memory if bullet has profiling on and therefore
 // does not allow for threading
@@ -67,20 +103,24 @@ SpiderSwarm::SpiderSwarm()
       it->update(experiment);
   };
 
-  mBuildingWorker = [](std::vector<Phenotype>::iterator begin,
-                       std::vector<Phenotype>::iterator end,
-                       const Experiment&                exp,
-                       NEAT::Population&                pop,
-                       Substrate&                       sub) {
+  mBuildingWorker = [](std::vector<Phenotype*>::iterator begin,
+                       std::vector<Phenotype*>::iterator end,
+                       const Experiment&                 exp,
+                       NEAT::Population&                 pop,
+                       Substrate&                        sub) {
     for (auto it = begin; it != end; ++it) {
+      Phenotype* p = *it;
+
       if (exp.parameters().useESHyperNEAT) {
-        pop.m_Species[it->speciesIndex]
-          .m_Individuals[it->individualIndex]
-          .BuildESHyperNEATPhenotype(*it->network, sub, pop.m_Parameters);
+        ESHyperNEAT::build(pop.m_Species[p->speciesIndex]
+                             .m_Individuals[p->individualIndex],
+                           *p->network,
+                           sub,
+                           pop.m_Parameters);
       } else {
-        pop.m_Species[it->speciesIndex]
-          .m_Individuals[it->individualIndex]
-          .BuildHyperNEATPhenotype(*it->network, sub);
+        pop.m_Species[p->speciesIndex]
+          .m_Individuals[p->individualIndex]
+          .BuildHyperNEATPhenotype(*p->network, sub);
       }
     }
   };
@@ -96,10 +136,22 @@ SpiderSwarm::SpiderSwarm()
  *   some information, it has to be done before you delete things
  */
 SpiderSwarm::~SpiderSwarm() {
+  mStopThread = true;
+
+  if (mSimulationThread.joinable())
+    mSimulationThread.join();
+
+  waitForBuilds();
+
   for (auto& p : mPhenotypes)
     p.remove();
 
   delete mCurrentExperiment;
+  delete mMaster;
+  delete mIslands;
+  delete mRenderer;
+  delete mReplay;
+  delete mReplaySpider;
   mPhenotypes.clear();
 }
 
@@ -130,30 +182,20 @@ void SpiderSwarm::enableDrawing() {
  */
 void SpiderSwarm::setup(const std::string& name, bool startExperiment) {
   stop();
+  waitForBuilds();
 
   if (mCurrentExperiment != nullptr) {
     delete mCurrentExperiment;
     mCurrentExperiment = nullptr;
   }
 
-  if (name == "Walking0102")
-    mCurrentExperiment = new Walking0102();
-  else if (name == "Walking04")
-    mCurrentExperiment = new Walking04();
-  else if (name == "Standing0102")
-    mCurrentExperiment = new Standing0102();
-  else if (name == "Standing0304")
-    mCurrentExperiment = new Standing0304();
-  else if (name == "Walking05")
-    mCurrentExperiment = new Walking05();
-  else if (name == "Walking03")
-    mCurrentExperiment = new Walking03();
-  else if (name == "Walking08")
-    mCurrentExperiment = new Walking08();
-  else if (name == "Walking07")
-    mCurrentExperiment = new Walking07();
-  else
-    throw std::runtime_error("Unable to find experiment: " + name);
+  if (mIslands != nullptr) {
+    delete mIslands;
+    mIslands = nullptr;
+  }
+
+  mCurrentExperiment = Experiment::create(name);
+  mNetworkCache.clear();
 
   mPopulation = mCurrentExperiment->population();
   mSubstrate  = mCurrentExperiment->substrate();
@@ -170,6 +212,59 @@ void SpiderSwarm::setup(const std::string& name, bool startExperiment) {
     start();
 }
 
+/**
+ * @brief
+ *   Setups an experiment using the island model. Each island gets its own
+ *   instance of the experiment and evolves independently, sending its
+ *   `numMigrants` best genomes to the next island every
+ *   `migrationInterval` generations.
+ *
+ *   The experiment is also setup normally so that genomes can still be
+ *   loaded and run.
+ *
+ *   The islands are evaluated locally using generations, so steady state
+ *   and distributed evaluation cannot be used together with them.
+ *
+ * @param name
+ * @param numIslands
+ * @param migrationInterval
+ * @param numMigrants
+ * @param startExperiment
+ */
+void SpiderSwarm::setupIslands(const std::string& name,
+                               unsigned int       numIslands,
+                               unsigned int       migrationInterval,
+                               unsigned int       numMigrants,
+                               bool               startExperiment) {
+  if (mSteadyState || isDistributed()) {
+    mLog->error("Islands cannot be used with steady state or distributed "
+                "evaluation, disable them first");
+    return;
+  }
+
+  setup(name);
+
+  // Free the phenotypes of the single population since they are unused
+  waitForBuilds();
+
+  for (auto& p : mPhenotypes)
+    p.remove();
+
+  mPhenotypes.clear();
+  mSpeciesLeaders.clear();
+
+  mIslands = new IslandModel(
+    name, numIslands, migrationInterval, numMigrants, mSeed);
+  mIslands->setRecording(mRecordingMethod, mRecordingDirectory);
+
+  if (startExperiment)
+    start();
+}
+
+void SpiderSwarm::setSeed(int seed) {
+  mSeed = seed;
+}
+
 /**
  * @brief
  *   Starts a simulation that has been setup
@@ -192,6 +287,11 @@ void SpiderSwarm::start() {
  *   Stops the current active experiment, if any
  */
 void SpiderSwarm::stop() {
+  if (mSimulatingStage == SimulationStage::Replaying) {
+    mSimulatingStage = mStageBeforeReplay;
+    return;
+  }
+
   if (mCurrentExperiment == nullptr || mPopulation == nullptr ||
       mSubstrate == nullptr) {
     mLog->warn("Cannot stop experiment without setting up experiment");
@@ -285,9 +385,11 @@ void SpiderSwarm::runGenome(unsigned int genomeId) {
   mCurrentExperiment->initPhenotype(mPhenotypes[0]);
 
   if (mCurrentExperiment->parameters().useESHyperNEAT) {
-    g->BuildESHyperNEATPhenotype(*mPhenotypes[0].network,
-                                 *mSubstrate,
-                                 mPopulation->m_Parameters);
+    ESHyperNEAT::build(*g,
+                       *mPhenotypes[0].network,
+                       *mSubstrate,
+                       mPopulation->m_Parameters,
+                       &ThreadPool::global());
   } else {
     g->BuildHyperNEATPhenotype(*mPhenotypes[0].network, *mSubstrate);
   }
@@ -317,25 +419,211 @@ SpiderSwarm::DrawingMethod SpiderSwarm::drawingMethod() {
   return mDrawingMethod;
 }
 
+/**
+ * @brief
+ *   Toggles the labels above the spiders, which show the species and
+ *   individual of each of them. Like the networks, they can only be drawn
+ *   while simulating on the main thread.
+ */
+void SpiderSwarm::toggleDrawLabels() {
+  if (mSimulationThread.joinable()) {
+    mLog->warn("Labels cannot be drawn while simulating on a thread");
+    return;
+  }
+
+  mDrawLabels = !mDrawLabels;
+}
+
 /**
  * @brief
  *   Toggles the drawing of the neural networks
  */
 void SpiderSwarm::toggleDrawANN() {
+  if (mSimulationThread.joinable()) {
+    mLog->warn("Networks cannot be drawn while simulating on a thread");
+    return;
+  }
+
   mDrawDebugNetworks = !mDrawDebugNetworks;
 
   if (mDrawDebugNetworks && mSimulatingStage == SimulationStage::Experiment) {
     for (auto& i : mPhenotypes) {
-      i.drawablePhenotype->recreate(*i.network, mmm::vec3(1.0, 1.0, 1.0));
+      i.recreateDrawable();
     }
   } else if (mDrawDebugNetworks &&
              (mSimulatingStage == SimulationStage::Simulating ||
               mSimulatingStage == SimulationStage::SimulationReady)) {
-    mPhenotypes[0].drawablePhenotype->recreate(*mPhenotypes[0].network,
-                                               mmm::vec3(1));
+    mPhenotypes[0].recreateDrawable();
+  }
+}
+
+/**
+ * @brief
+ *   Sets which individuals are recorded to replay files. Each recording is
+ *   named after the generation, species and genome, like
+ *   `g12-s3-4051.replay`, and the directory must exist.
+ *
+ *   Species leaders and the best genome are recorded when they have been
+ *   selected, by simulating them again in this process, no matter whether
+ *   they were evaluated here, by workers or on an island. Individuals
+ *   evaluated here are recorded while they are evaluated when everything
+ *   is recorded, while those evaluated by workers are simulated again.
+ *
+ * @param method
+ * @param directory
+ */
+void SpiderSwarm::setRecording(RecordingMethod    method,
+                               const std::string& directory) {
+  mRecordingMethod    = method;
+  mRecordingDirectory = directory;
+
+  if (mIslands != nullptr)
+    mIslands->setRecording(method, directory);
+}
+
+/**
+ * @brief
+ *   Loads the replay file and plays it in a loop instead of the current
+ *   experiment, which is paused until `stop` is called and then continues
+ *   where it was. The spider is moved by the replay alone, so nothing is
+ *   simulated.
+ *
+ * @param filename
+ */
+void SpiderSwarm::playReplay(const std::string& filename) {
+  Replay* replay = new Replay(filename);
+
+  delete mReplay;
+  mReplay = replay;
+
+  if (mReplaySpider == nullptr)
+    mReplaySpider = new Spider();
+
+  if (mSimulatingStage != SimulationStage::Replaying)
+    mStageBeforeReplay = mSimulatingStage;
+
+  mReplayTime      = 0;
+  mSimulatingStage = SimulationStage::Replaying;
+
+  mLog->info("Playing replay of genome {} in species {}, {} seconds",
+             mReplay->genomeId(),
+             mReplay->speciesId(),
+             mReplay->duration());
+}
+
+void SpiderSwarm::setReplaySpeed(float speed) {
+  mReplaySpeed = speed;
+}
+
+/**
+ * @brief
+ *   Moves the replay forward by the time that has passed, scaled by the
+ *   speed. A negative speed plays it backwards. The replay starts over
+ *   when it reaches either end.
+ *
+ * @param deltaTime
+ */
+void SpiderSwarm::updateReplay(float deltaTime) {
+  float duration = mReplay->duration();
+
+  mReplayTime += deltaTime * mReplaySpeed;
+
+  if (duration > 0) {
+    mReplayTime = std::fmod(mReplayTime, duration);
+
+    if (mReplayTime < 0)
+      mReplayTime += duration;
+  }
+
+  mReplay->apply(*mReplaySpider, mReplayTime);
+}
+
+/**
+ * @brief
+ *   Starts recording the Phenotype, which has just been reset, if every
+ *   individual is recorded and it is evaluated by this process. Anything
+ *   else is recorded once it has been selected.
+ *
+ * @param p
+ */
+void SpiderSwarm::startRecording(Phenotype& p) {
+  if (mRecordingMethod != RecordingMethod::All || isDistributed())
+    return;
+
+  p.startRecording(mRecordingDirectory + "/" +
+                     ReplayRecorder::name(mGeneration, p.speciesId, p.genomeId),
+                   *mCurrentExperiment);
+}
+
+/**
+ * @brief
+ *   Records the genomes of the generation that was just evaluated which the
+ *   recording method selects. This is where the fitness of every path
+ *   except steady state is assigned, so the leaders of the species and the
+ *   best genome are recorded here no matter where they were evaluated.
+ *
+ *   The Phenotypes were reset, and recorded if everything is recorded,
+ *   before the generation was increased, so that is the generation used.
+ *
+ * @param bestIndex
+ *   The index of the best Phenotype of the generation
+ * @param changedBest
+ *   Whether it is the best genome ever
+ */
+void SpiderSwarm::recordGeneration(size_t bestIndex, bool changedBest) {
+  unsigned int generation = mGeneration - 1;
+
+  switch (mRecordingMethod) {
+    case RecordingMethod::None:
+      break;
+    case RecordingMethod::SpeciesLeaders:
+      for (auto i : mSpeciesLeaders)
+        recordGenome(mPhenotypes[i].genomeId, generation);
+      break;
+    case RecordingMethod::BestFitness:
+      if (changedBest)
+        recordGenome(mPhenotypes[bestIndex].genomeId, generation);
+      break;
+    case RecordingMethod::All:
+      // Only workers do not record while evaluating
+      if (isDistributed())
+        for (auto& p : mPhenotypes)
+          recordGenome(p.genomeId, generation);
+      break;
   }
 }
 
+/**
+ * @brief
+ *   Builds the network of the genome and simulates it for the whole
+ *   experiment again, recording it to a replay file. The simulation is
+ *   the same as the one that gave the genome its fitness, so the replay
+ *   shows what was evaluated wherever that was.
+ *
+ * @param genomeId
+ * @param generation
+ */
+void SpiderSwarm::recordGenome(unsigned int genomeId, unsigned int generation) {
+  size_t        speciesIndex    = 0;
+  size_t        individualIndex = 0;
+  NEAT::Genome* genome = findGenome(genomeId, speciesIndex, individualIndex);
+
+  if (genome == nullptr)
+    return;
+
+  unsigned int        speciesId = mPopulation->m_Species[speciesIndex].ID();
+  NEAT::NeuralNetwork network;
+  buildNetwork(*genome, network);
+
+  Phenotype::evaluate(
+    *mCurrentExperiment,
+    network,
+    genomeId,
+    speciesId,
+    mRecordingDirectory + "/" +
+      ReplayRecorder::name(generation, speciesId, genomeId));
+}
+
 void SpiderSwarm::updateSimulation() {
   if (mSimulatingStage == SimulationStage::SimulationReady &&
       mPhenotypes[0].duration > 0.0)
@@ -359,15 +647,30 @@ void SpiderSwarm::updateSimulation() {
  *   recreating the Phenotypes and returning, waiting until next update
  *   to start again.
  */
-void SpiderSwarm::update(float deltaTime) {
+void SpiderSwarm::step(float deltaTime) {
   if (mSimulatingStage == SimulationStage::None)
     return;
 
+  if (mSimulatingStage == SimulationStage::Replaying)
+    return updateReplay(deltaTime);
+
   if (mSimulatingStage == SimulationStage::Simulating ||
       mSimulatingStage == SimulationStage::SimulationReady)
     return updateSimulation();
 
+  if (mIslands != nullptr) {
+    if (mRestartOnNextUpdate) {
+      mIslands->restart();
+      mRestartOnNextUpdate = false;
+      return;
+    }
+
+    return mIslands->update(1.f / 60.f);
+  }
+
   if (mRestartOnNextUpdate) {
+    waitForBuilds();
+
     for (auto& p : mPhenotypes)
       p.remove();
 
@@ -378,17 +681,28 @@ void SpiderSwarm::update(float deltaTime) {
     mCurrentDuration     = 0;
     mRestartOnNextUpdate = false;
     mSpeciesLeaders.clear();
-    mBestIndex = 0;
+    mBestIndex    = 0;
+    mHasSubmitted = false;
+    mSlotDurations.clear();
+
+    if (mMaster != nullptr)
+      mMaster->clear();
 
     recreatePhenotypes();
     return;
   }
 
+  if (isDistributed())
+    return updateDistributed();
+
   deltaTime = 1.f / 60.f;
 
   if (deltaTime > 0.5)
     return;
 
+  if (mSteadyState)
+    return updateSteadyState(deltaTime);
+
   bool isWipeout = true;
   for (auto& p : mPhenotypes)
     if (!p.hasBeenKilled()) {
@@ -424,6 +738,164 @@ void SpiderSwarm::update(float deltaTime) {
 #endif
 }
 
+/**
+ * @brief
+ *   Runs a step of the simulation and captures what should be drawn, unless
+ *   the simulation has its own thread, in which case it is only checked
+ *   whether the thread has stopped.
+ *
+ * @param deltaTime
+ */
+void SpiderSwarm::update(float deltaTime) {
+  if (mSimulationThread.joinable()) {
+    if (mThreadStopped)
+      mSimulationThread.join();
+
+    return;
+  }
+
+  step(deltaTime);
+  publishSnapshot();
+}
+
+/**
+ * @brief
+ *   Runs the simulation on a thread of its own, or stops it. While the
+ *   thread is running, experiments are simulated as fast as possible, and
+ *   everything else at the speed it would have been drawn at. Drawing uses
+ *   the latest snapshot of the spiders, so neither waits for the other.
+ *
+ *   Everything that calls the SpiderSwarm from another thread must hold
+ *   `lock` while doing so. The thread is stopped once the lock is released,
+ *   which is why the thread is not joined here.
+ *
+ *   Spiders are created on the thread, so the resources they use must have
+ *   been loaded. The networks cannot be drawn, since they are OpenGL
+ *   buffers that belong to the main thread.
+ *
+ * @param enable
+ */
+void SpiderSwarm::setSimulationThread(bool enable) {
+  if (!enable) {
+    mStopThread = true;
+    return;
+  }
+
+  if (mSimulationThread.joinable()) {
+    // The thread is still waiting for the lock, so it can be kept
+    if (!mThreadStopped) {
+      mStopThread = false;
+      return;
+    }
+
+    mSimulationThread.join();
+  }
+
+  if (mDrawDebugNetworks) {
+    mLog->warn("Networks are not drawn while simulating on a thread");
+    mDrawDebugNetworks = false;
+  }
+
+  if (mDrawLabels) {
+    mLog->warn("Labels are not drawn while simulating on a thread");
+    mDrawLabels = false;
+  }
+
+  mStopThread       = false;
+  mThreadStopped    = false;
+  mSimulationThread = std::thread(&SpiderSwarm::simulationLoop, this);
+}
+
+/**
+ * @brief
+ *   Locks the SpiderSwarm, waiting for the current step of the simulation
+ *   to finish. The simulation thread gives up its turn as long as a lock is
+ *   wanted, so this never waits for more than a single step.
+ *
+ * @return
+ */
+std::unique_lock<std::mutex> SpiderSwarm::lock() {
+  ++mLocksWanted;
+  std::unique_lock<std::mutex> lock(mMutex);
+  --mLocksWanted;
+
+  return lock;
+}
+
+/**
+ * @brief
+ *   The loop of the simulation thread, running steps until it is stopped.
+ */
+void SpiderSwarm::simulationLoop() {
+  using Clock = std::chrono::steady_clock;
+
+  const float deltaTime = 1.f / 60.f;
+  const auto  interval  = std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<float>(deltaTime));
+  auto next = Clock::now();
+
+  while (true) {
+    while (mLocksWanted > 0)
+      std::this_thread::yield();
+
+    bool isRealTime;
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+
+      if (mStopThread) {
+        mThreadStopped = true;
+        return;
+      }
+
+      step(deltaTime);
+      publishSnapshot();
+
+      isRealTime = mSimulatingStage != SimulationStage::Experiment;
+    }
+
+    if (isRealTime) {
+      next += interval;
+      std::this_thread::sleep_until(next);
+    } else {
+      next = Clock::now();
+    }
+  }
+}
+
+/**
+ * @brief
+ *   Captures the spiders that should be drawn into the back buffer of the
+ *   snapshots and publishes it. Nothing is captured until the last
+ *   snapshot has been drawn, so a simulation that runs faster than it is
+ *   drawn does not spend its time capturing snapshots no one will see.
+ */
+void SpiderSwarm::publishSnapshot() {
+  if (!mSnapshotWanted.exchange(false))
+    return;
+
+  std::vector<SpiderRenderer::Instance>& instances = mSnapshots.back();
+  instances.clear();
+
+  if (mSimulatingStage != SimulationStage::None && !mDisableDrawing)
+    captureSpiders(instances);
+
+  mSnapshots.publish();
+}
+
+/**
+ * @brief
+ *   Gives the latest snapshot of the spiders to the renderer. This is
+ *   called once a frame, before the spiders are drawn by each pass.
+ */
+void SpiderSwarm::prepareDraw() {
+  const std::vector<SpiderRenderer::Instance>& instances = mSnapshots.read();
+
+  mRenderer->clear();
+  mRenderer->add(instances);
+  mSnapshotWanted = true;
+}
+
 /**
  * @brief
  *   Draws the spiders depending on the DrawingMethod used. See the
@@ -437,20 +909,76 @@ void SpiderSwarm::update(float deltaTime) {
  *   They all really have position 0,0,0, but are offset slightly to make it
  *   easier to identify each one of them.
  *
+ *   All the spiders are drawn at once by instancing their parts, so the
+ *   number of draw calls does not depend on the number of spiders. The
+ *   spiders are those given by the last `prepareDraw`.
+ *
  * @param prog
  * @param bindTexture
+ * @param frustum
  */
-void SpiderSwarm::draw(std::shared_ptr<Program>& prog, bool bindTexture) {
+void SpiderSwarm::draw(std::shared_ptr<Program>& prog,
+                       bool                      bindTexture,
+                       const Frustum&            frustum) {
   if (mSimulatingStage == SimulationStage::None || mDisableDrawing)
     return;
 
+  mRenderer->draw(prog, bindTexture, frustum);
+
+  // The networks are only drawn when simulating on the main thread, so
+  // they can be read while drawing
+  if (bindTexture && mDrawDebugNetworks && !mSimulationThread.joinable()) {
+    forEachDrawn([](Phenotype& p, const mmm::vec3& offset) {
+      if (p.drawablePhenotype != nullptr)
+        p.drawablePhenotype->draw3D(offset + mmm::vec3(0, 5, 0));
+    });
+  }
+
+  // The labels are batched, so all of them take a few draw calls
+  if (bindTexture && mDrawLabels && !mSimulationThread.joinable()) {
+    TextRenderer* textRenderer = Drawable::mAsset->textRenderer();
+
+    textRenderer->begin();
+    forEachDrawn([](Phenotype& p, const mmm::vec3& offset) {
+      p.drawLabel(offset);
+    });
+    textRenderer->end();
+  }
+}
+
+/**
+ * @brief
+ *   Captures the spiders that should be drawn, given the stage and the
+ *   drawing method.
+ *
+ * @param instances
+ */
+void SpiderSwarm::captureSpiders(
+  std::vector<SpiderRenderer::Instance>& instances) {
+  if (mSimulatingStage == SimulationStage::Replaying)
+    return SpiderRenderer::capture(*mReplaySpider, mmm::vec3(0), instances);
+
+  if (mIslands != nullptr && mSimulatingStage == SimulationStage::Experiment)
+    return mIslands->capture(instances, grid);
+
+  forEachDrawn([&instances](Phenotype& p, const mmm::vec3& offset) {
+    p.capture(instances, offset);
+  });
+}
+
+/**
+ * @brief
+ *   Calls the function with each Phenotype that should be drawn, given
+ *   the drawing method, and the offset it should be drawn at.
+ *
+ * @param function
+ */
+void SpiderSwarm::forEachDrawn(
+  const std::function<void(Phenotype&, const mmm::vec3&)>& function) {
   if (mSimulatingStage == SimulationStage::Simulating ||
       mSimulatingStage == SimulationStage::SimulationReady) {
-    mPhenotypes[0].draw(prog, mmm::vec3(0, 0, 0), bindTexture);
-
-    if (bindTexture && mDrawDebugNetworks) {
-      mPhenotypes[0].drawablePhenotype->draw3D(mmm::vec3(0, 5, 0));
-    }
+    if (!mPhenotypes.empty())
+      function(mPhenotypes[0], mmm::vec3(0, 0, 0));
 
     return;
   }
@@ -465,13 +993,8 @@ void SpiderSwarm::draw(std::shared_ptr<Program>& prog, bool bindTexture) {
 
     // Draw only the first spider of the current batch
     case DrawingMethod::DrawSingleInBatch: {
-      if (mBatchStart < mPhenotypes.size()) {
-        mPhenotypes[mBatchStart].draw(prog, grid[0], bindTexture);
-
-        if (bindTexture && mDrawDebugNetworks)
-          mPhenotypes[mBatchStart].drawablePhenotype->draw3D(
-            grid[gridIndex] + mmm::vec3(0, 5, 0));
-      }
+      if (mBatchStart < mPhenotypes.size())
+        function(mPhenotypes[mBatchStart], grid[0]);
       break;
     }
 
@@ -479,14 +1002,8 @@ void SpiderSwarm::draw(std::shared_ptr<Program>& prog, bool bindTexture) {
     case DrawingMethod::DrawAllInBatch: {
       for (unsigned int i = mBatchStart;
            i < mBatchEnd && i < mPhenotypes.size() && i < gridSize;
-           i++) {
-
-        mPhenotypes[i].draw(prog, grid[0], bindTexture);
-
-        if (bindTexture && mDrawDebugNetworks)
-          mPhenotypes[i].drawablePhenotype->draw3D(grid[gridIndex] +
-                                                   mmm::vec3(0, 5, 0));
-      }
+           i++)
+        function(mPhenotypes[i], grid[0]);
       break;
     }
 
@@ -494,10 +1011,7 @@ void SpiderSwarm::draw(std::shared_ptr<Program>& prog, bool bindTexture) {
     case DrawingMethod::Species1: {
       for (auto& a : mPhenotypes) {
         if (a.speciesIndex == gridIndex && gridIndex < gridSize) {
-          a.draw(prog, grid[gridIndex], bindTexture);
-
-          if (bindTexture && mDrawDebugNetworks)
-            a.drawablePhenotype->draw3D(grid[gridIndex] + mmm::vec3(0, 5, 0));
+          function(a, grid[gridIndex]);
           gridIndex++;
         }
       }
@@ -508,13 +1022,8 @@ void SpiderSwarm::draw(std::shared_ptr<Program>& prog, bool bindTexture) {
     // Draw the leaders of the species
     case DrawingMethod::SpeciesLeaders: {
       for (auto& a : mSpeciesLeaders) {
-        if (a < numPhenotypes && gridIndex < gridSize) {
-          mPhenotypes[a].draw(prog, grid[gridIndex], bindTexture);
-
-          if (bindTexture && mDrawDebugNetworks)
-            mPhenotypes[a].drawablePhenotype->draw3D(grid[gridIndex] +
-                                                     mmm::vec3(0, 5, 0));
-        }
+        if (a < numPhenotypes && gridIndex < gridSize)
+          function(mPhenotypes[a], grid[gridIndex]);
 
         gridIndex++;
       }
@@ -524,23 +1033,15 @@ void SpiderSwarm::draw(std::shared_ptr<Program>& prog, bool bindTexture) {
 
     // Draw the one with the best fitness in the last generation
     case DrawingMethod::BestFitness:
-      if (mBestIndex < numPhenotypes) {
-        mPhenotypes[mBestIndex].draw(prog, mmm::vec3(0, 0, 0), bindTexture);
-        if (bindTexture && mDrawDebugNetworks)
-          mPhenotypes[mBestIndex].drawablePhenotype->draw3D(grid[gridIndex] +
-                                                            mmm::vec3(0, 5, 0));
-      }
+      if (mBestIndex < numPhenotypes)
+        function(mPhenotypes[mBestIndex], mmm::vec3(0, 0, 0));
       break;
 
     // Draw all spiders
     case DrawingMethod::DrawAll:
       for (auto& p : mPhenotypes) {
-        if (gridIndex < gridSize) {
-          p.draw(prog, grid[gridIndex], bindTexture);
-          if (bindTexture && mDrawDebugNetworks) {
-            p.drawablePhenotype->draw3D(grid[gridIndex] + mmm::vec3(0, 5, 0));
-          }
-        }
+        if (gridIndex < gridSize)
+          function(p, grid[gridIndex]);
         gridIndex++;
       }
       break;
@@ -574,6 +1075,9 @@ void SpiderSwarm::save(const std::string& filename) {
     return;
   }
 
+  if (mIslands != nullptr)
+    return mIslands->save(filename);
+
   std::string popFilename    = filename + ".population";
   std::string subFilename    = filename + ".substrate";
   std::string genomeFilename = filename + ".genome";
@@ -626,8 +1130,11 @@ void SpiderSwarm::load(const std::string& filename) {
   std::string subFilename    = filename + ".substrate";
   std::string genomeFilename = filename + ".genome";
 
+  waitForBuilds();
+
   mPopulation = new NEAT::Population(popFilename.c_str());
   mSubstrate->load(subFilename);
+  mNetworkCache.clear();
 
   // Load the best possible genome if its available.
   std::ifstream fs;
@@ -652,6 +1159,45 @@ void SpiderSwarm::load(const std::string& filename) {
   mLog->info("Ready to start experiment");
 }
 
+/**
+ * @brief
+ *   Loads the best possible genome and the substrate it was evolved on,
+ *   without the population, which is all that is needed to export or
+ *   look at a champion. The files loaded are `<filename>.genome` and
+ *   `<filename>.substrate`.
+ *
+ * @param filename
+ *
+ * @return
+ *   Whether the genome was found
+ */
+bool SpiderSwarm::loadChampion(const std::string& filename) {
+  if (mCurrentExperiment == nullptr) {
+    mLog->warn("You must load experiment before loading file");
+    return false;
+  }
+
+  std::string subFilename    = filename + ".substrate";
+  std::string genomeFilename = filename + ".genome";
+
+  std::ifstream fs;
+  fs.open(genomeFilename);
+
+  if (!fs.is_open()) {
+    mLog->error("Could not open genome: {}", genomeFilename);
+    return false;
+  }
+
+  waitForBuilds();
+
+  mSubstrate->load(subFilename);
+  mNetworkCache.clear();
+  mBestPossibleGenome = NEAT::Genome(genomeFilename.c_str());
+
+  mLog->info("Loaded genome from file: {}", filename);
+  return true;
+}
+
 /**
  * @brief
  *   Returns the current iteration duration
@@ -691,37 +1237,21 @@ SpiderSwarm::SimulationStage SpiderSwarm::stage() {
  *   batch into several smaller pieces, but instead splits the entire number
  *   of Phenotypes into smaller batches.
  *
- *   For instance, if you have 4 threads and a population size of 50, it will
- *   split 12 Phenotypes to 3 of the threads and the last one will have work
- *   with the remaining 14.
+ *   The batches are run by the threads of the global ThreadPool, which are
+ *   kept alive between ticks instead of being created for every tick.
  *
  * @param deltaTime
  */
 #ifdef BT_NO_PROFILE
 void SpiderSwarm::updateThreadBatches(float deltaTime) {
+  auto begin = std::begin(mPhenotypes);
 
-  int size    = mPhenotypes.size();
-  int nThread = mmm::min(std::thread::hardware_concurrency(), size);
-  std::vector<std::thread> threads(nThread);
-
-  auto workIter  = std::begin(mPhenotypes);
-  int  grainSize = size / threads.size();
-
-  for (auto it = std::begin(threads); it != std::end(threads) - 1; ++it) {
-    *it = std::thread(mWorker,
-                      workIter,
-                      workIter + grainSize,
-                      std::ref(*mCurrentExperiment));
-    workIter += grainSize;
-  }
-
-  threads.back() = std::thread(mWorker,
-                               workIter,
-                               std::end(mPhenotypes),
-                               std::ref(*mCurrentExperiment));
-
-  for (auto&& i : threads)
-    i.join();
+  ThreadPool::global().parallelFor(mPhenotypes.size(),
+                                   [&](size_t first, size_t last) {
+                                     mWorker(begin + first,
+                                             begin + last,
+                                             *mCurrentExperiment);
+                                   });
 
   mCurrentDuration += deltaTime;
 }
@@ -845,7 +1375,11 @@ void SpiderSwarm::updateEpoch() {
     for (size_t j = 0; j < mPopulation->m_Species[i].m_Individuals.size();
          ++j) {
 
-      float fitness = mPhenotypes[index].finalizeFitness(*mCurrentExperiment);
+      // Phenotypes evaluated by workers have already been finalized
+      Phenotype& p       = mPhenotypes[index];
+      float      fitness = p.hasFinalized ?
+                        p.finalizedFitness :
+                        p.finalizeFitness(*mCurrentExperiment);
       mPopulation->m_Species[i].m_Individuals[j].SetFitness(fitness);
       mPopulation->m_Species[i].m_Individuals[j].SetEvaluated();
 
@@ -877,6 +1411,7 @@ void SpiderSwarm::updateEpoch() {
 
   mBestIndex = bestIndex;
 
+  reportEvaluations(index);
   mStats.addEntry(mPhenotypes, mGeneration);
 
   if (changedBest) {
@@ -884,6 +1419,8 @@ void SpiderSwarm::updateEpoch() {
     save("current-g" + std::to_string(mGeneration));
   }
 
+  recordGeneration(bestIndex, changedBest);
+
   // Log some information about the generation that just finished
   // excuting, such as the best fitness overall and the best
   // for each species, together with the individual fitness values
@@ -892,6 +1429,7 @@ void SpiderSwarm::updateEpoch() {
              best,
              mBestPossibleFitness,
              mBestPossibleFitnessGeneration);
+  mLog->info("Evaluations per second: {}", mEvaluationsPerSecond);
 
   for (auto i : mSpeciesLeaders) {
     if (i >= mPhenotypes.size())
@@ -952,6 +1490,9 @@ void SpiderSwarm::updateEpoch() {
  *   If BT_NO_PROFILE is true, it will generated the ESHyperNEAT phenotypes
  *   using multithreading, splitting up the workload much like
  *   `updateThreadBatches`
+ *
+ *   Genomes that are unchanged since the last generation, such as elites,
+ *   reuse the network from the NetworkCache instead of being rebuilt.
  */
 void SpiderSwarm::recreatePhenotypes() {
   mLog->debug("Recreating {} phenotypes...",
@@ -960,6 +1501,11 @@ void SpiderSwarm::recreatePhenotypes() {
 
   size_t index      = 0;
   bool   addLeaders = mSpeciesLeaders.size() == 0;
+  bool   useES      = mCurrentExperiment->parameters().useESHyperNEAT;
+
+  std::vector<Phenotype*> toBuild;
+  std::vector<uint64_t>   hashes;
+
   for (size_t i = 0; i < mPopulation->m_Species.size(); ++i) {
     auto& species = mPopulation->m_Species[i];
 
@@ -979,18 +1525,34 @@ void SpiderSwarm::recreatePhenotypes() {
       mPhenotypes[index].reset(species.ID(), i, j, g.GetID());
       mPhenotypes[index].spider->disableUpdatingFromPhysics();
       mCurrentExperiment->initPhenotype(mPhenotypes[index]);
+      startRecording(mPhenotypes[index]);
+
+      // The workers build their own networks
+      if (isDistributed()) {
+        ++index;
+        continue;
+      }
+
+      uint64_t hash = NetworkCache::hash(g);
+
+      if (!mNetworkCache.get(g.GetID(), hash, *mPhenotypes[index].network)) {
+        toBuild.push_back(&mPhenotypes[index]);
+        hashes.push_back(hash);
+      }
 
 // If we are using single-threaded mode, create the neural
 // networks, otherwise wait until later
 #ifndef BT_NO_PROFILE
-      auto& individual = species.m_Individuals[j];
-      if (mCurrentExperiment->parameters().useESHyperNEAT) {
-        individual.BuildESHyperNEATPhenotype(*mPhenotypes[index].network,
-                                             *mSubstrate,
-                                             mPopulation->m_Parameters);
-      } else {
-        individual.BuildHyperNEATPhenotype(*mPhenotypes[index].network,
-                                           *mSubstrate);
+      if (toBuild.size() > 0 && toBuild.back() == &mPhenotypes[index]) {
+        if (useES) {
+          ESHyperNEAT::build(g,
+                             *mPhenotypes[index].network,
+                             *mSubstrate,
+                             mPopulation->m_Parameters,
+                             &ThreadPool::global());
+        } else {
+          g.BuildHyperNEATPhenotype(*mPhenotypes[index].network, *mSubstrate);
+        }
       }
 #endif
       ++index;
@@ -1005,44 +1567,38 @@ void SpiderSwarm::recreatePhenotypes() {
   }
 
 // If using multithreaded more, generated the ESHyperNEAT neural
-// networks in paralell
+// networks in paralell. The workers build their own networks
 #ifdef BT_NO_PROFILE
-  int size    = mPhenotypes.size();
-  int nThread = mmm::min(std::thread::hardware_concurrency(), size);
-  std::vector<std::thread> threads(nThread);
-
-  auto workIter  = std::begin(mPhenotypes);
-  int  grainSize = size / threads.size();
-
-  mLog->debug("Building networks with {} thread(s)", nThread);
-
-  for (auto it = std::begin(threads); it != std::end(threads) - 1; ++it) {
-    *it = std::thread(mBuildingWorker,
-                      workIter,
-                      workIter + grainSize,
-                      std::ref(*mCurrentExperiment),
-                      std::ref(*mPopulation),
-                      std::ref(*mSubstrate));
-    workIter += grainSize;
+  if (toBuild.size() > 0) {
+    auto begin = std::begin(toBuild);
+
+    mLog->debug("Building networks with {} thread(s)",
+                ThreadPool::global().numThreads() + 1);
+
+    ThreadPool::global().parallelFor(toBuild.size(),
+                                     [&](size_t first, size_t last) {
+                                       mBuildingWorker(begin + first,
+                                                       begin + last,
+                                                       *mCurrentExperiment,
+                                                       *mPopulation,
+                                                       *mSubstrate);
+                                     });
   }
+#endif
 
-  threads.back() = std::thread(mBuildingWorker,
-                               workIter,
-                               std::end(mPhenotypes),
-                               std::ref(*mCurrentExperiment),
-                               std::ref(*mPopulation),
-                               std::ref(*mSubstrate));
-
-  for (auto&& i : threads)
-    i.join();
+  for (size_t i = 0; i < toBuild.size(); ++i)
+    mNetworkCache.put(toBuild[i]->genomeId, hashes[i], *toBuild[i]->network);
 
-#endif
+  mLog->debug("Reused {} network(s), built {}",
+              mNetworkCache.hits(),
+              toBuild.size());
+  mNetworkCache.nextGeneration();
 
   // If we want to see the Networks, create those
   // after the networks have been added
   if (mDrawDebugNetworks) {
     for (auto& i : mPhenotypes) {
-      i.drawablePhenotype->recreate(*i.network, mmm::vec3(1.0, 1.0, 1.0));
+      i.recreateDrawable();
     }
   }
 
@@ -1099,3 +1655,951 @@ NEAT::Genome& SpiderSwarm::bestPossibleGenome() {
 void SpiderSwarm::restart() {
   mRestartOnNextUpdate = true;
 }
+
+/**
+ * @brief
+ *   Starts listening for evaluation workers on the given address, which
+ *   is either `host:port` or `unix:/path`. Workers are started with
+ *   `--worker <address>`.
+ *
+ *   From the next generation on, every genome is evaluated by the workers
+ *   instead of locally.
+ *
+ * @param address
+ *
+ * @return
+ */
+bool SpiderSwarm::listen(const std::string& address) {
+  if (mIslands != nullptr) {
+    mLog->error("Islands cannot be evaluated by workers");
+    return false;
+  }
+
+  if (mMaster == nullptr)
+    mMaster = new EvaluationMaster();
+
+  return mMaster->listen(address);
+}
+
+/**
+ * @brief
+ *   Stops listening for workers, telling the connected ones to shut down.
+ *   The current generation is restarted locally.
+ */
+void SpiderSwarm::stopListening() {
+  if (mMaster == nullptr)
+    return;
+
+  delete mMaster;
+  mMaster = nullptr;
+  restart();
+}
+
+void SpiderSwarm::setWorkerTimeout(float seconds) {
+  if (mMaster == nullptr)
+    mMaster = new EvaluationMaster();
+
+  mMaster->setTimeout(seconds);
+}
+
+void SpiderSwarm::setWorkerBatchSize(unsigned int batchSize) {
+  if (mMaster == nullptr)
+    mMaster = new EvaluationMaster();
+
+  mMaster->setBatchSize(batchSize);
+}
+
+bool SpiderSwarm::isDistributed() const {
+  return mMaster != nullptr && mMaster->isListening();
+}
+
+/**
+ * @brief
+ *   Submits every genome of the generation to the workers the first time
+ *   it is called. On every call it polls the workers, copying the results
+ *   into the Phenotypes as they arrive. Once every genome has a result,
+ *   the epoch is updated just like after a local evaluation.
+ */
+void SpiderSwarm::updateDistributed() {
+  if (!mHasSubmitted) {
+    mMaster->clear();
+
+    // The substrate and parameters may have been loaded from file, which
+    // the workers know nothing about
+    const ExperimentParameters& params = mCurrentExperiment->parameters();
+    Evaluation::Settings        settings;
+    std::stringstream           substrate;
+
+    mSubstrate->save(substrate);
+
+    settings.experiment      = mCurrentExperiment->name();
+    settings.substrate       = substrate.str();
+    settings.parameters      = Evaluation::serializeParameters(
+      mPopulation->m_Parameters);
+    settings.singlePrecision      = params.singlePrecision;
+    settings.persistentLeakyState = params.persistentLeakyState;
+    settings.sparsify             = params.sparsify;
+    mMaster->setup(settings);
+
+    size_t index = 0;
+    for (auto& species : mPopulation->m_Species)
+      for (auto& individual : species.m_Individuals)
+        mMaster->submit(index++, mCurrentExperiment->name(), individual);
+
+    mHasSubmitted = true;
+    mLog->debug("Submitted {} genomes to {} worker(s)",
+                index,
+                mMaster->numWorkers());
+  }
+
+  mMaster->poll();
+
+  for (auto& result : mMaster->results()) {
+    if (result.first >= mPhenotypes.size())
+      continue;
+
+    Phenotype& p       = mPhenotypes[result.first];
+    p.finalizedFitness = result.second.finalizedFitness;
+    p.duration         = result.second.duration;
+    p.failed           = result.second.killed;
+    p.hasFinalized     = true;
+
+    for (size_t i = 0; i < result.second.fitness.size() && i < 9; ++i)
+      p.fitness[i] = result.second.fitness[i];
+  }
+
+  if (!mMaster->done())
+    return;
+
+  mHasSubmitted = false;
+  updateEpoch();
+}
+
+/**
+ * @brief
+ *   Enables or disables steady state evolution. Disabling it restarts
+ *   the evaluation of the population using generations.
+ *
+ * @param enable
+ */
+void SpiderSwarm::setSteadyState(bool enable) {
+  if (enable == mSteadyState)
+    return;
+
+  if (enable && mIslands != nullptr) {
+    mLog->error("Islands cannot use steady state evolution");
+    return;
+  }
+
+  mSteadyState = enable;
+  mSlotDurations.clear();
+
+  if (!enable)
+    restart();
+}
+
+bool SpiderSwarm::isSteadyState() {
+  return mSteadyState;
+}
+
+float SpiderSwarm::evaluationsPerSecond() {
+  return mEvaluationsPerSecond;
+}
+
+/**
+ * @brief
+ *   Enables the sparsification stage for the current experiment. Every
+ *   network is sparsified right before it is activated for the first time.
+ *
+ * @param minContribution
+ * @param mergeDuplicates
+ * @param quantization
+ */
+void SpiderSwarm::setSparsification(double             minContribution,
+                                    bool               mergeDuplicates,
+                                    const std::string& quantization) {
+  if (mCurrentExperiment == nullptr) {
+    mLog->warn("Must setup experiment before setting sparsification");
+    return;
+  }
+
+  SparsifyOptions options;
+  options.minContribution = minContribution;
+  options.mergeDuplicates = mergeDuplicates;
+  options.quantization    = Sparsifier::quantizationFromString(quantization);
+
+  mCurrentExperiment->setSparsifyOptions(options);
+}
+
+/**
+ * @brief
+ *   Builds the network of the best possible genome, which is the one loaded
+ *   by `load` or `loadGenome`, and sparsifies a copy of it. Both networks
+ *   are then simulated for the whole experiment so that the change in
+ *   fitness can be compared with how many connections were removed.
+ *
+ *   This is meant to be used on the champions:
+ *
+ *   swarm:setup("Walking08", false)
+ *   swarm:load("champions/Walking/WalkingChampion")
+ *   swarm:reportSparsification(0.05, true, "int8")
+ *
+ * @param minContribution
+ * @param mergeDuplicates
+ * @param quantization
+ */
+void SpiderSwarm::reportSparsification(double             minContribution,
+                                       bool               mergeDuplicates,
+                                       const std::string& quantization) {
+  if (mCurrentExperiment == nullptr || mBestPossibleGenome.NumNeurons() == 0) {
+    mLog->warn("Must setup experiment and load a genome before reporting");
+    return;
+  }
+
+  SparsifyOptions options;
+  options.minContribution = minContribution;
+  options.mergeDuplicates = mergeDuplicates;
+  options.quantization    = Sparsifier::quantizationFromString(quantization);
+
+  NEAT::NeuralNetwork network;
+  buildBestNetwork(network);
+
+  NEAT::NeuralNetwork sparse = network;
+  SparsifyReport      report = Sparsifier::sparsify(sparse, options);
+
+  // Both networks are evaluated as they are
+  SparsifyOptions previous = mCurrentExperiment->parameters().sparsify;
+  mCurrentExperiment->setSparsifyOptions(SparsifyOptions());
+
+  float original   = evaluateNetwork(network);
+  float sparsified = evaluateNetwork(sparse);
+
+  mCurrentExperiment->setSparsifyOptions(previous);
+
+  float reduction = report.connectionsBefore > 0 ?
+                      100.f * (report.connectionsBefore -
+                               report.connectionsAfter) /
+                        report.connectionsBefore :
+                      0.f;
+
+  mLog->info("Connections: {} -> {} ({:.1f}% fewer, {} pruned, {} merged)",
+             report.connectionsBefore,
+             report.connectionsAfter,
+             reduction,
+             report.pruned,
+             report.merged);
+  mLog->info("Weight storage: {} -> {} bytes, max weight error {}",
+             report.bytesBefore,
+             report.bytesAfter,
+             report.maxWeightError);
+  mLog->info("Fitness: {} -> {} (drift {})",
+             original,
+             sparsified,
+             sparsified - original);
+}
+
+/**
+ * @brief
+ *   Builds the networks with both MultiNEAT and the parallel builder,
+ *   stopping at the first genome whose networks differ.
+ *
+ *   The first genome is the minimal CPPN the experiments start from, with
+ *   weights from a fixed seed, so that the check does not depend on the
+ *   run. It is followed by every genome of the current population.
+ *
+ * @return
+ */
+bool SpiderSwarm::checkESHyperNEAT() {
+  if (mPopulation == nullptr || mSubstrate == nullptr) {
+    mLog->warn("You must load experiment before checking ES-HyperNEAT");
+    return false;
+  }
+
+  NEAT::Parameters&         params = mPopulation->m_Parameters;
+  std::vector<NEAT::Genome> genomes;
+  NEAT::RNG                 rng;
+
+  genomes.push_back(NEAT::Genome(0,
+                                 mSubstrate->GetMinCPPNInputs(),
+                                 0,
+                                 mSubstrate->GetMinCPPNOutputs(),
+                                 false,
+                                 NEAT::ActivationFunction::SIGNED_SINE,
+                                 NEAT::ActivationFunction::SIGNED_GAUSS,
+                                 0,
+                                 params));
+  rng.Seed(0);
+  genomes.back().Randomize_LinkWeights(params.MaxWeight, rng);
+
+  for (auto& species : mPopulation->m_Species)
+    for (auto& individual : species.m_Individuals)
+      genomes.push_back(individual);
+
+  for (auto& g : genomes) {
+    std::string difference = ESHyperNEAT::compare(g, *mSubstrate, params);
+
+    if (!difference.empty()) {
+      mLog->error("ES-HyperNEAT networks of genome {} differ: {}",
+                  g.GetID(),
+                  difference);
+      return false;
+    }
+  }
+
+  mLog->info("ES-HyperNEAT networks of {} genome(s) are the same",
+             genomes.size());
+  return true;
+}
+
+/**
+ * @brief
+ *   Switches the ES-HyperNEAT builder. Enabling it runs `checkESHyperNEAT`
+ *   first, keeping MultiNEAT if the networks differ.
+ *
+ * @param enable
+ */
+void SpiderSwarm::setParallelESHyperNEAT(bool enable) {
+  if (enable && !checkESHyperNEAT()) {
+    mLog->error("Keeping MultiNEAT to build ES-HyperNEAT networks");
+    return;
+  }
+
+  ESHyperNEAT::setParallel(enable);
+  mNetworkCache.clear();
+}
+
+/**
+ * @brief
+ *   Sets whether the networks of the current experiment are activated in
+ *   float or double precision.
+ *
+ * @param enable
+ */
+void SpiderSwarm::setSinglePrecision(bool enable) {
+  if (mCurrentExperiment == nullptr) {
+    mLog->warn("Must setup experiment before setting the precision");
+    return;
+  }
+
+  mCurrentExperiment->setSinglePrecision(enable);
+}
+
+/**
+ * @brief
+ *   Sets whether the leaky networks of the current experiment keep their
+ *   membrane potentials between time steps, instead of starting from rest
+ *   every time step.
+ *
+ * @param enable
+ */
+void SpiderSwarm::setPersistentLeakyState(bool enable) {
+  if (mCurrentExperiment == nullptr) {
+    mLog->warn("Must setup experiment before setting the leaky state");
+    return;
+  }
+
+  mCurrentExperiment->setPersistentLeakyState(enable);
+}
+
+/**
+ * @brief
+ *   Simulates the network of the best possible genome for the whole
+ *   experiment twice, once in double precision and once in float, and logs
+ *   the difference in fitness. This shows whether float is precise enough
+ *   for a stored genome before using it:
+ *
+ *   swarm:setup("Walking08", false)
+ *   swarm:load("champions/Walking/WalkingChampion")
+ *   swarm:reportPrecision()
+ */
+void SpiderSwarm::reportPrecision() {
+  if (mCurrentExperiment == nullptr || mBestPossibleGenome.NumNeurons() == 0) {
+    mLog->warn("Must setup experiment and load a genome before reporting");
+    return;
+  }
+
+  NEAT::NeuralNetwork network;
+  buildBestNetwork(network);
+
+  bool previous = mCurrentExperiment->parameters().singlePrecision;
+
+  mCurrentExperiment->setSinglePrecision(false);
+  float full = evaluateNetwork(network);
+
+  mCurrentExperiment->setSinglePrecision(true);
+  float single = evaluateNetwork(network);
+
+  mCurrentExperiment->setSinglePrecision(previous);
+
+  float relative = full != 0 ? 100.f * (single - full) / std::abs(full) : 0.f;
+
+  mLog->info("Fitness of genome {}: double {}, float {} (difference {}, "
+             "{:.3f}%)",
+             mBestPossibleGenome.GetID(),
+             full,
+             single,
+             single - full,
+             relative);
+}
+
+/**
+ * @brief
+ *   Exports the network of the best possible genome to a controller file
+ *   that can be run without the engine by ControllerRuntime:
+ *
+ *   swarm:setup("Walking08", false)
+ *   swarm:load("champions/Walking/WalkingChampion")
+ *   swarm:exportController("WalkingChampion.controller")
+ *
+ *   The network is sparsified and compiled in single precision just like
+ *   during evolution, and the experiment describes which sensors and
+ *   motors its inputs and outputs are connected to.
+ *
+ * @param filename
+ */
+void SpiderSwarm::exportController(const std::string& filename) {
+  if (mCurrentExperiment == nullptr || mBestPossibleGenome.NumNeurons() == 0) {
+    mLog->warn("Must setup experiment and load a genome before exporting");
+    return;
+  }
+
+  const ExperimentParameters& params = mCurrentExperiment->parameters();
+
+  // The runtime keeps the membrane potentials between time steps
+  if (mSubstrate->m_leaky && !params.persistentLeakyState)
+    mLog->warn("The network was evolved without persistent leaky state, "
+               "the exported controller may behave differently");
+
+  NEAT::NeuralNetwork network;
+  buildBestNetwork(network);
+
+  if (params.sparsify.enabled())
+    Sparsifier::sparsify(network, params.sparsify);
+
+  CompiledNetworkF compiled;
+  ControllerFile   file;
+
+  compiled.compile(network);
+  compiled.exportTo(file);
+
+  file.leaky     = mSubstrate->m_leaky;
+  file.passes    = std::max(params.numActivates, 1);
+  file.tolerance = params.activationTolerance;
+  file.timeStep  = params.deltaTime;
+
+  // The spider is needed to find the active joints and their limits
+  Phenotype p;
+  p.reset(0, 0, 0, mBestPossibleGenome.GetID());
+  p.spider->disableUpdatingFromPhysics();
+  mCurrentExperiment->initPhenotype(p);
+  mCurrentExperiment->describeController(p, file);
+  p.remove();
+
+  file.save(filename);
+
+  mLog->info("Exported genome {} to {}: {} neurons, {} connections, {} "
+             "sensors and {} motors",
+             mBestPossibleGenome.GetID(),
+             filename,
+             file.numNeurons,
+             file.connections.size(),
+             file.sensors.size(),
+             file.motors.size());
+}
+
+/**
+ * @brief
+ *   Returns the value of a sensor by the name given to it in
+ *   Experiment::describeController
+ *
+ * @param p
+ * @param name
+ *
+ * @return
+ */
+static float readSensor(const Phenotype& p, const std::string& name) {
+  const std::string rotation = "SternumRotation";
+  const std::string contact  = "Contact";
+
+  if (name.compare(0, rotation.size(), rotation) == 0) {
+    btRigidBody* sternum = p.spider->parts().at("Sternum").part->rigidBody();
+    mmm::vec3    rots    = ExpUtil::getEulerAngles(sternum->getOrientation());
+    char         axis    = name.back();
+
+    return axis == 'X' ? rots.x : axis == 'Y' ? rots.y : rots.z;
+  }
+
+  size_t suffix = name.size() - std::min(name.size(), contact.size());
+
+  if (suffix > 0 && name.substr(suffix) == contact)
+    return p.collidesWithTerrain(name.substr(0, suffix)) ? 1.0 : 0.0;
+
+  return p.spider->parts().at(name).hinge->getHingeAngle();
+}
+
+/**
+ * @brief
+ *   Simulates the best possible genome for the whole experiment and writes
+ *   the sensors of the controller file at every step, one step per line.
+ *   The recording is used by CheckController to compare the generated
+ *   code of a controller against ControllerRuntime on realistic input:
+ *
+ *   swarm:exportController("WalkingChampion.controller")
+ *   swarm:recordSensors("WalkingChampion.controller",
+ *                       "WalkingChampion.sensors")
+ *
+ * @param controller
+ * @param filename
+ */
+void SpiderSwarm::recordSensors(const std::string& controller,
+                                const std::string& filename) {
+  if (mCurrentExperiment == nullptr || mBestPossibleGenome.NumNeurons() == 0) {
+    mLog->warn("Must setup experiment and load a genome before recording");
+    return;
+  }
+
+  ControllerFile file = ControllerFile::load(controller);
+  std::ofstream  fs(filename);
+
+  if (!fs.is_open())
+    throw std::runtime_error("Unable to write recording: " + filename);
+
+  fs << std::setprecision(std::numeric_limits<float>::max_digits10);
+
+  NEAT::NeuralNetwork network;
+  buildBestNetwork(network);
+
+  Phenotype p;
+  float     deltaTime = mCurrentExperiment->parameters().deltaTime;
+  size_t    steps     = 0;
+
+  p.reset(0, 0, 0, mBestPossibleGenome.GetID());
+  p.spider->disableUpdatingFromPhysics();
+  mCurrentExperiment->initPhenotype(p);
+  *p.network = network;
+
+  for (float t = 0; t < mCurrentExperiment->totalDuration(); t += deltaTime) {
+    if (p.hasBeenKilled())
+      break;
+
+    for (size_t i = 0; i < file.sensors.size(); ++i)
+      fs << (i > 0 ? " " : "") << readSensor(p, file.sensors[i]);
+
+    fs << std::endl;
+    steps += 1;
+
+    p.update(*mCurrentExperiment);
+  }
+
+  p.remove();
+
+  mLog->info("Recorded {} steps of {} sensors to {}",
+             steps,
+             file.sensors.size(),
+             filename);
+}
+
+/**
+ * @brief
+ *   Builds the network of the best possible genome in the same way as the
+ *   networks of the population are built
+ *
+ * @param network
+ */
+void SpiderSwarm::buildBestNetwork(NEAT::NeuralNetwork& network) {
+  buildNetwork(mBestPossibleGenome, network);
+}
+
+/**
+ * @brief
+ *   Builds the network of any genome with the substrate and parameters of
+ *   the population
+ *
+ * @param genome
+ * @param network
+ */
+void SpiderSwarm::buildNetwork(NEAT::Genome&        genome,
+                               NEAT::NeuralNetwork& network) {
+  if (mCurrentExperiment->parameters().useESHyperNEAT) {
+    ESHyperNEAT::build(genome,
+                       network,
+                       *mSubstrate,
+                       mPopulation->m_Parameters,
+                       &ThreadPool::global());
+  } else {
+    genome.BuildHyperNEATPhenotype(network, *mSubstrate);
+  }
+}
+
+/**
+ * @brief
+ *   Runs a Phenotype with the given network from start to end, without
+ *   drawing it, and returns the finalized fitness.
+ *
+ * @param network
+ *
+ * @return
+ */
+float SpiderSwarm::evaluateNetwork(const NEAT::NeuralNetwork& network) {
+  return Phenotype::evaluate(
+    *mCurrentExperiment, network, mBestPossibleGenome.GetID(), 0);
+}
+
+/**
+ * @brief
+ *   Performs a step on every Phenotype. Unlike the generational update,
+ *   there is no waiting for the slowest Phenotype. Those that have been
+ *   killed or have run for the entire duration are finalized and replaced
+ *   by new offspring right away, while the rest continue.
+ *
+ *   Each Phenotype is therefore considered a slot with its own duration.
+ *   A slot whose offspring is still being built by the thread pool sits
+ *   out until its network is done.
+ *
+ * @param deltaTime
+ */
+void SpiderSwarm::updateSteadyState(float deltaTime) {
+  // Slots that are already running when steady state is enabled
+  // keep their progress
+  if (mSlotDurations.size() != mPhenotypes.size())
+    mSlotDurations.resize(mPhenotypes.size(), mCurrentDuration);
+
+  mSlotBuilds.resize(mPhenotypes.size());
+
+  std::vector<size_t> running;
+
+  for (size_t i = 0; i < mPhenotypes.size(); ++i) {
+    std::future<void>& build = mSlotBuilds[i];
+
+    if (build.valid()) {
+      if (build.wait_for(std::chrono::seconds(0)) !=
+          std::future_status::ready)
+        continue;
+
+      build.get();
+
+      if (mDrawDebugNetworks)
+        mPhenotypes[i].recreateDrawable();
+    }
+
+    running.push_back(i);
+  }
+
+#ifdef BT_NO_PROFILE
+  ThreadPool::global().parallelFor(running.size(),
+                                   [&](size_t begin, size_t end) {
+                                     for (size_t k = begin; k < end; ++k)
+                                       mPhenotypes[running[k]].update(
+                                         *mCurrentExperiment);
+                                   });
+#else
+  for (auto i : running)
+    mPhenotypes[i].update(*mCurrentExperiment);
+#endif
+
+  std::vector<size_t> finished;
+  float               totalDuration = mCurrentExperiment->totalDuration();
+
+  for (auto i : running) {
+    mSlotDurations[i] += deltaTime;
+
+    if (mPhenotypes[i].hasBeenKilled() || mSlotDurations[i] >= totalDuration)
+      finished.push_back(i);
+  }
+
+  if (finished.empty())
+    return;
+
+  // Genomes that Tick removed while they were being evaluated were
+  // never evaluated as far as the population is concerned
+  size_t numEvaluations = 0;
+
+  for (auto i : finished)
+    if (commitFitness(mPhenotypes[i]))
+      numEvaluations += 1;
+
+  replacePhenotypes(finished);
+  reportEvaluations(numEvaluations);
+}
+
+/**
+ * @brief
+ *   Finalizes the fitness of the Phenotype and gives it to the genome.
+ *   The genome may have been removed from the population while it was
+ *   being evaluated, in which case the fitness is thrown away.
+ *
+ *   Since there are no generations, a genome is recorded as soon as it
+ *   becomes the best ever or the leader of its species.
+ *
+ * @param p
+ *
+ * @return
+ *   Whether or not the genome was still part of the population
+ */
+bool SpiderSwarm::commitFitness(Phenotype& p) {
+  float  fitness         = p.finalizeFitness(*mCurrentExperiment);
+  size_t speciesIndex    = 0;
+  size_t individualIndex = 0;
+
+  NEAT::Genome* genome = findGenome(p.genomeId, speciesIndex, individualIndex);
+
+  if (genome == nullptr)
+    return false;
+
+  genome->SetFitness(fitness);
+  genome->SetEvaluated();
+
+  bool isBest = fitness > mBestPossibleFitness;
+
+  if (isBest) {
+    mBestPossibleFitness           = fitness;
+    mBestPossibleGenome            = *genome;
+    mBestPossibleFitnessGeneration = mGeneration;
+    mChangedBest                   = true;
+  }
+
+  if (mRecordingMethod == RecordingMethod::BestFitness && isBest)
+    recordGenome(p.genomeId, mGeneration);
+
+  if (mRecordingMethod == RecordingMethod::SpeciesLeaders) {
+    bool isLeader = true;
+
+    for (auto& g : mPopulation->m_Species[speciesIndex].m_Individuals)
+      if (g.IsEvaluated() && g.GetFitness() > fitness)
+        isLeader = false;
+
+    if (isLeader)
+      recordGenome(p.genomeId, mGeneration);
+  }
+
+  return true;
+}
+
+/**
+ * @brief
+ *   Lets the Population produce one offspring for each slot, replacing
+ *   its worst individual each time. If the removed individual is still
+ *   being evaluated, that Phenotype is killed so that it gets an offspring
+ *   of its own on the next update.
+ *
+ *   Once all the offspring exist, the Phenotypes are reset and their
+ *   networks are handed to the thread pool to be built, so the other slots
+ *   keep running in the meantime. Since Tick may reorder the species, the
+ *   indices of every Phenotype are looked up again by genome ID, after
+ *   which the leaders are picked again among the Phenotypes that are left.
+ *
+ * @param slots
+ */
+void SpiderSwarm::replacePhenotypes(const std::vector<size_t>& slots) {
+  std::vector<NEAT::Genome> offspring;
+  offspring.reserve(slots.size());
+
+  for (size_t k = 0; k < slots.size(); ++k) {
+    NEAT::Genome deleted;
+
+    // The returned pointer is invalidated by the next tick, so copy it
+    offspring.push_back(*mPopulation->Tick(deleted));
+
+    for (size_t i = 0; i < mPhenotypes.size(); ++i)
+      if (mPhenotypes[i].genomeId == deleted.GetID() &&
+          std::find(slots.begin(), slots.end(), i) == slots.end())
+        mPhenotypes[i].kill();
+  }
+
+  for (size_t k = 0; k < slots.size(); ++k) {
+    size_t     speciesIndex    = 0;
+    size_t     individualIndex = 0;
+    Phenotype& p               = mPhenotypes[slots[k]];
+
+    findGenome(offspring[k].GetID(), speciesIndex, individualIndex);
+
+    p.reset(mPopulation->m_Species[speciesIndex].ID(),
+            speciesIndex,
+            individualIndex,
+            offspring[k].GetID());
+    p.spider->disableUpdatingFromPhysics();
+    mCurrentExperiment->initPhenotype(p);
+    startRecording(p);
+    mSlotDurations[slots[k]] = 0;
+  }
+
+  // The offspring have fresh indices, but those of the other Phenotypes
+  // may have been shifted by Tick
+  updateGenomeIndices();
+  updateRunningLeaders();
+
+  bool useES = mCurrentExperiment->parameters().useESHyperNEAT;
+
+  for (size_t k = 0; k < slots.size(); ++k) {
+    NEAT::NeuralNetwork* network = mPhenotypes[slots[k]].network;
+    NEAT::Parameters     params  = mPopulation->m_Parameters;
+    Substrate*           sub     = mSubstrate;
+
+    // Tick changes the parameters of the population, so the build
+    // uses a copy of them
+    mSlotBuilds[slots[k]] = ThreadPool::global().async(
+      [network, params, sub, useES, genome = offspring[k]]() mutable {
+        if (useES)
+          ESHyperNEAT::build(genome, *network, *sub, params);
+        else
+          genome.BuildHyperNEATPhenotype(*network, *sub);
+      });
+  }
+}
+
+/**
+ * @brief
+ *   Updates the species and individual index of every Phenotype from its
+ *   genome ID. Phenotypes whose genome is gone keep their old indices.
+ */
+void SpiderSwarm::updateGenomeIndices() {
+  std::map<unsigned int, std::pair<size_t, size_t>> indices;
+
+  for (size_t i = 0; i < mPopulation->m_Species.size(); ++i) {
+    auto& individuals = mPopulation->m_Species[i].m_Individuals;
+
+    for (size_t j = 0; j < individuals.size(); ++j)
+      indices[individuals[j].GetID()] = { i, j };
+  }
+
+  for (auto& p : mPhenotypes) {
+    auto it = indices.find(p.genomeId);
+
+    if (it == indices.end())
+      continue;
+
+    p.speciesId       = mPopulation->m_Species[it->second.first].ID();
+    p.speciesIndex    = it->second.first;
+    p.individualIndex = it->second.second;
+  }
+}
+
+/**
+ * @brief
+ *   Sets the leaders of the species and the best index from the fitness
+ *   the Phenotypes have gathered so far. In steady state, the Phenotypes
+ *   that finished have been replaced, so the indices from the last epoch
+ *   would point at offspring that have nothing to do with them.
+ *
+ *   Slots that have been killed are left out, so that they are not drawn
+ *   or logged as leaders.
+ */
+void SpiderSwarm::updateRunningLeaders() {
+  std::map<unsigned int, std::pair<size_t, float>> leaders;
+
+  float best = -99999.f;
+  mBestIndex = 0;
+
+  for (size_t i = 0; i < mPhenotypes.size(); ++i) {
+    Phenotype& p = mPhenotypes[i];
+
+    if (p.hasBeenKilled())
+      continue;
+
+    float fitness = mCurrentExperiment->mergeFitnessValues(p.fitness);
+    auto  it      = leaders.find(p.speciesIndex);
+
+    if (it == leaders.end() || fitness > it->second.second)
+      leaders[p.speciesIndex] = { i, fitness };
+
+    if (fitness > best) {
+      best       = fitness;
+      mBestIndex = i;
+    }
+  }
+
+  mSpeciesLeaders.clear();
+
+  for (auto& leader : leaders)
+    mSpeciesLeaders.push_back(leader.second.first);
+}
+
+/**
+ * @brief
+ *   Waits for the networks of the steady state slots that are still
+ *   being built, which must be done before the Phenotypes, substrate or
+ *   experiment they use are changed.
+ */
+void SpiderSwarm::waitForBuilds() {
+  for (auto& build : mSlotBuilds)
+    if (build.valid())
+      build.wait();
+
+  mSlotBuilds.clear();
+}
+
+/**
+ * @brief
+ *   Counts the evaluations, measuring the number of evaluations per second
+ *   every time a population worth of evaluations has completed.
+ *
+ *   In steady state mode, this is also where the progress is logged and
+ *   the swarm is saved if a new best genome has been found, since there
+ *   are no generations to do it at.
+ *
+ * @param numEvaluations
+ */
+void SpiderSwarm::reportEvaluations(size_t numEvaluations) {
+  size_t populationSize = std::max<size_t>(mPhenotypes.size(), 1);
+
+  mNumEvaluations += numEvaluations;
+  mTimerEvaluations += numEvaluations;
+
+  if (mTimerEvaluations < populationSize)
+    return;
+
+  auto                         now     = std::chrono::steady_clock::now();
+  std::chrono::duration<float> elapsed = now - mEvaluationTimer;
+
+  mEvaluationsPerSecond = mTimerEvaluations / std::max(elapsed.count(), 1e-6f);
+  mEvaluationTimer      = now;
+  mTimerEvaluations     = 0;
+
+  if (!mSteadyState)
+    return;
+
+  // Treat every population worth of evaluations as a generation
+  // so that saved files and logs are comparable to generational runs
+  ++mGeneration;
+
+  mLog->info("Evaluations: {}, evaluations per second: {}",
+             mNumEvaluations,
+             mEvaluationsPerSecond);
+  mLog->info("Best of all: {} ({})",
+             mBestPossibleFitness,
+             mBestPossibleFitnessGeneration);
+
+  if (mChangedBest) {
+    save("current-g" + std::to_string(mGeneration));
+    mChangedBest = false;
+  }
+}
+
+/**
+ * @brief
+ *   Finds the genome with the given ID, setting the indices of the
+ *   species and the individual within the species.
+ *
+ * @param id
+ * @param speciesIndex
+ * @param individualIndex
+ *
+ * @return
+ */
+NEAT::Genome* SpiderSwarm::findGenome(unsigned int id,
+                                      size_t&      speciesIndex,
+                                      size_t&      individualIndex) {
+  for (size_t i = 0; i < mPopulation->m_Species.size(); ++i) {
+    auto& individuals = mPopulation->m_Species[i].m_Individuals;
+
+    for (size_t j = 0; j < individuals.size(); ++j) {
+      if (individuals[j].GetID() == id) {
+        speciesIndex    = i;
+        individualIndex = j;
+        return &individuals[j];
+      }
+    }
+  }
+
+  return nullptr;
+}
@@ -1,17 +1,29 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include <btBulletDynamicsCommon.h>
 #include <mmm.hpp>
 
+#include "../3D/SpiderRenderer.hpp"
 #include "../Log.hpp"
+#include "../Utils/TripleBuffer.hpp"
+#include "NetworkCache.hpp"
 #include "Phenotype.hpp"
+#include "Replay.hpp"
 #include "Statistics.hpp"
 
 #include <Genome.h>
 
+class EvaluationMaster;
+class IslandModel;
 class Program;
 class Spider;
 class Terrain;
@@ -45,6 +57,23 @@ namespace NEAT {
  *
  * The SpiderSwarm will use mutlithreading on hte machine if BT_NO_PROFILE is
  * defined.
+ *
+ * If `listen` has been called, the evaluation of each generation is instead
+ * handed to the workers that connect to the SpiderSwarm, and the local
+ * Phenotypes are only used to hold the results.
+ *
+ * In steady state mode there are no generations. Instead, rtNEAT is used:
+ * as soon as a Phenotype has finished, its fitness is given to the genome
+ * and the Population replaces its worst individual with a new offspring
+ * that takes over the Phenotype.
+ *
+ * Finally, `setupIslands` replaces the single population by an IslandModel
+ * with several populations that exchange their best genomes.
+ *
+ * Drawing never reads the physics of the spiders directly. After a step, the
+ * parts that should be drawn are captured into a snapshot, which is handed
+ * to drawing through a TripleBuffer. The simulation can therefore run on a
+ * thread of its own, see `setSimulationThread`.
  */
 class SpiderSwarm : Logging::Log {
 public:
@@ -68,11 +97,16 @@ public:
     DrawNone
   };
 
+  //! This describes which individuals are recorded to replay files,
+  //! shared with the IslandModel
+  using RecordingMethod = ::RecordingMethod;
+
   enum class SimulationStage {
     None,
     Experiment,
     SimulationReady,
     Simulating,
+    Replaying,
   };
 
   SpiderSwarm();
@@ -90,6 +124,18 @@ public:
   // Setups an experiment
   void setup(const std::string& name, bool startExperiment = false);
 
+  // Setups an experiment with several islands that evolve in parallel,
+  // migrating genomes between them every few generations
+  void setupIslands(const std::string& name,
+                    unsigned int       numIslands,
+                    unsigned int       migrationInterval,
+                    unsigned int       numMigrants,
+                    bool               startExperiment = false);
+
+  // Sets the seed that the islands of `setupIslands` derive their
+  // seeds from. Defaults to the time the swarm was created
+  void setSeed(int seed);
+
   // Starts the simluation
   void start();
 
@@ -111,15 +157,42 @@ public:
   // Returns the current drawing method
   DrawingMethod drawingMethod();
 
+  // Sets which individuals are recorded, writing one replay file for each
+  // of them into the directory
+  void setRecording(RecordingMethod method, const std::string& directory);
+
+  // Plays a replay file instead of the experiment, until stop is called
+  void playReplay(const std::string& filename);
+
+  // Sets how fast the replay is played, where 1 is the recorded speed
+  void setReplaySpeed(float speed);
+
   // Toggles the drawing of the neural network for each spider
   void toggleDrawANN();
 
+  // Toggles the labels with the species and individual above each spider
+  void toggleDrawLabels();
+
   // Updates the SpiderSwarm which will either run a normal update
-  // on the current batch or figure out which batch is next
+  // on the current batch or figure out which batch is next. Does nothing
+  // when the simulation runs on its own thread
   void update(float deltaTime);
 
-  // Draws X number of spiders from current batch set by DrawLimit
-  void draw(std::shared_ptr<Program>& prog, bool bindTexture);
+  // Runs the simulation on a thread of its own instead of in update
+  void setSimulationThread(bool enable);
+
+  // Locks the SpiderSwarm, which must be held by other threads than the
+  // simulation thread while they use it
+  std::unique_lock<std::mutex> lock();
+
+  // Takes the latest snapshot of the spiders to draw this frame
+  void prepareDraw();
+
+  // Draws X number of spiders from current batch set by DrawLimit,
+  // skipping the parts outside of the frustum
+  void draw(std::shared_ptr<Program>& prog,
+            bool                      bindTexture,
+            const Frustum&            frustum = Frustum());
 
   // Saves the population, parameters and substrate of spiderswarm
   // to file
@@ -129,6 +202,10 @@ public:
   // from file
   void load(const std::string& filename);
 
+  // Loads only the best possible genome and the substrate from file,
+  // returning whether the genome was found
+  bool loadChampion(const std::string& filename);
+
   // Returns the current duration
   float currentDuration();
 
@@ -153,6 +230,72 @@ public:
   // Restarts the simulation
   void restart();
 
+  // Starts listening for evaluation workers on the address. While
+  // listening, all evaluation is done by the workers
+  bool listen(const std::string& address);
+
+  // Stops listening, shutting down the connected workers
+  void stopListening();
+
+  // Sets the number of seconds before a job is given to another worker
+  void setWorkerTimeout(float seconds);
+
+  // Sets the number of genomes sent to a worker at a time. 0 uses the
+  // number of threads on the worker
+  void setWorkerBatchSize(unsigned int batchSize);
+
+  // Enables or disables steady state evolution
+  void setSteadyState(bool enable);
+
+  // Returns whether or not steady state evolution is used
+  bool isSteadyState();
+
+  // Returns the number of evaluations completed per second, measured
+  // over the last PopulationSize evaluations in steady state mode or
+  // over the last generation otherwise
+  float evaluationsPerSecond();
+
+  // Enables pruning, merging and quantization of every network after it
+  // has been built. Quantization is either "none", "float16" or "int8"
+  void setSparsification(double             minContribution,
+                         bool               mergeDuplicates,
+                         const std::string& quantization);
+
+  // Sparsifies the network of the best possible genome, logging how many
+  // connections were removed and how much its fitness changed
+  void reportSparsification(double             minContribution,
+                            bool               mergeDuplicates,
+                            const std::string& quantization);
+
+  // Sets whether networks are activated in float instead of double
+  void setSinglePrecision(bool enable);
+
+  // Sets whether leaky networks keep their state between time steps
+  void setPersistentLeakyState(bool enable);
+
+  // Simulates the best possible genome in both double and float precision,
+  // logging the difference in fitness
+  void reportPrecision();
+
+  // Builds the ES-HyperNEAT networks of a fixed genome and of the
+  // population with both MultiNEAT and ESHyperNEAT::buildParallel,
+  // returning whether or not they are the same
+  bool checkESHyperNEAT();
+
+  // Builds ES-HyperNEAT networks with ESHyperNEAT::buildParallel instead
+  // of MultiNEAT. Only enabled if `checkESHyperNEAT` passes
+  void setParallelESHyperNEAT(bool enable);
+
+  // Exports the network of the best possible genome, together with how
+  // the experiment maps sensors and motors, to a file that can be run by
+  // ControllerRuntime
+  void exportController(const std::string& filename);
+
+  // Simulates the best possible genome, writing the sensors of the
+  // controller at every step so that generated code can be checked
+  void recordSensors(const std::string& controller,
+                     const std::string& filename);
+
 private:
   std::vector<Phenotype> mPhenotypes;
 
@@ -166,21 +309,64 @@ private:
   float        mBestPossibleFitness;
   unsigned int mBestPossibleFitnessGeneration;
 
-  bool            mDrawDebugNetworks;
-  bool            mRestartOnNextUpdate;
-  SimulationStage mSimulatingStage;
+  bool mDrawDebugNetworks;
+  bool mDrawLabels;
+  bool mRestartOnNextUpdate;
+  bool mHasSubmitted;
+  bool mSteadyState;
+
+  // Read by draw without taking the lock of the simulation thread
+  std::atomic<SimulationStage> mSimulatingStage;
 
   Statistics mStats;
 
+  // Networks of the previous generation, reused for unchanged genomes
+  NetworkCache mNetworkCache;
+
   NEAT::Genome mBestPossibleGenome;
 
   // Drawing settings
-  DrawingMethod mDrawingMethod;
-  bool          mDisableDrawing;
+  DrawingMethod     mDrawingMethod;
+  std::atomic<bool> mDisableDrawing;
 
   std::vector<size_t> mSpeciesLeaders;
   size_t              mBestIndex;
 
+  // Recording settings
+  RecordingMethod mRecordingMethod;
+  std::string     mRecordingDirectory;
+
+  // The replay being played and the spider it moves, together with the
+  // stage to go back to once it is stopped
+  Replay*         mReplay;
+  Spider*         mReplaySpider;
+  float           mReplayTime;
+  float           mReplaySpeed;
+  SimulationStage mStageBeforeReplay;
+
+  // Steady state information
+  std::vector<float> mSlotDurations;
+  size_t             mNumEvaluations;
+  size_t             mTimerEvaluations;
+  float              mEvaluationsPerSecond;
+  bool               mChangedBest;
+
+  // Networks of offspring that are still being built by the thread pool
+  std::vector<std::future<void>> mSlotBuilds;
+
+  std::chrono::steady_clock::time_point mEvaluationTimer;
+
+  // The simulation thread and what it needs to be stopped and locked
+  std::thread       mSimulationThread;
+  std::mutex        mMutex;
+  std::atomic<int>  mLocksWanted;
+  std::atomic<bool> mStopThread;
+  std::atomic<bool> mThreadStopped;
+
+  // The spiders to draw, captured after a step of the simulation
+  TripleBuffer<std::vector<SpiderRenderer::Instance>> mSnapshots;
+  std::atomic<bool>                                   mSnapshotWanted;
+
 // Save some memory if bullet has profiling on and therefore
 // does not allow for threading
 #ifdef BT_NO_PROFILE
@@ -189,16 +375,91 @@ private:
                      const Experiment&                experiment)>
     mWorker;
 
-  std::function<void(std::vector<Phenotype>::iterator begin,
-                     std::vector<Phenotype>::iterator end,
-                     const Experiment&                exp,
-                     NEAT::Population&                pop,
-                     Substrate&                       sub)>
+  std::function<void(std::vector<Phenotype*>::iterator begin,
+                     std::vector<Phenotype*>::iterator end,
+                     const Experiment&                 exp,
+                     NEAT::Population&                 pop,
+                     Substrate&                        sub)>
     mBuildingWorker;
 #endif
 
   void updateSimulation();
 
+  // Runs a single step of whatever is being simulated
+  void step(float deltaTime);
+
+  // Runs steps until the simulation thread is stopped
+  void simulationLoop();
+
+  // Captures the spiders to draw into the next snapshot, if it is wanted
+  void publishSnapshot();
+
+  // Appends the parts of every spider that should be drawn
+  void captureSpiders(std::vector<SpiderRenderer::Instance>& instances);
+
+  // Calls the function for each Phenotype of the drawing method
+  void forEachDrawn(
+    const std::function<void(Phenotype&, const mmm::vec3&)>& function);
+
+  // Advances the replay and moves its spider
+  void updateReplay(float deltaTime);
+
+  // Starts recording the Phenotype if the recording method selects it
+  void startRecording(Phenotype& p);
+
+  // Records the genomes of the generation the recording method selects
+  void recordGeneration(size_t bestIndex, bool changedBest);
+
+  // Simulates the genome again, recording it to a replay file
+  void recordGenome(unsigned int genomeId, unsigned int generation);
+
+  // Hands the generation to the workers and waits for all results
+  void updateDistributed();
+
+  // Whether or not evaluation is done by workers
+  bool isDistributed() const;
+
+  // Runs a step of every Phenotype, replacing those that have finished
+  // with new offspring
+  void updateSteadyState(float deltaTime);
+
+  // Gives the fitness of a finished Phenotype to its genome, returning
+  // false if the genome has been removed from the population
+  bool commitFitness(Phenotype& p);
+
+  // Replaces the worst individuals by new offspring, one for each slot,
+  // and starts building their networks on the thread pool
+  void replacePhenotypes(const std::vector<size_t>& slots);
+
+  // Looks up the indices of every Phenotype by its genome ID
+  void updateGenomeIndices();
+
+  // Picks the leaders of the species and the best among the running
+  // Phenotypes, which steady state does after every replacement
+  void updateRunningLeaders();
+
+  // Waits for every network that is being built for a slot
+  void waitForBuilds();
+
+  // Measures evaluations per second and logs the progress
+  void reportEvaluations(size_t numEvaluations);
+
+  // Simulates the network for the entire experiment on the main thread,
+  // returning its fitness
+  float evaluateNetwork(const NEAT::NeuralNetwork& network);
+
+  // Builds the network of the best possible genome
+  void buildBestNetwork(NEAT::NeuralNetwork& network);
+
+  // Builds the network of the genome with the current substrate
+  void buildNetwork(NEAT::Genome& genome, NEAT::NeuralNetwork& network);
+
+  // Finds the genome with the given ID, returning nullptr if it is
+  // no longer part of the population
+  NEAT::Genome* findGenome(unsigned int id,
+                           size_t&      speciesIndex,
+                           size_t&      individualIndex);
+
   // If called, it will use as many threads as possible to
   void updateUsingThreads(float deltaTime);
 
@@ -220,4 +481,10 @@ private:
   Substrate*        mSubstrate;
   NEAT::Population* mPopulation;
   Experiment*       mCurrentExperiment;
+  EvaluationMaster* mMaster;
+  IslandModel*      mIslands;
+  int               mSeed;
+
+  // Draws the spiders of every drawing method with instancing
+  SpiderRenderer* mRenderer;
 };
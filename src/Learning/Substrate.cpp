@@ -27,6 +27,18 @@ void Substrate::save(const std::string& filename) {
   if (!fs.is_open())
     throw std::runtime_error("Unable to open substrate file: " + filename);
 
+  save(fs);
+  fs.close();
+}
+
+/**
+ * @brief
+ *   Writes the substrate to the stream in the same format as the
+ *   substrate files.
+ *
+ * @param fs
+ */
+void Substrate::save(std::ostream& fs) {
   fs << saveValue("m_input_coords", m_input_coords) << std::endl;
   fs << saveValue("m_hidden_coords", m_hidden_coords) << std::endl;
   fs << saveValue("m_output_coords", m_output_coords) << std::endl;
@@ -59,8 +71,6 @@ void Substrate::save(const std::string& filename) {
   fs << saveValue("m_max_weight_and_bias", m_max_weight_and_bias) << std::endl;
   fs << saveValue("m_min_time_const", m_min_time_const) << std::endl;
   fs << saveValue("m_max_time_const", m_max_time_const) << std::endl;
-
-  fs.close();
 }
 
 /**
@@ -78,6 +88,17 @@ void Substrate::load(const std::string& filename) {
   if (!fs.is_open())
     throw std::runtime_error("Unable to open substrate file: " + filename);
 
+  load(fs);
+  fs.close();
+}
+
+/**
+ * @brief
+ *   Reads a substrate written by `save` from the stream.
+ *
+ * @param fs
+ */
+void Substrate::load(std::istream& fs) {
   std::map<std::string, std::string> entries;
   std::string line;
   size_t      lineNum = 0;
@@ -148,8 +169,6 @@ void Substrate::load(const std::string& filename) {
   }
 
   // Load each and every variable if they exist in the file
-
-  fs.close();
 }
 
 void Substrate::loadValue(const std::string& value, bool& t) {
@@ -1,6 +1,11 @@
 #pragma once
 
 #include <Substrate.h>
+#include <iomanip>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -32,7 +37,15 @@ public:
   // Loads the substrate from a given file
   void load(const std::string& filename);
 
+  // Writes / reads the substrate in the file format to / from a stream
+  void save(std::ostream& stream);
+  void load(std::istream& stream);
+
 private:
+  // Converts a number to string without losing any precision
+  template <typename T>
+  static std::string toString(T val);
+
   // Converts a generic value to string
   template <typename T>
   std::string saveValue(const std::string& name, T val);
@@ -58,9 +71,26 @@ private:
 // Below follow template definitons of saveValue
 // --------------------------------------------
 
+/**
+ * @brief
+ *   Unlike std::to_string, this writes floating point values with
+ *   enough digits to be read back exactly.
+ *
+ * @tparam T
+ * @param val
+ *
+ * @return
+ */
+template <typename T>
+std::string Substrate::toString(T val) {
+  std::ostringstream ss;
+  ss << std::setprecision(std::numeric_limits<T>::max_digits10) << val;
+  return ss.str();
+}
+
 template <typename T>
 std::string Substrate::saveValue(const std::string& name, T val) {
-  return name + " " + std::to_string(val);
+  return name + " " + toString(val);
 }
 
 /**
@@ -87,9 +117,9 @@ std::string Substrate::saveValue(const std::string&           name,
 
     for (unsigned int i = 0; i < vec.size(); i++) {
       if (i + 1 == vec.size())
-        final += std::to_string(vec[i]);
+        final += toString(vec[i]);
       else
-        final += std::to_string(vec[i]) + ",";
+        final += toString(vec[i]) + ",";
     }
 
     final += "]";
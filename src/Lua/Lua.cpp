@@ -2,6 +2,7 @@
 
 #include "../Console/Console.hpp"
 #include "../Engine.hpp"
+#include "../Graphical/FrameCapture.hpp"
 #include "../Utils/CFG.hpp"
 #include "../Utils/Utils.hpp"
 
@@ -107,6 +108,7 @@ namespace Lua {
       : Logging::Log("LuaEngine")
       , mConsole(nullptr)
       , mCFG(c)
+      , mFrameCapture(nullptr)
       , mNativeLibraries(n)
       , mEngineLibraries(e) {
     reInitialize();
@@ -353,6 +355,10 @@ namespace Lua {
                      sol::c_call<decltype(&LuaLib::Util::openUtil),
                                  &LuaLib::Util::openUtil>,
                      false);
+      engine.require("Util.FrameCapture",
+                     sol::c_call<decltype(&LuaLib::Util::openFrameCapture),
+                                 &LuaLib::Util::openFrameCapture>,
+                     false);
     }
 
     if (hasFlag(Lib::Engine::Learning, enginelib)) {
@@ -396,6 +402,9 @@ namespace Lua {
     engine["package"]["path"] = path + sep + "./lua/?.lua";
     engine["cfg"]             = mCFG;
 
+    if (mFrameCapture != nullptr)
+      engine["capture"] = mFrameCapture;
+
     loadFile("lua/main.lua");
 
     emit("reInitialize");
@@ -418,6 +427,21 @@ namespace Lua {
     engine["console"] = console;
   }
 
+  /**
+   * @brief
+   *   Adds the frame capture to global scope as a `capture` variable. The
+   *   pointer is stored, so it is added again by `reInitialize`, which
+   *   the states call whenever they are entered.
+   *
+   * @param capture
+   */
+  void Lua::add(FrameCapture* capture) {
+    mFrameCapture = capture;
+
+    if (capture != nullptr)
+      engine["capture"] = capture;
+  }
+
   /**
    * @brief
    *   This will try to load a filename. If it cannot find the file,
@@ -9,6 +9,7 @@
 class Engine;
 class CFG;
 class Console;
+class FrameCapture;
 
 namespace Input {
   class Input;
@@ -76,13 +77,17 @@ namespace Lua {
     //! Adds the console object to Lua, making it available to Lua runtime
     void add(Console* c);
 
+    //! Adds the frame capture to Lua as `capture`, keeping it through
+    //! reInitialize
+    void add(FrameCapture* f);
+
     // Loads one or more native libraries based on active bit fields
     void openLibraries(Lib::Native nativeLib);
 
     // Loads one more more engine libraries based on active bit fields
     void openLibraries(Lib::Engine engine);
 
-    //! Recreates the lua engine, adding the console and config
+    //! Recreates the lua engine, adding the config and frame capture
     //! objects and reruns the files that are loaded
     void reInitialize();
 
@@ -114,8 +119,9 @@ namespace Lua {
     bool shouldIncludeType(const std::string& name, const std::string& search);
 
     std::map<std::string, std::vector<EventHandler>> mHandlers;
-    Console* mConsole;
-    CFG*     mCFG;
+    Console*      mConsole;
+    CFG*          mCFG;
+    FrameCapture* mFrameCapture;
 
     Lib::Native mNativeLibraries;
     Lib::Engine mEngineLibraries;
@@ -13,6 +13,7 @@
 #include "../GUI/Slider.hpp"
 #include "../GUI/Text.hpp"
 #include "../GUI/Window.hpp"
+#include "../Graphical/FrameCapture.hpp"
 #include "../Input/Event.hpp"
 #include "../Input/Input.hpp"
 #include "../State/State.hpp"
@@ -1175,6 +1176,23 @@ sol::table LuaLib::Util::openUtil(sol::this_state state) {
   return module;
 }
 
+sol::table LuaLib::Util::openFrameCapture(sol::this_state state) {
+  sol::state_view lua(state);
+  sol::table      module = lua.create_table();
+
+  sol::constructors<> ctor;
+
+  sol::usertype<FrameCapture> type(ctor,
+    "start", &FrameCapture::start,
+    "stop", &FrameCapture::stop,
+    "isCapturing", &FrameCapture::isCapturing,
+    "numFrames", &FrameCapture::numFrames);
+
+  module.set_usertype("FrameCapture", type);
+
+  return module["FrameCapture"];
+}
+
 sol::table LuaLib::Learning::openLearning(sol::this_state state) {
   sol::state_view lua(state);
   sol::table      module = lua.create_table();
@@ -1190,6 +1208,11 @@ sol::table LuaLib::Learning::openLearning(sol::this_state state) {
    "BestFitness", SpiderSwarm::DrawingMethod::BestFitness,
    "DrawAll", SpiderSwarm::DrawingMethod::DrawAll,
    "DrawNone", SpiderSwarm::DrawingMethod::DrawNone);
+  module["RecordingMethod"] = lua.create_named_table("RecordingMethod",
+   "None", SpiderSwarm::RecordingMethod::None,
+   "SpeciesLeaders", SpiderSwarm::RecordingMethod::SpeciesLeaders,
+   "BestFitness", SpiderSwarm::RecordingMethod::BestFitness,
+   "All", SpiderSwarm::RecordingMethod::All);
 
   return module;
 }
@@ -1207,6 +1230,8 @@ sol::table LuaLib::Learning::openSpiderSwarm(sol::this_state state) {
     "substrate", &SpiderSwarm::substrate,
     "restart", &SpiderSwarm::restart,
     "setup", &SpiderSwarm::setup,
+    "setupIslands", &SpiderSwarm::setupIslands,
+    "setSeed", &SpiderSwarm::setSeed,
     "start", &SpiderSwarm::start,
     "stop", &SpiderSwarm::stop,
     "setDrawingMethod", &SpiderSwarm::setDrawingMethod,
@@ -1216,7 +1241,29 @@ sol::table LuaLib::Learning::openSpiderSwarm(sol::this_state state) {
     "disableDrawing", &SpiderSwarm::disableDrawing,
     "enableDrawing", &SpiderSwarm::enableDrawing,
     "toggleDrawANN", &SpiderSwarm::toggleDrawANN,
-    "currentDuration", &SpiderSwarm::currentDuration);
+    "toggleDrawLabels", &SpiderSwarm::toggleDrawLabels,
+    "currentDuration", &SpiderSwarm::currentDuration,
+    "listen", &SpiderSwarm::listen,
+    "stopListening", &SpiderSwarm::stopListening,
+    "setWorkerTimeout", &SpiderSwarm::setWorkerTimeout,
+    "setWorkerBatchSize", &SpiderSwarm::setWorkerBatchSize,
+    "setSteadyState", &SpiderSwarm::setSteadyState,
+    "isSteadyState", &SpiderSwarm::isSteadyState,
+    "evaluationsPerSecond", &SpiderSwarm::evaluationsPerSecond,
+    "setSparsification", &SpiderSwarm::setSparsification,
+    "reportSparsification", &SpiderSwarm::reportSparsification,
+    "setSinglePrecision", &SpiderSwarm::setSinglePrecision,
+    "setPersistentLeakyState", &SpiderSwarm::setPersistentLeakyState,
+    "reportPrecision", &SpiderSwarm::reportPrecision,
+    "checkESHyperNEAT", &SpiderSwarm::checkESHyperNEAT,
+    "setParallelESHyperNEAT", &SpiderSwarm::setParallelESHyperNEAT,
+    "exportController", &SpiderSwarm::exportController,
+    "loadChampion", &SpiderSwarm::loadChampion,
+    "recordSensors", &SpiderSwarm::recordSensors,
+    "setRecording", &SpiderSwarm::setRecording,
+    "playReplay", &SpiderSwarm::playReplay,
+    "setReplaySpeed", &SpiderSwarm::setReplaySpeed,
+    "setSimulationThread", &SpiderSwarm::setSimulationThread);
 
   module.set_usertype("SpiderSwarm", type);
 
@@ -119,6 +119,9 @@ namespace LuaLib {
     // Util exposes neat utility functions
     // that helps working with Lua and C++
     sol::table openUtil(sol::this_state state);
+
+    // Exposes the capturing of frames to video
+    sol::table openFrameCapture(sol::this_state state);
   }
 
   namespace Learning {
@@ -0,0 +1,396 @@
+#include "Socket.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Frames larger than this are considered to be garbage
+static const uint32_t MAX_FRAME_SIZE = 64 * 1024 * 1024;
+static const size_t   HEADER_SIZE    = 8;
+
+/**
+ * @brief
+ *   Resolves an address string into a socket address. Handles both the
+ *   `unix:/path` and the `host:port` format.
+ *
+ *   If the host is empty or `*` it will bind to any address
+ *
+ * @param address
+ * @param storage
+ * @param length
+ * @param unixPath
+ *
+ * @return
+ */
+static bool resolveAddress(const std::string& address,
+                           sockaddr_storage&  storage,
+                           socklen_t&         length,
+                           std::string&       unixPath) {
+  std::memset(&storage, 0, sizeof(storage));
+
+  if (address.compare(0, 5, "unix:") == 0) {
+    sockaddr_un* un = reinterpret_cast<sockaddr_un*>(&storage);
+    unixPath        = address.substr(5);
+
+    if (unixPath.size() >= sizeof(un->sun_path))
+      return false;
+
+    un->sun_family = AF_UNIX;
+    std::strncpy(un->sun_path, unixPath.c_str(), sizeof(un->sun_path) - 1);
+    length = sizeof(sockaddr_un);
+    return true;
+  }
+
+  size_t colon = address.find_last_of(':');
+
+  if (colon == std::string::npos)
+    return false;
+
+  std::string host = address.substr(0, colon);
+  std::string port = address.substr(colon + 1);
+
+  addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family   = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags    = AI_PASSIVE;
+
+  addrinfo* result = nullptr;
+  const char* node = host.empty() || host == "*" ? nullptr : host.c_str();
+
+  if (getaddrinfo(node, port.c_str(), &hints, &result) != 0 || !result)
+    return false;
+
+  std::memcpy(&storage, result->ai_addr, result->ai_addrlen);
+  length = result->ai_addrlen;
+  freeaddrinfo(result);
+  return true;
+}
+
+Socket::Socket() : Logging::Log("Socket"), mFd(-1) {}
+
+Socket::Socket(int fd) : Logging::Log("Socket"), mFd(fd) {}
+
+Socket::~Socket() {
+  close();
+}
+
+/**
+ * @brief
+ *   Binds the socket to the given address and starts listening. The
+ *   listening socket is non-blocking so that `accept` can be polled.
+ *
+ * @param address
+ * @param backlog
+ *
+ * @return
+ */
+bool Socket::listen(const std::string& address, int backlog) {
+  sockaddr_storage storage;
+  socklen_t        length;
+
+  close();
+  mBuffer.clear();
+
+  if (!resolveAddress(address, storage, length, mUnixPath)) {
+    mLog->error("Invalid address: {}", address);
+    return false;
+  }
+
+  mFd = ::socket(storage.ss_family, SOCK_STREAM, 0);
+
+  if (mFd < 0) {
+    mLog->error("Unable to create socket: {}", std::strerror(errno));
+    return false;
+  }
+
+  if (storage.ss_family == AF_UNIX) {
+    ::unlink(mUnixPath.c_str());
+  } else {
+    int yes = 1;
+    ::setsockopt(mFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  }
+
+  if (::bind(mFd, reinterpret_cast<sockaddr*>(&storage), length) < 0 ||
+      ::listen(mFd, backlog) < 0) {
+    mLog->error("Unable to listen on {}: {}", address, std::strerror(errno));
+    close();
+    return false;
+  }
+
+  setBlocking(false);
+  mLog->info("Listening on {}", address);
+  return true;
+}
+
+/**
+ * @brief
+ *   Connects to a listening socket on the given address. The socket
+ *   is left in blocking mode.
+ *
+ * @param address
+ *
+ * @return
+ */
+bool Socket::connect(const std::string& address) {
+  sockaddr_storage storage;
+  socklen_t        length;
+  std::string      unixPath;
+
+  close();
+  mBuffer.clear();
+
+  if (!resolveAddress(address, storage, length, unixPath)) {
+    mLog->error("Invalid address: {}", address);
+    return false;
+  }
+
+  mFd = ::socket(storage.ss_family, SOCK_STREAM, 0);
+
+  if (mFd < 0) {
+    mLog->error("Unable to create socket: {}", std::strerror(errno));
+    return false;
+  }
+
+  if (::connect(mFd, reinterpret_cast<sockaddr*>(&storage), length) < 0) {
+    mLog->error("Unable to connect to {}: {}", address, std::strerror(errno));
+    close();
+    return false;
+  }
+
+  if (storage.ss_family != AF_UNIX) {
+    int yes = 1;
+    ::setsockopt(mFd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+  }
+
+  return true;
+}
+
+/**
+ * @brief
+ *   Accepts a pending connection if there is any. The returned socket
+ *   is non-blocking, just like the listening socket.
+ *
+ * @return
+ */
+Socket* Socket::accept() {
+  if (mFd < 0)
+    return nullptr;
+
+  int fd = ::accept(mFd, nullptr, nullptr);
+
+  if (fd < 0)
+    return nullptr;
+
+  Socket* socket = new Socket(fd);
+  socket->setBlocking(false);
+  return socket;
+}
+
+/**
+ * @brief
+ *   Closes the socket if it is open. If the socket was listening
+ *   on a Unix socket, the socket file is removed.
+ *
+ *   Frames that have already been read can still be popped afterwards.
+ */
+void Socket::close() {
+  if (mFd < 0)
+    return;
+
+  ::close(mFd);
+  mFd = -1;
+
+  if (!mUnixPath.empty()) {
+    ::unlink(mUnixPath.c_str());
+    mUnixPath.clear();
+  }
+}
+
+bool Socket::isOpen() const {
+  return mFd >= 0;
+}
+
+int Socket::fd() const {
+  return mFd;
+}
+
+void Socket::setBlocking(bool blocking) {
+  if (mFd < 0)
+    return;
+
+  int flags = ::fcntl(mFd, F_GETFL, 0);
+  flags     = blocking ? flags & ~O_NONBLOCK : flags | O_NONBLOCK;
+  ::fcntl(mFd, F_SETFL, flags);
+}
+
+/**
+ * @brief
+ *   Writes all of the data to the socket, retrying on partial writes.
+ *   Waits for the socket to become writable if it is non-blocking.
+ *
+ * @param data
+ * @param size
+ *
+ * @return
+ */
+bool Socket::writeAll(const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t written = ::send(mFd, data, size, MSG_NOSIGNAL);
+
+    if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      fd_set set;
+      FD_ZERO(&set);
+      FD_SET(mFd, &set);
+      ::select(mFd + 1, nullptr, &set, nullptr, nullptr);
+      continue;
+    }
+
+    if (written < 0 && errno == EINTR)
+      continue;
+
+    if (written <= 0)
+      return false;
+
+    data += written;
+    size -= written;
+  }
+
+  return true;
+}
+
+/**
+ * @brief
+ *   Sends a frame of the given type.
+ *
+ * @param type
+ * @param payload
+ *
+ * @return
+ */
+bool Socket::send(uint32_t type, const std::string& payload) {
+  if (mFd < 0)
+    return false;
+
+  uint32_t header[2] = { htonl(type), htonl(payload.size()) };
+
+  if (!writeAll(reinterpret_cast<const char*>(header), HEADER_SIZE) ||
+      !writeAll(payload.data(), payload.size())) {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief
+ *   Blocks until a whole frame has been read from the socket.
+ *
+ *   Returns false if the connection was closed before a whole
+ *   frame could be read.
+ *
+ * @param type
+ * @param payload
+ *
+ * @return
+ */
+bool Socket::receive(uint32_t& type, std::string& payload) {
+  char buffer[4096];
+
+  while (!pop(type, payload)) {
+    if (mFd < 0)
+      return false;
+
+    ssize_t size = ::recv(mFd, buffer, sizeof(buffer), 0);
+
+    if (size < 0 && errno == EINTR)
+      continue;
+
+    if (size <= 0) {
+      close();
+      return false;
+    }
+
+    mBuffer.append(buffer, size);
+  }
+
+  return true;
+}
+
+/**
+ * @brief
+ *   Reads everything that is available on the socket into the internal
+ *   buffer without blocking.
+ *
+ *   Returns false if the other end has closed the connection
+ *
+ * @return
+ */
+bool Socket::pump() {
+  char buffer[4096];
+
+  while (mFd >= 0) {
+    ssize_t size = ::recv(mFd, buffer, sizeof(buffer), MSG_DONTWAIT);
+
+    if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return true;
+
+    if (size < 0 && errno == EINTR)
+      continue;
+
+    if (size <= 0) {
+      close();
+      return false;
+    }
+
+    mBuffer.append(buffer, size);
+  }
+
+  return false;
+}
+
+/**
+ * @brief
+ *   Pops the first complete frame from the internal buffer.
+ *
+ *   Returns false if there is no complete frame. If the frame header
+ *   is invalid, the connection is closed.
+ *
+ * @param type
+ * @param payload
+ *
+ * @return
+ */
+bool Socket::pop(uint32_t& type, std::string& payload) {
+  if (mBuffer.size() < HEADER_SIZE)
+    return false;
+
+  uint32_t header[2];
+  std::memcpy(header, mBuffer.data(), HEADER_SIZE);
+
+  uint32_t length = ntohl(header[1]);
+
+  if (length > MAX_FRAME_SIZE) {
+    mLog->error("Received frame of invalid size: {}", length);
+    close();
+    return false;
+  }
+
+  if (mBuffer.size() < HEADER_SIZE + length)
+    return false;
+
+  type    = ntohl(header[0]);
+  payload = mBuffer.substr(HEADER_SIZE, length);
+  mBuffer.erase(0, HEADER_SIZE + length);
+
+  return true;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "../Log.hpp"
+
+/**
+ * @brief
+ *   A thin wrapper around a POSIX stream socket that sends and receives
+ *   length-prefixed frames.
+ *
+ *   Addresses are given as strings and can either be a TCP address in the
+ *   format `host:port` or a Unix domain socket in the format `unix:/path`.
+ *   The latter is the easiest way of running several workers on one machine.
+ *
+ *   Each frame consists of a 4 byte type, a 4 byte length and the payload
+ *   itself. Both of the integers are sent in network byte order.
+ *
+ *   The socket can be used both in a blocking fashion, through `send` and
+ *   `receive`, and in a non-blocking fashion, through `pump` and `pop`,
+ *   which is useful when the socket is polled from the main loop.
+ */
+class Socket : public Logging::Log {
+public:
+  Socket();
+  explicit Socket(int fd);
+  ~Socket();
+
+  Socket(const Socket&) = delete;
+  Socket& operator=(const Socket&) = delete;
+
+  // Binds the socket to an address and starts listening on it
+  bool listen(const std::string& address, int backlog = 16);
+
+  // Connects the socket to a listening socket at the given address
+  bool connect(const std::string& address);
+
+  // Accepts a pending connection, returning nullptr if there is none.
+  // The caller owns the returned socket
+  Socket* accept();
+
+  // Closes the socket. Removes the file if listening on a Unix socket
+  void close();
+
+  // Whether or not the socket is open
+  bool isOpen() const;
+
+  // Returns the file descriptor of the socket
+  int fd() const;
+
+  // Sets whether or not calls on the socket should block
+  void setBlocking(bool blocking);
+
+  // Sends a whole frame, blocking until it has been written
+  bool send(uint32_t type, const std::string& payload);
+
+  // Blocks until a whole frame has been received
+  bool receive(uint32_t& type, std::string& payload);
+
+  // Reads all the data that is currently available without blocking.
+  // Returns false if the connection has been closed
+  bool pump();
+
+  // Pops a frame that has been completely read by `pump`, if any
+  bool pop(uint32_t& type, std::string& payload);
+
+private:
+  bool writeAll(const char* data, size_t size);
+
+  int         mFd;
+  std::string mUnixPath;
+  std::string mBuffer;
+};
@@ -0,0 +1,47 @@
+#include "FontAtlas.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+/**
+ * @brief
+ *   Bakes the distance field atlas of a font ahead of time, so that the
+ *   engine can load it instead of rasterizing the font on start:
+ *
+ *   BakeFontAtlas media/Fonts/DejaVuSansMono.ttf
+ *
+ *   The atlas is written next to the font, where Font looks for it, unless
+ *   another output is given.
+ *
+ * @param argc
+ * @param argv
+ *
+ * @return
+ */
+int main(int argc, char* argv[]) {
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: " << argv[0] << " <font> [atlas]" << std::endl;
+    return 1;
+  }
+
+  std::string font   = argv[1];
+  std::string output = argc == 3 ? argv[2] : font + ".sdf";
+  FT_Library  library;
+
+  if (FT_Init_FreeType(&library)) {
+    std::cerr << "FreeType not initialized correctly" << std::endl;
+    return 1;
+  }
+
+  int status = 0;
+
+  try {
+    FontAtlas::generate(library, font).save(output);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    status = 1;
+  }
+
+  FT_Done_FreeType(library);
+  return status;
+}
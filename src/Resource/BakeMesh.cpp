@@ -0,0 +1,38 @@
+#include "MeshData.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+/**
+ * @brief
+ *   Imports a model and writes the cache that Mesh reads instead, so that
+ *   the engine never has to run Assimp on start:
+ *
+ *   BakeMesh media/models/spider.dae
+ *
+ *   The cache is written next to the model, where Mesh looks for it,
+ *   unless another output is given.
+ *
+ * @param argc
+ * @param argv
+ *
+ * @return
+ */
+int main(int argc, char* argv[]) {
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: " << argv[0] << " <model> [cache]" << std::endl;
+    return 1;
+  }
+
+  std::string model  = argv[1];
+  std::string output = argc == 3 ? argv[2] : model + ".mesh";
+
+  try {
+    MeshData::import(model).save(output, model);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
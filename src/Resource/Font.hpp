@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <mutex>
 
 #include "../OpenGLHeaders.hpp"
 #include <mmm.hpp>
@@ -9,22 +10,28 @@
 #include FT_FREETYPE_H
 
 #include "../Log.hpp"
+#include "FontAtlas.hpp"
 #include "Resource.hpp"
 
-class Program;
 class Texture;
 
+/**
+ * @brief
+ *   A font drawn from a signed distance field atlas. The atlas is created
+ *   once per font at FontAtlas::SIZE and every character size is drawn
+ *   from it by scaling the glyphs, so a new size never rasterizes the font
+ *   or uploads a texture.
+ *
+ *   The atlas is read from `<font>.sdf` if it has been baked with
+ *   BakeFontAtlas. Otherwise it is generated from the font and written
+ *   there for the next time.
+ */
 class Font : public Resource, public Logging::Log {
 public:
+  static constexpr ResourceType TYPE = ResourceType::Font;
+
   //! Represents a character within the font.
-  struct Glyph {
-    Glyph();
-    Glyph(FT_GlyphSlot& gs, const mmm::vec2& offset, const mmm::vec2& size);
-    mmm::vec2 advance;
-    mmm::vec2 bitmapSize;
-    mmm::vec2 bitmapLoc;
-    mmm::vec2 tc;
-  };
+  using Glyph = FontAtlas::Glyph;
 
   Font();
 
@@ -32,43 +39,36 @@ public:
   //! If it is the last font object alive, it will deinitalize FreeType
   ~Font();
 
-  // Default handler, calls load with 12
+  // Loads the atlas and uploads it as a texture
   bool load(ResourceManager*);
 
-  //! Loads a font from file and converts it to a OpenGL texture
-  bool load(int size);
+  // Reads or generates the atlas, leaving only the upload to load
+  bool prepare();
 
   // unloads all the resources
   void unload();
 
-  //! Gets a glyph, if it does not exists loads
-  //! the entire bitmap for that size
-  const Font::Glyph& getGlyph(unsigned int c, int size);
+  //! Gets a glyph scaled to the size
+  Font::Glyph getGlyph(unsigned int c, int size);
 
   //! Returns the metric values (Line spacing etc) for character size
-  const mmm::vec2& getMetrics(int size);
+  mmm::vec2 getMetrics(int size);
 
-  //! Returns a texture, it it does not exists,
-  //! loads the entire bitmap for that size
+  //! Returns the atlas texture, which is the same for every size
   Texture* getTexture(int size);
 
 private:
-  struct Page {
-    Page();
-    ~Page();
-
-    Texture*  texture;
-    mmm::vec2 metrics;
-    std::map<unsigned int, Glyph> glyphs;
+  // Reads the baked atlas, or generates it from the font
+  FontAtlas loadAtlas();
 
-  private:
-    Page(const Page& p);
-    Page& operator=(const Page&);
-  };
+  Texture*                      mTexture;
+  mmm::vec2                     mMetrics;
+  std::map<unsigned int, Glyph> mGlyphs;
 
-  std::map<unsigned int, Page> mPages;
-  FT_Face mFace;
+  // The atlas between prepare and load
+  FontAtlas mAtlas;
 
   static int        numFonts;
   static FT_Library fontLib;
+  static std::mutex fontLibMutex;
 };
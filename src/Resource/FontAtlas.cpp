@@ -0,0 +1,374 @@
+#include "FontAtlas.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+  const char     MAGIC[4] = { 'S', 'D', 'F', 'A' };
+  const uint32_t VERSION  = 1;
+
+  // Width of the atlas before a new row of glyphs is started
+  const unsigned int MAX_WIDTH = 1024;
+
+  // The offset from a pixel to the closest pixel of the other kind
+  struct Offset {
+    int x;
+    int y;
+
+    int distanceSquared() const { return x * x + y * y; }
+  };
+
+  /**
+   * @brief
+   *   A two pass, eight neighbour sequential euclidean distance transform.
+   *   Each pixel ends up with the offset to the closest pixel where
+   *   `isTarget` is true.
+   */
+  class DistanceField {
+  public:
+    DistanceField(const std::vector<bool>& isTarget, int width, int height)
+        : mWidth(width), mHeight(height), mGrid(width * height) {
+      for (size_t i = 0; i < mGrid.size(); ++i)
+        mGrid[i] = isTarget[i] ? Offset{ 0, 0 } : Offset{ FAR, FAR };
+
+      for (int y = 0; y < mHeight; ++y) {
+        for (int x = 0; x < mWidth; ++x) {
+          compare(x, y, -1, 0);
+          compare(x, y, 0, -1);
+          compare(x, y, -1, -1);
+          compare(x, y, 1, -1);
+        }
+
+        for (int x = mWidth - 1; x >= 0; --x)
+          compare(x, y, 1, 0);
+      }
+
+      for (int y = mHeight - 1; y >= 0; --y) {
+        for (int x = mWidth - 1; x >= 0; --x) {
+          compare(x, y, 1, 0);
+          compare(x, y, 0, 1);
+          compare(x, y, -1, 1);
+          compare(x, y, 1, 1);
+        }
+
+        for (int x = 0; x < mWidth; ++x)
+          compare(x, y, -1, 0);
+      }
+    }
+
+    float distance(int x, int y) const {
+      return std::sqrt(
+        static_cast<float>(mGrid[y * mWidth + x].distanceSquared()));
+    }
+
+  private:
+    // Larger than any glyph, but small enough to never overflow
+    static const int FAR = 10000;
+
+    void compare(int x, int y, int offsetX, int offsetY) {
+      int nx = x + offsetX;
+      int ny = y + offsetY;
+
+      if (nx < 0 || ny < 0 || nx >= mWidth || ny >= mHeight)
+        return;
+
+      Offset other = mGrid[ny * mWidth + nx];
+      other.x += offsetX;
+      other.y += offsetY;
+
+      Offset& current = mGrid[y * mWidth + x];
+
+      if (other.distanceSquared() < current.distanceSquared())
+        current = other;
+    }
+
+    int                 mWidth;
+    int                 mHeight;
+    std::vector<Offset> mGrid;
+  };
+
+  /**
+   * @brief
+   *   Converts the coverage bitmap of a glyph into a distance field that
+   *   is SPREAD pixels larger on each side, so that the distance outside
+   *   the glyph can be stored too.
+   *
+   * @param bitmap
+   *
+   * @return
+   */
+  std::vector<unsigned char> toDistanceField(const FT_Bitmap& bitmap) {
+    int spread = FontAtlas::SPREAD;
+    int width  = bitmap.width + 2 * spread;
+    int height = bitmap.rows + 2 * spread;
+
+    std::vector<bool> inside(width * height, false);
+    std::vector<bool> outside(width * height, true);
+
+    for (unsigned int y = 0; y < bitmap.rows; ++y) {
+      for (unsigned int x = 0; x < bitmap.width; ++x) {
+        size_t i = (y + spread) * width + x + spread;
+
+        inside[i]  = bitmap.buffer[y * bitmap.pitch + x] >= 128;
+        outside[i] = !inside[i];
+      }
+    }
+
+    DistanceField toInside(inside, width, height);
+    DistanceField toOutside(outside, width, height);
+
+    std::vector<unsigned char> field(width * height);
+
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        float distance = toOutside.distance(x, y) - toInside.distance(x, y);
+        float value    = 0.5f + distance / (2.0f * spread);
+
+        field[y * width + x] =
+          static_cast<unsigned char>(std::min(std::max(value, 0.0f), 1.0f) *
+                                     255.0f);
+      }
+    }
+
+    return field;
+  }
+
+  template <typename T>
+  void write(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  void read(std::ifstream& file, T& value) {
+    file.read(reinterpret_cast<char*>(&value), sizeof(T));
+  }
+
+  void write(std::ofstream& file, const mmm::vec2& value) {
+    write(file, value.x);
+    write(file, value.y);
+  }
+
+  void read(std::ifstream& file, mmm::vec2& value) {
+    read(file, value.x);
+    read(file, value.y);
+  }
+}
+
+/**
+ * @brief
+ *   Scales the glyph from the size of the atlas to the given size. The
+ *   texture coordinates stay the same, since every size uses the same
+ *   atlas.
+ *
+ * @param size
+ *
+ * @return
+ */
+FontAtlas::Glyph FontAtlas::Glyph::scaled(int size) const {
+  float scale = static_cast<float>(size) / SIZE;
+
+  return { advance * scale, bitmapSize * scale, bitmapLoc * scale, tc, tcSize };
+}
+
+/**
+ * @brief
+ *   Rasterizes the first 256 characters of the font at SIZE and converts
+ *   each of them into a distance field, packing them into rows of at most
+ *   MAX_WIDTH pixels.
+ *
+ * @param library
+ * @param font
+ *
+ * @return
+ */
+FontAtlas FontAtlas::generate(FT_Library library, const std::string& font) {
+  FT_Face face;
+
+  if (FT_New_Face(library, font.c_str(), 0, &face))
+    throw std::runtime_error("Unable to load font: " + font);
+
+  FT_Set_Char_Size(face, SIZE * 64, 0, 96, 0);
+  FT_GlyphSlot g = face->glyph;
+
+  struct Rasterized {
+    unsigned int               code;
+    Glyph                      glyph;
+    std::vector<unsigned char> field;
+    mmm::vec2                  offset;
+  };
+
+  std::vector<Rasterized> rasterized;
+
+  unsigned int offsetX = 0;
+  unsigned int offsetY = 0;
+  unsigned int rowH    = 0;
+  unsigned int width   = 0;
+  float        widest  = 0;
+
+  FT_UInt  glyphIndex;
+  FT_ULong charCode = FT_Get_First_Char(face, &glyphIndex);
+
+  for (; glyphIndex != 0 && charCode <= 255;
+       charCode = FT_Get_Next_Char(face, charCode, &glyphIndex)) {
+    if (FT_Load_Char(face, charCode, FT_LOAD_RENDER))
+      continue;
+
+    Rasterized r;
+    r.code             = charCode;
+    r.glyph.advance    = mmm::vec2(g->advance.x >> 6, g->advance.y >> 6);
+    r.glyph.bitmapSize = mmm::vec2(0);
+    r.glyph.bitmapLoc  = mmm::vec2(g->bitmap_left, g->bitmap_top);
+    r.glyph.tc         = mmm::vec2(0);
+    r.glyph.tcSize     = mmm::vec2(0);
+    r.offset           = mmm::vec2(0);
+
+    widest = std::max(widest, static_cast<float>(g->bitmap.width));
+
+    // Glyphs without pixels, like space, only need their advance
+    if (g->bitmap.width == 0 || g->bitmap.rows == 0) {
+      rasterized.push_back(r);
+      continue;
+    }
+
+    unsigned int w = g->bitmap.width + 2 * SPREAD;
+    unsigned int h = g->bitmap.rows + 2 * SPREAD;
+
+    if (offsetX + w + 1 >= MAX_WIDTH) {
+      offsetY += rowH;
+      offsetX = 0;
+      rowH    = 0;
+    }
+
+    r.field            = toDistanceField(g->bitmap);
+    r.offset           = mmm::vec2(offsetX, offsetY);
+    r.glyph.bitmapSize = mmm::vec2(w, h);
+    r.glyph.bitmapLoc  = r.glyph.bitmapLoc + mmm::vec2(-SPREAD, SPREAD);
+    rasterized.push_back(r);
+
+    offsetX += w + 1;
+    rowH  = std::max(rowH, h);
+    width = std::max(width, offsetX);
+  }
+
+  FontAtlas atlas;
+  atlas.size    = mmm::vec2(width, offsetY + rowH);
+  atlas.metrics = mmm::vec2(widest, face->size->metrics.height >> 6);
+  atlas.pixels.assign(width * (offsetY + rowH), 0);
+
+  FT_Done_Face(face);
+
+  for (auto& r : rasterized) {
+    unsigned int w = r.glyph.bitmapSize.x;
+    unsigned int h = r.glyph.bitmapSize.y;
+    unsigned int x = r.offset.x;
+    unsigned int y = r.offset.y;
+
+    for (unsigned int row = 0; row < h; ++row)
+      std::copy(r.field.begin() + row * w,
+                r.field.begin() + (row + 1) * w,
+                atlas.pixels.begin() + (y + row) * width + x);
+
+    if (w != 0) {
+      r.glyph.tc     = r.offset / atlas.size;
+      r.glyph.tcSize = r.glyph.bitmapSize / atlas.size;
+    }
+
+    atlas.glyphs[r.code] = r.glyph;
+  }
+
+  return atlas;
+}
+
+/**
+ * @brief
+ *   Loads an atlas from file. Atlases baked with another SIZE or SPREAD
+ *   are rejected, since the shader depends on the spread.
+ *
+ * @param filename
+ *
+ * @return
+ */
+FontAtlas FontAtlas::load(const std::string& filename) {
+  std::ifstream file(filename, std::ios::in | std::ios::binary);
+
+  if (!file.is_open())
+    throw std::runtime_error("Unable to open font atlas: " + filename);
+
+  char     magic[4];
+  uint32_t version, size, spread, numGlyphs;
+
+  file.read(magic, 4);
+  read(file, version);
+  read(file, size);
+  read(file, spread);
+
+  if (!file || !std::equal(magic, magic + 4, MAGIC) || version != VERSION ||
+      size != SIZE || spread != SPREAD)
+    throw std::runtime_error("Font atlas is outdated: " + filename);
+
+  FontAtlas atlas;
+  read(file, atlas.size);
+  read(file, atlas.metrics);
+  read(file, numGlyphs);
+
+  for (uint32_t i = 0; i < numGlyphs; ++i) {
+    uint32_t code;
+    Glyph    glyph;
+
+    read(file, code);
+    read(file, glyph.advance);
+    read(file, glyph.bitmapSize);
+    read(file, glyph.bitmapLoc);
+    read(file, glyph.tc);
+    read(file, glyph.tcSize);
+
+    atlas.glyphs[code] = glyph;
+  }
+
+  atlas.pixels.resize(atlas.size.x * atlas.size.y);
+  file.read(reinterpret_cast<char*>(atlas.pixels.data()),
+            atlas.pixels.size());
+
+  if (!file)
+    throw std::runtime_error("Font atlas is truncated: " + filename);
+
+  return atlas;
+}
+
+/**
+ * @brief
+ *   Saves the atlas in a binary format that can be read by load
+ *
+ * @param filename
+ */
+void FontAtlas::save(const std::string& filename) const {
+  std::ofstream file(filename, std::ios::out | std::ios::binary);
+
+  if (!file.is_open())
+    throw std::runtime_error("Unable to write font atlas: " + filename);
+
+  file.write(MAGIC, 4);
+  write(file, VERSION);
+  write(file, static_cast<uint32_t>(SIZE));
+  write(file, static_cast<uint32_t>(SPREAD));
+  write(file, size);
+  write(file, metrics);
+  write(file, static_cast<uint32_t>(glyphs.size()));
+
+  for (auto& g : glyphs) {
+    write(file, static_cast<uint32_t>(g.first));
+    write(file, g.second.advance);
+    write(file, g.second.bitmapSize);
+    write(file, g.second.bitmapLoc);
+    write(file, g.second.tc);
+    write(file, g.second.tcSize);
+  }
+
+  file.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+
+  if (!file)
+    throw std::runtime_error("Unable to write font atlas: " + filename);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <mmm.hpp>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+/**
+ * @brief
+ *   A signed distance field atlas of the first 256 characters of a font.
+ *
+ *   Instead of the coverage of each pixel, the atlas stores the distance
+ *   from the pixel to the outline of the glyph, where 0.5 is on the
+ *   outline and larger values are inside. Since the distance can be
+ *   interpolated, the shader can draw the glyphs sharply at any size from
+ *   the one atlas, which is rasterized once at SIZE.
+ *
+ *   The atlas only depends on FreeType, so that it can be baked to disk
+ *   ahead of time by BakeFontAtlas.
+ */
+struct FontAtlas {
+  // The size, in points, the glyphs are rasterized at
+  static const int SIZE = 48;
+
+  // How far from the outline, in pixels, distances are stored
+  static const int SPREAD = 8;
+
+  //! Represents a character within the font, in pixels at the size of the
+  //! atlas unless it has been scaled
+  struct Glyph {
+    mmm::vec2 advance;
+    mmm::vec2 bitmapSize;
+    mmm::vec2 bitmapLoc;
+    mmm::vec2 tc;
+    mmm::vec2 tcSize;
+
+    // Returns the glyph scaled to the given size, in points
+    Glyph scaled(int size) const;
+  };
+
+  // Rasterizes the font file into an atlas
+  static FontAtlas generate(FT_Library library, const std::string& font);
+
+  // Loads an atlas saved by save, throws if it cannot be read or if it
+  // was baked with different settings
+  static FontAtlas load(const std::string& filename);
+
+  // Saves the atlas to file
+  void save(const std::string& filename) const;
+
+  // Width and height of the atlas in pixels
+  mmm::vec2 size;
+
+  // The widest glyph and the line height, at the size of the atlas
+  mmm::vec2 metrics;
+
+  std::map<unsigned int, Glyph> glyphs;
+  std::vector<unsigned char>    pixels;
+};
@@ -6,15 +6,16 @@
 
 #include <limits>
 
-#include <assimp/Importer.hpp>
-#include <assimp/postprocess.h>
-#include <assimp/scene.h>
-
 using mmm::mat4;
 
 size_t Mesh::npos = std::numeric_limits<unsigned int>::max();
 
-Mesh::Mesh() : Logging::Log("Mesh"), mVBO(0), mVAO(0) {}
+Mesh::Mesh()
+    : Logging::Log("Mesh")
+    , mVBO(0)
+    , mVAO(0)
+    , mIsBound(false)
+    , mIsPrepared(false) {}
 
 Mesh::~Mesh() {
   unload();
@@ -22,9 +23,61 @@ Mesh::~Mesh() {
 
 /**
  * @brief
- *   Loads the mesh by reading it from the filename that was given
- *   to it by the resource manager. The mesh is then divided into
- *   submeshes that are all stored within one object.
+ *   Reads the vertices and nodes of the mesh from its cache, or imports
+ *   them from the model. This is the slow part of loading a mesh and does
+ *   not need OpenGL, so it can be done on a worker thread before `load`
+ *   is called.
+ *
+ * @return
+ */
+bool Mesh::prepare() {
+  if (mIsPrepared)
+    return true;
+
+  try {
+    mPrepared = loadData();
+  } catch (const std::runtime_error& e) {
+    mLog->error(e.what());
+    return false;
+  }
+
+  mIsPrepared = true;
+  return true;
+}
+
+/**
+ * @brief
+ *   Returns the cached data of the model. If there is no cache, or the
+ *   model has changed since it was made, the model is imported through
+ *   Assimp and the cache is written for the next time.
+ *
+ * @return
+ */
+MeshData Mesh::loadData() {
+  std::string cache = filename() + ".mesh";
+
+  try {
+    return MeshData::load(cache, filename());
+  } catch (const std::runtime_error& e) {
+    mLog->debug("{}, importing the model", e.what());
+  }
+
+  MeshData data = MeshData::import(filename());
+
+  try {
+    data.save(cache, filename());
+  } catch (const std::runtime_error& e) {
+    mLog->warn(e.what());
+  }
+
+  return data;
+}
+
+/**
+ * @brief
+ *   Loads the mesh from the data read by `prepare`, which is called
+ *   first if it has not been already. The mesh is divided into submeshes
+ *   that are all stored within one object.
  *
  *   The submeshes may have a texture or more children associated
  *   with it.
@@ -37,27 +90,16 @@ Mesh::~Mesh() {
  * @return
  */
 bool Mesh::load(ResourceManager* manager) {
-  Assimp::Importer importer;
-  const aiScene*   scene =
-    importer.ReadFile(filename().c_str(), aiProcess_Triangulate
-                      // aiProcess_MakeLeftHanded |
-                      // aiProcess_OptimizeGraph |
-                      //   aiProcess_OptimizeMeshes
-                      // aiProcess_CalcTangentSpace |
-                      // aiProcess_GenUVCoords |
-                      // aiProcess_ValidateDataStructure |
-                      // aiProcess_PreTransformVertices |
-                      // aiProcess_SplitLargeMeshes |
-                      // aiProcess_RemoveComponent
-                      );
-
-  if (!scene) {
-    mLog->error("Unable to load mesh: {}", filename());
+  if (!mIsPrepared && !prepare())
     return false;
-  }
 
-  addSubMesh(
-    SubMesh(this, manager, scene, scene->mRootNode, mmm::mat4::identity));
+  mData = std::move(mPrepared.vertices);
+
+  for (auto& node : mPrepared.nodes)
+    addSubMesh(SubMesh(this, manager, node));
+
+  mPrepared   = MeshData();
+  mIsPrepared = false;
 
   mLog->debug("Loaded '{}': {} vertices", filename(), numVertices());
 
@@ -264,115 +306,40 @@ SubMesh::SubMesh()
 
 /**
  * @brief
- *   Creates a submesh that it extracts from
- *   the scene
+ *   Creates a submesh from a node of the mesh data, looking up the
+ *   textures of its materials
  *
  * @param model
  * @param manager
- * @param scene
  * @param node
- * @param transform
  */
-SubMesh::SubMesh(Mesh*            model,
-                 ResourceManager* manager,
-                 const aiScene*   scene,
-                 const aiNode*    node,
-                 mmm::mat4        transform)
+SubMesh::SubMesh(Mesh*                 model,
+                 ResourceManager*      manager,
+                 const MeshData::Node& node)
     : Logging::Log("SubMesh")
-    , mStartIndex(model->numVertices())
-    , mSize(0)
-    , mIndex(model->numSubMeshes())
-    , mName("")
-    , mTransform(mmm::mat4::identity)
+    , mStartIndex(node.startIndex)
+    , mSize(node.size)
+    , mIndex(node.index)
+    , mName(node.name)
+    , mTransform(node.transform)
     , mParent(model) {
-  aiMatrix4x4 am = node->mTransformation;
-  mTransform     = transform * mat4(am.a1,
-                                am.a2,
-                                am.a3,
-                                am.a4,
-                                am.b1,
-                                am.b2,
-                                am.b3,
-                                am.b4,
-                                am.c1,
-                                am.c2,
-                                am.c3,
-                                am.c4,
-                                am.d1,
-                                am.d2,
-                                am.d3,
-                                am.d4);
-
-  // Add name if it exists
-  if (node->mName.length != 0)
-    mName = std::string(node->mName.C_Str());
-
-  // parse the node
-  std::vector<std::string> textureNames;
-
-  // When a mesh is exported and has multiple materials for that mesh, assimp
-  // splits it into multiple smaller meshes where each mesh has one material
-  // assigned to it.
-  //
-  // This goes through all meshes and loads them together with
-  // their material
-  for (unsigned int i = 0; i < node->mNumMeshes; i += 1) {
-    const aiMesh*     mesh     = scene->mMeshes[node->mMeshes[i]];
-    const aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-
-    int startIndex  = model->numVertices();
-    int numTextures = material->GetTextureCount(aiTextureType_DIFFUSE);
-
-    if (numTextures < 1)
-      mLog->warn("Multiple texture per material is not supported");
-
-    // load the textures for the particular mesh
-    aiString texPath;
-    aiReturn ret = material->GetTexture(aiTextureType_DIFFUSE, 0, &texPath);
+  for (auto& material : node.materials) {
     std::shared_ptr<Texture> texture = nullptr;
 
-    if (ret == AI_SUCCESS) {
-      texture =
-        manager->get<Texture>(std::string("Texture::") + texPath.C_Str());
-    }
-
-    if (!mesh->HasPositions() || !mesh->HasTextureCoords(0) ||
-        !mesh->HasNormals())
-      break;
-
-    // might break if a mesh don't have normals, texcords etc...
-    for (unsigned int j = 0; j < mesh->mNumFaces; j += 1) {
-      const aiFace& face = mesh->mFaces[j];
-
-      if (face.mNumIndices < 3)
-        break;
+    if (!material.texture.empty())
+      texture = manager->get<Texture>("Texture::" + material.texture);
 
-      aiVector3D* const* texCoords = mesh->mTextureCoords;
-      aiVector3D*        vertices  = mesh->mVertices;
-      aiVector3D*        normals   = mesh->mNormals;
-
-      for (unsigned int fIndex = 0; fIndex < 3; ++fIndex) {
-        unsigned int i1    = face.mIndices[fIndex];
-        mmm::vec3 vertex   = { vertices[i1].x, vertices[i1].y, vertices[i1].z };
-        mmm::vec2 texCoord = { texCoords[0][i1].x, texCoords[0][i1].y };
-        mmm::vec3 normal   = { normals[i1].x, normals[i1].y, normals[i1].z };
-
-        model->addVertex({ vertex, texCoord, normal });
-      }
-    }
-
-    int materialSize = model->numVertices() - startIndex;
-
-    mMaterials.push_back({ startIndex, materialSize, texture });
+    mMaterials.push_back({ material.startIndex, material.size, texture });
   }
 
-  mSize = model->numVertices() - mStartIndex;
+  // The vertices are drawn as they are, without indices, so the submesh
+  // is the vertices from its start index
+  const std::vector<MeshData::Vertex>& vertices = model->data();
 
-  // recursively parse child nodes
-  for (unsigned int i = 0; i < node->mNumChildren; ++i) {
-    model->addSubMesh(
-      SubMesh(model, manager, scene, node->mChildren[i], mTransform));
-  }
+  int end = mmm::min(mStartIndex + mSize, int(vertices.size()));
+
+  for (int i = mStartIndex; i < end; ++i)
+    mBounds.add(vertices[i].vertex);
 }
 
 /**
@@ -413,6 +380,17 @@ const mmm::mat4& SubMesh::transform() const {
   return mTransform;
 }
 
+/**
+ * @brief
+ *   Returns the box around the vertices of the submesh, in the coordinates
+ *   they are drawn in. The box is empty if the submesh has no vertices.
+ *
+ * @return
+ */
+const BoundingBox& SubMesh::bounds() const {
+  return mBounds;
+}
+
 /**
  * @brief
  *   If the submesh had a name associated with it when it was created
@@ -491,3 +469,39 @@ void SubMesh::draw(int textureLocation) const {
     glDrawArrays(GL_TRIANGLES, mStartIndex, mSize);
   }
 }
+
+/**
+ * @brief
+ *   Works just like draw, except that each draw call draws the given
+ *   number of instances. The instance attributes has to be set up by the
+ *   caller while the vertex array of the parent is bound.
+ *
+ * @param instances
+ * @param textureLocation
+ *
+ * @return
+ */
+size_t SubMesh::drawInstanced(size_t instances, int textureLocation) const {
+  if (mSize == 0 || instances == 0)
+    return 0;
+
+  mParent->bindVertexArray();
+
+  if (mMaterials.size() > 0 && textureLocation >= 0) {
+    for (auto& material : mMaterials) {
+      if (material.texture != nullptr)
+        material.texture->bind(textureLocation);
+      glDrawArraysInstanced(
+        GL_TRIANGLES, material.startIndex, material.size, instances);
+    }
+
+    return mMaterials.size();
+  }
+
+  glDrawArraysInstanced(GL_TRIANGLES, mStartIndex, mSize, instances);
+  return 1;
+}
+
+const Mesh* SubMesh::mesh() const {
+  return mParent;
+}
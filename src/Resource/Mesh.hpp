@@ -7,13 +7,13 @@
 
 #include "../Log.hpp"
 #include "../OpenGLHeaders.hpp"
+#include "../Shape/BoundingBox.hpp"
+#include "MeshData.hpp"
 #include "Resource.hpp"
 
 class Texture;
 class Asset;
 
-struct aiScene;
-struct aiNode;
 class Mesh;
 class ResourceManager;
 class Program;
@@ -25,11 +25,9 @@ class SubMesh : public Logging::Log {
 public:
   SubMesh();
 
-  SubMesh(Mesh*            model,
-          ResourceManager* r,
-          const aiScene*   scene,
-          const aiNode*    node,
-          mmm::mat4        transform);
+  SubMesh(Mesh*                 model,
+          ResourceManager*      r,
+          const MeshData::Node& node);
 
   // Returns the index of the SubMesh within the Mesh class
   int index() const;
@@ -43,6 +41,9 @@ public:
   // Returns the transformation of the mesh from its parent
   const mmm::mat4& transform() const;
 
+  // Returns the box around the vertices of the mesh
+  const BoundingBox& bounds() const;
+
   // Returns the name of the mesh, if it has one.
   const std::string& name() const;
 
@@ -57,6 +58,13 @@ public:
   // Draws the submesh
   void draw(int textureLocation = 1) const;
 
+  // Draws the submesh once per instance, returning the number of draw
+  // calls used
+  size_t drawInstanced(size_t instances, int textureLocation = 1) const;
+
+  // Returns the mesh that the submesh is part of
+  const Mesh* mesh() const;
+
 private:
   int         mStartIndex;
   int         mSize;
@@ -64,6 +72,7 @@ private:
   std::string mName;
   mmm::mat4   mTransform;
   Mesh*       mParent;
+  BoundingBox mBounds;
 
   // A mesh can have multiple materials and is therefore split
   // into several draw calls to texture it correctly.
@@ -80,18 +89,18 @@ private:
 };
 
 /**
- * @brief Holds a mesh
+ * @brief
+ *   Holds a mesh. The mesh is read from a cache next to the model,
+ *   `<model>.mesh`, which is made through Assimp the first time the model
+ *   is loaded and again whenever the model changes.
  */
 class Mesh : public Resource, public Logging::Log {
 public:
-  static size_t npos;
+  static constexpr ResourceType TYPE = ResourceType::Mesh;
 
-  struct Vertex {
-    mmm::vec3 vertex;
-    mmm::vec2 texCoord;
-    mmm::vec3 normals;
-  };
+  static size_t npos;
 
+  using Vertex = MeshData::Vertex;
 
   Mesh();
   ~Mesh();
@@ -102,6 +111,10 @@ public:
   // loads the mesh
   bool load(ResourceManager* r);
 
+  // Reads the cache of the model, or imports the model, so that load
+  // only has to create the buffers
+  bool prepare();
+
   // unloads the mesh from memory
   void unload();
 
@@ -148,4 +161,11 @@ private:
 
   std::vector<SubMesh> mSubMeshes;
   std::vector<Vertex>  mData;
+
+  // Reads the cache of the model, or imports it and saves the cache
+  MeshData loadData();
+
+  // Holds the vertices and nodes between prepare and load
+  MeshData mPrepared;
+  bool     mIsPrepared;
 };
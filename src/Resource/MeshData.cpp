@@ -0,0 +1,325 @@
+#include "MeshData.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+
+#include <sys/stat.h>
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+static_assert(sizeof(MeshData::Vertex) == 8 * sizeof(float),
+              "Vertices must be tightly packed to be read in one go");
+
+namespace {
+  const char     MAGIC[4] = { 'M', 'E', 'S', 'H' };
+  const uint32_t VERSION  = 1;
+
+  // Identifies the version of a model on disk, so that a cache made from
+  // an older version is not used
+  struct Source {
+    int64_t size;
+    int64_t modified;
+
+    bool operator==(const Source& other) const {
+      return size == other.size && modified == other.modified;
+    }
+  };
+
+  Source source(const std::string& model) {
+    struct stat info;
+
+    if (stat(model.c_str(), &info) != 0)
+      throw std::runtime_error("Unable to find model: " + model);
+
+    return { static_cast<int64_t>(info.st_size),
+             static_cast<int64_t>(info.st_mtime) };
+  }
+
+  template <typename T>
+  void write(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  void read(std::ifstream& file, T& value) {
+    file.read(reinterpret_cast<char*>(&value), sizeof(T));
+  }
+
+  void write(std::ofstream& file, const std::string& value) {
+    write(file, static_cast<uint32_t>(value.size()));
+    file.write(value.data(), value.size());
+  }
+
+  void read(std::ifstream& file, std::string& value) {
+    uint32_t size = 0;
+    read(file, size);
+
+    if (!file)
+      return;
+
+    value.resize(size);
+    file.read(&value[0], size);
+  }
+
+  void write(std::ofstream& file, const mmm::mat4& value) {
+    for (int i = 0; i < 4; ++i)
+      for (int j = 0; j < 4; ++j)
+        write(file, value[i][j]);
+  }
+
+  void read(std::ifstream& file, mmm::mat4& value) {
+    float m[16];
+    file.read(reinterpret_cast<char*>(m), sizeof(m));
+
+    value = mmm::mat4(m[0],
+                      m[1],
+                      m[2],
+                      m[3],
+                      m[4],
+                      m[5],
+                      m[6],
+                      m[7],
+                      m[8],
+                      m[9],
+                      m[10],
+                      m[11],
+                      m[12],
+                      m[13],
+                      m[14],
+                      m[15]);
+  }
+
+  /**
+   * @brief
+   *   Adds the node and all of its children to the data. The children are
+   *   added before the node itself, but the node's vertices come before
+   *   theirs, which is the order Mesh has always stored its submeshes in.
+   *
+   * @param scene
+   * @param node
+   * @param transform the transform of the parent
+   * @param data
+   */
+  void importNode(const aiScene*   scene,
+                  const aiNode*    node,
+                  const mmm::mat4& transform,
+                  MeshData&        data) {
+    const aiMatrix4x4& am = node->mTransformation;
+
+    MeshData::Node result;
+    result.index      = data.nodes.size();
+    result.startIndex = data.vertices.size();
+    result.transform  = transform * mmm::mat4(am.a1,
+                                             am.a2,
+                                             am.a3,
+                                             am.a4,
+                                             am.b1,
+                                             am.b2,
+                                             am.b3,
+                                             am.b4,
+                                             am.c1,
+                                             am.c2,
+                                             am.c3,
+                                             am.c4,
+                                             am.d1,
+                                             am.d2,
+                                             am.d3,
+                                             am.d4);
+
+    if (node->mName.length != 0)
+      result.name = node->mName.C_Str();
+
+    // When a mesh is exported and has multiple materials for that mesh,
+    // assimp splits it into multiple smaller meshes where each mesh has
+    // one material assigned to it.
+    for (unsigned int i = 0; i < node->mNumMeshes; i += 1) {
+      const aiMesh*     mesh     = scene->mMeshes[node->mMeshes[i]];
+      const aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+
+      MeshData::Material part;
+      part.startIndex = data.vertices.size();
+
+      aiString texPath;
+      if (material->GetTexture(aiTextureType_DIFFUSE, 0, &texPath) ==
+          AI_SUCCESS)
+        part.texture = texPath.C_Str();
+
+      if (!mesh->HasPositions() || !mesh->HasTextureCoords(0) ||
+          !mesh->HasNormals())
+        break;
+
+      aiVector3D* const* texCoords = mesh->mTextureCoords;
+      aiVector3D*        vertices  = mesh->mVertices;
+      aiVector3D*        normals   = mesh->mNormals;
+
+      data.vertices.reserve(data.vertices.size() + mesh->mNumFaces * 3);
+
+      for (unsigned int j = 0; j < mesh->mNumFaces; j += 1) {
+        const aiFace& face = mesh->mFaces[j];
+
+        if (face.mNumIndices < 3)
+          break;
+
+        for (unsigned int fIndex = 0; fIndex < 3; ++fIndex) {
+          unsigned int i1 = face.mIndices[fIndex];
+
+          data.vertices.push_back(
+            { { vertices[i1].x, vertices[i1].y, vertices[i1].z },
+              { texCoords[0][i1].x, texCoords[0][i1].y },
+              { normals[i1].x, normals[i1].y, normals[i1].z } });
+        }
+      }
+
+      part.size = data.vertices.size() - part.startIndex;
+      result.materials.push_back(part);
+    }
+
+    result.size = data.vertices.size() - result.startIndex;
+
+    for (unsigned int i = 0; i < node->mNumChildren; ++i)
+      importNode(scene, node->mChildren[i], result.transform, data);
+
+    data.nodes.push_back(result);
+  }
+}
+
+/**
+ * @brief
+ *   Imports the model through Assimp, triangulating it and turning every
+ *   face into three vertices.
+ *
+ * @param model
+ *
+ * @return
+ */
+MeshData MeshData::import(const std::string& model) {
+  Assimp::Importer importer;
+  const aiScene*   scene =
+    importer.ReadFile(model.c_str(), aiProcess_Triangulate);
+
+  if (!scene)
+    throw std::runtime_error("Unable to load mesh: " + model);
+
+  MeshData data;
+  importNode(scene, scene->mRootNode, mmm::mat4::identity, data);
+  return data;
+}
+
+/**
+ * @brief
+ *   Loads a cache of the model. The vertices are read straight into the
+ *   vector that is uploaded.
+ *
+ * @param filename the cache
+ * @param model the model the cache should have been made from
+ *
+ * @return
+ */
+MeshData MeshData::load(const std::string& filename,
+                        const std::string& model) {
+  std::ifstream file(filename, std::ios::in | std::ios::binary);
+
+  if (!file.is_open())
+    throw std::runtime_error("Unable to open mesh cache: " + filename);
+
+  char     magic[4];
+  uint32_t version;
+  Source   cached;
+
+  file.read(magic, 4);
+  read(file, version);
+  read(file, cached.size);
+  read(file, cached.modified);
+
+  if (!file || !std::equal(magic, magic + 4, MAGIC) || version != VERSION ||
+      !(cached == source(model)))
+    throw std::runtime_error("Mesh cache is outdated: " + filename);
+
+  MeshData data;
+  uint32_t numVertices, numNodes;
+
+  read(file, numVertices);
+  data.vertices.resize(numVertices);
+  file.read(reinterpret_cast<char*>(data.vertices.data()),
+            numVertices * sizeof(Vertex));
+
+  read(file, numNodes);
+
+  for (uint32_t i = 0; file && i < numNodes; ++i) {
+    Node     node;
+    uint32_t numMaterials;
+
+    read(file, node.index);
+    read(file, node.startIndex);
+    read(file, node.size);
+    read(file, node.name);
+    read(file, node.transform);
+    read(file, numMaterials);
+
+    for (uint32_t j = 0; file && j < numMaterials; ++j) {
+      Material material;
+
+      read(file, material.startIndex);
+      read(file, material.size);
+      read(file, material.texture);
+
+      node.materials.push_back(material);
+    }
+
+    data.nodes.push_back(node);
+  }
+
+  if (!file)
+    throw std::runtime_error("Mesh cache is truncated: " + filename);
+
+  return data;
+}
+
+/**
+ * @brief
+ *   Saves the data in a binary format that can be read by load
+ *
+ * @param filename the cache
+ * @param model the model the data was imported from
+ */
+void MeshData::save(const std::string& filename,
+                    const std::string& model) const {
+  Source        current = source(model);
+  std::ofstream file(filename, std::ios::out | std::ios::binary);
+
+  if (!file.is_open())
+    throw std::runtime_error("Unable to write mesh cache: " + filename);
+
+  file.write(MAGIC, 4);
+  write(file, VERSION);
+  write(file, current.size);
+  write(file, current.modified);
+
+  write(file, static_cast<uint32_t>(vertices.size()));
+  file.write(reinterpret_cast<const char*>(vertices.data()),
+             vertices.size() * sizeof(Vertex));
+
+  write(file, static_cast<uint32_t>(nodes.size()));
+
+  for (auto& node : nodes) {
+    write(file, node.index);
+    write(file, node.startIndex);
+    write(file, node.size);
+    write(file, node.name);
+    write(file, node.transform);
+    write(file, static_cast<uint32_t>(node.materials.size()));
+
+    for (auto& material : node.materials) {
+      write(file, material.startIndex);
+      write(file, material.size);
+      write(file, material.texture);
+    }
+  }
+
+  if (!file)
+    throw std::runtime_error("Unable to write mesh cache: " + filename);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <mmm.hpp>
+
+/**
+ * @brief
+ *   The vertices and node tree of a model, as used by Mesh, without any
+ *   OpenGL objects or textures.
+ *
+ *   Importing a model through Assimp is slow, so the result is cached in
+ *   a compact binary file next to the model. The vertices are stored the
+ *   way they are uploaded, so loading the cache is a single read that can
+ *   be handed straight to OpenGL.
+ *
+ *   The cache remembers the size and modification time of the model it
+ *   was made from and is rejected if the model changes. It can be baked
+ *   ahead of time by BakeMesh.
+ */
+struct MeshData {
+  //! An interleaved vertex, exactly as it is uploaded
+  struct Vertex {
+    mmm::vec3 vertex;
+    mmm::vec2 texCoord;
+    mmm::vec3 normals;
+  };
+
+  //! A range of the vertices drawn with one texture. The texture is the
+  //! name used by Assimp, or empty if there is none.
+  struct Material {
+    int         startIndex;
+    int         size;
+    std::string texture;
+  };
+
+  //! A node in the tree of the model, in the order the submeshes of Mesh
+  //! are stored in
+  struct Node {
+    int                   index;
+    int                   startIndex;
+    int                   size;
+    std::string           name;
+    mmm::mat4             transform;
+    std::vector<Material> materials;
+  };
+
+  // Imports the model through Assimp, throws if it cannot be read
+  static MeshData import(const std::string& model);
+
+  // Loads a cache saved by save, throws if it cannot be read or if the
+  // model has changed since the cache was made
+  static MeshData load(const std::string& filename, const std::string& model);
+
+  // Saves the data to file as a cache of the given model
+  void save(const std::string& filename, const std::string& model) const;
+
+  std::vector<Vertex> vertices;
+  std::vector<Node>   nodes;
+};
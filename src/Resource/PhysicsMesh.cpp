@@ -5,13 +5,21 @@
 #include <btBulletDynamicsCommon.h>
 #include <btBulletWorldImporter.h>
 
-using RigidBodyInfo = btRigidBody::btRigidBodyConstructionInfo;
-
 PhysicsMesh::PhysicsMesh()
-    : Logging::Log("PhysicsMesh"), mFileloader(nullptr), mMesh(nullptr) {}
+    : Logging::Log("PhysicsMesh")
+    , mFileloader(nullptr)
+    , mMesh(nullptr)
+    , mGeneration(0) {}
 
 PhysicsMesh::~PhysicsMesh() {
   unload();
+
+  // A mesh can be prepared without being loaded, in which case the
+  // importer still owns the bodies and constraints it created
+  if (mFileloader != nullptr) {
+    mFileloader->deleteAllData();
+    delete mFileloader;
+  }
 }
 
 std::string PhysicsMesh::findNameByPointer(btRigidBody* body) {
@@ -22,19 +30,14 @@ std::string PhysicsMesh::findNameByPointer(btRigidBody* body) {
 
 /**
  * @brief
- *   Loads the physics from a bullet file and expects there to be an
- *   associated mesh that goes by the same name that this is requested
- *   as from the resource manager.
- *
- *   For instance, if a resource is called PhysicsMesh::Spider, it expects
- *   the matches the Mesh::Spider.
- *
- * @param manager
+ *   Reads the rigid bodies and constraints from the bullet file. Bullet
+ *   objects are only created, not added to any world, so this can run on
+ *   a worker thread before `load`.
  *
  * @return
  */
-bool PhysicsMesh::load(ResourceManager* manager) {
-  if (loaded())
+bool PhysicsMesh::prepare() {
+  if (mFileloader != nullptr)
     return true;
 
   // Load the file with nullptr world as it does not require
@@ -80,6 +83,32 @@ bool PhysicsMesh::load(ResourceManager* manager) {
                 toConstraint);
   }
 
+  return true;
+}
+
+/**
+ * @brief
+ *   Loads the physics from a bullet file and expects there to be an
+ *   associated mesh that goes by the same name that this is requested
+ *   as from the resource manager.
+ *
+ *   For instance, if a resource is called PhysicsMesh::Spider, it expects
+ *   the matches the Mesh::Spider.
+ *
+ *   The bullet file is read by `prepare`, which is called first if it has
+ *   not been already.
+ *
+ * @param manager
+ *
+ * @return
+ */
+bool PhysicsMesh::load(ResourceManager* manager) {
+  if (loaded())
+    return true;
+
+  if (mFileloader == nullptr && !prepare())
+    return false;
+
   // time to load the mesh for the physics
   size_t position = mName.find("::");
 
@@ -112,44 +141,19 @@ void PhysicsMesh::unload() {
   if (!loaded())
     return;
 
-  for (auto& storedCopy : mCopies) {
-    // Delete constraints first
-    for (auto& el : storedCopy.constraints) {
-      for (auto& innerEl : el.second) {
-        if (storedCopy.bodies[el.first] == &innerEl->getRigidBodyA()) {
-          delete innerEl;
-          innerEl = nullptr;
-        }
-      }
-
-      el.second.clear();
-    }
-
-    // Followed by all rigidBodies
-    for (auto& el : storedCopy.bodies)
-      delete el.second;
-
-    for (auto& el : storedCopy.motions)
-      delete el.second;
-
-
-    // Now that all copies have been deleted, clear the maps
-    // of strings.
-    storedCopy.bodies.clear();
-    storedCopy.motions.clear();
-    storedCopy.constraints.clear();
-  }
-
   for (auto& a : mConstraints)
     a.second.clear();
 
-  mCopies.clear();
   mConstraints.clear();
   mBodies.clear();
   mNames.clear();
   mAllElements.clear();
   mFileloader->deleteAllData();
 
+  delete mFileloader;
+  mFileloader = nullptr;
+
+  mGeneration++;
   setLoaded(false);
 }
 
@@ -199,265 +203,24 @@ SubMeshPhysics PhysicsMesh::findByName(const std::string& name) {
   return s;
 }
 
-PhysicsElements* PhysicsMesh::createAll() {
-  auto&            meshes   = getAll();
-  PhysicsElements* elements = new PhysicsElements();
-
-  // First create copies of the rigid bodies together with new
-  // motion state based on the internal variables of the rigid bodies
-  for (auto& mesh : meshes) {
-    btRigidBody*      mainBody = mesh.second.body;
-    btCollisionShape* shape    = mainBody->getCollisionShape();
-
-    btMatrix3x3      mat;
-    const mmm::mat4& t      = mesh.second.subMesh->transform();
-    const mmm::vec3& matPos = mmm::dropColumns<3>(t).xyz;
-
-    // TODO fix static +2 up translation
-    const btVector3 pos = btVector3(matPos.x, matPos.y + 1, matPos.z);
-
-    mat.setFromOpenGLSubMatrix(mmm::transpose(t).rawdata);
-
-    btMotionState* motion = new btDefaultMotionState(btTransform(mat, pos));
-    btVector3      inertia;
-    shape->calculateLocalInertia(0.1, inertia);
-    mainBody->setMotionState(motion);
-    mainBody->setMassProps(0.1, inertia);
-
-    elements->bodies[mesh.first]  = mainBody;
-    elements->meshes[mesh.first]  = mesh.second.subMesh;
-    elements->motions[mesh.first] = mainBody->getMotionState();
-  }
-
-  for (int i = 0; i < mFileloader->getNumConstraints(); ++i) {
-    btTypedConstraint* c              = mFileloader->getConstraintByIndex(i);
-    const std::string& fromConstraint = findNameByPointer(&c->getRigidBodyA());
-    const std::string& toConstraint   = findNameByPointer(&c->getRigidBodyB());
-
-    if (c != nullptr) {
-      elements->constraints[fromConstraint].push_back(c);
-      elements->constraints[toConstraint].push_back(c);
-    }
-  }
-
-  return elements;
-}
-
 /**
  * @brief
- *   Creates a copy of all the physics elements stored and returns those to you.
- *   The reason for this function is because you cannot add two of the same
- *   rigidbodies to a world. This copies each rigidBody, sets a motion state
- *   based on the transforms in the Mesh and setup the constraints.
+ *   Returns every constraint that was read from the bullet file
  *
  * @return
  */
-PhysicsElements* PhysicsMesh::createCopyAll() {
-  auto&           meshes = getAll();
-  PhysicsElements elements;
-
-  // First create copies of the rigid bodies together with new
-  // motion state based on the internal variables of the rigid bodies
-  for (auto& mesh : meshes) {
-    btRigidBody*      mainBody = mesh.second.body;
-    btCollisionShape* shape    = mainBody->getCollisionShape();
-
-    btMatrix3x3      mat;
-    const mmm::mat4& t      = mesh.second.subMesh->transform();
-    const mmm::vec3& matPos = mmm::dropColumns<3>(t).xyz;
-
-    // TODO fix static +2 up translation
-    const btVector3 pos = btVector3(matPos.x, matPos.y + 1, matPos.z);
-    btVector3       inertia;
-
-    // auto mass = 2.f;
-    auto mass = mainBody->getInvMass();
-
-    if (mesh.first == "Abdomin")
-      mass = 10.f;
-    else if (mesh.first == "Sternum")
-      mass = 5.f;
-    else if (mesh.first == "Eye")
-      mass = 2.5;
-    else
-      mass = 1.0f;
-
-    shape->calculateLocalInertia(mass, inertia);
-
-    mat.setFromOpenGLSubMatrix(mmm::transpose(t).rawdata);
-    btMotionState* motion = new btDefaultMotionState(btTransform(mat, pos));
-
-    auto info       = RigidBodyInfo(mass, motion, shape, inertia);
-    info.m_friction = 0.84;
+std::vector<btTypedConstraint*> PhysicsMesh::constraints() const {
+  std::vector<btTypedConstraint*> constraints;
 
-    btRigidBody* body = new btRigidBody(info);
+  if (mFileloader == nullptr)
+    return constraints;
 
-    elements.bodies[mesh.first]  = body;
-    elements.motions[mesh.first] = motion;
-    elements.meshes[mesh.first]  = mesh.second.subMesh;
-  }
-
-  // Now that all bodies and motions have been created, the constraints can be
-  // duplicated.
-  //
-  // Since different constraints may contain different variables, they have to
-  // be handled seperately
-  for (int i = 0; i < mFileloader->getNumConstraints(); ++i) {
-    btTypedConstraint* c              = mFileloader->getConstraintByIndex(i);
-    const std::string& fromConstraint = findNameByPointer(&c->getRigidBodyA());
-    const std::string& toConstraint   = findNameByPointer(&c->getRigidBodyB());
+  constraints.reserve(mFileloader->getNumConstraints());
 
-    btRigidBody* a = nullptr;
-    btRigidBody* b = nullptr;
-
-    if (fromConstraint != "")
-      a = elements.bodies[fromConstraint];
-
-    if (toConstraint != "")
-      b = elements.bodies[toConstraint];
-
-    btTypedConstraint* constraintCopy = nullptr;
-
-    switch (c->getConstraintType()) {
-      case btTypedConstraintType::POINT2POINT_CONSTRAINT_TYPE:
-        mLog->error("No duplication handler for Point2Point constraint");
-        break;
-      case btTypedConstraintType::HINGE_CONSTRAINT_TYPE: {
-        btHingeConstraint* h      = dynamic_cast<btHingeConstraint*>(c);
-        const btTransform& aFrame = h->getAFrame();
-        const btTransform& bFrame = h->getBFrame();
-
-        btHingeConstraint* n =
-          new btHingeConstraint(*a,
-                                *b,
-                                aFrame,
-                                bFrame,
-                                h->getUseReferenceFrameA());
-
-        n->setAngularOnly(n->getAngularOnly());
-
-        if (h->hasLimit()) {
-          n->setLimit(h->getLowerLimit(), h->getUpperLimit());
-        }
-
-        constraintCopy = n;
-        break;
-      }
-      case btTypedConstraintType::CONETWIST_CONSTRAINT_TYPE:
-        mLog->error("No duplication handler for ConeTwist constraint");
-        break;
-      case btTypedConstraintType::D6_CONSTRAINT_TYPE:
-        mLog->error("No duplication handler for D6 constraint");
-        break;
-      case btTypedConstraintType::SLIDER_CONSTRAINT_TYPE:
-        mLog->error("No duplication handler for Slider constraint");
-        break;
-      case btTypedConstraintType::CONTACT_CONSTRAINT_TYPE:
-        mLog->error("No duplication handler for Contact constraint");
-        break;
-      case btTypedConstraintType::D6_SPRING_CONSTRAINT_TYPE: {
-
-        btGeneric6DofSpringConstraint* d =
-          dynamic_cast<btGeneric6DofSpringConstraint*>(c);
-
-        const btTransform& aFrame = d->getFrameOffsetA();
-        const btTransform& bFrame = d->getFrameOffsetB();
-
-        btGeneric6DofSpringConstraint* n =
-          new btGeneric6DofSpringConstraint(*a, *b, aFrame, bFrame, true);
-
-        btVector3 lll;
-        btVector3 lul;
-        btVector3 all;
-        btVector3 aul;
-
-        d->getLinearLowerLimit(lll);
-        d->getLinearUpperLimit(lul);
-        d->getAngularLowerLimit(all);
-        d->getAngularUpperLimit(aul);
-
-        n->setLinearLowerLimit(lll);
-        n->setLinearUpperLimit(lul);
-        n->setAngularLowerLimit(all);
-        n->setAngularUpperLimit(aul);
-
-        constraintCopy = n;
-        break;
-      }
-      case btTypedConstraintType::GEAR_CONSTRAINT_TYPE:
-        mLog->error("No duplication handler for Gear constraint");
-        break;
-      case btTypedConstraintType::FIXED_CONSTRAINT_TYPE:
-        mLog->error("No duplication handler for Gear constraint");
-        break;
-      case btTypedConstraintType::D6_SPRING_2_CONSTRAINT_TYPE:
-        mLog->error("No duplication handler for D6Spring2 constraint");
-        break;
-      case btTypedConstraintType::MAX_CONSTRAINT_TYPE:
-        mLog->error("No duplication handler for Max constraint");
-        break;
-    }
-
-    if (constraintCopy != nullptr) {
-      elements.constraints[fromConstraint].push_back(constraintCopy);
-      elements.constraints[toConstraint].push_back(constraintCopy);
-    }
-  }
-
-  mCopies.push_back(elements);
+  for (int i = 0; i < mFileloader->getNumConstraints(); ++i)
+    constraints.push_back(mFileloader->getConstraintByIndex(i));
 
-  return &mCopies.back();
-}
-
-/**
- * @brief
- *   Clears all the resources that have been allocated to a PhysicsElement
- *   before removing it from the list of stored copies all together.
- *
- *   This will invalidate all other references to the PhysicsElement
- *
- * @param copy
- */
-void PhysicsMesh::deleteCopy(PhysicsElements* copy) {
-  unsigned int i = 0;
-  for (auto& storedCopy : mCopies) {
-
-    // when we have found our match, go through and delete it all
-    if (&storedCopy == copy) {
-
-      // Delete constraints first
-      for (auto& el : storedCopy.constraints) {
-        for (auto& innerEl : el.second) {
-          if (storedCopy.bodies[el.first] == &innerEl->getRigidBodyA()) {
-            delete innerEl;
-            innerEl = nullptr;
-          }
-        }
-
-        el.second.clear();
-      }
-
-      // Followed by all rigidBodies
-      for (auto& el : storedCopy.bodies)
-        delete el.second;
-
-      for (auto& el : storedCopy.motions)
-        delete el.second;
-
-
-      // Now that all copies have been deleted, clear the maps
-      // of strings.
-      storedCopy.bodies.clear();
-      storedCopy.motions.clear();
-      storedCopy.constraints.clear();
-
-      // Remove the element from the list and break the loop
-      mCopies.erase(mCopies.begin() + i);
-      break;
-    }
-
-    ++i;
-  }
+  return constraints;
 }
 
 /**
@@ -519,3 +282,7 @@ PhysicsMesh::getAll() {
 const std::shared_ptr<Mesh>& PhysicsMesh::mesh() const {
   return mMesh;
 }
+
+unsigned int PhysicsMesh::generation() const {
+  return mGeneration;
+}
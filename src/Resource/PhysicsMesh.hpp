@@ -3,6 +3,7 @@
 #include "Log.hpp"
 #include "Resource.hpp"
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
@@ -15,7 +16,6 @@ class Mesh;
 class btRigidBody;
 class btBulletWorldImporter;
 class btTypedConstraint;
-class btMotionState;
 class btDiscreteDynamicsWorld;
 
 /**
@@ -29,21 +29,19 @@ struct SubMeshPhysics {
   std::vector<btTypedConstraint*> constraints;
 };
 
-struct PhysicsElements {
-  std::map<std::string, const SubMesh*>                  meshes;
-  std::map<std::string, btRigidBody*>                    bodies;
-  std::map<std::string, btMotionState*>                  motions;
-  std::map<std::string, std::vector<btTypedConstraint*>> constraints;
-};
-
 class PhysicsMesh : public Resource, public Logging::Log {
 public:
+  static constexpr ResourceType TYPE = ResourceType::PhysicsMesh;
+
   PhysicsMesh();
   ~PhysicsMesh();
 
   // Loads the physics mesh from file
   bool load(ResourceManager* manager);
 
+  // Reads the bullet file, leaving only the mesh to be looked up by load
+  bool prepare();
+
   // Unloads the Physics mesh
   void unload();
 
@@ -55,20 +53,8 @@ public:
   // Both pointers in this structure may be null
   SubMeshPhysics findByName(const std::string& name);
 
-  // Creates a copy of all the physics elements stored
-  // and returns those to you.
-  //
-  // The reason for this function is because you cannot add two of the same
-  // rigidbodies to a world. This copies each rigidBody, sets a motion state
-  // based on the transforms in the Mesh and setup the constraints.
-  PhysicsElements* createCopyAll();
-  PhysicsElements* createAll();
-
-  // Releases the resources allocated for a copy of the elements.
-  //
-  // When this function is called, it is expected that it is detached from
-  // the world.
-  void deleteCopy(PhysicsElements* copy);
+  // Returns every constraint in the file, in the order they were stored
+  std::vector<btTypedConstraint*> constraints() const;
 
   // Returns all the submeshes and rigid bodies merged together
   // for one mesh together with the name of the given mesh/rigid body.
@@ -80,6 +66,10 @@ public:
   // Returns the mesh
   const std::shared_ptr<Mesh>& mesh() const;
 
+  // Returns how many times the mesh has been unloaded, so that anything
+  // built from its bodies and shapes can tell that they are gone
+  unsigned int generation() const;
+
 private:
   std::string findNameByPointer(btRigidBody* body);
 
@@ -90,6 +80,5 @@ private:
   std::map<std::string, btRigidBody*>                    mBodies;
   std::map<btRigidBody*, std::string>                    mNames;
   std::vector<std::pair<std::string, SubMeshPhysics>>    mAllElements;
-
-  std::vector<PhysicsElements> mCopies;
+  std::atomic<unsigned int>                              mGeneration;
 };
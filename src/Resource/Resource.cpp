@@ -9,6 +9,17 @@ Resource::Resource()
 
 Resource::~Resource() {}
 
+/**
+ * @brief
+ *   By default there is nothing to prepare and all the work is done by
+ *   `load` on the main thread.
+ *
+ * @return
+ */
+bool Resource::prepare() {
+  return true;
+}
+
 /**
  * @brief
  *   Sets the type to an enum that can be found in
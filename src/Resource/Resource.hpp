@@ -31,6 +31,10 @@ enum class ResourceScope {
  *   All of these operations should be reserved for the `load` function.
  *   Similarily, all deallocation of the said resources should be reserved
  *   for the `unload` function.
+ *
+ *   Resources that spend a lot of time on the CPU before they can be
+ *   uploaded should move that work into `prepare`, which may be called on
+ *   another thread before `load` is called on the main thread.
  */
 class Resource {
 public:
@@ -43,6 +47,12 @@ public:
   //! variable or the getter function
   virtual bool load(ResourceManager* manager) = 0;
 
+  //! Does the part of loading that only needs the CPU, like reading and
+  //! decoding files, so that the resource manager can run it on a worker
+  //! thread ahead of `load`. It must not use OpenGL or other resources.
+  //! `load` should call it itself if it has not been called yet.
+  virtual bool prepare();
+
   //! Whenever the resource manager feels like this resource
   //! is useless, it will call unload. This function
   //! should unload any resources it requires.
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+class ResourceManager;
+
+/**
+ * @brief
+ *   A resource that has been looked up by name once, through
+ *   `ResourceManager::handle`. Using it afterwards only compares its
+ *   generation with the one stored by the manager, which is an index into
+ *   an array.
+ *
+ *   The manager increases the generation of a resource every time it is
+ *   unloaded or replaced. A handle that sees another generation loads the
+ *   resource again and takes the one the manager has now, so handles can
+ *   be kept for as long as the manager exists.
+ *
+ *   The functions that use the manager are implemented at the bottom of
+ *   ResourceManager.hpp, which has to be included to use them.
+ */
+template <typename T>
+class ResourceHandle {
+public:
+  // Creates a handle that does not refer to any resource
+  ResourceHandle();
+
+  // Returns the resource, loading it again if it has been unloaded
+  const std::shared_ptr<T>& get();
+
+  T* operator->();
+
+  // Returns whether the handle refers to a resource
+  bool valid() const;
+
+private:
+  friend class ResourceManager;
+
+  ResourceHandle(ResourceManager*   manager,
+                 size_t             index,
+                 uint32_t           generation,
+                 std::shared_ptr<T> resource);
+
+  ResourceManager*   mManager;
+  size_t             mIndex;
+  uint32_t           mGeneration;
+  std::shared_ptr<T> mResource;
+};
+
+template <typename T>
+ResourceHandle<T>::ResourceHandle()
+    : mManager(nullptr), mIndex(0), mGeneration(0) {}
+
+template <typename T>
+ResourceHandle<T>::ResourceHandle(ResourceManager*   manager,
+                                  size_t             index,
+                                  uint32_t           generation,
+                                  std::shared_ptr<T> resource)
+    : mManager(manager)
+    , mIndex(index)
+    , mGeneration(generation)
+    , mResource(resource) {}
+
+template <typename T>
+T* ResourceHandle<T>::operator->() {
+  return get().get();
+}
+
+template <typename T>
+bool ResourceHandle<T>::valid() const {
+  return mManager != nullptr;
+}
@@ -1,7 +1,10 @@
 #include "ResourceManager.hpp"
 
+#include <chrono>
+
 #include "../GLSL/Program.hpp"
 #include "../Lua/Lua.hpp"
+#include "../Utils/ThreadPool.hpp"
 #include "../Utils/Utils.hpp"
 #include "Font.hpp"
 #include "Mesh.hpp"
@@ -15,38 +18,252 @@ ResourceManager::~ResourceManager() {
   unloadAll();
 }
 
+/**
+ * @brief
+ *   Loads every resource that is part of the scope. The files are still
+ *   decoded in parallel on the worker threads, but the call does not
+ *   return until all of them have been uploaded.
+ *
+ * @param scope
+ */
 void ResourceManager::loadRequired(ResourceScope scope) {
+  loadRequiredAsync(scope);
+  finishLoading();
+}
+
+/**
+ * @brief
+ *   Starts preparing every resource of the scope that is not loaded on the
+ *   worker threads and returns right away. They are uploaded by `update`,
+ *   or by `get` if they are needed before that.
+ *
+ * @param scope
+ */
+void ResourceManager::loadRequiredAsync(ResourceScope scope) {
   mLog->debug("Loading required for scope: '{}'", static_cast<int>(scope));
   mCurrentScope = scope;
-  for (auto& rPair : mResources) {
-    if (rPair.second->includesScope(scope) && !rPair.second->loaded()) {
-      mLog->debug("Loading: '{}'", rPair.second->filename());
-      rPair.second->load(this);
-      rPair.second->setLoaded(true);
-    } else if (rPair.second->includesScope(scope) && rPair.second->loaded()) {
-      mLog->debug("Already loaded: '{}'", rPair.second->filename());
-    } else {
-      mLog->debug("Not loading: '{}'", rPair.second->filename());
+  for (size_t i = 0; i < mResources.size(); ++i) {
+    Resource* resource = mResources[i].resource.get();
+
+    if (!resource->includesScope(scope)) {
+      mLog->debug("Not loading: '{}'", resource->filename());
+    } else if (resource->loaded()) {
+      mLog->debug("Already loaded: '{}'", resource->filename());
+    } else if (mLoading.count(i) == 0) {
+      mLog->debug("Loading: '{}'", resource->filename());
+      mLoading[i] = ThreadPool::global().async([resource]() {
+        if (!resource->prepare())
+          throw std::runtime_error("Failed to prepare resource: '" +
+                                   resource->name() + "'");
+      });
     }
   }
 }
 
-void ResourceManager::unloadAll() {
-  for (auto& rPair : mResources) {
-    if (rPair.second->loaded()) {
-      rPair.second->unload();
-      rPair.second->setLoaded(false);
+/**
+ * @brief
+ *   Uploads the resources whose preparation has finished, stopping once
+ *   the budget has been used. At least one resource is uploaded if any is
+ *   ready, so loading always moves forward.
+ *
+ *   Resources that fail are logged and left unloaded, so that `get` will
+ *   try to load them again and report the error to the one that needs it.
+ *
+ * @param budget the time, in seconds, that may be spent
+ *
+ * @return true if there is nothing left to load
+ */
+bool ResourceManager::update(float budget) {
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point start = Clock::now();
+
+  while (!mLoading.empty()) {
+    auto ready = mLoading.end();
+
+    for (auto it = mLoading.begin(); it != mLoading.end(); ++it) {
+      if (it->second.wait_for(std::chrono::seconds(0)) ==
+          std::future_status::ready) {
+        ready = it;
+        break;
+      }
+    }
+
+    if (ready == mLoading.end())
+      break;
+
+    size_t index = ready->first;
+
+    try {
+      finish(index);
+    } catch (const std::exception& e) {
+      mLog->error("Failed to load '{}': {}",
+                  mResources[index].resource->name(),
+                  e.what());
     }
+
+    std::chrono::duration<float> spent = Clock::now() - start;
+
+    if (spent.count() >= budget)
+      break;
+  }
+
+  return mLoading.empty();
+}
+
+/**
+ * @brief
+ *   Waits for every resource that is loading in the background and
+ *   uploads it.
+ */
+void ResourceManager::finishLoading() {
+  while (!mLoading.empty())
+    finish(mLoading.begin()->first);
+}
+
+size_t ResourceManager::numLoading() const {
+  return mLoading.size();
+}
+
+/**
+ * @brief
+ *   Checks that the resource can be used in the current scope and loads
+ *   it if it is not loaded.
+ *
+ * @param index
+ *
+ * @return the generation of the loaded resource
+ */
+uint32_t ResourceManager::acquire(size_t index) {
+  Entry& entry = mResources[index];
+
+  if (!entry.resource->includesScope(mCurrentScope)) {
+    throw std::runtime_error("'" + entry.resource->name() +
+                             "' is not available for scope: '" +
+                             std::to_string(static_cast<int>(mCurrentScope)) +
+                             "'");
+  }
+
+  if (!entry.resource->loaded() && !finish(index))
+    throw std::runtime_error("Failed to load resource: '" +
+                             entry.resource->name() + "'");
+
+  return entry.generation;
+}
+
+/**
+ * @brief
+ *   Returns the index of the resource with the name. Asking for a texture
+ *   that does not exist gives the debug texture instead.
+ *
+ * @param name
+ * @param type the type the resource is used as
+ *
+ * @return
+ */
+size_t ResourceManager::indexOf(const std::string& name, ResourceType type) {
+  auto it = mIndices.find(name);
+
+  if (it == mIndices.end()) {
+    if (type == ResourceType::Texture && name != "Texture::Debug") {
+      mLog->error("Tried to load Texture that did not exist: {}", name);
+      return indexOf("Texture::Debug", type);
+    }
+
+    throw std::runtime_error("Could not find filename for " + name);
+  }
+
+  if (mResources[it->second].resource->type() != type)
+    throw std::runtime_error("'" + name + "' is not of the requested type");
+
+  return it->second;
+}
+
+/**
+ * @brief
+ *   Loads the resource on this thread. If it is being prepared in the
+ *   background, this waits for only that resource, rethrowing anything
+ *   the preparation threw.
+ *
+ *   Loading a resource may load others through `get`, which can finish
+ *   other resources that are loading as well.
+ *
+ * @param index
+ *
+ * @return whether the resource was loaded
+ */
+bool ResourceManager::finish(size_t index) {
+  auto loading = mLoading.find(index);
+
+  if (loading != mLoading.end()) {
+    std::future<void> prepared = std::move(loading->second);
+    mLoading.erase(loading);
+    prepared.get();
+  }
+
+  std::shared_ptr<Resource>& resource = mResources[index].resource;
+
+  if (resource->loaded())
+    return true;
+
+  if (!resource->load(this)) {
+    mLog->error("Failed to load: '{}'", resource->filename());
+    return false;
+  }
+
+  resource->setLoaded(true);
+  return true;
+}
+
+/**
+ * @brief
+ *   Waits for the preparations that are running, since they write to the
+ *   resources, without uploading anything. The prepared data is kept by
+ *   the resources and used if they are loaded later.
+ */
+void ResourceManager::cancelLoading() {
+  for (auto& loading : mLoading) {
+    try {
+      loading.second.get();
+    } catch (const std::exception& e) {
+      mLog->debug("Cancelled '{}': {}",
+                  mResources[loading.first].resource->name(),
+                  e.what());
+    }
+  }
+
+  mLoading.clear();
+}
+
+/**
+ * @brief
+ *   Unloads the resource. Increasing the generation makes every handle to
+ *   it load it again the next time it is used.
+ *
+ * @param entry
+ */
+void ResourceManager::unload(Entry& entry) {
+  entry.resource->unload();
+  entry.resource->setLoaded(false);
+  entry.generation++;
+}
+
+void ResourceManager::unloadAll() {
+  cancelLoading();
+
+  for (auto& entry : mResources) {
+    if (entry.resource->loaded())
+      unload(entry);
   }
 }
 
 void ResourceManager::unloadUnnecessary(ResourceScope scope) {
+  cancelLoading();
+
   mCurrentScope = scope;
-  for (auto& rPair : mResources) {
-    if (!rPair.second->includesScope(scope) && rPair.second->loaded()) {
-      rPair.second->unload();
-      rPair.second->setLoaded(false);
-    }
+  for (auto& entry : mResources) {
+    if (!entry.resource->includesScope(scope) && entry.resource->loaded())
+      unload(entry);
   }
 }
 
@@ -75,37 +292,63 @@ void ResourceManager::loadDescription(const std::string& filename) {
                          std::string   path,
                          ResourceType  type,
                          ResourceScope scope) {
-    bool existsButDifferent =
-      mResources.count(name) && mResources[name]->filename() != path;
-    if (existsButDifferent) {
+    auto existing = mIndices.find(name);
+
+    if (existing != mIndices.end() &&
+        mResources[existing->second].resource->filename() != path) {
       throw std::invalid_argument(
         "Name already in resourcename with different filename");
     }
 
+    std::shared_ptr<Resource> resource;
+
     switch (type) {
       case ResourceType::Program:
-        mResources[name] = std::shared_ptr<Resource>(new class Program());
+        resource = std::shared_ptr<Resource>(new class Program());
         break;
       case ResourceType::Font:
-        mResources[name] = std::shared_ptr<Resource>(new class Font());
+        resource = std::shared_ptr<Resource>(new class Font());
         break;
       case ResourceType::Texture:
-        mResources[name] = std::shared_ptr<Resource>(new class Texture());
+        resource = std::shared_ptr<Resource>(new class Texture());
         break;
       case ResourceType::Mesh:
-        mResources[name] = std::shared_ptr<Resource>(new class Mesh());
+        resource = std::shared_ptr<Resource>(new class Mesh());
         break;
       case ResourceType::PhysicsMesh:
-        mResources[name] = std::shared_ptr<Resource>(new class PhysicsMesh());
+        resource = std::shared_ptr<Resource>(new class PhysicsMesh());
         break;
       default:
         throw std::runtime_error("ResourceType implementation does not exist");
     }
 
-    mResources[name]->setFilename(path);
-    mResources[name]->setScope(scope);
-    mResources[name]->setType(type);
-    mResources[name]->setName(name);
+    resource->setFilename(path);
+    resource->setScope(scope);
+    resource->setType(type);
+    resource->setName(name);
+
+    // Adding the same resource again replaces it, but keeps its index so
+    // that handles to it stay valid. The generation is increased even if
+    // it was not loaded, since the handles hold on to the old resource
+    if (existing != mIndices.end()) {
+      Entry& entry   = mResources[existing->second];
+      auto   loading = mLoading.find(existing->second);
+
+      if (loading != mLoading.end()) {
+        loading->second.wait();
+        mLoading.erase(loading);
+      }
+
+      if (entry.resource->loaded())
+        entry.resource->unload();
+
+      entry.resource = resource;
+      entry.generation++;
+    } else {
+      mIndices[name] = mResources.size();
+      mResources.push_back({ resource, 0 });
+    }
+
     mLog->debug("Added '{}'", name);
   };
 
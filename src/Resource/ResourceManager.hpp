@@ -1,32 +1,104 @@
 #pragma once
 
+#include <cstdint>
+#include <future>
 #include <map>
 #include <memory>
+#include <stdexcept>
 #include <string>
-#include <type_traits>
+#include <vector>
 
 #include "../Log.hpp"
 #include "Resource.hpp"
+#include "ResourceHandle.hpp"
 
-class Texture;
-
+/**
+ * @brief
+ *   Keeps track of every resource described in `media/resources.lua` and
+ *   loads or unloads them as the scope changes.
+ *
+ *   Resources are loaded in two steps. `Resource::prepare` reads and
+ *   decodes files on the worker threads of the global ThreadPool, then
+ *   `Resource::load` uploads the result on the main thread, which is the
+ *   only thread with an OpenGL context.
+ *
+ *   `loadRequired` does both steps before it returns, while
+ *   `loadRequiredAsync` only starts the first one. The uploads are then
+ *   done a few at a time by `update`, which is called once per frame. A
+ *   resource that is needed before that is finished by `get`, which only
+ *   waits for that one resource.
+ *
+ *   Resources are stored in an array and named only to be found by
+ *   `handle` or `get`. Code that uses a resource repeatedly should keep
+ *   the handle, which skips the lookup by name.
+ */
 class ResourceManager : public Logging::Log {
 public:
   ResourceManager();
   ~ResourceManager();
 
+  // Looks the resource up by name, loading it if it is not loaded
+  template <typename T>
+  ResourceHandle<T> handle(const std::string& name);
+
   template <typename T>
   std::shared_ptr<T> get(const std::string& name);
 
+  // Returns whether the resource has been unloaded since the generation
+  bool isCurrent(size_t index, uint32_t generation) const;
+
+  // Loads the resource if it is not loaded, returning its generation
+  uint32_t acquire(size_t index);
+
+  // Returns the resource at the index, which must have the type T
+  template <typename T>
+  std::shared_ptr<T> resource(size_t index) const;
+
   void loadDescription(const std::string& filename);
 
+  // Loads every resource of the scope before returning
   void loadRequired(ResourceScope scope);
+
+  // Starts loading every resource of the scope in the background
+  void loadRequiredAsync(ResourceScope scope);
+
+  // Uploads resources that have been prepared in the background until
+  // `budget` seconds have passed. Returns true when nothing is loading
+  bool update(float budget);
+
+  // Blocks until every resource that is loading has been loaded
+  void finishLoading();
+
+  // Returns the number of resources that are still loading
+  size_t numLoading() const;
+
   void unloadAll();
   void unloadUnnecessary(ResourceScope scope);
 
 private:
-  ResourceScope mCurrentScope;
-  std::map<std::string, std::shared_ptr<Resource>> mResources;
+  struct Entry {
+    std::shared_ptr<Resource> resource;
+
+    // Increased every time the resource is unloaded or replaced
+    uint32_t generation;
+  };
+
+  // Returns the index of the resource, checking that it has the type
+  size_t indexOf(const std::string& name, ResourceType type);
+
+  // Waits for the resource to be prepared, if it is, and loads it
+  bool finish(size_t index);
+
+  // Unloads the resource and increases its generation
+  void unload(Entry& entry);
+
+  // Waits for every prepare that is running, throwing away the results
+  void cancelLoading();
+
+  ResourceScope                       mCurrentScope;
+  std::vector<Entry>                  mResources;
+  std::map<std::string, size_t>       mIndices;
+  std::map<size_t, std::future<void>> mLoading;
 };
 
 // ----------------------------------------------------------
@@ -35,30 +107,59 @@ private:
 //
 // ----------------------------------------------------------
 
+inline bool ResourceManager::isCurrent(size_t   index,
+                                       uint32_t generation) const {
+  return mResources[index].generation == generation;
+}
+
+/**
+ * @brief
+ *   Returns a handle to the resource. The type is checked once here, so
+ *   the handle can hold the resource as a T without casting it again.
+ *
+ *   Textures that do not exist are replaced by the debug texture, any
+ *   other resource that does not exist throws.
+ *
+ * @param name
+ *
+ * @return
+ */
+template <typename T>
+ResourceHandle<T> ResourceManager::handle(const std::string& name) {
+  size_t   index      = indexOf(name, T::TYPE);
+  uint32_t generation = acquire(index);
+
+  return ResourceHandle<T>(
+    this,
+    index,
+    generation,
+    std::static_pointer_cast<T>(mResources[index].resource));
+}
+
+template <typename T>
+std::shared_ptr<T> ResourceManager::resource(size_t index) const {
+  return std::static_pointer_cast<T>(mResources[index].resource);
+}
+
 template <typename T>
 std::shared_ptr<T> ResourceManager::get(const std::string& name) {
-  bool invalid = mResources.count(name) == 0;
-  if (invalid && std::is_same<T, Texture>::value && name != "Texture::Debug") {
-    mLog->error("Tried to load Texture that did not exist: {}", name);
-    return get<T>("Texture::Debug");
-  } else if (invalid)
-    throw std::runtime_error("Could not find filename for " + name);
-
-  if (!mResources[name]->includesScope(mCurrentScope)) {
-    throw std::runtime_error("'" + name + "' is not available for scope: '" +
-                             std::to_string(static_cast<int>(mCurrentScope)) +
-                             "'");
-  }
+  size_t index = indexOf(name, T::TYPE);
+  acquire(index);
 
-  if (mResources[name]->loaded())
-    return std::dynamic_pointer_cast<T>(mResources[name]);
+  return std::static_pointer_cast<T>(mResources[index].resource);
+}
 
-  bool result = mResources[name]->load(this);
+template <typename T>
+const std::shared_ptr<T>& ResourceHandle<T>::get() {
+  if (mManager == nullptr)
+    throw std::runtime_error("Tried to use an empty resource handle");
 
-  if (!result)
-    throw std::runtime_error("Failed to load resource: '" + name + "'");
-  else
-    mResources[name]->setLoaded(true);
+  // The resource may have been replaced by another one with the same
+  // name, so it is looked up again by its index
+  if (!mManager->isCurrent(mIndex, mGeneration)) {
+    mGeneration = mManager->acquire(mIndex);
+    mResource   = mManager->resource<T>(mIndex);
+  }
 
-  return std::dynamic_pointer_cast<T>(mResources[name]);
+  return mResource;
 }
@@ -15,7 +15,8 @@ Texture::Texture()
     , mMode(0)
     , mTextureId(0)
     , mSamplerId(0)
-    , mSize(0, 0) {}
+    , mSize(0, 0)
+    , mImage(nullptr) {}
 
 void Texture::unload() {
   mLog->debug("Unloading {}", mFilename);
@@ -33,12 +34,16 @@ void Texture::unload() {
   if (mSamplerId != 0)
     glDeleteSamplers(1, &mSamplerId);
 
+  if (mImage != nullptr)
+    SOIL_free_image_data(mImage);
+
   mTextureId = 0;
   mSamplerId = 0;
+  mImage     = nullptr;
 }
 
 Texture::~Texture() {
-  if (mLoaded)
+  if (mLoaded || mImage != nullptr)
     unload();
 }
 
@@ -102,25 +107,44 @@ bool Texture::load(ResourceManager*) {
   return true;
 }
 
-bool Texture::loadTexture() {
-  int            width, height;
-  unsigned char* image;
+/**
+ * @brief
+ *   Decodes the image file into memory without touching OpenGL, so that
+ *   it can be done on another thread than the one that uploads it.
+ *
+ * @return
+ */
+bool Texture::prepare() {
+  bool isDDS = mFilename.substr(mFilename.size() - 4) == ".dds";
+
+  if (mImage != nullptr || isDDS)
+    return true;
 
-  image =
+  int width, height;
+
+  mImage =
     SOIL_load_image(mFilename.c_str(), &width, &height, 0, SOIL_LOAD_RGBA);
 
-  if (image == 0)
+  if (mImage == 0)
     throw std::runtime_error("Failed to load SOIL_IMAGE");
 
+  mSize = vec2(width, height);
+  return true;
+}
+
+bool Texture::loadTexture() {
+  if (mImage == nullptr)
+    prepare();
+
   glTexImage2D(GL_TEXTURE_2D,
                0,
                GL_RGBA8,
-               width,
-               height,
+               mSize.x,
+               mSize.y,
                0,
                GL_RGBA,
                GL_UNSIGNED_BYTE,
-               image);
+               mImage);
 
   if (!Utils::getGLError())
     throw std::runtime_error("Failed to load SOIL_IMAGE");
@@ -135,8 +159,8 @@ bool Texture::loadTexture() {
     clampToEdge();
   }
 
-  SOIL_free_image_data(image);
-  mSize = vec2(width, height);
+  SOIL_free_image_data(mImage);
+  mImage = nullptr;
   return true;
 }
 
@@ -15,6 +15,8 @@ class ResourceManager;
 //! can load .PNG & .dds.
 class Texture : public Resource, public Logging::Log {
 public:
+  static constexpr ResourceType TYPE = ResourceType::Texture;
+
   //! Textures to load - MODE
   enum { GUI, TEXTURE, DDS, CUBE, MAP, EMPTY };
   enum { CUBENORMAL, CUBEREFLECTION };
@@ -28,6 +30,10 @@ public:
   //! Loads a texture using SOIL. Can load .PNG
   bool load(ResourceManager*);
 
+  //! Decodes the image so that load only has to upload it. Does nothing
+  //! for .dds, which SOIL uploads as it decodes
+  bool prepare();
+
   void unload();
 
   //! Loads a white texture into OpenGL with specified size -
@@ -90,6 +96,9 @@ private:
   GLuint    mSamplerId;
   mmm::vec2 mSize;
 
+  // The decoded image between prepare and load
+  unsigned char* mImage;
+
   static std::map<unsigned int, GLuint> activeTextures;
   static GLuint activeTexture;
 };
@@ -0,0 +1,181 @@
+#include "ControllerRuntime.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+// The generated header and its namespace are given by the build
+#include CONTROLLER_HEADER
+
+namespace {
+  namespace Generated = CONTROLLER_NAMESPACE;
+
+  // Largest difference allowed between the two implementations
+  const float TOLERANCE = 1e-5f;
+
+  // Number of steps each implementation is timed for
+  const size_t BENCHMARK_STEPS = 1000000;
+
+  /**
+   * @brief
+   *   Reads the sensors recorded by `swarm:recordSensors`, one step per
+   *   line. Without a recording, random sensors are used instead.
+   *
+   * @param filename
+   * @param numSensors
+   *
+   * @return
+   */
+  std::vector<std::vector<float>> readSensors(const std::string& filename,
+                                              size_t numSensors) {
+    std::vector<std::vector<float>> steps;
+
+    if (filename.empty()) {
+      std::mt19937                          random(1);
+      std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+      for (size_t i = 0; i < 1000; ++i) {
+        steps.push_back({});
+
+        for (size_t s = 0; s < numSensors; ++s)
+          steps.back().push_back(value(random));
+      }
+
+      return steps;
+    }
+
+    std::ifstream fs(filename);
+    std::string   line;
+
+    if (!fs.is_open())
+      throw std::runtime_error("Unable to open recording: " + filename);
+
+    while (std::getline(fs, line)) {
+      std::istringstream values(line);
+      std::vector<float> sensors;
+      float              value;
+
+      while (values >> value)
+        sensors.push_back(value);
+
+      if (sensors.empty())
+        continue;
+
+      if (sensors.size() != numSensors)
+        throw std::runtime_error("Recording does not match the controller");
+
+      steps.push_back(sensors);
+    }
+
+    if (steps.empty())
+      throw std::runtime_error("Recording is empty: " + filename);
+
+    return steps;
+  }
+
+  /**
+   * @brief
+   *   Runs the controller over the recorded steps until BENCHMARK_STEPS
+   *   steps have been taken, returning the average time of a step in
+   *   nanoseconds
+   *
+   * @param controller
+   * @param steps
+   * @param numMotors
+   *
+   * @return
+   */
+  template <typename Controller>
+  double benchmark(Controller&                            controller,
+                   const std::vector<std::vector<float>>& steps,
+                   size_t                                 numMotors) {
+    std::vector<float> motors(std::max<size_t>(numMotors, 1));
+    volatile float     sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < BENCHMARK_STEPS; ++i) {
+      if (i % steps.size() == 0)
+        controller.reset();
+
+      controller.step(steps[i % steps.size()].data(), motors.data());
+      sink = sink + motors[0];
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+           BENCHMARK_STEPS;
+  }
+}
+
+/**
+ * @brief
+ *   Compares the generated controller against ControllerRuntime on the
+ *   same sensors and times a step of each of them:
+ *
+ *   CheckController WalkingChampion.controller [WalkingChampion.sensors]
+ *
+ *   Returns 1 if the motor targets differ by more than TOLERANCE.
+ *
+ * @param argc
+ * @param argv
+ *
+ * @return
+ */
+int main(int argc, char* argv[]) {
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: " << argv[0] << " <controller> [recording]"
+              << std::endl;
+    return 1;
+  }
+
+  try {
+    ControllerRuntime     runtime(argv[1]);
+    Generated::Controller generated;
+
+    if (runtime.numSensors() != Generated::numSensors ||
+        runtime.numMotors() != Generated::numMotors)
+      throw std::runtime_error("Generated code does not match controller");
+
+    auto steps = readSensors(argc == 3 ? argv[2] : "", runtime.numSensors());
+
+    std::vector<float> expected(runtime.numMotors());
+    std::vector<float> actual(runtime.numMotors());
+    float              worst = 0;
+
+    for (auto& sensors : steps) {
+      runtime.step(sensors.data(), expected.data());
+      generated.step(sensors.data(), actual.data());
+
+      for (size_t i = 0; i < expected.size(); ++i)
+        worst = std::max(worst, std::abs(expected[i] - actual[i]));
+    }
+
+    double interpreted = benchmark(runtime, steps, runtime.numMotors());
+    double compiled    = benchmark(generated, steps, runtime.numMotors());
+
+    std::cout << "Steps compared:     " << steps.size() << std::endl;
+    std::cout << "Largest difference: " << worst << std::endl;
+    std::cout << "ControllerRuntime:  " << interpreted << " ns/step"
+              << std::endl;
+    std::cout << "Generated code:     " << compiled << " ns/step ("
+              << interpreted / compiled << "x)" << std::endl;
+
+    if (!(worst <= TOLERANCE)) {
+      std::cerr << "Generated code differs from ControllerRuntime"
+                << std::endl;
+      return 1;
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,439 @@
+#include "ControllerCodegen.hpp"
+
+#include "ControllerFile.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+  typedef ControllerFile::Function Function;
+
+  /**
+   * @brief
+   *   Writes the float as a literal that is read back as the exact same
+   *   float by the compiler
+   *
+   * @param value
+   *
+   * @return
+   */
+  std::string literal(float value) {
+    if (!std::isfinite(value))
+      throw std::runtime_error("Cannot generate code for non-finite value");
+
+    std::ostringstream ss;
+    ss << std::setprecision(std::numeric_limits<float>::max_digits10)
+       << value;
+
+    std::string str = ss.str();
+
+    if (str.find_first_of(".e") == std::string::npos)
+      str += ".0";
+
+    return "(" + str + "f)";
+  }
+
+  /**
+   * @brief
+   *   Returns the activation function applied to `x`, written in the same
+   *   way as ControllerRuntime computes it so that the results are equal
+   *
+   * @param function
+   * @param x
+   * @param a
+   * @param b
+   *
+   * @return
+   */
+  std::string activation(Function           function,
+                         const std::string& x,
+                         float              a,
+                         float              b) {
+    std::string la = literal(a);
+    std::string lb = literal(b);
+
+    switch (function) {
+      case Function::SignedSigmoid:
+        return "(1.0f / (1.0f + std::exp(-" + la + " * " + x + " - " + lb +
+               ")) - 0.5f) * 2.0f";
+      case Function::UnsignedSigmoid:
+        return "1.0f / (1.0f + std::exp(-" + la + " * " + x + " - " + lb +
+               "))";
+      case Function::Tanh:
+        return "std::tanh(" + x + " * " + la + ")";
+      case Function::TanhCubic:
+        return "std::tanh(" + x + " * " + x + " * " + x + " * " + la + ")";
+      case Function::SignedStep:
+        return x + " > " + lb + " ? 1.0f : -1.0f";
+      case Function::UnsignedStep:
+        return x + " > 0.5f + " + lb + " ? 1.0f : 0.0f";
+      case Function::SignedGauss:
+        return "(std::exp(-" + la + " * " + x + " * " + x + " + " + lb +
+               ") - 0.5f) * 2.0f";
+      case Function::UnsignedGauss:
+        return "std::exp(-" + la + " * " + x + " * " + x + " + " + lb + ")";
+      case Function::Abs:
+        return "std::abs(" + x + " + " + lb + ")";
+      case Function::SignedSine:
+        return "std::sin(" + x + " * " + la + " + " + lb + ")";
+      case Function::UnsignedSine:
+        return "(std::sin(" + x + " * " + la + " + " + lb + ") + 1.0f) / 2.0f";
+      case Function::Linear:
+        return x + " + " + lb;
+      case Function::Relu:
+        return x + " > 0 ? " + x + " : 0";
+      case Function::Softplus:
+        return "std::log(1.0f + std::exp(" + x + "))";
+    }
+
+    return x;
+  }
+
+  /**
+   * @brief
+   *   Writes the names as a null terminated array, so that the array is
+   *   never empty
+   *
+   * @param out
+   * @param name
+   * @param names
+   */
+  void writeNames(std::ostream&                   out,
+                  const std::string&              name,
+                  const std::vector<std::string>& names) {
+    out << "constexpr const char* " << name << "[] = {\n";
+
+    for (auto& n : names)
+      out << "  \"" << n << "\",\n";
+
+    out << "  nullptr\n};\n\n";
+  }
+
+  /**
+   * @brief
+   *   Writes the statements that set the input neurons from the sensors,
+   *   the clock and the outputs of the previous step
+   *
+   * @param out
+   * @param file
+   */
+  void writeInputs(std::ostream& out, const ControllerFile& file) {
+    typedef ControllerFile::InputType Type;
+
+    for (size_t i = 0; i < file.inputs.size(); ++i) {
+      const ControllerFile::Input& in = file.inputs[i];
+
+      out << "    mActivation[" << i << "] = ";
+
+      switch (in.type) {
+        case Type::Feedback:
+          out << "mActivation[" << file.numInputs + in.index << "]";
+          break;
+        case Type::Constant:
+          out << literal(in.value);
+          break;
+        case Type::Clock:
+          out << "std::sin(mTime * " << literal(in.value) << " + "
+              << literal(in.phase) << ")";
+          break;
+        case Type::Sensor:
+          out << "sensors[" << in.index << "]";
+          break;
+        case Type::Angle:
+          out << "normalizeAngle(sensors[" << in.index << "] + "
+              << literal(in.value) << ", " << literal(in.low) << ", "
+              << literal(in.up) << ", " << literal(in.rest) << ")";
+          break;
+      }
+
+      out << ";\n";
+    }
+  }
+
+  /**
+   * @brief
+   *   Writes the sum of the connections into each neuron. Connections are
+   *   stored in `weights` in the same order as they are summed, with the
+   *   recurrent connections of a neuron after the others, which is also
+   *   the order used by ControllerRuntime.
+   *
+   * @param out
+   * @param indent
+   * @param file
+   * @param neuron
+   * @param sum
+   * @param previous
+   * @param weight
+   */
+  void writeSum(std::ostream&         out,
+                const std::string&    indent,
+                const ControllerFile& file,
+                uint32_t              neuron,
+                const std::string&    sum,
+                const std::string&    previous,
+                size_t&               weight) {
+    out << indent << sum << " = 0;\n";
+
+    for (int recurrent = 0; recurrent < 2; ++recurrent) {
+      for (auto& c : file.connections) {
+        if (c.target != neuron || c.recurrent != (recurrent == 1))
+          continue;
+
+        out << indent << sum << " += "
+            << (c.recurrent ? previous : "mActivation") << "[" << c.source
+            << "] * weights[" << weight << "];\n";
+        weight += 1;
+      }
+    }
+  }
+
+  void writeWeights(std::ostream& out, const ControllerFile& file) {
+    if (file.connections.empty())
+      return;
+
+    out << "// In the order that they are summed\n";
+    out << "constexpr float weights[] = {\n";
+
+    for (uint32_t n = 0; n < file.neurons.size(); ++n)
+      for (int recurrent = 0; recurrent < 2; ++recurrent)
+        for (auto& c : file.connections)
+          if (c.target == n && c.recurrent == (recurrent == 1))
+            out << "  " << literal(c.weight) << ",\n";
+
+    out << "};\n\n";
+  }
+
+  /**
+   * @brief
+   *   Writes `activate` for networks that are activated in layers, with
+   *   `pass` activating every neuron once
+   *
+   * @param out
+   * @param file
+   * @param recurrent
+   */
+  void writeLayered(std::ostream&         out,
+                    const ControllerFile& file,
+                    bool                  recurrent) {
+    out << "  void activate() {\n"
+        << "    for (std::size_t i = " << file.numInputs << "; i < "
+        << file.numNeurons << "; ++i)\n"
+        << "      mActivation[i] = 0;\n\n"
+        << "    pass();\n";
+
+    if (recurrent)
+      out << "\n"
+          << "    for (unsigned p = 1; p < " << file.passes << "; ++p) {\n"
+          << "      pass();\n\n"
+          << "      float change = 0;\n\n"
+          << "      for (std::size_t i = " << file.numInputs << "; i < "
+          << file.numNeurons << "; ++i)\n"
+          << "        change = std::max(change,\n"
+          << "                          std::abs(mActivation[i] - "
+          << "mPrevious[i]));\n\n"
+          << "      if (change <= " << literal(file.tolerance) << ")\n"
+          << "        break;\n"
+          << "    }\n";
+
+    out << "  }\n\n";
+    out << "  void pass() {\n";
+
+    if (recurrent)
+      out << "    for (std::size_t i = 0; i < " << file.numNeurons
+          << "; ++i)\n"
+          << "      mPrevious[i] = mActivation[i];\n\n";
+
+    out << "    float s;\n";
+
+    size_t weight = 0;
+
+    for (uint32_t i = 0; i < file.neurons.size(); ++i) {
+      const ControllerFile::Neuron& n = file.neurons[i];
+
+      out << "\n";
+      writeSum(out, "    ", file, i, "s", "mPrevious", weight);
+      out << "    mActivation[" << n.index
+          << "] = " << activation(n.function, "s", n.a, n.b) << ";\n";
+    }
+
+    out << "  }\n\n";
+  }
+
+  /**
+   * @brief
+   *   Writes `activate` for leaky networks, which integrates the membrane
+   *   potentials in `passes` smaller steps. The rate of each neuron is
+   *   computed here in the same way as by ControllerRuntime.
+   *
+   * @param out
+   * @param file
+   */
+  void writeLeaky(std::ostream& out, const ControllerFile& file) {
+    uint32_t passes = std::max<uint32_t>(file.passes, 1);
+    float    step   = file.timeStep / passes;
+    size_t   weight = 0;
+
+    out << "  void activate() {\n"
+        << "    for (unsigned p = 0; p < " << passes << "; ++p) {\n";
+
+    // Every connection reads the activations from the previous step
+    for (uint32_t i = 0; i < file.neurons.size(); ++i) {
+      std::string sum = "mSum[" + std::to_string(i) + "]";
+      writeSum(out, "      ", file, i, sum, "mActivation", weight);
+    }
+
+    out << "\n      float s;\n";
+
+    for (uint32_t i = 0; i < file.neurons.size(); ++i) {
+      const ControllerFile::Neuron& n = file.neurons[i];
+      float rate = n.timeConst > 0 ? step / n.timeConst : 1.0f;
+
+      out << "\n"
+          << "      mMembrane[" << i << "] = " << literal(1.0f - rate)
+          << " * mMembrane[" << i << "] + " << literal(rate) << " * mSum["
+          << i << "];\n"
+          << "      s = mMembrane[" << i << "] + " << literal(n.bias) << ";\n"
+          << "      mActivation[" << n.index
+          << "] = " << activation(n.function, "s", n.a, n.b) << ";\n";
+    }
+
+    out << "    }\n  }\n\n";
+  }
+}
+
+/**
+ * @brief
+ *   Writes the header. The network is written out neuron by neuron, while
+ *   the inputs and motors are mapped in the same way as by
+ *   ControllerRuntime.
+ *
+ * @param file
+ * @param name
+ * @param out
+ */
+void ControllerCodegen::write(const ControllerFile& file,
+                              const std::string&    name,
+                              std::ostream&         out) {
+  file.validate();
+
+  bool recurrent = false;
+  bool angles    = false;
+
+  for (auto& c : file.connections)
+    recurrent = recurrent || c.recurrent;
+
+  for (auto& i : file.inputs)
+    angles = angles || i.type == ControllerFile::InputType::Angle;
+
+  out << "// Generated from a controller file by GenerateController, do not "
+         "edit\n"
+      << "#pragma once\n\n"
+      << "#include <algorithm>\n"
+      << "#include <cmath>\n"
+      << "#include <cstddef>\n\n"
+      << "namespace " << name << " {\n"
+      << "constexpr std::size_t numSensors = " << file.sensors.size()
+      << ";\n"
+      << "constexpr std::size_t numMotors  = " << file.motors.size() << ";\n"
+      << "constexpr float       timeStep   = " << literal(file.timeStep)
+      << ";\n\n";
+
+  writeNames(out, "sensorNames", file.sensors);
+
+  std::vector<std::string> motors;
+
+  for (auto& m : file.motors)
+    motors.push_back(m.name);
+
+  writeNames(out, "motorNames", motors);
+  writeWeights(out, file);
+
+  if (angles)
+    out << "inline float normalizeAngle(float angle, float low, float up,\n"
+        << "                            float rest) {\n"
+        << "  const float PI = 3.14159265358979f;\n\n"
+        << "  if (angle < low)\n"
+        << "    angle += 2.f * PI;\n"
+        << "  if (angle > up)\n"
+        << "    angle -= 2.f * PI;\n\n"
+        << "  if (angle - rest == 0.f)\n"
+        << "    return 0.f;\n\n"
+        << "  return angle < rest ? -(angle - rest) / (low - rest) :\n"
+        << "                        (angle - rest) / (up - rest);\n"
+        << "}\n\n";
+
+  out << "inline float denormalizeAngle(float p, float low, float up,\n"
+      << "                              float rest) {\n"
+      << "  return p < 0 ? p * std::abs(low - rest) + rest :\n"
+      << "                 p * std::abs(up - rest) + rest;\n"
+      << "}\n\n";
+
+  out << "class Controller {\n"
+      << "public:\n"
+      << "  Controller() { reset(); }\n\n"
+      << "  void reset() {\n"
+      << "    mTime = 0;\n\n"
+      << "    for (auto& a : mActivation)\n"
+      << "      a = 0;\n";
+
+  if (file.leaky)
+    out << "\n    for (auto& m : mMembrane)\n"
+        << "      m = 0;\n";
+
+  out << "  }\n\n"
+      << "  void step(const float* sensors, float* motors) {\n"
+      << "    (void)sensors;\n"
+      << "    (void)motors;\n\n"
+      << "    mTime += timeStep;\n\n";
+
+  writeInputs(out, file);
+
+  out << "\n    activate();\n\n";
+
+  for (size_t i = 0; i < file.motors.size(); ++i) {
+    const ControllerFile::Motor& m = file.motors[i];
+
+    out << "    motors[" << i << "] = denormalizeAngle(mActivation["
+        << file.numInputs + m.output << "], " << literal(m.low) << ", "
+        << literal(m.up) << ", " << literal(m.rest) << ");\n";
+  }
+
+  out << "  }\n\n"
+      << "private:\n";
+
+  if (file.leaky)
+    writeLeaky(out, file);
+  else
+    writeLayered(out, file, recurrent);
+
+  size_t size = std::max<size_t>(file.neurons.size(), 1);
+
+  out << "  float mTime;\n"
+      << "  float mActivation[" << file.numNeurons << "];\n";
+
+  if (recurrent && !file.leaky)
+    out << "  float mPrevious[" << file.numNeurons << "];\n";
+
+  if (file.leaky)
+    out << "  float mMembrane[" << size << "];\n"
+        << "  float mSum[" << size << "];\n";
+
+  out << "};\n"
+      << "}\n";
+}
+
+void ControllerCodegen::save(const ControllerFile& file,
+                             const std::string&    name,
+                             const std::string&    filename) {
+  std::ofstream fs(filename);
+
+  if (!fs.is_open())
+    throw std::runtime_error("Unable to write controller code: " + filename);
+
+  write(file, name, fs);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <iosfwd>
+#include <string>
+
+struct ControllerFile;
+
+/**
+ * @brief
+ *   Turns a ControllerFile into a C++ header, so that a fixed champion
+ *   can be compiled into a program instead of being interpreted by
+ *   ControllerRuntime.
+ *
+ *   The weights are stored in constexpr arrays and every neuron becomes
+ *   its own statement in the order of activation, which lets the compiler
+ *   see the whole network. The generated controller has the same
+ *   interface and gives the same outputs as ControllerRuntime:
+ *
+ *     #include "WalkingChampion.hpp"
+ *
+ *     WalkingChampion::Controller controller;
+ *     controller.step(sensors, motors);
+ *
+ *   The header only depends on the standard library.
+ */
+namespace ControllerCodegen {
+  // Writes the header with everything placed in the given namespace
+  void write(const ControllerFile& file,
+             const std::string&    name,
+             std::ostream&         out);
+
+  // Writes the header to the file, throwing if it cannot be opened
+  void save(const ControllerFile& file,
+            const std::string&    name,
+            const std::string&    filename);
+}
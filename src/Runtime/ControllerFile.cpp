@@ -0,0 +1,229 @@
+#include "ControllerFile.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+  const int VERSION = 1;
+
+  const char* FUNCTION_NAMES[] = {
+    "signed_sigmoid", "unsigned_sigmoid", "tanh",        "tanh_cubic",
+    "signed_step",    "unsigned_step",    "signed_gauss", "unsigned_gauss",
+    "abs",            "signed_sine",      "unsigned_sine", "linear",
+    "relu",           "softplus"
+  };
+
+  const char* INPUT_NAMES[] = { "feedback", "constant", "clock", "sensor",
+                                "angle" };
+
+  ControllerFile::InputType inputTypeFromName(const std::string& name) {
+    for (int i = 0; i < 5; ++i)
+      if (name == INPUT_NAMES[i])
+        return static_cast<ControllerFile::InputType>(i);
+
+    throw std::runtime_error("Unknown controller input type: " + name);
+  }
+
+  /**
+   * @brief
+   *   Throws if any of the values of the line could not be read
+   *
+   * @param line
+   * @param number
+   */
+  void check(const std::istringstream& line, size_t number) {
+    if (line.fail())
+      throw std::runtime_error("Invalid controller file at line " +
+                               std::to_string(number));
+  }
+}
+
+ControllerFile::Input ControllerFile::Input::feedback(uint32_t output) {
+  return { InputType::Feedback, output, 0, 0, 0, 0, 0 };
+}
+
+ControllerFile::Input ControllerFile::Input::constant(float value) {
+  return { InputType::Constant, 0, value, 0, 0, 0, 0 };
+}
+
+ControllerFile::Input ControllerFile::Input::clock(float frequency,
+                                                   float phase) {
+  return { InputType::Clock, 0, frequency, phase, 0, 0, 0 };
+}
+
+ControllerFile::Input ControllerFile::Input::sensor(uint32_t sensor) {
+  return { InputType::Sensor, sensor, 0, 0, 0, 0, 0 };
+}
+
+ControllerFile::Input ControllerFile::Input::angle(
+  uint32_t sensor, float low, float up, float rest, float offset) {
+  return { InputType::Angle, sensor, offset, 0, low, up, rest };
+}
+
+uint32_t ControllerFile::addSensor(const std::string& name) {
+  for (uint32_t i = 0; i < sensors.size(); ++i)
+    if (sensors[i] == name)
+      return i;
+
+  sensors.push_back(name);
+  return sensors.size() - 1;
+}
+
+/**
+ * @brief
+ *   Makes sure that every index in the file is within the network and the
+ *   mapping, so that the runtime never has to check them
+ */
+void ControllerFile::validate() const {
+  if (numInputs + numOutputs > numNeurons)
+    throw std::runtime_error("Controller has more inputs and outputs than "
+                             "neurons");
+
+  if (neurons.size() != numNeurons - numInputs)
+    throw std::runtime_error("Controller has the wrong number of neurons");
+
+  for (auto& n : neurons)
+    if (n.index < numInputs || n.index >= numNeurons)
+      throw std::runtime_error("Controller neuron is out of range");
+
+  for (auto& c : connections)
+    if (c.target >= neurons.size() || c.source >= numNeurons)
+      throw std::runtime_error("Controller connection is out of range");
+
+  if (inputs.size() != numInputs)
+    throw std::runtime_error("Controller must map every input");
+
+  for (auto& i : inputs) {
+    bool isSensor =
+      i.type == InputType::Sensor || i.type == InputType::Angle;
+
+    if (isSensor && i.index >= sensors.size())
+      throw std::runtime_error("Controller input uses an unknown sensor");
+
+    if (i.type == InputType::Feedback && i.index >= numOutputs)
+      throw std::runtime_error("Controller input uses an unknown output");
+  }
+
+  for (auto& m : motors)
+    if (m.output >= numOutputs)
+      throw std::runtime_error("Controller motor uses an unknown output");
+}
+
+void ControllerFile::save(const std::string& filename) const {
+  validate();
+
+  std::ofstream fs(filename);
+
+  if (!fs.is_open())
+    throw std::runtime_error("Unable to write controller: " + filename);
+
+  // Enough digits for every float to be read back exactly
+  fs << std::setprecision(std::numeric_limits<float>::max_digits10);
+
+  fs << "controller " << VERSION << std::endl;
+  fs << "network " << numNeurons << " " << numInputs << " " << numOutputs
+     << " " << leaky << " " << passes << " " << tolerance << " " << timeStep
+     << std::endl;
+
+  for (auto& n : neurons)
+    fs << "neuron " << n.index << " " << functionName(n.function) << " "
+       << n.a << " " << n.b << " " << n.timeConst << " " << n.bias
+       << std::endl;
+
+  for (auto& c : connections)
+    fs << "connection " << c.target << " " << c.source << " " << c.weight
+       << " " << c.recurrent << std::endl;
+
+  for (auto& s : sensors)
+    fs << "sensor " << s << std::endl;
+
+  for (auto& i : inputs)
+    fs << "input " << INPUT_NAMES[static_cast<int>(i.type)] << " " << i.index
+       << " " << i.value << " " << i.phase << " " << i.low << " " << i.up
+       << " " << i.rest << std::endl;
+
+  for (auto& m : motors)
+    fs << "motor " << m.name << " " << m.output << " " << m.low << " "
+       << m.up << " " << m.rest << std::endl;
+}
+
+ControllerFile ControllerFile::load(const std::string& filename) {
+  std::ifstream fs(filename);
+
+  if (!fs.is_open())
+    throw std::runtime_error("Unable to open controller: " + filename);
+
+  ControllerFile file;
+  std::string    line;
+  size_t         number = 0;
+  int            version = 0;
+
+  while (std::getline(fs, line)) {
+    std::istringstream values(line);
+    std::string        key;
+
+    number += 1;
+
+    if (!(values >> key))
+      continue;
+
+    if (key == "controller") {
+      values >> version;
+    } else if (key == "network") {
+      values >> file.numNeurons >> file.numInputs >> file.numOutputs >>
+        file.leaky >> file.passes >> file.tolerance >> file.timeStep;
+    } else if (key == "neuron") {
+      Neuron      n;
+      std::string function;
+      values >> n.index >> function >> n.a >> n.b >> n.timeConst >> n.bias;
+      n.function = functionFromName(function);
+      file.neurons.push_back(n);
+    } else if (key == "connection") {
+      Connection c;
+      values >> c.target >> c.source >> c.weight >> c.recurrent;
+      file.connections.push_back(c);
+    } else if (key == "sensor") {
+      std::string name;
+      values >> name;
+      file.sensors.push_back(name);
+    } else if (key == "input") {
+      Input       i;
+      std::string type;
+      values >> type >> i.index >> i.value >> i.phase >> i.low >> i.up >>
+        i.rest;
+      i.type = inputTypeFromName(type);
+      file.inputs.push_back(i);
+    } else if (key == "motor") {
+      Motor m;
+      values >> m.name >> m.output >> m.low >> m.up >> m.rest;
+      file.motors.push_back(m);
+    } else {
+      throw std::runtime_error("Unknown controller entry: " + key);
+    }
+
+    check(values, number);
+  }
+
+  if (version != VERSION)
+    throw std::runtime_error("Unsupported controller version: " +
+                             std::to_string(version));
+
+  file.validate();
+  return file;
+}
+
+const char* ControllerFile::functionName(Function function) {
+  return FUNCTION_NAMES[static_cast<int>(function)];
+}
+
+ControllerFile::Function
+ControllerFile::functionFromName(const std::string& name) {
+  for (int i = 0; i < 14; ++i)
+    if (name == FUNCTION_NAMES[i])
+      return static_cast<Function>(i);
+
+  throw std::runtime_error("Unknown activation function: " + name);
+}
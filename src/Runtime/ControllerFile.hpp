@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief
+ *   Everything needed to run an evolved controller outside of the engine:
+ *   the compiled network, how the sensors of the robot become the inputs
+ *   of the network and how the outputs of the network become motor
+ *   targets.
+ *
+ *   The file only uses the standard library so that it can be loaded by
+ *   ControllerRuntime without MultiNEAT, Bullet or OpenGL. It is created
+ *   by SpiderSwarm::exportController from a genome and a substrate.
+ *
+ *   The file is stored as text, one entry per line:
+ *
+ *     controller <version>
+ *     network <neurons> <inputs> <outputs> <leaky> <passes> <tolerance>
+ *             <time step>
+ *     neuron <index> <function> <a> <b> <time constant> <bias>
+ *     connection <target> <source> <weight> <recurrent>
+ *     sensor <name>
+ *     input <type> <index> <value> <phase> <low> <up> <rest>
+ *     motor <name> <output> <low> <up> <rest>
+ *
+ *   Neurons are listed in the order they are activated and the target of
+ *   a connection is the position of the neuron in that list, while the
+ *   source is the index of the neuron in the network.
+ */
+struct ControllerFile {
+  //! Same functions as NEAT::ActivationFunction
+  enum class Function {
+    SignedSigmoid,
+    UnsignedSigmoid,
+    Tanh,
+    TanhCubic,
+    SignedStep,
+    UnsignedStep,
+    SignedGauss,
+    UnsignedGauss,
+    Abs,
+    SignedSine,
+    UnsignedSine,
+    Linear,
+    Relu,
+    Softplus
+  };
+
+  //! Where the value of an input of the network comes from
+  enum class InputType {
+    Feedback, // The output `index` from the previous step
+    Constant, // Always `value`
+    Clock,    // sin(time * value + phase)
+    Sensor,   // The sensor `index` as it is
+    Angle     // The sensor `index` plus `value`, normalized between low/up
+  };
+
+  struct Neuron {
+    uint32_t index;
+    Function function;
+    float    a;
+    float    b;
+    float    timeConst;
+    float    bias;
+  };
+
+  struct Connection {
+    uint32_t target;
+    uint32_t source;
+    float    weight;
+    bool     recurrent;
+  };
+
+  struct Input {
+    InputType type;
+    uint32_t  index;
+    float     value;
+    float     phase;
+    float     low;
+    float     up;
+    float     rest;
+
+    static Input feedback(uint32_t output);
+    static Input constant(float value);
+    static Input clock(float frequency, float phase);
+    static Input sensor(uint32_t sensor);
+    static Input
+    angle(uint32_t sensor, float low, float up, float rest, float offset = 0);
+  };
+
+  //! The output is turned into an angle between low and up
+  struct Motor {
+    std::string name;
+    uint32_t    output;
+    float       low;
+    float       up;
+    float       rest;
+  };
+
+  // The network
+  uint32_t                numNeurons = 0;
+  uint32_t                numInputs  = 0;
+  uint32_t                numOutputs = 0;
+  bool                    leaky      = false;
+  uint32_t                passes     = 1;
+  float                   tolerance  = 0;
+  float                   timeStep   = 1.0f / 60.0f;
+  std::vector<Neuron>     neurons;
+  std::vector<Connection> connections;
+
+  // The mapping, with one input per input of the network
+  std::vector<std::string> sensors;
+  std::vector<Input>       inputs;
+  std::vector<Motor>       motors;
+
+  // Returns the index of the sensor with the name, adding it if needed
+  uint32_t addSensor(const std::string& name);
+
+  // Throws if the indices in the file do not fit together
+  void validate() const;
+
+  void save(const std::string& filename) const;
+  static ControllerFile load(const std::string& filename);
+
+  // Converts between functions and the names used in the file
+  static const char* functionName(Function function);
+  static Function functionFromName(const std::string& name);
+};
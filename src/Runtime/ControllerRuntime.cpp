@@ -0,0 +1,306 @@
+#include "ControllerRuntime.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+  const float PI = 3.14159265358979f;
+
+  typedef ControllerFile::Function Function;
+
+  /**
+   * @brief
+   *   Applies the activation function in the same way as
+   *   NEAT::NeuralNetwork::Activate
+   *
+   * @param function
+   * @param x
+   * @param a
+   * @param b
+   *
+   * @return
+   */
+  float activation(Function function, float x, float a, float b) {
+    switch (function) {
+      case Function::SignedSigmoid:
+        return (1.0f / (1.0f + std::exp(-a * x - b)) - 0.5f) * 2.0f;
+      case Function::UnsignedSigmoid:
+        return 1.0f / (1.0f + std::exp(-a * x - b));
+      case Function::Tanh:
+        return std::tanh(x * a);
+      case Function::TanhCubic:
+        return std::tanh(x * x * x * a);
+      case Function::SignedStep:
+        return x > b ? 1.0f : -1.0f;
+      case Function::UnsignedStep:
+        return x > 0.5f + b ? 1.0f : 0.0f;
+      case Function::SignedGauss:
+        return (std::exp(-a * x * x + b) - 0.5f) * 2.0f;
+      case Function::UnsignedGauss:
+        return std::exp(-a * x * x + b);
+      case Function::Abs:
+        return std::abs(x + b);
+      case Function::SignedSine:
+        return std::sin(x * a + b);
+      case Function::UnsignedSine:
+        return (std::sin(x * a + b) + 1.0f) / 2.0f;
+      case Function::Linear:
+        return x + b;
+      case Function::Relu:
+        return x > 0 ? x : 0;
+      case Function::Softplus:
+        return std::log(1.0f + std::exp(x));
+    }
+
+    return x;
+  }
+
+  //! Same as ExpUtil::normalizeAngle
+  float normalizeAngle(float angle, float low, float up, float rest) {
+    if (angle < low)
+      angle += 2.f * PI;
+    if (angle > up)
+      angle -= 2.f * PI;
+
+    if (angle - rest == 0.f)
+      return 0.f;
+
+    return angle < rest ? -(angle - rest) / (low - rest) :
+                          (angle - rest) / (up - rest);
+  }
+
+  //! Same as ExpUtil::denormalizeAngle
+  float denormalizeAngle(float p, float low, float up, float rest) {
+    return p < 0 ? p * std::abs(low - rest) + rest :
+                   p * std::abs(up - rest) + rest;
+  }
+}
+
+/**
+ * @brief
+ *   Stores the connections of the file by their target, with the
+ *   recurrent connections of each neuron after the others, and allocates
+ *   everything that step needs.
+ *
+ * @param file
+ */
+ControllerRuntime::ControllerRuntime(const ControllerFile& file)
+    : mFile(file), mTime(0), mIsRecurrent(false) {
+  mFile.validate();
+
+  size_t size = mFile.neurons.size();
+  float  step = mFile.timeStep / std::max<uint32_t>(mFile.passes, 1);
+
+  for (auto& n : mFile.neurons) {
+    mIndex.push_back(n.index);
+    mTimeRate.push_back(n.timeConst > 0 ? step / n.timeConst : 1.0f);
+  }
+
+  mStart.assign(size + 1, 0);
+  mRecurrent.assign(size, 0);
+
+  for (auto& c : mFile.connections) {
+    mStart[c.target + 1] += 1;
+
+    if (!c.recurrent)
+      mRecurrent[c.target] += 1;
+
+    mIsRecurrent = mIsRecurrent || c.recurrent;
+  }
+
+  for (size_t i = 0; i < size; ++i) {
+    mStart[i + 1] += mStart[i];
+    mRecurrent[i] += mStart[i];
+  }
+
+  std::vector<uint32_t> forward(mStart.begin(), mStart.end() - 1);
+  std::vector<uint32_t> recurrent(mRecurrent);
+
+  mSource.resize(mFile.connections.size());
+  mWeight.resize(mFile.connections.size());
+
+  for (auto& c : mFile.connections) {
+    uint32_t& next = c.recurrent ? recurrent[c.target] : forward[c.target];
+
+    mSource[next] = c.source;
+    mWeight[next] = c.weight;
+    next += 1;
+  }
+
+  mMembrane.resize(size);
+  mSum.resize(size);
+  mActivation.resize(mFile.numNeurons);
+  mPrevious.resize(mFile.numNeurons);
+
+  reset();
+}
+
+ControllerRuntime::ControllerRuntime(const std::string& filename)
+    : ControllerRuntime(ControllerFile::load(filename)) {}
+
+void ControllerRuntime::reset() {
+  mTime = 0;
+
+  std::fill(mMembrane.begin(), mMembrane.end(), 0.0f);
+  std::fill(mActivation.begin(), mActivation.end(), 0.0f);
+  std::fill(mPrevious.begin(), mPrevious.end(), 0.0f);
+}
+
+/**
+ * @brief
+ *   Advances the clock by the time step, activates the network with the
+ *   sensors and writes the target angle of each motor
+ *
+ * @param sensors
+ * @param motors
+ */
+void ControllerRuntime::step(const float* sensors, float* motors) {
+  mTime += mFile.timeStep;
+
+  setInputs(sensors);
+
+  if (mFile.leaky)
+    activateLeaky();
+  else
+    activate();
+
+  for (size_t i = 0; i < mFile.motors.size(); ++i) {
+    const ControllerFile::Motor& m = mFile.motors[i];
+    float output = mActivation[mFile.numInputs + m.output];
+
+    motors[i] = denormalizeAngle(output, m.low, m.up, m.rest);
+  }
+}
+
+size_t ControllerRuntime::numSensors() const {
+  return mFile.sensors.size();
+}
+
+size_t ControllerRuntime::numMotors() const {
+  return mFile.motors.size();
+}
+
+const std::string& ControllerRuntime::sensorName(size_t index) const {
+  return mFile.sensors[index];
+}
+
+const std::string& ControllerRuntime::motorName(size_t index) const {
+  return mFile.motors[index].name;
+}
+
+float ControllerRuntime::timeStep() const {
+  return mFile.timeStep;
+}
+
+/**
+ * @brief
+ *   Sets the input neurons. Feedback inputs read the outputs from the
+ *   previous step, which are still stored in the output neurons.
+ *
+ * @param sensors
+ */
+void ControllerRuntime::setInputs(const float* sensors) {
+  typedef ControllerFile::InputType Type;
+
+  for (size_t i = 0; i < mFile.inputs.size(); ++i) {
+    const ControllerFile::Input& in = mFile.inputs[i];
+
+    switch (in.type) {
+      case Type::Feedback:
+        mActivation[i] = mActivation[mFile.numInputs + in.index];
+        break;
+      case Type::Constant:
+        mActivation[i] = in.value;
+        break;
+      case Type::Clock:
+        mActivation[i] = std::sin(mTime * in.value + in.phase);
+        break;
+      case Type::Sensor:
+        mActivation[i] = sensors[in.index];
+        break;
+      case Type::Angle:
+        mActivation[i] = normalizeAngle(
+          sensors[in.index] + in.value, in.low, in.up, in.rest);
+        break;
+    }
+  }
+}
+
+/**
+ * @brief
+ *   Activates every layer once, repeating while the recurrent connections
+ *   still change the activations. The network is flushed first, except
+ *   for the inputs that were just set.
+ */
+void ControllerRuntime::activate() {
+  for (auto i : mIndex)
+    mActivation[i] = 0;
+
+  std::fill(mPrevious.begin(), mPrevious.end(), 0.0f);
+
+  pass();
+
+  for (uint32_t p = 1; mIsRecurrent && p < mFile.passes; ++p) {
+    pass();
+
+    float change = 0;
+
+    for (auto i : mIndex)
+      change = std::max(change, std::abs(mActivation[i] - mPrevious[i]));
+
+    if (change <= mFile.tolerance)
+      break;
+  }
+}
+
+/**
+ * @brief
+ *   Runs a single pass in the order of activation. Recurrent connections
+ *   read the activations from before the pass.
+ */
+void ControllerRuntime::pass() {
+  if (mIsRecurrent)
+    std::copy(mActivation.begin(), mActivation.end(), mPrevious.begin());
+
+  for (size_t i = 0; i < mIndex.size(); ++i) {
+    const ControllerFile::Neuron& n   = mFile.neurons[i];
+    float                         sum = 0;
+
+    for (uint32_t c = mStart[i]; c < mRecurrent[i]; ++c)
+      sum += mActivation[mSource[c]] * mWeight[c];
+
+    for (uint32_t c = mRecurrent[i]; c < mStart[i + 1]; ++c)
+      sum += mPrevious[mSource[c]] * mWeight[c];
+
+    mActivation[mIndex[i]] = activation(n.function, sum, n.a, n.b);
+  }
+}
+
+/**
+ * @brief
+ *   Integrates the membrane potentials over the time step, in `passes`
+ *   smaller steps where every neuron is updated at the same time.
+ */
+void ControllerRuntime::activateLeaky() {
+  size_t size = mIndex.size();
+
+  for (uint32_t p = 0; p < std::max<uint32_t>(mFile.passes, 1); ++p) {
+    for (size_t i = 0; i < size; ++i) {
+      float sum = 0;
+
+      for (uint32_t c = mStart[i]; c < mStart[i + 1]; ++c)
+        sum += mActivation[mSource[c]] * mWeight[c];
+
+      mSum[i] = sum;
+    }
+
+    for (size_t i = 0; i < size; ++i) {
+      const ControllerFile::Neuron& n = mFile.neurons[i];
+      float                         r = mTimeRate[i];
+
+      mMembrane[i] = (1.0f - r) * mMembrane[i] + r * mSum[i];
+      mActivation[mIndex[i]] =
+        activation(n.function, mMembrane[i] + n.bias, n.a, n.b);
+    }
+  }
+}
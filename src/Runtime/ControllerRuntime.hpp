@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ControllerFile.hpp"
+
+/**
+ * @brief
+ *   Runs a controller that has been exported to a ControllerFile. It only
+ *   depends on the standard library, so it can be used to run a champion
+ *   on a robot or in another simulator.
+ *
+ *   Every buffer is allocated when the runtime is created, so `step` never
+ *   allocates. Each step takes the sensors in the order of
+ *   `sensorName(i)` and writes a target angle for each motor in the order
+ *   of `motorName(i)`.
+ *
+ *   The network is activated in the same way as by the Phenotype in
+ *   single precision: leaky networks integrate over the time step in
+ *   `passes` smaller steps, other networks are activated once per layer,
+ *   repeating up to `passes` times while recurrent connections change
+ *   the outputs by more than the tolerance.
+ */
+class ControllerRuntime {
+public:
+  explicit ControllerRuntime(const ControllerFile& file);
+
+  // Loads the controller from the file
+  explicit ControllerRuntime(const std::string& filename);
+
+  // Clears the network, the feedback and the clock
+  void reset();
+
+  // Runs the controller for a single time step
+  void step(const float* sensors, float* motors);
+
+  size_t numSensors() const;
+  size_t numMotors() const;
+
+  const std::string& sensorName(size_t index) const;
+  const std::string& motorName(size_t index) const;
+
+  // The time step that the controller was evolved with
+  float timeStep() const;
+
+private:
+  void setInputs(const float* sensors);
+  void activate();
+  void activateLeaky();
+  void pass();
+
+  ControllerFile mFile;
+  float          mTime;
+  bool           mIsRecurrent;
+
+  // In the order of activation
+  std::vector<uint32_t> mIndex;
+  std::vector<float>    mTimeRate;
+  std::vector<float>    mMembrane;
+  std::vector<float>    mSum;
+
+  // mStart[i] to mStart[i + 1] are the connections into neuron i, where
+  // those from mRecurrent[i] are recurrent
+  std::vector<uint32_t> mStart;
+  std::vector<uint32_t> mRecurrent;
+  std::vector<uint32_t> mSource;
+  std::vector<float>    mWeight;
+
+  // Indexed by the index of the neuron in the network
+  std::vector<float> mActivation;
+  std::vector<float> mPrevious;
+};
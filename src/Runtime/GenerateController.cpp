@@ -0,0 +1,33 @@
+#include "ControllerCodegen.hpp"
+#include "ControllerFile.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+/**
+ * @brief
+ *   Generates a C++ header from a controller file:
+ *
+ *   GenerateController WalkingChampion.controller WalkingChampion out.hpp
+ *
+ * @param argc
+ * @param argv
+ *
+ * @return
+ */
+int main(int argc, char* argv[]) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0] << " <controller> <namespace> <header>"
+              << std::endl;
+    return 1;
+  }
+
+  try {
+    ControllerCodegen::save(ControllerFile::load(argv[1]), argv[2], argv[3]);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
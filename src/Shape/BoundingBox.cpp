@@ -0,0 +1,50 @@
+#include "BoundingBox.hpp"
+
+#include <limits>
+
+BoundingBox::BoundingBox()
+    : min(std::numeric_limits<float>::max())
+    , max(-std::numeric_limits<float>::max()) {}
+
+BoundingBox::BoundingBox(const mmm::vec3& min, const mmm::vec3& max)
+    : min(min), max(max) {}
+
+void BoundingBox::add(const mmm::vec3& p) {
+  min.x = mmm::min(min.x, p.x);
+  min.y = mmm::min(min.y, p.y);
+  min.z = mmm::min(min.z, p.z);
+  max.x = mmm::max(max.x, p.x);
+  max.y = mmm::max(max.y, p.y);
+  max.z = mmm::max(max.z, p.z);
+}
+
+bool BoundingBox::isEmpty() const {
+  return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+/**
+ * @brief
+ *   Transforms each corner of the box and returns the box around them. The
+ *   box is larger than the object if it is rotated, which is fine for
+ *   telling whether it can be seen.
+ *
+ * @param model
+ *
+ * @return
+ */
+BoundingBox BoundingBox::transformed(const mmm::mat4& model) const {
+  BoundingBox box;
+
+  if (isEmpty())
+    return box;
+
+  for (int i = 0; i < 8; ++i) {
+    mmm::vec3 corner((i & 1) ? max.x : min.x,
+                     (i & 2) ? max.y : min.y,
+                     (i & 4) ? max.z : min.z);
+
+    box.add(mmm::vec3(model * mmm::vec4(corner, 1)));
+  }
+
+  return box;
+}
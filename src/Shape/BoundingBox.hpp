@@ -0,0 +1,24 @@
+#pragma once
+
+#include <mmm.hpp>
+
+/**
+ * @brief
+ *   An axis aligned box, used to find out whether an object can be seen
+ *   before drawing it. A box that nothing has been added to is empty.
+ */
+struct BoundingBox {
+  mmm::vec3 min;
+  mmm::vec3 max;
+
+  BoundingBox();
+  BoundingBox(const mmm::vec3& min, const mmm::vec3& max);
+
+  // Grows the box so that it contains the point
+  void add(const mmm::vec3& point);
+
+  bool isEmpty() const;
+
+  // Returns the box around this box after it has been transformed
+  BoundingBox transformed(const mmm::mat4& model) const;
+};
@@ -154,3 +154,31 @@ void GLSphere::draw() {
 
   glBindVertexArray(0);
 }
+
+void GLSphere::bindVertexArray() {
+  glBindVertexArray(mVAO);
+}
+
+void GLSphere::unbindVertexArray() {
+  glBindVertexArray(0);
+}
+
+/**
+ * @brief
+ *   Draws the sphere once per instance, as an outline if the sphere was
+ *   created as one
+ *
+ * @param instances
+ */
+void GLSphere::drawInstanced(int instances) {
+  if (mVAO == 0 || instances == 0)
+    return;
+
+  if (mOutline)
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+
+  glDrawArraysInstanced(GL_TRIANGLES, 0, mNumQuads, instances);
+
+  if (mOutline)
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+}
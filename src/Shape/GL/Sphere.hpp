@@ -12,6 +12,15 @@ public:
   void setup();
   void draw();
 
+  // Binds the vertex array shared by all spheres, so that instance
+  // attributes can be added to it before drawing instances
+  void bindVertexArray();
+  void unbindVertexArray();
+
+  // Draws the sphere once for each instance. The vertex array must be
+  // bound.
+  void drawInstanced(int instances);
+
 private:
   Vertex genVertex(float u, float v);
 
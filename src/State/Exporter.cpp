@@ -0,0 +1,55 @@
+#include "Exporter.hpp"
+
+#include "../OpenGLHeaders.hpp"
+
+#include "../Learning/SpiderSwarm.hpp"
+#include "../Resource/ResourceManager.hpp"
+#include "../Utils/Asset.hpp"
+
+Exporter::Exporter(Asset*             a,
+                   const std::string& experiment,
+                   const std::string& genome,
+                   const std::string& filename)
+    : mSwarm(new SpiderSwarm())
+    , mAsset(a)
+    , mExperiment(experiment)
+    , mGenome(genome)
+    , mFilename(filename) {
+  setLoggerName("Exporter");
+  ResourceManager* r = a->rManager();
+
+  r->unloadUnnecessary(ResourceScope::Master);
+  r->loadRequired(ResourceScope::Master);
+
+  mLog->info("Initialized successfully, exporting {}", mGenome);
+}
+
+Exporter::~Exporter() {
+  delete mSwarm;
+}
+
+/**
+ * @brief
+ *   Exports the genome on the first update and closes the window, whether
+ *   the export succeeded or not.
+ *
+ * @param deltaTime
+ */
+void Exporter::update(float deltaTime) {
+  mDeltaTime = deltaTime;
+
+  try {
+    mSwarm->setup(mExperiment, false);
+
+    if (mSwarm->loadChampion(mGenome))
+      mSwarm->exportController(mFilename);
+  } catch (const std::exception& e) {
+    mLog->error("Failed to export {}: {}", mGenome, e.what());
+  }
+
+  glfwSetWindowShouldClose(glfwGetCurrentContext(), GL_TRUE);
+}
+
+void Exporter::draw(float) {}
+
+void Exporter::input(const Input::Event&) {}
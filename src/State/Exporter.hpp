@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+
+#include "State.hpp"
+
+namespace Input {
+  class Event;
+}
+
+class Asset;
+class SpiderSwarm;
+
+/**
+ * @brief
+ *   A headless state that exports a stored genome to a controller file
+ *   and then closes the window, ending the program.
+ *
+ *   The genome is read from `<genome>.genome` and `<genome>.substrate`,
+ *   and is exported with the experiment given, which describes which
+ *   sensors and motors the network is connected to.
+ *
+ *   The state still needs the Master resources since the Spider loads
+ *   its meshes through the ResourceManager.
+ */
+class Exporter : public State {
+public:
+  Exporter(Asset*             asset,
+           const std::string& experiment,
+           const std::string& genome,
+           const std::string& filename);
+
+  ~Exporter();
+
+  void update(float deltaTime);
+
+  void draw(float deltaTime);
+
+  void input(const Input::Event& event);
+
+private:
+  SpiderSwarm* mSwarm;
+  Asset*       mAsset;
+  std::string  mExperiment;
+  std::string  mGenome;
+  std::string  mFilename;
+};
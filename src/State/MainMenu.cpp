@@ -20,7 +20,7 @@ MainMenu::MainMenu(Asset* asset) {
   mLua   = mAsset->lua();
   mLua->reInitialize();
   mAsset->rManager()->unloadUnnecessary(ResourceScope::MainMenu);
-  mAsset->rManager()->loadRequired(ResourceScope::MainMenu);
+  mAsset->rManager()->loadRequiredAsync(ResourceScope::MainMenu);
 
   OptionsMenu* opts = new OptionsMenu(mAsset->input());
   CFG*         cfg  = mAsset->cfg();
@@ -26,6 +26,8 @@
 
 #include "../Learning/SpiderSwarm.hpp"
 
+#include <cstring>
+
 using mmm::vec2;
 using mmm::vec3;
 
@@ -36,7 +38,7 @@ Master::Master(Asset* a) : mAsset(a) {
   ResourceManager* r         = a->rManager();
 
   r->unloadUnnecessary(ResourceScope::Master);
-  r->loadRequired(ResourceScope::Master);
+  r->loadRequiredAsync(ResourceScope::Master);
 
   mLua         = a->lua();
   mCamera      = new Camera(a);
@@ -44,6 +46,10 @@ Master::Master(Asset* a) : mAsset(a) {
   mWorld       = new World(vec3(0, -9.81, 0));
   mShadowmap =
     new Framebuffer(r->get<Program>("Program::Shadow"), shadowRes, true);
+  mStaticShadowmap =
+    new Framebuffer(r->get<Program>("Program::Shadow"), shadowRes, true);
+  mHasStaticShadows = false;
+  mModelProgram = r->handle<Program>("Program::Model");
 
   mDrawable3D = { new Terrain() };
   mSwarm      = new SpiderSwarm();
@@ -68,6 +74,7 @@ Master::Master(Asset* a) : mAsset(a) {
 Master::~Master() {
   delete mCamera;
   delete mShadowmap;
+  delete mStaticShadowmap;
   delete mWorld;
   delete mSwarm;
 
@@ -85,28 +92,99 @@ void Master::draw3D() {
   glEnable(GL_DEPTH_TEST);
   glCullFace(GL_BACK);
 
+  mCamera->uploadFrameUniforms();
+
   std::shared_ptr<Program> shadowProgram = mShadowmap->program();
-  mCamera->setLightVPUniforms(shadowProgram, "light");
+  Frustum                  lightFrustum  = mCamera->lightFrustum();
+  Frustum                  viewFrustum   = mCamera->frustum();
 
-  mShadowmap->bind(true);
+  mSwarm->prepareDraw();
+
+  // Start from the shadows of the static objects, so that only the objects
+  // that move are drawn into the shadow map every frame
+  drawStaticShadows();
+  mStaticShadowmap->copyTo(mShadowmap);
+
+  mShadowmap->nonClearBind(true);
   for (auto d : mDrawable3D)
-    d->draw(shadowProgram, false);
-  mSwarm->draw(shadowProgram, false);
+    if (!d->isStatic() && d->isVisible(lightFrustum))
+      d->draw(shadowProgram, false);
+  mSwarm->draw(shadowProgram, false, lightFrustum);
   mShadowmap->finalize();
   mShadowmap->texture()->bind(0);
 
-  std::shared_ptr<Program> modelProgram =
-    mAsset->rManager()->get<Program>("Program::Model");
+  std::shared_ptr<Program> modelProgram = mModelProgram.get();
 
-  modelProgram->setUniform("view", mCamera->view());
-  modelProgram->setUniform("proj", mCamera->projection());
-  modelProgram->setUniform("dir", mCamera->light().direction);
+  for (auto d : mDrawable3D)
+    if (d->isVisible(viewFrustum))
+      d->draw(modelProgram, true);
+  mSwarm->draw(modelProgram, true, viewFrustum);
+}
 
-  mCamera->setLightVPUniforms(modelProgram, "light");
+/**
+ * @brief
+ *   The light follows the camera, so the static shadows are drawn again
+ *   whenever the camera moves. They are also drawn again when a static
+ *   object is added, removed, replaced or moved. Otherwise the terrain is
+ *   not drawn into the shadow map at all.
+ */
+void Master::drawStaticShadows() {
+  const Camera::Light& light     = mCamera->light();
+  mmm::mat4            lightView = light.projection * light.view;
 
-  for (auto d : mDrawable3D)
-    d->draw(modelProgram, true);
-  mSwarm->draw(modelProgram, true);
+  if (mHasStaticShadows &&
+      std::memcmp(&lightView, &mStaticShadowLight, sizeof(mmm::mat4)) == 0 &&
+      !haveStaticObjectsChanged())
+    return;
+
+  std::shared_ptr<Program> shadowProgram = mStaticShadowmap->program();
+  Frustum                  lightFrustum  = mCamera->lightFrustum();
+
+  mStaticShadowCasters.clear();
+
+  mStaticShadowmap->bind(true);
+  for (auto d : mDrawable3D) {
+    if (!d->isStatic())
+      continue;
+
+    mStaticShadowCasters.push_back({ d, d->position(), d->rotation() });
+
+    if (d->isVisible(lightFrustum))
+      d->draw(shadowProgram, false);
+  }
+  mStaticShadowmap->finalize();
+
+  mStaticShadowLight = lightView;
+  mHasStaticShadows  = true;
+}
+
+/**
+ * @brief
+ *   Compares the static objects with those the static shadows were drawn
+ *   with, in the same order, so that a terrain that is replaced or a
+ *   static object that is added, removed or moved is noticed.
+ *
+ * @return
+ */
+bool Master::haveStaticObjectsChanged() const {
+  size_t i = 0;
+
+  for (auto d : mDrawable3D) {
+    if (!d->isStatic())
+      continue;
+
+    if (i == mStaticShadowCasters.size())
+      return true;
+
+    const StaticShadowCaster& caster = mStaticShadowCasters[i++];
+
+    if (caster.drawable != d ||
+        std::memcmp(&caster.position, &d->position(), sizeof(mmm::vec3)) ||
+        std::memcmp(&caster.rotation, &d->rotation(), sizeof(mmm::mat4)))
+      return true;
+  }
+
+  return i != mStaticShadowCasters.size();
 }
 
 void Master::drawGUI() {
@@ -115,6 +193,9 @@ void Master::drawGUI() {
   for (auto g : mGUIElements)
     g->draw();
 
+  // Lua may use the swarm, which could be simulating on its own thread
+  auto lock = mSwarm->lock();
+
   try {
     mLua->engine["draw"]();
   } catch (const sol::error& e) {
@@ -123,6 +204,9 @@ void Master::drawGUI() {
 }
 
 void Master::input(const Input::Event& event) {
+  // The console runs Lua, which may use the swarm
+  auto lock = mSwarm->lock();
+
   for (auto g : mGUIElements)
     g->input(event);
 
@@ -149,6 +233,8 @@ void Master::update(float deltaTime) {
     mCamera->input(deltaTime);
   mCamera->update(deltaTime);
 
+  auto lock = mSwarm->lock();
+
   try {
     mLua->engine["update"](deltaTime);
   } catch (const sol::error& e) {
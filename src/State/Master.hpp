@@ -1,5 +1,8 @@
 #pragma once
 
+#include <mmm.hpp>
+
+#include "../Resource/ResourceHandle.hpp"
 #include "State.hpp"
 
 namespace Input {
@@ -18,6 +21,7 @@ class Camera;
 class Framebuffer;
 class World;
 class SpiderSwarm;
+class Program;
 
 class Master : public State {
 public:
@@ -32,16 +36,40 @@ public:
   void input(const Input::Event& event);
 
 private:
+  //! A static object as it was when the static shadows were drawn
+  struct StaticShadowCaster {
+    Drawable3D* drawable;
+    mmm::vec3   position;
+    mmm::mat4   rotation;
+  };
+
   void draw3D();
   void drawGUI();
 
+  // Draws the static objects into their own shadow map, unless neither
+  // the light nor the static objects have changed since they were drawn
+  void drawStaticShadows();
+
+  // Returns whether the static objects are not the ones, or not where
+  // they were, when the static shadows were drawn
+  bool haveStaticObjectsChanged() const;
+
   Camera*      mCamera;
   Framebuffer* mShadowmap;
+  Framebuffer* mStaticShadowmap;
   World*       mWorld;
   Lua::Lua*    mLua;
   SpiderSwarm* mSwarm;
   // Input::Input* mInput;
   Asset* mAsset;
 
+  ResourceHandle<Program> mModelProgram;
+
+  // The view and projection of the light and the static objects the static
+  // shadows were drawn with
+  mmm::mat4                       mStaticShadowLight;
+  std::vector<StaticShadowCaster> mStaticShadowCasters;
+
   bool mFixedCamera;
+  bool mHasStaticShadows;
 };
@@ -26,7 +26,9 @@ namespace States {
     Refresh,
     WinRefresh,
     NoChange,
-    LuaReload
+    LuaReload,
+    Worker,
+    Exporter
   };
 }
 
@@ -0,0 +1,57 @@
+#include "Worker.hpp"
+
+#include <chrono>
+#include <thread>
+
+#include "../OpenGLHeaders.hpp"
+
+#include "../Learning/EvaluationWorker.hpp"
+#include "../Resource/ResourceManager.hpp"
+#include "../Utils/Asset.hpp"
+
+Worker::Worker(Asset* a, const std::string& address)
+    : mWorker(new EvaluationWorker())
+    , mAsset(a)
+    , mAddress(address)
+    , mHasConnected(false) {
+  setLoggerName("Worker");
+  ResourceManager* r = a->rManager();
+
+  r->unloadUnnecessary(ResourceScope::Master);
+  r->loadRequired(ResourceScope::Master);
+
+  mLog->info("Initialized successfully, master at {}", mAddress);
+}
+
+Worker::~Worker() {
+  delete mWorker;
+}
+
+/**
+ * @brief
+ *   Keeps trying to connect to the master once every second until it
+ *   succeeds. Once connected, it blocks until a batch of jobs has been
+ *   evaluated. When the connection is lost, the window is closed.
+ *
+ * @param deltaTime
+ */
+void Worker::update(float deltaTime) {
+  mDeltaTime = deltaTime;
+
+  if (!mHasConnected) {
+    if (mWorker->connect(mAddress)) {
+      mHasConnected = true;
+    } else {
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    return;
+  }
+
+  if (!mWorker->step())
+    glfwSetWindowShouldClose(glfwGetCurrentContext(), GL_TRUE);
+}
+
+void Worker::draw(float) {}
+
+void Worker::input(const Input::Event&) {}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+
+#include "State.hpp"
+
+namespace Input {
+  class Event;
+}
+
+class Asset;
+class EvaluationWorker;
+
+/**
+ * @brief
+ *   A headless state that turns the program into an evaluation worker.
+ *
+ *   It connects to an EvaluationMaster and evaluates the jobs it is
+ *   sent until the master closes the connection, at which point the
+ *   window is closed, ending the program.
+ *
+ *   The state still needs the Master resources since the Spider loads
+ *   its meshes through the ResourceManager.
+ */
+class Worker : public State {
+public:
+  Worker(Asset* asset, const std::string& address);
+
+  ~Worker();
+
+  void update(float deltaTime);
+
+  void draw(float deltaTime);
+
+  void input(const Input::Event& event);
+
+private:
+  EvaluationWorker* mWorker;
+  Asset*            mAsset;
+  std::string       mAddress;
+  bool              mHasConnected;
+};
@@ -40,6 +40,18 @@ Camera* Asset::camera() {
   return mCamera;
 }
 
+TextRenderer* Asset::textRenderer() {
+  if (mTextRenderer == nullptr)
+    throw std::runtime_error("Tried to access TextRenderer when nullptr");
+  return mTextRenderer;
+}
+
+FrameCapture* Asset::frameCapture() {
+  if (mFrameCapture == nullptr)
+    throw std::runtime_error("Tried to access FrameCapture when nullptr");
+  return mFrameCapture;
+}
+
 void Asset::setCFG(CFG* c) {
   mCFG = c;
 }
@@ -59,3 +71,11 @@ void Asset::setResourceManager(ResourceManager* r) {
 void Asset::setCamera(Camera* c) {
   mCamera = c;
 }
+
+void Asset::setTextRenderer(TextRenderer* t) {
+  mTextRenderer = t;
+}
+
+void Asset::setFrameCapture(FrameCapture* f) {
+  mFrameCapture = f;
+}
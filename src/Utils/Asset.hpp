@@ -11,6 +11,8 @@ namespace Lua {
 class CFG;
 class ResourceManager;
 class Camera;
+class TextRenderer;
+class FrameCapture;
 
 //! Asset is a class that is being sent around that stores a lot of useful
 //! settings.
@@ -23,12 +25,16 @@ public:
   Lua::Lua*        lua();
   ResourceManager* rManager();
   Camera*          camera();
+  TextRenderer*    textRenderer();
+  FrameCapture*    frameCapture();
 
   void setCFG(CFG* c);
   void setInput(Input::Input* i);
   void setLua(Lua::Lua* lua);
   void setResourceManager(ResourceManager* r);
   void setCamera(Camera* c);
+  void setTextRenderer(TextRenderer* t);
+  void setFrameCapture(FrameCapture* f);
 
 private:
   CFG*             mCFG             = nullptr;
@@ -36,4 +42,6 @@ private:
   Lua::Lua*        mLua             = nullptr;
   ResourceManager* mResourceManager = nullptr;
   Camera*          mCamera          = nullptr;
+  TextRenderer*    mTextRenderer    = nullptr;
+  FrameCapture*    mFrameCapture    = nullptr;
 };
@@ -0,0 +1,173 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int numThreads) : mStopping(false) {
+  if (numThreads == 0)
+    numThreads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+  for (unsigned int i = 0; i < numThreads; ++i)
+    mThreads.push_back(std::thread(&ThreadPool::worker, this));
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopping = true;
+  }
+
+  mWorkAvailable.notify_all();
+
+  for (auto&& t : mThreads)
+    t.join();
+}
+
+/**
+ * @brief
+ *   Calls work with consecutive ranges that together cover [0, size).
+ *   The ranges are handed out in order, but may be run in any order and
+ *   on any thread, so work must not depend on which range runs first.
+ *
+ *   The range is split into a few chunks per thread so that uneven work
+ *   is still spread out.
+ *
+ *   An exception thrown by work, on whichever thread, is caught there so
+ *   it does not terminate the program. Once every chunk has finished or
+ *   been skipped, the first exception is thrown again here.
+ *
+ * @param size
+ * @param work
+ */
+void ThreadPool::parallelFor(size_t size, const Work& work) {
+  if (size == 0)
+    return;
+
+  size_t numChunks = (mThreads.size() + 1) * 4;
+
+  if (mThreads.empty() || size == 1) {
+    work(0, size);
+    return;
+  }
+
+  auto task       = std::make_shared<Task>();
+  task->work      = &work;
+  task->size      = size;
+  task->grainSize = std::max<size_t>(size / numChunks, 1);
+  task->next      = 0;
+  task->finished  = 0;
+  task->failed    = false;
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTasks.push_back(task);
+  }
+
+  mWorkAvailable.notify_all();
+  runChunks(*task);
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  mTaskFinished.wait(lock, [&task]() { return task->finished == task->size; });
+
+  if (task->error)
+    std::rethrow_exception(task->error);
+}
+
+/**
+ * @brief
+ *   Queues the job to be run by one of the threads in the pool. If the
+ *   pool has no threads, the job is run before returning.
+ *
+ * @param job
+ *
+ * @return a future that is ready when the job has finished
+ */
+std::future<void> ThreadPool::async(Job job) {
+  std::packaged_task<void()> task(std::move(job));
+  std::future<void>          future = task.get_future();
+
+  if (mThreads.empty()) {
+    task();
+    return future;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mJobs.push_back(std::move(task));
+  }
+
+  mWorkAvailable.notify_one();
+  return future;
+}
+
+size_t ThreadPool::numThreads() const {
+  return mThreads.size();
+}
+
+ThreadPool& ThreadPool::global() {
+  static ThreadPool pool;
+  return pool;
+}
+
+void ThreadPool::runChunks(Task& task) {
+  size_t begin;
+
+  while ((begin = task.next.fetch_add(task.grainSize)) < task.size) {
+    size_t end = std::min(begin + task.grainSize, task.size);
+
+    // The rest of the chunks are only counted once one has thrown
+    if (!task.failed) {
+      try {
+        (*task.work)(begin, end);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (!task.error)
+          task.error = std::current_exception();
+
+        task.failed = true;
+      }
+    }
+
+    // The one that finishes the last chunk wakes up the caller. The lock
+    // makes sure the caller is either waiting or has yet to check
+    if (task.finished.fetch_add(end - begin) + (end - begin) == task.size) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mTaskFinished.notify_all();
+    }
+  }
+}
+
+void ThreadPool::worker() {
+  while (true) {
+    std::shared_ptr<Task>      task;
+    std::packaged_task<void()> job;
+
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mWorkAvailable.wait(lock, [this]() {
+        return mStopping || !mTasks.empty() || !mJobs.empty();
+      });
+
+      if (mStopping)
+        return;
+
+      if (!mTasks.empty()) {
+        task = mTasks.front();
+
+        // Every chunk has been handed out, so no one else needs to see it
+        if (task->next >= task->size) {
+          mTasks.pop_front();
+          continue;
+        }
+      } else {
+        job = std::move(mJobs.front());
+        mJobs.pop_front();
+      }
+    }
+
+    if (task)
+      runChunks(*task);
+    else
+      job();
+  }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief
+ *   A fixed set of threads that are kept alive for the lifetime of the
+ *   pool, so that work which is split up many times per second does not
+ *   have to pay for creating threads every time.
+ *
+ *   Work is given to the pool through `parallelFor`, which splits a range
+ *   into chunks that are picked up by the threads of the pool as well as
+ *   the calling thread. The call blocks until every chunk has finished.
+ *   If a chunk throws, the chunks that have not started are skipped and
+ *   the first exception is thrown again by `parallelFor`.
+ *
+ *   Several threads may call `parallelFor` at the same time. Since the
+ *   calling thread always takes part in its own work, a call will finish
+ *   even if every thread in the pool is busy with something else.
+ *
+ *   Longer, independent work can be given through `async`, which returns
+ *   right away. Such jobs are only picked up when there are no chunks of
+ *   `parallelFor` waiting, so they never hold up a caller that is blocked.
+ */
+class ThreadPool {
+public:
+  typedef std::function<void(size_t begin, size_t end)> Work;
+  typedef std::function<void()> Job;
+
+  // Creates a pool of numThreads threads. 0 uses one less than the
+  // number of hardware threads, since the caller takes part as well
+  ThreadPool(unsigned int numThreads = 0);
+  ~ThreadPool();
+
+  // Runs work over [0, size) split into chunks, blocking until done.
+  // Throws the first exception thrown by any chunk
+  void parallelFor(size_t size, const Work& work);
+
+  // Runs the job on a thread of the pool without waiting for it. The
+  // future holds any exception the job throws
+  std::future<void> async(Job job);
+
+  // Returns the number of threads in the pool, not counting the caller
+  size_t numThreads() const;
+
+  // Returns a pool that is shared by the whole program
+  static ThreadPool& global();
+
+private:
+  struct Task {
+    const Work*         work;
+    size_t              size;
+    size_t              grainSize;
+    std::atomic<size_t> next;
+    std::atomic<size_t> finished;
+    std::atomic<bool>   failed;
+    std::exception_ptr  error;
+  };
+
+  // Runs chunks of the task until there are none left, storing the
+  // first exception any of them throws in the task
+  void runChunks(Task& task);
+
+  // The loop that each thread in the pool runs
+  void worker();
+
+  std::vector<std::thread>               mThreads;
+  std::deque<std::shared_ptr<Task>>      mTasks;
+  std::deque<std::packaged_task<void()>> mJobs;
+  std::mutex                             mMutex;
+  std::condition_variable                mWorkAvailable;
+  std::condition_variable                mTaskFinished;
+  bool                                   mStopping;
+};
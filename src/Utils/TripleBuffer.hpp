@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+
+/**
+ * @brief
+ *   Hands values from one thread to another without locking. The writer
+ *   fills `back` and calls `publish`, while the reader calls `read` to get
+ *   the latest value that has been published.
+ *
+ *   Of the three buffers, one is written to, one is read from and the one
+ *   in the middle holds the latest published value. Publishing and reading
+ *   only swap their buffer with the middle one, so neither of them ever
+ *   waits for the other, and the reader always gets a complete value.
+ *   Values that are published faster than they are read are skipped.
+ *
+ *   The buffers are reused, so a vector that is cleared and filled again
+ *   keeps its memory.
+ *
+ *   Only one thread may write and one thread may read.
+ */
+template <typename T>
+class TripleBuffer {
+public:
+  TripleBuffer();
+
+  // Returns the buffer to write the next value into
+  T& back();
+
+  // Makes the back buffer the latest value, giving the writer a new one
+  void publish();
+
+  // Returns the latest published value, which stays valid until the
+  // next call to read
+  const T& read();
+
+  // Returns whether a value has been published since the last read
+  bool hasUnread() const;
+
+private:
+  // Set on the middle index when it holds a value that has not been read
+  static const unsigned int UNREAD = 4;
+
+  T                         mBuffers[3];
+  unsigned int              mBack;
+  unsigned int              mFront;
+  std::atomic<unsigned int> mMiddle;
+};
+
+template <typename T>
+TripleBuffer<T>::TripleBuffer() : mBack(0), mFront(1), mMiddle(2) {}
+
+template <typename T>
+T& TripleBuffer<T>::back() {
+  return mBuffers[mBack];
+}
+
+template <typename T>
+void TripleBuffer<T>::publish() {
+  unsigned int middle =
+    mMiddle.exchange(mBack | UNREAD, std::memory_order_acq_rel);
+  mBack = middle & ~UNREAD;
+}
+
+template <typename T>
+const T& TripleBuffer<T>::read() {
+  if (hasUnread())
+    mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & ~UNREAD;
+
+  return mBuffers[mFront];
+}
+
+template <typename T>
+bool TripleBuffer<T>::hasUnread() const {
+  return (mMiddle.load(std::memory_order_acquire) & UNREAD) != 0;
+}
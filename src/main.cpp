@@ -4,6 +4,7 @@
 #include "GlobalLog.hpp"
 #include "Log.hpp"
 #include <stdexcept>
+#include <string>
 
 Engine* engine = nullptr;
 // Handle sigterm on both Linux and Windows
@@ -37,6 +38,14 @@ Engine* engine = nullptr;
  *   you can tell the game to start at a certain
  *   resolution or with a certain keybinding set.
  *
+ *   If `--worker <address>` is given, the program runs as a
+ *   headless evaluation worker connecting to the master at
+ *   the address, such as `unix:/tmp/woooo.sock` or `host:port`.
+ *
+ *   If `--export <experiment> <genome> <file>` is given, the genome
+ *   stored in `<genome>.genome` and `<genome>.substrate` is exported
+ *   to a controller file without showing a window.
+ *
  * @param argc
  *   Number of arguments sent
  *
@@ -61,7 +70,35 @@ int main(int argc, char* argv[]) {
 
   engine = new Engine();
 
-  if (!engine->initialize(argc, argv, States::Init, States::MasterThesis)) {
+  int initState = States::MasterThesis;
+
+  // Remove the worker and export arguments before the rest is given to
+  // the CFG
+  for (int i = 1; i < argc; ++i) {
+    std::string argument = argv[i];
+    int         count    = 0;
+
+    if (argument == "--worker" && i + 1 < argc) {
+      engine->setWorkerAddress(argv[i + 1]);
+      initState = States::Worker;
+      count     = 2;
+    } else if (argument == "--export" && i + 3 < argc) {
+      engine->setExport(argv[i + 1], argv[i + 2], argv[i + 3]);
+      initState = States::Exporter;
+      count     = 4;
+    } else {
+      continue;
+    }
+
+    for (int j = i + count; j < argc; ++j)
+      argv[j - count] = argv[j];
+
+    argc -= count;
+    argv[argc] = nullptr;
+    break;
+  }
+
+  if (!engine->initialize(argc, argv, States::Init, initState)) {
     throw std::runtime_error("Engined failed to initialize");
   }
 
@@ -0,0 +1,25 @@
+#!/bin/bash
+# Starts a number of evaluation workers on this machine that connect to
+# a master listening on a Unix socket. Start the master first by calling
+# `swarm:listen("unix:/tmp/woooo.sock")` from Lua.
+#
+# Must be executed from the folder containing the executable so that
+# the workers can find the media and config folders.
+
+# $1 number of workers, defaults to 2
+# $2 address of the master, defaults to unix:/tmp/woooo.sock
+
+NUM_WORKERS=${1:-2}
+ADDRESS=${2:-unix:/tmp/woooo.sock}
+
+if [ ! -x "./Woooo" ]; then
+  echo "Error: Woooo executable not found in current folder"
+  exit 1
+fi
+
+for i in $(seq 1 "$NUM_WORKERS"); do
+  ./Woooo --worker "$ADDRESS" > "worker-$i.log" 2>&1 &
+done
+
+echo "Started $NUM_WORKERS worker(s) connecting to $ADDRESS"
+wait